@@ -138,6 +138,10 @@ void Config::ReadValues() {
     // Core
     ReadSetting("Core", Settings::values.use_cpu_jit);
     ReadSetting("Core", Settings::values.cpu_clock_percentage);
+    ReadSetting("Core", Settings::values.host_write_tracking);
+    ReadSetting("Core", Settings::values.use_fastmem);
+    ReadSetting("Core", Settings::values.parallel_cpu_cores);
+    ReadSetting("Core", Settings::values.skip_idle_loops);
 
     // Premium
     ReadSetting("Premium", Settings::values.texture_filter_name);
@@ -149,8 +153,10 @@ void Config::ReadValues() {
     ReadSetting("Renderer", Settings::values.graphics_api);
     ReadSetting("Renderer", Settings::values.use_hw_shader);
     ReadSetting("Renderer", Settings::values.use_shader_jit);
+    ReadSetting("Renderer", Settings::values.use_gpu_thread);
     ReadSetting("Renderer", Settings::values.resolution_factor);
     ReadSetting("Renderer", Settings::values.use_disk_shader_cache);
+    ReadSetting("Renderer", Settings::values.async_shader_compilation);
     ReadSetting("Renderer", Settings::values.use_vsync_new);
 
     // Work around to map Android setting for enabling the frame limiter to the format Citra expects
@@ -195,6 +201,8 @@ void Config::ReadValues() {
     ReadSetting("Utility", Settings::values.dump_textures);
     ReadSetting("Utility", Settings::values.custom_textures);
     ReadSetting("Utility", Settings::values.preload_textures);
+    ReadSetting("Utility", Settings::values.async_custom_loading);
+    ReadSetting("Utility", Settings::values.custom_textures_budget);
 
     // Audio
     ReadSetting("Audio", Settings::values.audio_emulation);
@@ -258,6 +266,11 @@ void Config::ReadValues() {
 
     // Miscellaneous
     ReadSetting("Miscellaneous", Settings::values.log_filter);
+    ReadSetting("Miscellaneous", Settings::values.savestate_compression_level);
+    ReadSetting("Miscellaneous", Settings::values.savestate_compression_threads);
+    ReadSetting("Miscellaneous", Settings::values.rewind_enabled);
+    ReadSetting("Miscellaneous", Settings::values.rewind_interval);
+    ReadSetting("Miscellaneous", Settings::values.rewind_memory_limit);
 
     // Debugging
     Settings::values.record_frame_times =
@@ -97,6 +97,24 @@ use_cpu_jit =
 # Range is any positive integer (but we suspect 25 - 400 is a good idea) Default is 100
 cpu_clock_percentage =
 
+# Detects CPU writes to memory cached by the GPU with the host MMU instead of trapping every access
+# 0 (default): Off, 1: On
+host_write_tracking =
+
+# Maps guest memory into host address space so that the JIT can access it without lookups
+# 0: Off, 1 (default): On
+use_fastmem =
+
+# Runs the emulated CPU cores on separate host threads. Requires the JIT.
+# The cores still run serially while a movie is recorded or played back, or while rewind is
+# enabled, as parallel execution is not deterministic.
+# 0 (default): Off, 1: On
+parallel_cpu_cores =
+
+# Fast-forwards to the next event when every core is idle or spinning in a loop polling memory
+# 0 (default): Off, 1: On
+skip_idle_loops =
+
 [Renderer]
 # Whether to render using OpenGL
 # 1: OpenGLES (default)
@@ -118,6 +136,12 @@ shaders_accurate_mul =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to process PICA command lists and GPU transfers on a dedicated video thread
+# While a movie is recorded or played back, or while rewind is enabled, the emulation thread waits
+# for each command list and transfer, as overlapping them is not deterministic.
+# 0 (default): Off, 1: On
+use_gpu_thread =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
@@ -127,6 +151,11 @@ use_vsync_new =
 # 0: Off, 1 (default. On)
 use_disk_shader_cache =
 
+# Compile fragment shaders in the background and draw with a generic shader until they are ready.
+# Reduces stuttering at the cost of slightly slower rendering while shaders are pending.
+# 0 (default): Off, 1: On
+async_shader_compilation =
+
 # Resolution scale factor
 # 0: Auto (scales resolution to window size), 1: Native 3DS screen resolution, Otherwise a scale
 # factor for the 3DS resolution
@@ -206,6 +235,7 @@ cardboard_y_shift =
 
 [Utility]
 # Dumps textures as PNG to dump/textures/[Title ID]/.
+# Textures listed in dump_index.bin there are not dumped again, delete it to dump them anew.
 # 0 (default): Off, 1: On
 dump_textures =
 
@@ -213,10 +243,18 @@ dump_textures =
 # 0 (default): Off, 1: On
 custom_textures =
 
-# Loads all custom textures into memory before booting.
+# Loads all custom textures into memory at boot, in the background with async_custom_loading.
 # 0 (default): Off, 1: On
 preload_textures =
 
+# Loads custom textures in the background, showing the original texture until they are ready.
+# 0: Off, 1 (default): On
+async_custom_loading =
+
+# Memory in MiB that loaded custom textures may use before the least recently used are dropped.
+# Default is 2048
+custom_textures_budget =
+
 [Audio]
 # Whether or not to enable DSP LLE
 # 0 (default): No, 1: Yes
@@ -314,6 +352,26 @@ camera_inner_flip =
 # Examples: *:Debug Kernel.SVC:Trace Service.*:Critical
 log_filter = *:Info
 
+# Zstandard compression level used for save states, higher is smaller but slower
+# 1 - 22 (default: 3)
+savestate_compression_level =
+
+# Number of background threads compressing save states while they are written
+# 0: Compress on the emulation thread, 1 - 16 (default: 2)
+savestate_compression_threads =
+
+# Keeps snapshots of recent frames in memory so that emulation can be rewound
+# 0 (default): Off, 1: On
+rewind_enabled =
+
+# Number of frames between rewind snapshots, raised automatically if taking them slows emulation
+# 1 - 600 (default: 30)
+rewind_interval =
+
+# Maximum memory used by rewind snapshots, in MiB. The oldest snapshots are dropped past it.
+# 16 - 4096 (default: 256)
+rewind_memory_limit =
+
 [Debugging]
 # Record frame time data, can be found in the log directory. Boolean value
 record_frame_times =
@@ -131,6 +131,10 @@ void Config::ReadValues() {
     // Core
     ReadSetting("Core", Settings::values.use_cpu_jit);
     ReadSetting("Core", Settings::values.cpu_clock_percentage);
+    ReadSetting("Core", Settings::values.host_write_tracking);
+    ReadSetting("Core", Settings::values.use_fastmem);
+    ReadSetting("Core", Settings::values.parallel_cpu_cores);
+    ReadSetting("Core", Settings::values.skip_idle_loops);
 
     // Renderer
     ReadSetting("Renderer", Settings::values.graphics_api);
@@ -144,8 +148,10 @@ void Config::ReadValues() {
 #endif
     ReadSetting("Renderer", Settings::values.shaders_accurate_mul);
     ReadSetting("Renderer", Settings::values.use_shader_jit);
+    ReadSetting("Renderer", Settings::values.use_gpu_thread);
     ReadSetting("Renderer", Settings::values.resolution_factor);
     ReadSetting("Renderer", Settings::values.use_disk_shader_cache);
+    ReadSetting("Renderer", Settings::values.async_shader_compilation);
     ReadSetting("Renderer", Settings::values.frame_limit);
     ReadSetting("Renderer", Settings::values.use_vsync_new);
     ReadSetting("Renderer", Settings::values.texture_filter_name);
@@ -181,6 +187,8 @@ void Config::ReadValues() {
     ReadSetting("Utility", Settings::values.dump_textures);
     ReadSetting("Utility", Settings::values.custom_textures);
     ReadSetting("Utility", Settings::values.preload_textures);
+    ReadSetting("Utility", Settings::values.async_custom_loading);
+    ReadSetting("Utility", Settings::values.custom_textures_budget);
 
     // Audio
     ReadSetting("Audio", Settings::values.audio_emulation);
@@ -304,6 +312,11 @@ void Config::ReadValues() {
 
     // Miscellaneous
     ReadSetting("Miscellaneous", Settings::values.log_filter);
+    ReadSetting("Miscellaneous", Settings::values.savestate_compression_level);
+    ReadSetting("Miscellaneous", Settings::values.savestate_compression_threads);
+    ReadSetting("Miscellaneous", Settings::values.rewind_enabled);
+    ReadSetting("Miscellaneous", Settings::values.rewind_interval);
+    ReadSetting("Miscellaneous", Settings::values.rewind_memory_limit);
 
     // Debugging
     Settings::values.record_frame_times =
@@ -56,7 +56,7 @@ const std::array<std::array<int, 5>, Settings::NativeAnalog::NumAnalogs> Config:
 // This must be in alphabetical order according to action name as it must have the same order as
 // UISetting::values.shortcuts, which is alphabetically ordered.
 // clang-format off
-const std::array<UISettings::Shortcut, 27> Config::default_hotkeys {{
+const std::array<UISettings::Shortcut, 28> Config::default_hotkeys {{
      {QStringLiteral("Advance Frame"),            QStringLiteral("Main Window"), {QStringLiteral(""),     Qt::ApplicationShortcut}},
      {QStringLiteral("Capture Screenshot"),       QStringLiteral("Main Window"), {QStringLiteral("Ctrl+P"), Qt::WidgetWithChildrenShortcut}},
      {QStringLiteral("Continue/Pause Emulation"), QStringLiteral("Main Window"), {QStringLiteral("F4"),     Qt::WindowShortcut}},
@@ -73,6 +73,7 @@ const std::array<UISettings::Shortcut, 27> Config::default_hotkeys {{
      {QStringLiteral("Mute Audio"),               QStringLiteral("Main Window"), {QStringLiteral("Ctrl+M"), Qt::WindowShortcut}},
      {QStringLiteral("Remove Amiibo"),            QStringLiteral("Main Window"), {QStringLiteral("F3"),     Qt::ApplicationShortcut}},
      {QStringLiteral("Restart Emulation"),        QStringLiteral("Main Window"), {QStringLiteral("F6"),     Qt::WindowShortcut}},
+     {QStringLiteral("Rewind"),                   QStringLiteral("Main Window"), {QStringLiteral("Backspace"), Qt::WindowShortcut}},
      {QStringLiteral("Rotate Screens Upright"),   QStringLiteral("Main Window"), {QStringLiteral("F8"),     Qt::WindowShortcut}},
      {QStringLiteral("Save to Oldest Slot"),      QStringLiteral("Main Window"), {QStringLiteral("Ctrl+C"), Qt::WindowShortcut}},
      {QStringLiteral("Stop Emulation"),           QStringLiteral("Main Window"), {QStringLiteral("F5"),     Qt::WindowShortcut}},
@@ -439,6 +440,8 @@ void Config::ReadUtilityValues() {
     ReadGlobalSetting(Settings::values.dump_textures);
     ReadGlobalSetting(Settings::values.custom_textures);
     ReadGlobalSetting(Settings::values.preload_textures);
+    ReadGlobalSetting(Settings::values.async_custom_loading);
+    ReadGlobalSetting(Settings::values.custom_textures_budget);
 
     qt_config->endGroup();
 }
@@ -450,6 +453,10 @@ void Config::ReadCoreValues() {
 
     if (global) {
         ReadBasicSetting(Settings::values.use_cpu_jit);
+        ReadBasicSetting(Settings::values.host_write_tracking);
+        ReadBasicSetting(Settings::values.use_fastmem);
+        ReadBasicSetting(Settings::values.parallel_cpu_cores);
+        ReadBasicSetting(Settings::values.skip_idle_loops);
     }
 
     qt_config->endGroup();
@@ -527,6 +534,11 @@ void Config::ReadMiscellaneousValues() {
     qt_config->beginGroup(QStringLiteral("Miscellaneous"));
 
     ReadBasicSetting(Settings::values.log_filter);
+    ReadBasicSetting(Settings::values.savestate_compression_level);
+    ReadBasicSetting(Settings::values.savestate_compression_threads);
+    ReadBasicSetting(Settings::values.rewind_enabled);
+    ReadBasicSetting(Settings::values.rewind_interval);
+    ReadBasicSetting(Settings::values.rewind_memory_limit);
 
     qt_config->endGroup();
 }
@@ -636,6 +648,7 @@ void Config::ReadRendererValues() {
 #endif
     ReadGlobalSetting(Settings::values.shaders_accurate_mul);
     ReadGlobalSetting(Settings::values.use_disk_shader_cache);
+    ReadGlobalSetting(Settings::values.async_shader_compilation);
     ReadGlobalSetting(Settings::values.use_vsync_new);
     ReadGlobalSetting(Settings::values.resolution_factor);
     ReadGlobalSetting(Settings::values.frame_limit);
@@ -648,6 +661,7 @@ void Config::ReadRendererValues() {
 
     if (global) {
         ReadBasicSetting(Settings::values.use_shader_jit);
+        ReadBasicSetting(Settings::values.use_gpu_thread);
     }
 
     qt_config->endGroup();
@@ -955,6 +969,8 @@ void Config::SaveUtilityValues() {
     WriteGlobalSetting(Settings::values.dump_textures);
     WriteGlobalSetting(Settings::values.custom_textures);
     WriteGlobalSetting(Settings::values.preload_textures);
+    WriteGlobalSetting(Settings::values.async_custom_loading);
+    WriteGlobalSetting(Settings::values.custom_textures_budget);
 
     qt_config->endGroup();
 }
@@ -966,6 +982,10 @@ void Config::SaveCoreValues() {
 
     if (global) {
         WriteBasicSetting(Settings::values.use_cpu_jit);
+        WriteBasicSetting(Settings::values.host_write_tracking);
+        WriteBasicSetting(Settings::values.use_fastmem);
+        WriteBasicSetting(Settings::values.parallel_cpu_cores);
+        WriteBasicSetting(Settings::values.skip_idle_loops);
     }
 
     qt_config->endGroup();
@@ -1038,6 +1058,11 @@ void Config::SaveMiscellaneousValues() {
     qt_config->beginGroup(QStringLiteral("Miscellaneous"));
 
     WriteBasicSetting(Settings::values.log_filter);
+    WriteBasicSetting(Settings::values.savestate_compression_level);
+    WriteBasicSetting(Settings::values.savestate_compression_threads);
+    WriteBasicSetting(Settings::values.rewind_enabled);
+    WriteBasicSetting(Settings::values.rewind_interval);
+    WriteBasicSetting(Settings::values.rewind_memory_limit);
 
     qt_config->endGroup();
 }
@@ -1114,6 +1139,7 @@ void Config::SaveRendererValues() {
 #endif
     WriteGlobalSetting(Settings::values.shaders_accurate_mul);
     WriteGlobalSetting(Settings::values.use_disk_shader_cache);
+    WriteGlobalSetting(Settings::values.async_shader_compilation);
     WriteGlobalSetting(Settings::values.use_vsync_new);
     WriteGlobalSetting(Settings::values.resolution_factor);
     WriteGlobalSetting(Settings::values.frame_limit);
@@ -1127,6 +1153,7 @@ void Config::SaveRendererValues() {
     if (global) {
         WriteSetting(QStringLiteral("use_shader_jit"), Settings::values.use_shader_jit.GetValue(),
                      true);
+        WriteBasicSetting(Settings::values.use_gpu_thread);
     }
 
     qt_config->endGroup();
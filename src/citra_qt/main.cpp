@@ -91,8 +91,10 @@
 #include "core/hle/service/cfg/cfg.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/hle/service/nfc/nfc.h"
+#include "core/hw/gpu.h"
 #include "core/loader/loader.h"
 #include "core/movie.h"
+#include "core/rewind.h"
 #include "core/savestate.h"
 #include "core/system_titles.h"
 #include "game_list_p.h"
@@ -347,8 +349,11 @@ void GMainWindow::InitializeWidgets() {
     emu_frametime_label->setToolTip(
         tr("Time taken to emulate a 3DS frame, not counting framelimiting or v-sync. For "
            "full-speed emulation this should be at most 16.67 ms."));
+    rewind_label = new QLabel();
+    rewind_label->setToolTip(tr("How far emulation can be rewound, and the memory the rewind "
+                                "snapshots currently use."));
 
-    for (auto& label : {emu_speed_label, game_fps_label, emu_frametime_label}) {
+    for (auto& label : {emu_speed_label, game_fps_label, emu_frametime_label, rewind_label}) {
         label->setVisible(false);
         label->setFrameStyle(QFrame::NoFrame);
         label->setContentsMargins(4, 0, 4, 0);
@@ -603,6 +608,15 @@ void GMainWindow::InitializeHotkeys() {
         }
         UpdateStatusBar();
     });
+    // We use "static" here in order to avoid capturing by lambda due to a MSVC bug, which makes
+    // the variable hold a garbage value after this function exits
+    static constexpr u32 REWIND_STEP_FRAMES = 60;
+    connect_shortcut(QStringLiteral("Rewind"), [&] {
+        if (emulation_running && Settings::values.rewind_enabled.GetValue()) {
+            Core::System::GetInstance().SendSignal(Core::System::Signal::Rewind,
+                                                   REWIND_STEP_FRAMES);
+        }
+    });
     connect_shortcut(QStringLiteral("Mute Audio"),
                      [] { Settings::values.audio_muted = !Settings::values.audio_muted; });
 
@@ -1309,6 +1323,7 @@ void GMainWindow::ShutdownGame() {
     emu_speed_label->setVisible(false);
     game_fps_label->setVisible(false);
     emu_frametime_label->setVisible(false);
+    rewind_label->setVisible(false);
 
     UpdateSaveStates();
 
@@ -2283,6 +2298,14 @@ void GMainWindow::UpdateStatusBar() {
     emu_speed_label->setVisible(true);
     game_fps_label->setVisible(true);
     emu_frametime_label->setVisible(true);
+
+    if (Settings::values.rewind_enabled.GetValue()) {
+        const auto stats = Core::System::GetInstance().RewindBuffer().GetStats();
+        rewind_label->setText(tr("Rewind: %1 s / %2 MiB")
+                                  .arg(stats.frames_available / GPU::SCREEN_REFRESH_RATE, 0, 'f', 1)
+                                  .arg(stats.memory_usage / (1024 * 1024)));
+    }
+    rewind_label->setVisible(Settings::values.rewind_enabled.GetValue());
 }
 
 void GMainWindow::UpdateBootHomeMenuState() {
@@ -2672,6 +2695,8 @@ void GMainWindow::RetranslateStatusBar() {
     emu_frametime_label->setToolTip(
         tr("Time taken to emulate a 3DS frame, not counting framelimiting or v-sync. For "
            "full-speed emulation this should be at most 16.67 ms."));
+    rewind_label->setToolTip(tr("How far emulation can be rewound, and the memory the rewind "
+                                "snapshots currently use."));
 
     multiplayer_state->retranslateUi();
 }
@@ -267,6 +267,7 @@ private:
     QLabel* emu_speed_label = nullptr;
     QLabel* game_fps_label = nullptr;
     QLabel* emu_frametime_label = nullptr;
+    QLabel* rewind_label = nullptr;
     QTimer status_bar_update_timer;
     bool message_label_used_for_movie = false;
 
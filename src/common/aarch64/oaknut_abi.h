@@ -0,0 +1,149 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/arch.h"
+#if CITRA_ARCH(arm64)
+
+#include <bitset>
+#include <initializer_list>
+#include <vector>
+#include <oaknut/oaknut.hpp>
+#include "common/assert.h"
+
+namespace Common::A64 {
+
+constexpr std::size_t RegToIndex(const oaknut::Reg& reg) {
+    ASSERT_MSG(reg.index() >= 0 && reg.index() < 32, "RegSet only supports X0-30 and V0-31.");
+    return static_cast<std::size_t>(reg.index()) + (reg.is_vector() ? 32 : 0);
+}
+
+constexpr oaknut::XReg IndexToXReg(std::size_t reg_index) {
+    ASSERT(reg_index < 31);
+    return oaknut::XReg(static_cast<int>(reg_index));
+}
+
+constexpr oaknut::QReg IndexToQReg(std::size_t reg_index) {
+    ASSERT(reg_index >= 32 && reg_index < 64);
+    return oaknut::QReg(static_cast<int>(reg_index - 32));
+}
+
+inline std::bitset<64> BuildRegSet(std::initializer_list<oaknut::Reg> regs) {
+    std::bitset<64> bits;
+    for (const oaknut::Reg& reg : regs) {
+        bits[RegToIndex(reg)] = true;
+    }
+    return bits;
+}
+
+constexpr inline std::bitset<64> ABI_ALL_GPRS(0x00000000'7FFFFFFF);
+constexpr inline std::bitset<64> ABI_ALL_FPRS(0xFFFFFFFF'00000000);
+
+constexpr inline oaknut::XReg ABI_RETURN = oaknut::util::X0;
+constexpr inline oaknut::XReg ABI_PARAM1 = oaknut::util::X0;
+constexpr inline oaknut::XReg ABI_PARAM2 = oaknut::util::X1;
+constexpr inline oaknut::XReg ABI_PARAM3 = oaknut::util::X2;
+constexpr inline oaknut::XReg ABI_PARAM4 = oaknut::util::X3;
+
+// AAPCS64: X0-X17 are caller saved (X18 is the platform register and is never used) and X30 is
+// overwritten by the call itself. Only the lower 64 bits of V8-V15 are preserved across calls,
+// so every vector register is considered caller saved.
+constexpr inline std::bitset<64> ABI_ALL_CALLER_SAVED(0xFFFFFFFF'4003FFFF);
+
+const std::bitset<64> ABI_ALL_CALLEE_SAVED = BuildRegSet({
+    // GPRs
+    oaknut::util::X19,
+    oaknut::util::X20,
+    oaknut::util::X21,
+    oaknut::util::X22,
+    oaknut::util::X23,
+    oaknut::util::X24,
+    oaknut::util::X25,
+    oaknut::util::X26,
+    oaknut::util::X27,
+    oaknut::util::X28,
+    oaknut::util::X29,
+    oaknut::util::X30,
+    // FPRs
+    oaknut::util::Q8,
+    oaknut::util::Q9,
+    oaknut::util::Q10,
+    oaknut::util::Q11,
+    oaknut::util::Q12,
+    oaknut::util::Q13,
+    oaknut::util::Q14,
+    oaknut::util::Q15,
+});
+
+/**
+ * Pushes the registers in the set onto the stack, keeping SP 16-byte aligned. Registers are
+ * stored in pairs where possible. Vector registers are saved in full.
+ */
+inline void ABI_PushRegisters(oaknut::CodeGenerator& code, std::bitset<64> regs) {
+    using namespace oaknut::util;
+
+    std::vector<oaknut::XReg> gprs;
+    std::vector<oaknut::QReg> fprs;
+    for (std::size_t i = 0; i < regs.size(); ++i) {
+        if (!regs[i]) {
+            continue;
+        }
+        if (ABI_ALL_GPRS[i]) {
+            gprs.push_back(IndexToXReg(i));
+        } else {
+            fprs.push_back(IndexToQReg(i));
+        }
+    }
+
+    for (std::size_t i = 0; i + 1 < gprs.size(); i += 2) {
+        code.STP(gprs[i], gprs[i + 1], SP, PRE_INDEXED, -16);
+    }
+    if (gprs.size() % 2 != 0) {
+        code.STR(gprs.back(), SP, PRE_INDEXED, -16);
+    }
+
+    for (std::size_t i = 0; i + 1 < fprs.size(); i += 2) {
+        code.STP(fprs[i], fprs[i + 1], SP, PRE_INDEXED, -32);
+    }
+    if (fprs.size() % 2 != 0) {
+        code.STR(fprs.back(), SP, PRE_INDEXED, -16);
+    }
+}
+
+/// Restores registers saved with ABI_PushRegisters using the same register set
+inline void ABI_PopRegisters(oaknut::CodeGenerator& code, std::bitset<64> regs) {
+    using namespace oaknut::util;
+
+    std::vector<oaknut::XReg> gprs;
+    std::vector<oaknut::QReg> fprs;
+    for (std::size_t i = 0; i < regs.size(); ++i) {
+        if (!regs[i]) {
+            continue;
+        }
+        if (ABI_ALL_GPRS[i]) {
+            gprs.push_back(IndexToXReg(i));
+        } else {
+            fprs.push_back(IndexToQReg(i));
+        }
+    }
+
+    if (fprs.size() % 2 != 0) {
+        code.LDR(fprs.back(), SP, POST_INDEXED, 16);
+    }
+    for (std::size_t i = fprs.size() & ~std::size_t{1}; i >= 2; i -= 2) {
+        code.LDP(fprs[i - 2], fprs[i - 1], SP, POST_INDEXED, 32);
+    }
+
+    if (gprs.size() % 2 != 0) {
+        code.LDR(gprs.back(), SP, POST_INDEXED, 16);
+    }
+    for (std::size_t i = gprs.size() & ~std::size_t{1}; i >= 2; i -= 2) {
+        code.LDP(gprs[i - 2], gprs[i - 1], SP, POST_INDEXED, 16);
+    }
+}
+
+} // namespace Common::A64
+
+#endif // CITRA_ARCH(arm64)
@@ -0,0 +1,131 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifndef _WIN32
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+#include <new>
+#include "common/assert.h"
+#include "common/host_memory.h"
+#include "common/virtual_buffer.h"
+
+namespace Common {
+
+#ifndef _WIN32
+namespace {
+
+/// Creates an anonymous shared memory object of the given size, returns -1 on failure
+int CreateSharedMemory(std::size_t size) {
+#ifdef __linux__
+    // Called through syscall as older C libraries, and Android before API 30, lack the wrapper
+    const int fd = static_cast<int>(syscall(SYS_memfd_create, "citra_memory", 1 /*CLOEXEC*/));
+#else
+    static std::atomic<u32> counter{0};
+    const std::string name =
+        "/citra_memory_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd != -1) {
+        shm_unlink(name.c_str());
+    }
+#endif
+    if (fd == -1) {
+        return -1;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // Anonymous namespace
+#endif
+
+HostMemory::HostMemory(std::size_t size, bool shared) : alloc_size{size} {
+    if (!shared || !IsSharingSupported()) {
+        base_ptr = static_cast<u8*>(AllocateMemoryPages(size));
+        return;
+    }
+#ifndef _WIN32
+    fd = CreateSharedMemory(size);
+    if (fd == -1) {
+        throw std::bad_alloc();
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        throw std::bad_alloc();
+    }
+    base_ptr = static_cast<u8*>(base);
+#endif
+}
+
+HostMemory::~HostMemory() {
+    if (!IsShared()) {
+        FreeMemoryPages(base_ptr, alloc_size);
+        return;
+    }
+#ifndef _WIN32
+    munmap(base_ptr, alloc_size);
+    close(fd);
+#endif
+}
+
+bool HostMemory::IsSharingSupported() {
+    // Arenas cover a whole 32-bit address space, which only fits in a 64-bit one
+#ifdef _WIN32
+    return false;
+#else
+    return sizeof(void*) >= 8;
+#endif
+}
+
+HostMemoryArena::HostMemoryArena(HostMemory& backing_, std::size_t size)
+    : backing{backing_}, arena_size{size} {
+    ASSERT_MSG(backing.IsShared(), "Arenas can only map shared memory");
+#ifndef _WIN32
+    void* base = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    base_ptr = static_cast<u8*>(base);
+#endif
+}
+
+HostMemoryArena::~HostMemoryArena() {
+#ifndef _WIN32
+    munmap(base_ptr, arena_size);
+#endif
+}
+
+void HostMemoryArena::Map(std::size_t offset, std::size_t backing_offset, std::size_t length,
+                          bool writable) {
+    ASSERT(offset + length <= arena_size && backing_offset + length <= backing.size());
+#ifndef _WIN32
+    const int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* result = mmap(base_ptr + offset, length, protection, MAP_SHARED | MAP_FIXED, backing.fd,
+                        static_cast<off_t>(backing_offset));
+    ASSERT_MSG(result != MAP_FAILED, "Mapping into the arena failed with errno {}", errno);
+#endif
+}
+
+void HostMemoryArena::Unmap(std::size_t offset, std::size_t length) {
+    ASSERT(offset + length <= arena_size);
+#ifndef _WIN32
+    // Replacing the pages keeps the range reserved, unlike munmap
+    void* result = mmap(base_ptr + offset, length, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    ASSERT_MSG(result != MAP_FAILED, "Unmapping from the arena failed with errno {}", errno);
+#endif
+}
+
+} // namespace Common
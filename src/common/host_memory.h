@@ -0,0 +1,86 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * A block of host memory allocated from whole host pages. A shared block is backed by an
+ * anonymous shared memory object, so that its pages can also be mapped into HostMemoryArenas.
+ */
+class HostMemory final {
+public:
+    /// Allocates size bytes of zero-filled memory, which must be a multiple of the host page size
+    HostMemory(std::size_t size, bool shared);
+    ~HostMemory();
+
+    HostMemory(const HostMemory&) = delete;
+    HostMemory& operator=(const HostMemory&) = delete;
+
+    /// Returns true if shared blocks can be allocated and mapped into arenas on this host
+    static bool IsSharingSupported();
+
+    u8* data() {
+        return base_ptr;
+    }
+
+    const u8* data() const {
+        return base_ptr;
+    }
+
+    std::size_t size() const {
+        return alloc_size;
+    }
+
+    bool IsShared() const {
+        return fd != -1;
+    }
+
+private:
+    friend class HostMemoryArena;
+
+    std::size_t alloc_size;
+    u8* base_ptr = nullptr;
+    int fd = -1;
+};
+
+/**
+ * A range of reserved host address space in which pages of a shared HostMemory can be mapped,
+ * the same memory appearing both at its own address and in the arena. Parts of the arena with
+ * nothing mapped are inaccessible, so accesses to them fault.
+ */
+class HostMemoryArena final {
+public:
+    /// Reserves size bytes of address space, which must be a multiple of the host page size
+    HostMemoryArena(HostMemory& backing, std::size_t size);
+    ~HostMemoryArena();
+
+    HostMemoryArena(const HostMemoryArena&) = delete;
+    HostMemoryArena& operator=(const HostMemoryArena&) = delete;
+
+    u8* data() {
+        return base_ptr;
+    }
+
+    std::size_t size() const {
+        return arena_size;
+    }
+
+    /// Maps length bytes of the backing memory at backing_offset to offset in the arena
+    void Map(std::size_t offset, std::size_t backing_offset, std::size_t length, bool writable);
+
+    /// Makes the range of the arena inaccessible again
+    void Unmap(std::size_t offset, std::size_t length);
+
+private:
+    HostMemory& backing;
+    std::size_t arena_size;
+    u8* base_ptr = nullptr;
+};
+
+} // namespace Common
@@ -114,6 +114,10 @@ void LogSettings() {
     LOG_INFO(Config, "Citra Configuration:");
     log_setting("Core_UseCpuJit", values.use_cpu_jit.GetValue());
     log_setting("Core_CPUClockPercentage", values.cpu_clock_percentage.GetValue());
+    log_setting("Core_HostWriteTracking", values.host_write_tracking.GetValue());
+    log_setting("Core_UseFastmem", values.use_fastmem.GetValue());
+    log_setting("Core_ParallelCpuCores", values.parallel_cpu_cores.GetValue());
+    log_setting("Core_SkipIdleLoops", values.skip_idle_loops.GetValue());
     log_setting("Renderer_UseGLES", values.use_gles.GetValue());
     log_setting("Renderer_GraphicsAPI", GetGraphicsAPIName(values.graphics_api.GetValue()));
     log_setting("Renderer_Debug", values.renderer_debug.GetValue());
@@ -121,6 +125,7 @@ void LogSettings() {
     log_setting("Renderer_SeparableShader", values.separable_shader.GetValue());
     log_setting("Renderer_ShadersAccurateMul", values.shaders_accurate_mul.GetValue());
     log_setting("Renderer_UseShaderJit", values.use_shader_jit.GetValue());
+    log_setting("Renderer_UseGpuThread", values.use_gpu_thread.GetValue());
     log_setting("Renderer_UseResolutionFactor", values.resolution_factor.GetValue());
     log_setting("Renderer_FrameLimit", values.frame_limit.GetValue());
     log_setting("Renderer_VSyncNew", values.use_vsync_new.GetValue());
@@ -139,7 +144,10 @@ void LogSettings() {
     log_setting("Layout_LargeScreenProportion", values.large_screen_proportion.GetValue());
     log_setting("Utility_DumpTextures", values.dump_textures.GetValue());
     log_setting("Utility_CustomTextures", values.custom_textures.GetValue());
+    log_setting("Utility_AsyncCustomLoading", values.async_custom_loading.GetValue());
+    log_setting("Utility_CustomTexturesBudget", values.custom_textures_budget.GetValue());
     log_setting("Utility_UseDiskShaderCache", values.use_disk_shader_cache.GetValue());
+    log_setting("Renderer_AsyncShaderCompilation", values.async_shader_compilation.GetValue());
     log_setting("Audio_Emulation", GetAudioEmulationName(values.audio_emulation.GetValue()));
     log_setting("Audio_OutputEngine", values.sink_id.GetValue());
     log_setting("Audio_EnableAudioStretching", values.enable_audio_stretching.GetValue());
@@ -166,6 +174,13 @@ void LogSettings() {
     log_setting("System_RegionValue", values.region_value.GetValue());
     log_setting("System_PluginLoader", values.plugin_loader_enabled.GetValue());
     log_setting("System_PluginLoaderAllowed", values.allow_plugin_loader.GetValue());
+    log_setting("Miscellaneous_SavestateCompressionLevel",
+                values.savestate_compression_level.GetValue());
+    log_setting("Miscellaneous_SavestateCompressionThreads",
+                values.savestate_compression_threads.GetValue());
+    log_setting("Miscellaneous_RewindEnabled", values.rewind_enabled.GetValue());
+    log_setting("Miscellaneous_RewindInterval", values.rewind_interval.GetValue());
+    log_setting("Miscellaneous_RewindMemoryLimit", values.rewind_memory_limit.GetValue());
     log_setting("Debugging_UseGdbstub", values.use_gdbstub.GetValue());
     log_setting("Debugging_GdbstubPort", values.gdbstub_port.GetValue());
 }
@@ -205,6 +220,7 @@ void RestoreGlobalState(bool is_powered_on) {
     values.use_hw_shader.SetGlobal(true);
     values.separable_shader.SetGlobal(true);
     values.use_disk_shader_cache.SetGlobal(true);
+    values.async_shader_compilation.SetGlobal(true);
     values.shaders_accurate_mul.SetGlobal(true);
     values.use_vsync_new.SetGlobal(true);
     values.resolution_factor.SetGlobal(true);
@@ -225,6 +241,8 @@ void RestoreGlobalState(bool is_powered_on) {
     values.dump_textures.SetGlobal(true);
     values.custom_textures.SetGlobal(true);
     values.preload_textures.SetGlobal(true);
+    values.async_custom_loading.SetGlobal(true);
+    values.custom_textures_budget.SetGlobal(true);
 }
 
 void LoadProfile(int index) {
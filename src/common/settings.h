@@ -405,6 +405,10 @@ struct Values {
     // Core
     Setting<bool> use_cpu_jit{true, "use_cpu_jit"};
     SwitchableSetting<s32, true> cpu_clock_percentage{100, 5, 400, "cpu_clock_percentage"};
+    Setting<bool> host_write_tracking{false, "host_write_tracking"};
+    Setting<bool> use_fastmem{true, "use_fastmem"};
+    Setting<bool> parallel_cpu_cores{false, "parallel_cpu_cores"};
+    Setting<bool> skip_idle_loops{false, "skip_idle_loops"};
     SwitchableSetting<bool> is_new_3ds{true, "is_new_3ds"};
 
     // Data Storage
@@ -426,9 +430,11 @@ struct Values {
     SwitchableSetting<bool> use_hw_shader{true, "use_hw_shader"};
     SwitchableSetting<bool> separable_shader{false, "use_separable_shader"};
     SwitchableSetting<bool> use_disk_shader_cache{true, "use_disk_shader_cache"};
+    SwitchableSetting<bool> async_shader_compilation{false, "async_shader_compilation"};
     SwitchableSetting<bool> shaders_accurate_mul{true, "shaders_accurate_mul"};
     SwitchableSetting<bool> use_vsync_new{true, "use_vsync_new"};
     Setting<bool> use_shader_jit{true, "use_shader_jit"};
+    Setting<bool> use_gpu_thread{false, "use_gpu_thread"};
     SwitchableSetting<u32, true> resolution_factor{1, 0, 10, "resolution_factor"};
     SwitchableSetting<u16, true> frame_limit{100, 0, 1000, "frame_limit"};
     SwitchableSetting<std::string> texture_filter_name{"none", "texture_filter_name"};
@@ -469,6 +475,8 @@ struct Values {
     SwitchableSetting<bool> dump_textures{false, "dump_textures"};
     SwitchableSetting<bool> custom_textures{false, "custom_textures"};
     SwitchableSetting<bool> preload_textures{false, "preload_textures"};
+    SwitchableSetting<bool> async_custom_loading{true, "async_custom_loading"};
+    SwitchableSetting<u32> custom_textures_budget{2048, "custom_textures_budget"};
 
     // Audio
     bool audio_muted;
@@ -493,6 +501,11 @@ struct Values {
 
     // Miscellaneous
     Setting<std::string> log_filter{"*:Info", "log_filter"};
+    Setting<u32, true> savestate_compression_level{3, 1, 22, "savestate_compression_level"};
+    Setting<u32, true> savestate_compression_threads{2, 0, 16, "savestate_compression_threads"};
+    Setting<bool> rewind_enabled{false, "rewind_enabled"};
+    Setting<u32, true> rewind_interval{30, 1, 600, "rewind_interval"};
+    Setting<u32, true> rewind_memory_limit{256, 16, 4096, "rewind_memory_limit"};
 
     // Video Dumping
     std::string output_format;
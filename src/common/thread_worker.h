@@ -0,0 +1,52 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Common {
+
+/// A fixed set of threads that execute queued work items in FIFO order
+class ThreadWorker final {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadWorker(std::size_t num_workers, const std::string& name);
+    ~ThreadWorker();
+
+    ThreadWorker(const ThreadWorker&) = delete;
+    ThreadWorker& operator=(const ThreadWorker&) = delete;
+
+    /// Queues a work item to be executed by one of the workers
+    void QueueWork(Task work);
+
+    /// Blocks until every queued work item has finished executing
+    void WaitForRequests();
+
+    /// Returns the number of worker threads
+    [[nodiscard]] std::size_t NumWorkers() const {
+        return threads.size();
+    }
+
+private:
+    void WorkerLoop(std::string thread_name);
+
+    std::vector<std::thread> threads;
+    std::queue<Task> requests;
+    std::mutex queue_mutex;
+    std::condition_variable work_cv;
+    std::condition_variable wait_cv;
+    std::size_t work_remaining = 0;
+    bool stop = false;
+};
+
+} // namespace Common
@@ -0,0 +1,69 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace Common {
+
+/// Allocates zero-filled memory directly from the host, aligned to the host page size
+void* AllocateMemoryPages(std::size_t size);
+
+/// Returns memory obtained from AllocateMemoryPages to the host
+void FreeMemoryPages(void* base, std::size_t size) noexcept;
+
+/// Returns the size of a host memory page in bytes
+std::size_t GetHostPageSize();
+
+/**
+ * A buffer backed by whole host memory pages. Unlike a heap allocation it starts at a page
+ * boundary, so its pages can be protected individually, and untouched pages take no memory.
+ */
+template <typename T>
+class VirtualBuffer final {
+public:
+    VirtualBuffer() = default;
+
+    explicit VirtualBuffer(std::size_t count) : alloc_size{count * sizeof(T)} {
+        base_ptr = static_cast<T*>(AllocateMemoryPages(alloc_size));
+    }
+
+    ~VirtualBuffer() {
+        FreeMemoryPages(base_ptr, alloc_size);
+    }
+
+    VirtualBuffer(const VirtualBuffer&) = delete;
+    VirtualBuffer& operator=(const VirtualBuffer&) = delete;
+
+    VirtualBuffer(VirtualBuffer&& other) noexcept
+        : alloc_size{std::exchange(other.alloc_size, 0)},
+          base_ptr{std::exchange(other.base_ptr, nullptr)} {}
+
+    VirtualBuffer& operator=(VirtualBuffer&& other) noexcept {
+        FreeMemoryPages(base_ptr, alloc_size);
+        alloc_size = std::exchange(other.alloc_size, 0);
+        base_ptr = std::exchange(other.base_ptr, nullptr);
+        return *this;
+    }
+
+    T* data() {
+        return base_ptr;
+    }
+
+    const T* data() const {
+        return base_ptr;
+    }
+
+    std::size_t size() const {
+        return alloc_size / sizeof(T);
+    }
+
+private:
+    std::size_t alloc_size = 0;
+    T* base_ptr = nullptr;
+};
+
+} // namespace Common
@@ -0,0 +1,275 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <csignal>
+#include <sys/mman.h>
+#endif
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <optional>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/virtual_buffer.h"
+#include "common/write_watch.h"
+
+namespace Common {
+
+namespace {
+
+/// Watches that the fault handler looks faulting addresses up in
+std::array<std::atomic<WriteWatch*>, 4> g_watches{};
+
+std::once_flag g_handler_installed;
+
+#ifndef _WIN32
+struct sigaction g_old_segv_action;
+struct sigaction g_old_bus_action;
+#endif
+
+} // Anonymous namespace
+
+bool HandleWriteFault(std::uintptr_t address) {
+    for (const auto& watch : g_watches) {
+        WriteWatch* const instance = watch.load(std::memory_order_acquire);
+        if (instance && instance->HandleFault(address)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+
+#ifdef _WIN32
+LONG WINAPI ExceptionHandler(PEXCEPTION_POINTERS pointers) {
+    const EXCEPTION_RECORD* record = pointers->ExceptionRecord;
+    if (record->ExceptionCode != EXCEPTION_ACCESS_VIOLATION || record->NumberParameters < 2 ||
+        record->ExceptionInformation[0] != 1) {
+        return EXCEPTION_CONTINUE_SEARCH;
+    }
+    if (!HandleWriteFault(static_cast<std::uintptr_t>(record->ExceptionInformation[1]))) {
+        return EXCEPTION_CONTINUE_SEARCH;
+    }
+    return EXCEPTION_CONTINUE_EXECUTION;
+}
+
+void InstallFaultHandler() {
+    AddVectoredExceptionHandler(1, ExceptionHandler);
+}
+#else
+void SignalHandler(int sig, siginfo_t* info, void* context) {
+    if (HandleWriteFault(reinterpret_cast<std::uintptr_t>(info->si_addr))) {
+        return;
+    }
+
+    // Not one of ours, hand it to whoever was installed before
+    const struct sigaction& old_action = sig == SIGSEGV ? g_old_segv_action : g_old_bus_action;
+    if (old_action.sa_flags & SA_SIGINFO) {
+        old_action.sa_sigaction(sig, info, context);
+    } else if (old_action.sa_handler == SIG_DFL || old_action.sa_handler == SIG_IGN) {
+        // Restore the default action, the faulting instruction will raise the signal again
+        sigaction(sig, &old_action, nullptr);
+    } else {
+        old_action.sa_handler(sig);
+    }
+}
+
+void InstallFaultHandler() {
+    struct sigaction action {};
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESTART;
+    action.sa_sigaction = SignalHandler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &g_old_segv_action);
+    // Write faults on read-only pages raise SIGBUS on some hosts
+    sigaction(SIGBUS, &action, &g_old_bus_action);
+}
+#endif
+
+} // Anonymous namespace
+
+WriteWatch::WriteWatch(u8* base_, std::size_t size_)
+    : base{base_}, size{size_}, page_size{GetHostPageSize()},
+      num_pages{(size_ + page_size - 1) / page_size}, watch_counts(num_pages),
+      suspend_counts(num_pages), protected_pages(num_pages),
+      written_bits{std::make_unique<std::atomic<u64>[]>((num_pages + 63) / 64)} {
+    ASSERT_MSG(reinterpret_cast<std::uintptr_t>(base) % page_size == 0,
+               "Watched memory is not page aligned");
+
+    std::call_once(g_handler_installed, InstallFaultHandler);
+    for (auto& watch : g_watches) {
+        WriteWatch* expected = nullptr;
+        if (watch.compare_exchange_strong(expected, this)) {
+            return;
+        }
+    }
+    UNREACHABLE_MSG("Too many write watches");
+}
+
+WriteWatch::~WriteWatch() {
+    SetProtection(0, num_pages, false);
+    for (auto& watch : g_watches) {
+        WriteWatch* expected = this;
+        watch.compare_exchange_strong(expected, nullptr);
+    }
+}
+
+bool WriteWatch::IsSupported() {
+#if defined(_WIN32) || defined(__unix__) || defined(__APPLE__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void WriteWatch::Watch(std::size_t offset, std::size_t range_size, bool watch) {
+    std::scoped_lock lock{mutex};
+    AdjustCount(watch_counts, offset, range_size, watch);
+}
+
+void WriteWatch::Suspend(std::size_t offset, std::size_t range_size, bool suspend) {
+    std::scoped_lock lock{mutex};
+    AdjustCount(suspend_counts, offset, range_size, suspend);
+}
+
+bool WriteWatch::IsWatched(std::size_t offset) const {
+    std::scoped_lock lock{mutex};
+    return watch_counts[offset / page_size] != 0;
+}
+
+void WriteWatch::MarkWritten(std::size_t offset, std::size_t range_size) {
+    if (range_size == 0) {
+        return;
+    }
+    std::scoped_lock lock{mutex};
+    const std::size_t last_page = (offset + range_size - 1) / page_size;
+    ASSERT(last_page < num_pages);
+    for (std::size_t page = offset / page_size; page <= last_page; page++) {
+        if (protected_pages[page]) {
+            RecordWrite(page);
+        }
+    }
+}
+
+WriteWatch::WrittenRanges WriteWatch::ConsumeWrites() {
+    WrittenRanges ranges;
+    if (!has_writes.exchange(false, std::memory_order_acq_rel)) {
+        return ranges;
+    }
+
+    std::scoped_lock lock{mutex};
+    for (std::size_t word = 0; word < (num_pages + 63) / 64; word++) {
+        u64 bits = written_bits[word].exchange(0, std::memory_order_acq_rel);
+        while (bits != 0) {
+            const std::size_t page = word * 64 + std::countr_zero(bits);
+            bits &= bits - 1;
+
+            // The fault handler made the page writable, protect it again before reporting it so
+            // that writes made after this point are caught
+            protected_pages[page] = false;
+            if (WantsProtection(page)) {
+                SetProtection(page, 1, true);
+            }
+
+            if (!ranges.empty() && ranges.back().first + ranges.back().second == page * page_size) {
+                ranges.back().second += page_size;
+            } else {
+                ranges.emplace_back(page * page_size, page_size);
+            }
+        }
+    }
+    return ranges;
+}
+
+bool WriteWatch::HandleFault(std::uintptr_t address) {
+    const auto start = reinterpret_cast<std::uintptr_t>(base);
+    if (address < start || address >= start + size) {
+        return false;
+    }
+
+    // Only pages protected by this watch can fault, the rest of the block is always writable.
+    // The protection state is not updated here as the handler may run concurrently with the
+    // methods above, ConsumeWrites takes care of it.
+    RecordWrite((address - start) / page_size);
+    return true;
+}
+
+void WriteWatch::RecordWrite(std::size_t page) {
+#ifdef _WIN32
+    DWORD old_protect;
+    VirtualProtect(base + page * page_size, page_size, PAGE_READWRITE, &old_protect);
+#else
+    mprotect(base + page * page_size, page_size, PROT_READ | PROT_WRITE);
+#endif
+    written_bits[page / 64].fetch_or(u64{1} << (page % 64), std::memory_order_acq_rel);
+    has_writes.store(true, std::memory_order_release);
+}
+
+void WriteWatch::AdjustCount(std::vector<u16>& counts, std::size_t offset, std::size_t range_size,
+                             bool add) {
+    if (range_size == 0) {
+        return;
+    }
+    const std::size_t first_page = offset / page_size;
+    const std::size_t last_page = (offset + range_size - 1) / page_size;
+    ASSERT(last_page < num_pages);
+
+    std::size_t run_start = first_page;
+    std::size_t run_pages = 0;
+    std::optional<bool> run_protect;
+    for (std::size_t page = first_page; page <= last_page; page++) {
+        if (add) {
+            counts[page]++;
+        } else {
+            ASSERT(counts[page] > 0);
+            counts[page]--;
+        }
+
+        // Batch consecutive pages that change to the same protection into one call
+        const bool protect = WantsProtection(page);
+        const bool changed = protected_pages[page] != protect;
+        if (!changed || (run_protect && *run_protect != protect)) {
+            if (run_pages != 0) {
+                SetProtection(run_start, run_pages, *run_protect);
+                run_pages = 0;
+            }
+        }
+        if (changed) {
+            run_start = run_pages == 0 ? page : run_start;
+            run_protect = protect;
+            run_pages++;
+        }
+    }
+    if (run_pages != 0) {
+        SetProtection(run_start, run_pages, *run_protect);
+    }
+}
+
+bool WriteWatch::WantsProtection(std::size_t page) const {
+    return watch_counts[page] != 0 && suspend_counts[page] == 0;
+}
+
+void WriteWatch::SetProtection(std::size_t first_page, std::size_t count, bool read_only) {
+    for (std::size_t page = first_page; page < first_page + count; page++) {
+        protected_pages[page] = read_only;
+    }
+    u8* const address = base + first_page * page_size;
+    const std::size_t length = count * page_size;
+#ifdef _WIN32
+    DWORD old_protect;
+    if (!VirtualProtect(address, length, read_only ? PAGE_READONLY : PAGE_READWRITE,
+                        &old_protect)) {
+        LOG_ERROR(Common_Memory, "VirtualProtect failed with error {}", GetLastError());
+    }
+#else
+    if (mprotect(address, length, read_only ? PROT_READ : PROT_READ | PROT_WRITE) != 0) {
+        LOG_ERROR(Common_Memory, "mprotect failed with errno {}", errno);
+    }
+#endif
+}
+
+} // namespace Common
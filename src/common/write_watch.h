@@ -0,0 +1,86 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Detects writes to a block of host memory with the host MMU. Watched pages are made read-only,
+ * the first write to one of them faults, and the fault handler makes the page writable again and
+ * records it as written. Reads and further writes run at full speed until the written pages are
+ * consumed and protected again.
+ */
+class WriteWatch {
+public:
+    /// Ranges of written memory, as offsets and sizes in bytes
+    using WrittenRanges = std::vector<std::pair<std::size_t, std::size_t>>;
+
+    /// Watches the memory at base, which must be aligned to the host page size
+    WriteWatch(u8* base, std::size_t size);
+    ~WriteWatch();
+
+    WriteWatch(const WriteWatch&) = delete;
+    WriteWatch& operator=(const WriteWatch&) = delete;
+
+    /// Returns true if write faults can be caught on this host
+    static bool IsSupported();
+
+    /// Starts or stops watching the pages overlapping the range. Calls are reference counted.
+    void Watch(std::size_t offset, std::size_t size, bool watch);
+
+    /**
+     * Suspends or resumes watching the pages overlapping the range. Suspended pages stay writable
+     * while they are watched. Calls are reference counted.
+     */
+    void Suspend(std::size_t offset, std::size_t size, bool suspend);
+
+    /// Returns true if the page containing the offset is watched, even if suspended
+    bool IsWatched(std::size_t offset) const;
+
+    /**
+     * Records the protected pages overlapping the range as written and makes them writable, like
+     * the fault handler does. Used ahead of writes that do not fault, such as the host kernel
+     * writing into the memory on behalf of a system call.
+     */
+    void MarkWritten(std::size_t offset, std::size_t size);
+
+    /// Returns the ranges written since the last call and protects the watched ones again
+    WrittenRanges ConsumeWrites();
+
+private:
+    bool HandleFault(std::uintptr_t address);
+    void RecordWrite(std::size_t page);
+
+    void AdjustCount(std::vector<u16>& counts, std::size_t offset, std::size_t size, bool add);
+    bool WantsProtection(std::size_t page) const;
+    void SetProtection(std::size_t first_page, std::size_t num_pages, bool read_only);
+
+    friend bool HandleWriteFault(std::uintptr_t address);
+
+    u8* base;
+    std::size_t size;
+    std::size_t page_size;
+    std::size_t num_pages;
+
+    mutable std::mutex mutex;
+    std::vector<u16> watch_counts;
+    std::vector<u16> suspend_counts;
+    std::vector<bool> protected_pages;
+
+    // Set by the fault handler, which may run on any thread
+    std::unique_ptr<std::atomic<u64>[]> written_bits;
+    std::atomic_bool has_writes{false};
+};
+
+} // namespace Common
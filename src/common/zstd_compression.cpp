@@ -6,6 +6,8 @@
 #include <zstd.h>
 
 #include "common/assert.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
 #include "common/zstd_compression.h"
 
 namespace Common::Compression {
@@ -48,4 +50,146 @@ std::vector<u8> DecompressDataZSTD(const std::vector<u8>& compressed) {
     return decompressed;
 }
 
+/// Size of the uncompressed data handed to the compressor at once. Large enough for the
+/// background workers to each get a job of their own.
+constexpr std::size_t STREAM_CHUNK_SIZE = 4 * 1024 * 1024;
+
+ZSTDCompressStreamBuffer::ZSTDCompressStreamBuffer(FileUtil::IOFile& file, s32 compression_level,
+                                                   u32 num_workers)
+    : file{file}, context{ZSTD_createCCtx()}, input(STREAM_CHUNK_SIZE),
+      output(ZSTD_CStreamOutSize()) {
+    compression_level = std::clamp(compression_level, ZSTD_minCLevel(), ZSTD_maxCLevel());
+    ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, compression_level);
+    // Lets ValidateZSTDStream and the decompressor detect corrupted data
+    ZSTD_CCtx_setParameter(context, ZSTD_c_checksumFlag, 1);
+    if (num_workers > 0 &&
+        ZSTD_isError(ZSTD_CCtx_setParameter(context, ZSTD_c_nbWorkers, num_workers))) {
+        LOG_WARNING(Common, "Multithreaded compression is not supported, using a single thread");
+    }
+    setp(input.data(), input.data() + input.size());
+}
+
+ZSTDCompressStreamBuffer::~ZSTDCompressStreamBuffer() {
+    ZSTD_freeCCtx(context);
+}
+
+bool ZSTDCompressStreamBuffer::Finish() {
+    return Compress(true) && !failed;
+}
+
+ZSTDCompressStreamBuffer::int_type ZSTDCompressStreamBuffer::overflow(int_type ch) {
+    if (!Compress(false)) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+bool ZSTDCompressStreamBuffer::Compress(bool end_frame) {
+    if (failed) {
+        return false;
+    }
+
+    const ZSTD_EndDirective directive = end_frame ? ZSTD_e_end : ZSTD_e_continue;
+    ZSTD_inBuffer in{pbase(), static_cast<std::size_t>(pptr() - pbase()), 0};
+    bool done;
+    do {
+        ZSTD_outBuffer out{output.data(), output.size(), 0};
+        const std::size_t remaining = ZSTD_compressStream2(context, &out, &in, directive);
+        if (ZSTD_isError(remaining) || file.WriteBytes(output.data(), out.pos) != out.pos) {
+            failed = true;
+            return false;
+        }
+        done = end_frame ? remaining == 0 : in.pos == in.size;
+    } while (!done);
+
+    setp(input.data(), input.data() + input.size());
+    return true;
+}
+
+bool ValidateZSTDStream(FileUtil::IOFile& file) {
+    const u64 start = file.Tell();
+    ZSTD_DCtx* context = ZSTD_createDCtx();
+    std::vector<u8> input(ZSTD_DStreamInSize());
+    std::vector<u8> output(ZSTD_DStreamOutSize());
+
+    // Stays non-zero while a frame is incomplete, and starts out that way for empty files
+    std::size_t remaining = 1;
+    bool valid = true;
+    while (valid) {
+        const std::size_t input_size = file.ReadBytes(input.data(), input.size());
+        if (input_size == 0) {
+            break;
+        }
+
+        ZSTD_inBuffer in{input.data(), input_size, 0};
+        while (in.pos < in.size) {
+            ZSTD_outBuffer out{output.data(), output.size(), 0};
+            remaining = ZSTD_decompressStream(context, &out, &in);
+            if (ZSTD_isError(remaining)) {
+                LOG_ERROR(Common, "Zstandard data is corrupted: {}", ZSTD_getErrorName(remaining));
+                valid = false;
+                break;
+            }
+        }
+    }
+
+    // The decompressor may still hold data of the last frame
+    while (valid && remaining != 0) {
+        ZSTD_inBuffer in{nullptr, 0, 0};
+        ZSTD_outBuffer out{output.data(), output.size(), 0};
+        remaining = ZSTD_decompressStream(context, &out, &in);
+        if (ZSTD_isError(remaining) || out.pos == 0) {
+            LOG_ERROR(Common, "Zstandard data is truncated");
+            valid = false;
+        }
+    }
+
+    ZSTD_freeDCtx(context);
+    file.Seek(static_cast<s64>(start), SEEK_SET);
+    return valid;
+}
+
+ZSTDDecompressStreamBuffer::ZSTDDecompressStreamBuffer(FileUtil::IOFile& file)
+    : file{file}, context{ZSTD_createDCtx()}, input(ZSTD_DStreamInSize()),
+      output(ZSTD_DStreamOutSize()) {}
+
+ZSTDDecompressStreamBuffer::~ZSTDDecompressStreamBuffer() {
+    ZSTD_freeDCtx(context);
+}
+
+ZSTDDecompressStreamBuffer::int_type ZSTDDecompressStreamBuffer::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    while (true) {
+        if (input_pos == input_size) {
+            input_size = file.ReadBytes(input.data(), input.size());
+            input_pos = 0;
+        }
+
+        ZSTD_inBuffer in{input.data(), input_size, input_pos};
+        ZSTD_outBuffer out{output.data(), output.size(), 0};
+        const std::size_t result = ZSTD_decompressStream(context, &out, &in);
+        if (ZSTD_isError(result)) {
+            LOG_ERROR(Common, "Zstandard decompression failed: {}", ZSTD_getErrorName(result));
+            return traits_type::eof();
+        }
+        input_pos = in.pos;
+
+        if (out.pos > 0) {
+            setg(output.data(), output.data(), output.data() + out.pos);
+            return traits_type::to_int_type(*gptr());
+        }
+        if (input_size == 0) {
+            // End of file, and the decompressor has nothing left to flush
+            return traits_type::eof();
+        }
+    }
+}
+
 } // namespace Common::Compression
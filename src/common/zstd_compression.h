@@ -4,10 +4,18 @@
 
 #pragma once
 
+#include <streambuf>
 #include <vector>
 
 #include "common/common_types.h"
 
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+namespace FileUtil {
+class IOFile;
+}
+
 namespace Common::Compression {
 
 /**
@@ -42,4 +50,72 @@ namespace Common::Compression {
  */
 [[nodiscard]] std::vector<u8> DecompressDataZSTD(const std::vector<u8>& compressed);
 
+/**
+ * Stream buffer which compresses the data written to it with Zstandard and writes the compressed
+ * data to a file as it is produced, so the uncompressed data never has to be held in memory as a
+ * whole. Finish must be called once all data was written.
+ */
+class ZSTDCompressStreamBuffer final : public std::streambuf {
+public:
+    /**
+     * @param file the file to append the compressed data to.
+     * @param compression_level the used compression level. Should be between 1 and 22.
+     * @param num_workers the number of threads compressing in the background. With 0, the data is
+     *                    compressed on the writing thread.
+     */
+    ZSTDCompressStreamBuffer(FileUtil::IOFile& file, s32 compression_level, u32 num_workers);
+    ~ZSTDCompressStreamBuffer() override;
+
+    /**
+     * Compresses the remaining data and ends the Zstandard frame.
+     *
+     * @return false if compressing or writing any of the data failed.
+     */
+    [[nodiscard]] bool Finish();
+
+protected:
+    int_type overflow(int_type ch) override;
+
+private:
+    bool Compress(bool end_frame);
+
+    FileUtil::IOFile& file;
+    ZSTD_CCtx_s* context;
+    std::vector<char> input;
+    std::vector<u8> output;
+    bool failed = false;
+};
+
+/**
+ * Checks that a file holds complete and intact Zstandard frames by decompressing them without
+ * keeping the output. The file position is restored afterwards.
+ *
+ * @param file the file to check, starting at its current position.
+ *
+ * @return false if the compressed data is truncated or corrupted.
+ */
+[[nodiscard]] bool ValidateZSTDStream(FileUtil::IOFile& file);
+
+/**
+ * Stream buffer which reads a Zstandard compressed file and provides the decompressed data
+ * piece by piece as it is consumed.
+ */
+class ZSTDDecompressStreamBuffer final : public std::streambuf {
+public:
+    /// @param file the file to read the compressed data from, starting at its current position.
+    explicit ZSTDDecompressStreamBuffer(FileUtil::IOFile& file);
+    ~ZSTDDecompressStreamBuffer() override;
+
+protected:
+    int_type underflow() override;
+
+private:
+    FileUtil::IOFile& file;
+    ZSTD_DCtx_s* context;
+    std::vector<u8> input;
+    std::size_t input_pos = 0;
+    std::size_t input_size = 0;
+    std::vector<char> output;
+};
+
 } // namespace Common::Compression
@@ -16,6 +16,7 @@
 #include "core/core_timing.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/svc.h"
+#include "core/hle/lock.h"
 #include "core/memory.h"
 
 class DynarmicThreadContext final : public ARM_Interface::ThreadContext {
@@ -78,41 +79,53 @@ public:
     ~DynarmicUserCallbacks() = default;
 
     std::uint8_t MemoryRead8(VAddr vaddr) override {
+        const auto lock = EnterEmulator();
         return memory.Read8(vaddr);
     }
     std::uint16_t MemoryRead16(VAddr vaddr) override {
+        const auto lock = EnterEmulator();
         return memory.Read16(vaddr);
     }
     std::uint32_t MemoryRead32(VAddr vaddr) override {
+        const auto lock = EnterEmulator();
         return memory.Read32(vaddr);
     }
     std::uint64_t MemoryRead64(VAddr vaddr) override {
+        const auto lock = EnterEmulator();
         return memory.Read64(vaddr);
     }
 
     void MemoryWrite8(VAddr vaddr, std::uint8_t value) override {
+        const auto lock = EnterEmulator();
         memory.Write8(vaddr, value);
     }
     void MemoryWrite16(VAddr vaddr, std::uint16_t value) override {
+        const auto lock = EnterEmulator();
         memory.Write16(vaddr, value);
     }
     void MemoryWrite32(VAddr vaddr, std::uint32_t value) override {
+        const auto lock = EnterEmulator();
         memory.Write32(vaddr, value);
     }
     void MemoryWrite64(VAddr vaddr, std::uint64_t value) override {
+        const auto lock = EnterEmulator();
         memory.Write64(vaddr, value);
     }
 
     bool MemoryWriteExclusive8(u32 vaddr, u8 value, u8 expected) override {
+        const auto lock = EnterEmulator();
         return memory.WriteExclusive8(vaddr, value, expected);
     }
     bool MemoryWriteExclusive16(u32 vaddr, u16 value, u16 expected) override {
+        const auto lock = EnterEmulator();
         return memory.WriteExclusive16(vaddr, value, expected);
     }
     bool MemoryWriteExclusive32(u32 vaddr, u32 value, u32 expected) override {
+        const auto lock = EnterEmulator();
         return memory.WriteExclusive32(vaddr, value, expected);
     }
     bool MemoryWriteExclusive64(u32 vaddr, u64 value, u64 expected) override {
+        const auto lock = EnterEmulator();
         return memory.WriteExclusive64(vaddr, value, expected);
     }
 
@@ -123,6 +136,7 @@ public:
     }
 
     void CallSVC(std::uint32_t swi) override {
+        const auto lock = EnterEmulator();
         svc_context.CallSVC(swi);
     }
 
@@ -166,6 +180,19 @@ public:
         return Core::TicksForInstruction(is_thumb, instruction);
     }
 
+    /**
+     * While the cores run in parallel, serializes a call into the emulator and makes this core the
+     * running one for it. Otherwise this core already is, and nothing else runs.
+     */
+    std::unique_lock<std::recursive_mutex> EnterEmulator() {
+        if (!parent.system.IsRunningCoresInParallel()) {
+            return {};
+        }
+        std::unique_lock lock{HLE::g_hle_lock};
+        parent.system.SetRunningCore(parent);
+        return lock;
+    }
+
     ARM_Dynarmic& parent;
     Kernel::SVCContext svc_context;
     Memory::MemorySystem& memory;
@@ -185,7 +212,10 @@ ARM_Dynarmic::~ARM_Dynarmic() = default;
 MICROPROFILE_DEFINE(ARM_Jit, "ARM JIT", "ARM JIT", MP_RGB(255, 64, 64));
 
 void ARM_Dynarmic::Run() {
-    ASSERT(memory.GetCurrentPageTable() == current_page_table);
+    // The current page table follows whichever core last called into the emulator when they run
+    // in parallel
+    ASSERT(system.IsRunningCoresInParallel() ||
+           memory.GetCurrentPageTable() == current_page_table);
     MICROPROFILE_SCOPE(ARM_Jit);
 
     jit->Run();
@@ -328,6 +358,9 @@ std::shared_ptr<Memory::PageTable> ARM_Dynarmic::GetPageTable() const {
 }
 
 void ARM_Dynarmic::SetPageTable(const std::shared_ptr<Memory::PageTable>& page_table) {
+    if (jit && page_table == current_page_table) {
+        return;
+    }
     current_page_table = page_table;
     Dynarmic::A32::Context ctx{};
     if (jit) {
@@ -357,7 +390,15 @@ void ARM_Dynarmic::ServeBreak() {
 std::unique_ptr<Dynarmic::A32::Jit> ARM_Dynarmic::MakeJit() {
     Dynarmic::A32::UserConfig config;
     config.callbacks = cb.get();
-    config.page_table = &current_page_table->GetPointerArray();
+    // With fastmem guest memory is accessed directly through the host mapping of the address
+    // space. An access that faults, because it targets MMIO or rasterizer-cached memory, has its
+    // block recompiled to go through the memory callbacks, which handle those pages.
+    if (u8* fastmem_arena = memory.GetFastmemArena(*current_page_table)) {
+        config.fastmem_pointer = fastmem_arena;
+        config.recompile_on_fastmem_failure = true;
+    } else {
+        config.page_table = &current_page_table->GetPointerArray();
+    }
     config.coprocessors[15] = std::make_shared<DynarmicCP15>(cp15_state);
     config.define_unpredictable_behaviour = true;
 
@@ -0,0 +1,42 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/arm/arm_interface.h"
+#include "core/arm/idle_loop_detector.h"
+#include "core/core_timing.h"
+
+namespace Core {
+
+void IdleLoopDetector::Run(ARM_Interface& core) {
+    if (IsPolling()) {
+        core.GetTimer().IdleAfter(PROBE_TICKS);
+    }
+    core.Run();
+    Sample(core);
+}
+
+void IdleLoopDetector::Sample(const ARM_Interface& core) {
+    // A core stopped before the end of its slice is about to reschedule, so it is not polling
+    if (core.GetTimer().GetDowncount() > 0) {
+        matching_samples = 0;
+        return;
+    }
+
+    bool matches = true;
+    const auto compare = [&matches](u32& sample, u32 value) {
+        matches &= sample == value;
+        sample = value;
+    };
+    for (std::size_t i = 0; i < regs.size(); ++i) {
+        compare(regs[i], core.GetReg(static_cast<int>(i)));
+    }
+    compare(cpsr, core.GetCPSR());
+    for (std::size_t i = 0; i < vfp_regs.size(); ++i) {
+        compare(vfp_regs[i], core.GetVFPReg(static_cast<int>(i)));
+    }
+    compare(fpscr, core.GetVFPSystemReg(VFP_FPSCR));
+    matching_samples = matches ? matching_samples + 1 : 0;
+}
+
+} // namespace Core
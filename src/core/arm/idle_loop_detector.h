@@ -0,0 +1,45 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "common/common_types.h"
+
+class ARM_Interface;
+
+namespace Core {
+
+/**
+ * Detects a core spinning in a loop that polls memory, for instance a HID or GSP shared memory
+ * block, by sampling its registers at the end of every time slice. Such a loop leaves them the
+ * same each time it is sampled, whereas a loop that makes progress changes them, possibly only the
+ * floating point ones. The PC is left out, as the slices end at arbitrary points of the loop.
+ */
+class IdleLoopDetector {
+public:
+    /// Ticks a polling core still executes of each slice, so that it notices when memory changes
+    static constexpr s64 PROBE_TICKS = 1000;
+
+    /// Number of samples in a row matching the previous one after which the core is polling
+    static constexpr u32 POLLING_THRESHOLD = 2;
+
+    /// Runs the slice of the core, only probing it if it is polling
+    void Run(ARM_Interface& core);
+
+    [[nodiscard]] bool IsPolling() const {
+        return matching_samples >= POLLING_THRESHOLD;
+    }
+
+private:
+    void Sample(const ARM_Interface& core);
+
+    std::array<u32, 15> regs{};
+    u32 cpsr{};
+    std::array<u32, 64> vfp_regs{};
+    u32 fpscr{};
+    u32 matching_samples{};
+};
+
+} // namespace Core
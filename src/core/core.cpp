@@ -3,9 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <fstream>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <utility>
+#include <boost/container/static_vector.hpp>
 #include <boost/serialization/array.hpp>
 #include "audio_core/dsp_interface.h"
 #include "audio_core/hle/hle.h"
@@ -13,8 +15,10 @@
 #include "common/arch.h"
 #include "common/logging/log.h"
 #include "common/texture.h"
+#include "common/thread_worker.h"
 #include "core/arm/arm_interface.h"
 #include "core/arm/exclusive_monitor.h"
+#include "core/arm/idle_loop_detector.h"
 #if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #endif
@@ -46,6 +50,7 @@
 #include "core/hw/lcd.h"
 #include "core/loader/loader.h"
 #include "core/movie.h"
+#include "core/rewind.h"
 #include "core/rpc/rpc_server.h"
 #include "network/network.h"
 #include "video_core/renderer_base.h"
@@ -125,6 +130,29 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         frame_limiter.WaitOnce();
         return ResultStatus::Success;
     }
+    case Signal::Snapshot: {
+        try {
+            rewind_buffer->Capture();
+        } catch (const std::exception& e) {
+            LOG_ERROR(Core, "Error taking snapshot: {}", e.what());
+        }
+        return ResultStatus::Success;
+    }
+    case Signal::Rewind: {
+        // param is the number of frames to go back
+        try {
+            if (!rewind_buffer->Rewind(param)) {
+                LOG_ERROR(Core, "Cannot rewind {} frames", param);
+                return ResultStatus::Success;
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR(Core, "Error loading snapshot: {}", e.what());
+            status_details = e.what();
+            return ResultStatus::ErrorSavestate;
+        }
+        frame_limiter.WaitOnce();
+        return ResultStatus::Success;
+    }
     case Signal::Save: {
         LOG_INFO(Core, "Begin save");
         try {
@@ -142,6 +170,11 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         break;
     }
 
+    // The GPU thread leaves the page tables to the emulation thread, which updates them while
+    // no core is running
+    memory->ApplyRasterizerMarks();
+    rewind_buffer->Update();
+
     // All cores should have executed the same amount of ticks. If this is not the case an event was
     // scheduled with a cycles_into_future smaller then the current downcount.
     // So we have to get those cores to the same global time first
@@ -189,36 +222,48 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
     } else {
         // Now all cores are at the same global time. So we will run them one after the other
         // with a max slice that is the minimum of all max slices of all cores
-        // TODO: Make special check for idle since we can easily revert the time of idle cores
-        s64 max_slice = Timing::MAX_SLICE_LENGTH;
+        s64 max_slice = std::numeric_limits<s64>::max();
+        bool all_cores_waiting = true;
         for (const auto& cpu_core : cpu_cores) {
             kernel->SetRunningCPU(cpu_core.get());
             cpu_core->GetTimer().Advance();
             cpu_core->PrepareReschedule();
             kernel->GetThreadManager(cpu_core->GetID()).Reschedule();
             max_slice = std::min(max_slice, cpu_core->GetTimer().GetMaxSliceLength());
+            all_cores_waiting &=
+                kernel->GetThreadManager(cpu_core->GetID()).GetCurrentThread() == nullptr ||
+                idle_loop_detectors[cpu_core->GetID()].IsPolling();
         }
-        for (auto& cpu_core : cpu_cores) {
-            cpu_core->GetTimer().SetNextSlice(max_slice);
-            auto start_ticks = cpu_core->GetTimer().GetTicks();
-            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
-                      cpu_core->GetTimer().GetDowncount());
-            running_core = cpu_core.get();
-            kernel->SetRunningCPU(running_core);
-            // If we don't have a currently active thread then don't execute instructions,
-            // instead advance to the next event and try to yield to the next thread
-            if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
-                LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
-                cpu_core->GetTimer().Idle();
-                PrepareReschedule();
-            } else {
-                if (tight_loop) {
-                    cpu_core->Run();
+        // When every core is idle or polling memory nothing happens until the next event, so
+        // skip straight to it, up to a second away, instead of stepping there in slices
+        const bool skip_to_event = all_cores_waiting && Settings::values.skip_idle_loops;
+        max_slice = std::min<s64>(max_slice, skip_to_event ? BASE_CLOCK_RATE_ARM11
+                                                           : Timing::MAX_SLICE_LENGTH);
+        if (tight_loop && CanRunCoresInParallel()) {
+            RunCoresInParallel(max_slice);
+        } else {
+            for (auto& cpu_core : cpu_cores) {
+                cpu_core->GetTimer().SetNextSlice(max_slice);
+                auto start_ticks = cpu_core->GetTimer().GetTicks();
+                LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                          cpu_core->GetTimer().GetDowncount());
+                running_core = cpu_core.get();
+                kernel->SetRunningCPU(running_core);
+                // If we don't have a currently active thread then don't execute instructions,
+                // instead advance to the next event and try to yield to the next thread
+                if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                    LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                    cpu_core->GetTimer().Idle();
+                    PrepareReschedule();
                 } else {
-                    cpu_core->Step();
+                    if (tight_loop) {
+                        RunCore(*cpu_core);
+                    } else {
+                        cpu_core->Step();
+                    }
                 }
+                max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
             }
-            max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
         }
     }
 
@@ -232,6 +277,74 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
     return status;
 }
 
+bool System::RequiresDeterminism() const {
+    const auto play_mode = Movie::GetInstance().GetPlayMode();
+    const bool movie_active =
+        play_mode == Movie::PlayMode::Recording || play_mode == Movie::PlayMode::Playing;
+    const bool rewind_active =
+        Settings::values.rewind_enabled.GetValue() || rewind_buffer->IsReplaying();
+    return movie_active || rewind_active;
+}
+
+bool System::CanRunCoresInParallel() const {
+    // The order in which parallel cores access shared memory depends on the host scheduler
+    return core_workers && !GDBStub::IsServerEnabled() && !RequiresDeterminism();
+}
+
+void System::RunCoresInParallel(s64 max_slice) {
+    // Idle cores only advance their timer, which is done here so that the kernel is left alone
+    // while the other cores execute
+    boost::container::static_vector<ARM_Interface*, 4> active_cores;
+    for (auto& cpu_core : cpu_cores) {
+        cpu_core->GetTimer().SetNextSlice(max_slice);
+        LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                  cpu_core->GetTimer().GetDowncount());
+        running_core = cpu_core.get();
+        kernel->SetRunningCPU(running_core);
+        if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+            LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+            cpu_core->GetTimer().Idle();
+            PrepareReschedule();
+        } else {
+            active_cores.push_back(cpu_core.get());
+        }
+    }
+    if (active_cores.size() < 2) {
+        for (ARM_Interface* cpu_core : active_cores) {
+            running_core = cpu_core;
+            kernel->SetRunningCPU(running_core);
+            RunCore(*cpu_core);
+        }
+        return;
+    }
+
+    // Every core runs the same slice on its own host thread, so they are at most a slice apart
+    // when they meet again here. Whenever a core calls back into the emulator it takes the HLE
+    // lock and makes itself the running core, the kernel and services being single threaded.
+    cores_in_parallel = true;
+    for (std::size_t i = 1; i < active_cores.size(); ++i) {
+        core_workers->QueueWork([this, cpu_core = active_cores[i]] { RunCore(*cpu_core); });
+    }
+    RunCore(*active_cores[0]);
+    core_workers->WaitForRequests();
+    cores_in_parallel = false;
+}
+
+void System::RunCore(ARM_Interface& core) {
+    if (Settings::values.skip_idle_loops) {
+        idle_loop_detectors[core.GetID()].Run(core);
+    } else {
+        core.Run();
+    }
+}
+
+void System::SetRunningCore(ARM_Interface& core) {
+    if (running_core != &core) {
+        running_core = &core;
+        kernel->SetRunningCPU(running_core);
+    }
+}
+
 bool System::SendSignal(System::Signal signal, u32 param) {
     std::lock_guard lock{signal_mutex};
     if (current_signal != signal && current_signal != Signal::None) {
@@ -316,16 +429,17 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
                   static_cast<u32>(load_result));
     }
     perf_stats = std::make_unique<PerfStats>(title_id);
-    custom_tex_cache = std::make_unique<Core::CustomTexCache>();
+    rewind_buffer = std::make_unique<Core::RewindBuffer>(*this);
+    const u64 program_id = Kernel().GetCurrentProcess()->codeset->program_id;
+    custom_tex_cache = std::make_unique<Core::CustomTexCache>(GetImageInterface(), program_id);
 
     if (Settings::values.custom_textures) {
-        const u64 program_id = Kernel().GetCurrentProcess()->codeset->program_id;
         FileUtil::CreateFullPath(fmt::format(
             "{}textures/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::LoadDir), program_id));
-        custom_tex_cache->FindCustomTextures(program_id);
+        custom_tex_cache->FindCustomTextures();
     }
     if (Settings::values.preload_textures) {
-        custom_tex_cache->PreloadTextures(*GetImageInterface());
+        custom_tex_cache->PreloadTextures();
     }
 
     status = ResultStatus::Success;
@@ -395,6 +509,14 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window,
         }
     }
     running_core = cpu_cores[0].get();
+    idle_loop_detectors.assign(num_cores, {});
+
+    // The kernel is only reached from the JIT through its callbacks, which allows serializing it
+    if (Settings::values.parallel_cpu_cores && Settings::values.use_cpu_jit && num_cores > 1) {
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
+        core_workers = std::make_unique<Common::ThreadWorker>(num_cores - 1, "CPUCore");
+#endif
+    }
 
     kernel->SetCPUs(cpu_cores);
     kernel->SetRunningCPU(cpu_cores[0].get());
@@ -495,6 +617,14 @@ const Cheats::CheatEngine& System::CheatEngine() const {
     return *cheat_engine;
 }
 
+Core::RewindBuffer& System::RewindBuffer() {
+    return *rewind_buffer;
+}
+
+const Core::RewindBuffer& System::RewindBuffer() const {
+    return *rewind_buffer;
+}
+
 VideoDumper::Backend& System::VideoDumper() {
     return *video_dumper;
 }
@@ -541,6 +671,7 @@ void System::Shutdown(bool is_deserializing) {
     VideoCore::Shutdown();
     HW::Shutdown();
     if (!is_deserializing) {
+        rewind_buffer.reset();
         GDBStub::Shutdown();
         perf_stats.reset();
         cheat_engine.reset();
@@ -552,6 +683,7 @@ void System::Shutdown(bool is_deserializing) {
     service_manager.reset();
     dsp_core.reset();
     kernel.reset();
+    core_workers.reset();
     cpu_cores.clear();
     exclusive_monitor.reset();
     timing.reset();
@@ -626,6 +758,7 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
     // flush on save, don't flush on load
     bool should_flush = !Archive::is_loading::value;
     Memory::RasterizerClearAll(should_flush);
+    memory->ApplyRasterizerMarks();
     ar&* timing.get();
     for (u32 i = 0; i < num_cores; i++) {
         ar&* cpu_cores[i].get();
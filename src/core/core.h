@@ -8,8 +8,10 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 #include <boost/serialization/version.hpp>
 #include "common/common_types.h"
+#include "core/arm/idle_loop_detector.h"
 #include "core/custom_tex_cache.h"
 #include "core/frontend/applets/mii_selector.h"
 #include "core/frontend/applets/swkbd.h"
@@ -17,10 +19,15 @@
 #include "core/loader/loader.h"
 #include "core/memory.h"
 #include "core/perf_stats.h"
+#include "core/savestate.h"
 #include "core/telemetry_session.h"
 
 class ARM_Interface;
 
+namespace Common {
+class ThreadWorker;
+}
+
 namespace Frontend {
 class EmuWindow;
 }
@@ -65,6 +72,7 @@ class RendererBase;
 namespace Core {
 
 class ExclusiveMonitor;
+class RewindBuffer;
 class Timing;
 
 class System {
@@ -121,7 +129,7 @@ public:
     /// Shutdown and then load again
     void Reset();
 
-    enum class Signal : u32 { None, Shutdown, Reset, Save, Load };
+    enum class Signal : u32 { None, Shutdown, Reset, Save, Load, Snapshot, Rewind };
 
     bool SendSignal(Signal signal, u32 param = 0);
 
@@ -177,6 +185,20 @@ public:
         return *running_core;
     };
 
+    /**
+     * Makes the core the running one, which the kernel and services act on. Used by cores
+     * executing in parallel before they call into the emulator, with HLE::g_hle_lock held.
+     */
+    void SetRunningCore(ARM_Interface& core);
+
+    /// Returns true while the CPU cores are executing their slices on separate host threads
+    [[nodiscard]] bool IsRunningCoresInParallel() const {
+        return cores_in_parallel;
+    }
+
+    /// Returns true while a movie or rewind relies on emulation being replayed the same way
+    [[nodiscard]] bool RequiresDeterminism() const;
+
     /**
      * Gets a reference to the emulated CPU.
      * @param core_id The id of the core requested.
@@ -258,6 +280,12 @@ public:
     /// Gets a const reference to the custom texture cache system
     [[nodiscard]] const Core::CustomTexCache& CustomTexCache() const;
 
+    /// Gets a reference to the rewind buffer
+    [[nodiscard]] Core::RewindBuffer& RewindBuffer();
+
+    /// Gets a const reference to the rewind buffer
+    [[nodiscard]] const Core::RewindBuffer& RewindBuffer() const;
+
     /// Gets a reference to the video dumper backend
     [[nodiscard]] VideoDumper::Backend& VideoDumper();
 
@@ -308,6 +336,15 @@ public:
 
     void LoadState(u32 slot);
 
+    /**
+     * Captures the current state in host memory. RAM pages that are unchanged since `base` was
+     * taken are shared with it instead of being copied.
+     */
+    [[nodiscard]] std::shared_ptr<const Snapshot> CreateSnapshot(const Snapshot* base) const;
+
+    /// Restores a state captured with CreateSnapshot
+    void LoadSnapshot(const Snapshot& snapshot);
+
     /// Self delete ncch
     bool SetSelfDelete(const std::string& file) {
         if (m_filepath == file) {
@@ -332,6 +369,19 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /// Whether the cores may run in parallel, which is not the case when execution must be
+    /// deterministic
+    [[nodiscard]] bool CanRunCoresInParallel() const;
+
+    /// Runs the slice of every core with a thread to execute at the same time, on separate threads
+    void RunCoresInParallel(s64 max_slice);
+
+    /// Runs the slice of the core, skipping most of it when the core is polling memory
+    void RunCore(ARM_Interface& core);
+
+    /// Writes a save state of the current state to the file at path, replacing it
+    void WriteSaveState(const std::string& path) const;
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
@@ -339,6 +389,13 @@ private:
     std::vector<std::shared_ptr<ARM_Interface>> cpu_cores;
     ARM_Interface* running_core = nullptr;
 
+    /// Watches each core for loops that wait on memory, indexed by core id
+    std::vector<IdleLoopDetector> idle_loop_detectors;
+
+    /// Threads running the additional cores when they execute in parallel, if enabled
+    std::unique_ptr<Common::ThreadWorker> core_workers;
+    bool cores_in_parallel{};
+
     /// DSP core
     std::unique_ptr<AudioCore::DspInterface> dsp_core;
 
@@ -364,6 +421,9 @@ private:
     /// Custom texture cache system
     std::unique_ptr<Core::CustomTexCache> custom_tex_cache;
 
+    /// Periodic snapshots used to rewind emulation
+    std::unique_ptr<Core::RewindBuffer> rewind_buffer;
+
     /// Image interface
     std::shared_ptr<Frontend::ImageInterface> registered_image_interface;
 
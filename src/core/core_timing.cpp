@@ -68,31 +68,30 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
         if (!timer->is_timer_sane)
             timer->ForceExceptionCheck(cycles_into_future);
 
-        timer->event_queue.emplace_back(
-            Event{timeout, timer->event_fifo_id++, user_data, event_type});
-        std::push_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
+        timer->event_queue.Push(Event{timeout, timer->event_fifo_id++, user_data, event_type});
     } else {
         timer->ts_queue.Push(Event{static_cast<s64>(timer->GetTicks() + cycles_into_future), 0,
                                    user_data, event_type});
     }
 }
 
+void Timing::ScheduleEventThreadsafe(const TimingEventType* event_type, std::uintptr_t user_data,
+                                     std::size_t core_id) {
+    ASSERT(event_type != nullptr && core_id < timers.size());
+    // The time is raised to the current one when the event is moved into the event queue
+    timers[core_id]->ts_queue.Push(Event{0, 0, user_data, event_type});
+}
+
 void Timing::UnscheduleEvent(const TimingEventType* event_type, std::uintptr_t user_data) {
     if (event_queue_locked) {
         return;
     }
     for (auto timer : timers) {
-        auto itr = std::remove_if(
-            timer->event_queue.begin(), timer->event_queue.end(),
-            [&](const Event& e) { return e.type == event_type && e.user_data == user_data; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
-        }
+        // Events scheduled from other threads are only cancelled once they are in the queue
+        timer->MoveEvents();
+        timer->event_queue.RemoveIf(event_type,
+                                    [&](const Event& e) { return e.user_data == user_data; });
     }
-    // TODO:remove events from ts_queue
 }
 
 void Timing::RemoveEvent(const TimingEventType* event_type) {
@@ -100,16 +99,9 @@ void Timing::RemoveEvent(const TimingEventType* event_type) {
         return;
     }
     for (auto timer : timers) {
-        auto itr = std::remove_if(timer->event_queue.begin(), timer->event_queue.end(),
-                                  [&](const Event& e) { return e.type == event_type; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
-        }
+        timer->MoveEvents();
+        timer->event_queue.RemoveIf(event_type, [](const Event&) { return true; });
     }
-    // TODO:remove events from ts_queue
 }
 
 void Timing::SetCurrentTimer(std::size_t core_id) {
@@ -168,9 +160,9 @@ void Timing::Timer::ForceExceptionCheck(s64 cycles) {
 
 void Timing::Timer::MoveEvents() {
     for (Event ev; ts_queue.Pop(ev);) {
+        ev.time = std::max(ev.time, executed_ticks);
         ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+        event_queue.Push(ev);
     }
 }
 
@@ -191,10 +183,10 @@ void Timing::Timer::EndAdjust(u32 start_adjust_handle) {
 }
 
 s64 Timing::Timer::GetMaxSliceLength() const {
-    const auto& next_event = event_queue.begin();
-    if (next_event != event_queue.end()) {
-        ASSERT(next_event->time - executed_ticks > 0);
-        return next_event->time - executed_ticks;
+    if (!event_queue.Empty()) {
+        const Event& next_event = event_queue.Front();
+        ASSERT(next_event.time - executed_ticks > 0);
+        return next_event.time - executed_ticks;
     }
     return MAX_SLICE_LENGTH;
 }
@@ -210,16 +202,15 @@ void Timing::Timer::Advance() {
 
     is_timer_sane = true;
 
-    while (!event_queue.empty() && event_queue.front().time <= executed_ticks) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
+    while (!event_queue.Empty() && event_queue.Front().time <= executed_ticks) {
+        Event evt = event_queue.PopFront();
         if (evt.type->callback != nullptr) {
             evt.type->callback(evt.user_data, static_cast<int>(executed_ticks - evt.time));
         } else {
             LOG_ERROR(Core, "Event '{}' has no callback", *evt.type->name);
         }
     }
+    event_queue.AdvanceTo(executed_ticks);
 
     is_timer_sane = false;
 }
@@ -228,9 +219,9 @@ void Timing::Timer::SetNextSlice(s64 max_slice_length) {
     slice_length = max_slice_length;
 
     // Still events left (scheduled in the future)
-    if (!event_queue.empty()) {
+    if (!event_queue.Empty()) {
         slice_length = static_cast<int>(
-            std::min<s64>(event_queue.front().time - executed_ticks, max_slice_length));
+            std::min<s64>(event_queue.Front().time - executed_ticks, max_slice_length));
     }
 
     downcount = slice_length;
@@ -241,6 +232,13 @@ void Timing::Timer::Idle() {
     downcount = 0;
 }
 
+void Timing::Timer::IdleAfter(s64 ticks) {
+    if (downcount > ticks) {
+        idled_cycles += downcount - ticks;
+        downcount = ticks;
+    }
+}
+
 s64 Timing::Timer::GetDowncount() const {
     return downcount;
 }
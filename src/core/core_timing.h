@@ -29,6 +29,7 @@
 #include "common/logging/log.h"
 #include "common/threadsafe_queue.h"
 #include "core/global.h"
+#include "core/timing_wheel.h"
 
 // The timing we get from the assembly is 268,111,855.956 Hz
 // It is possible that this number isn't just an integer because the compiler could have
@@ -192,6 +193,9 @@ public:
 
         void Idle();
 
+        /// Ends the slice after the given number of ticks, idling for the rest of it
+        void IdleAfter(s64 ticks);
+
         u64 GetTicks() const;
         u64 GetIdleTicks() const;
 
@@ -210,11 +214,9 @@ public:
 
     private:
         friend class Timing;
-        // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-        // We don't use std::priority_queue because we need to be able to serialize, unserialize and
-        // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
-        // accommodated by the standard adaptor class.
-        std::vector<Event> event_queue;
+        // Events are kept in a timing wheel rather than a heap so that they can be cancelled
+        // (RemoveEvent(), UnscheduleEvent()) without rebuilding the whole queue
+        TimingWheel<Event> event_queue;
         u64 event_fifo_id = 0;
         // the queue for storing the events from other threads threadsafe until they will be added
         // to the event_queue by the emu thread
@@ -246,12 +248,24 @@ public:
             // TODO(SaveState): Remove the next two lines when we break compatibility
             s64 x;
             ar& x; // to keep compatibility with old save states that stored global_timer
-            ar& event_queue;
+            // The events are stored as the sorted vector, which is also a valid heap, that
+            // save states have always contained
+            std::vector<Event> events;
+            if (!Archive::is_loading::value) {
+                events = event_queue.GetSortedEvents();
+            }
+            ar& events;
             ar& event_fifo_id;
             ar& slice_length;
             ar& downcount;
             ar& executed_ticks;
             ar& idled_cycles;
+            if (Archive::is_loading::value) {
+                event_queue.Reset(executed_ticks);
+                for (const Event& event : events) {
+                    event_queue.Push(event);
+                }
+            }
         }
         friend class boost::serialization::access;
     };
@@ -269,6 +283,14 @@ public:
                        std::uintptr_t user_data = 0,
                        std::size_t core_id = std::numeric_limits<std::size_t>::max());
 
+    /**
+     * Schedules an event from a host thread other than the emulation thread, like the GPU thread.
+     * The time of the timer can't be read from there, so the event is due right away and fires
+     * the next time the emulation thread advances the timer of the core.
+     */
+    void ScheduleEventThreadsafe(const TimingEventType* event_type, std::uintptr_t user_data = 0,
+                                 std::size_t core_id = 0);
+
     void UnscheduleEvent(const TimingEventType* event_type, std::uintptr_t user_data);
 
     /// We only permit one event of each type in the queue at a time.
@@ -2,35 +2,218 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <bitset>
+#include <cinttypes>
+#include <thread>
 #include <fmt/format.h>
+#include "common/common_funcs.h"
 #include "common/file_util.h"
+#include "common/hash.h"
+#include "common/settings.h"
+#include "common/swap.h"
 #include "common/texture.h"
+#include "common/thread_worker.h"
+#include "common/zstd_compression.h"
 #include "core.h"
 #include "core/custom_tex_cache.h"
+#include "core/frontend/image_interface.h"
 
 namespace Core {
-CustomTexCache::CustomTexCache() = default;
 
-CustomTexCache::~CustomTexCache() = default;
+namespace {
 
-bool CustomTexCache::IsTextureDumped(u64 hash) const {
+/**
+ * Header of the converted copy of a custom texture. It is followed by a zstd frame with the RGBA8
+ * texels, bottom row first, so loading it skips both PNG decoding and flipping.
+ */
+struct ConvertedTexHeader {
+    u32_le magic;
+    u32_le width;
+    u32_le height;
+    u32_le version;
+    u64_le source_size; ///< Size of the PNG file it was converted from
+    u64_le source_hash; ///< Hash of the contents of the PNG file it was converted from
+};
+static_assert(sizeof(ConvertedTexHeader) == 32, "ConvertedTexHeader has wrong size");
+
+constexpr u32 CONVERTED_TEX_MAGIC = 0x58455443; // "CTEX"
+
+/// Increase this when the converted files change, so that the ones already written are rejected
+constexpr u32 CONVERTED_TEX_VERSION = 1;
+
+/// Identifies the contents of a PNG file, as an edited texture may keep the size of the file
+struct SourceInfo {
+    u64 size;
+    u64 hash;
+};
+
+SourceInfo GetSourceInfo(const std::string& path) {
+    std::string contents;
+    FileUtil::ReadFileToString(false, path, contents);
+    return {contents.size(), Common::ComputeHash64(contents.data(), contents.size())};
+}
+
+/// Memory that textures waiting to be dumped may take up before rendering waits for the disk
+constexpr std::size_t MAX_DUMP_QUEUE_SIZE = 256 * 1024 * 1024;
+
+bool IsPowerOfTwo(u32 value) {
+    return std::bitset<32>(value).count() == 1;
+}
+
+std::shared_ptr<const CustomTexInfo> ReadConvertedTexture(const std::string& path,
+                                                          const SourceInfo& source) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen()) {
+        return nullptr;
+    }
+
+    ConvertedTexHeader header{};
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != CONVERTED_TEX_MAGIC || header.version != CONVERTED_TEX_VERSION ||
+        header.source_size != source.size || header.source_hash != source.hash ||
+        !IsPowerOfTwo(header.width) || !IsPowerOfTwo(header.height)) {
+        return nullptr;
+    }
+
+    std::vector<u8> compressed(file.GetSize() - sizeof(header));
+    if (file.ReadBytes(compressed.data(), compressed.size()) != compressed.size()) {
+        return nullptr;
+    }
+
+    auto texture = std::make_shared<CustomTexInfo>();
+    texture->width = header.width;
+    texture->height = header.height;
+    texture->tex = Common::Compression::DecompressDataZSTD(compressed);
+    if (texture->tex.size() != static_cast<std::size_t>(header.width) * header.height * 4) {
+        LOG_WARNING(Render_OpenGL, "Converted custom texture {} is corrupted", path);
+        return nullptr;
+    }
+    return texture;
+}
+
+void WriteConvertedTexture(const std::string& path, const CustomTexInfo& texture,
+                           const SourceInfo& source) {
+    ConvertedTexHeader header{};
+    header.magic = CONVERTED_TEX_MAGIC;
+    header.width = texture.width;
+    header.height = texture.height;
+    header.version = CONVERTED_TEX_VERSION;
+    header.source_size = source.size;
+    header.source_hash = source.hash;
+
+    // The textures are loaded far more often than they are converted, so favor the ratio
+    const std::vector<u8> compressed =
+        Common::Compression::CompressDataZSTD(texture.tex.data(), texture.tex.size(), 9);
+    FileUtil::IOFile file(path, "wb");
+    if (file.WriteObject(header) != 1 ||
+        file.WriteBytes(compressed.data(), compressed.size()) != compressed.size()) {
+        LOG_WARNING(Render_OpenGL, "Failed to write converted custom texture {}", path);
+        file.Close();
+        FileUtil::Delete(path);
+    }
+}
+
+} // Anonymous namespace
+
+CustomTexCache::CustomTexCache(std::shared_ptr<Frontend::ImageInterface> image_interface_,
+                               u64 program_id_)
+    : image_interface{std::move(image_interface_)}, program_id{program_id_},
+      async_loading{Settings::values.async_custom_loading.GetValue()},
+      memory_budget{std::size_t{Settings::values.custom_textures_budget.GetValue()} << 20} {}
+
+CustomTexCache::~CustomTexCache() {
+    stop_loading = true;
+    workers.reset();
+
+    // Unlike loads, queued dumps are still written
+    if (dump_workers) {
+        dump_workers->WaitForRequests();
+        LOG_INFO(Render_OpenGL, "Dumped {} of {} queued textures", GetWrittenDumpCount(),
+                 GetQueuedDumpCount());
+    }
+}
+
+bool CustomTexCache::IsTextureDumped(u64 hash) {
+    std::scoped_lock lock{dump_mutex};
+    if (!dump_index_loaded) {
+        LoadDumpIndex();
+    }
     return dumped_textures.count(hash);
 }
 
-void CustomTexCache::SetTextureDumped(const u64 hash) {
-    dumped_textures.insert(hash);
+void CustomTexCache::DumpTexture(u64 hash, std::string file_name, std::vector<u8> texels,
+                                 u32 width, u32 height) {
+    const std::size_t size = texels.size();
+    {
+        std::unique_lock lock{dump_mutex};
+        if (!dump_index_loaded) {
+            LoadDumpIndex();
+        }
+        if (!dumped_textures.insert(hash).second) {
+            return;
+        }
+        dump_cv.wait(lock, [this, size] {
+            return dump_queued_size == 0 || dump_queued_size + size <= MAX_DUMP_QUEUE_SIZE;
+        });
+        dump_queued_size += size;
+    }
+
+    if (!dump_workers) {
+        const std::size_t num_workers =
+            std::clamp<std::size_t>(std::thread::hardware_concurrency() / 4, 1, 4);
+        dump_workers = std::make_unique<Common::ThreadWorker>(num_workers, "TextureDumper");
+    }
+    ++queued_dumps;
+    dump_workers->QueueWork(
+        [this, hash, file_name = std::move(file_name), texels = std::move(texels), width,
+         height]() mutable { WriteDump(hash, file_name, texels, width, height); });
+}
+
+std::size_t CustomTexCache::GetQueuedDumpCount() const {
+    return queued_dumps;
 }
 
-bool CustomTexCache::IsTextureCached(u64 hash) const {
-    return custom_textures.count(hash);
+std::size_t CustomTexCache::GetWrittenDumpCount() const {
+    return written_dumps;
 }
 
-const CustomTexInfo& CustomTexCache::LookupTexture(u64 hash) const {
-    return custom_textures.at(hash);
+std::shared_ptr<const CustomTexInfo> CustomTexCache::GetTexture(u64 hash) {
+    const auto path_iter = custom_texture_paths.find(hash);
+    if (path_iter == custom_texture_paths.end()) {
+        return nullptr;
+    }
+
+    {
+        std::scoped_lock lock{mutex};
+        Entry& entry = entries[hash];
+        switch (entry.state) {
+        case LoadState::Loaded:
+            lru_list.splice(lru_list.begin(), lru_list, entry.lru_position);
+            return entry.texture;
+        case LoadState::Loading:
+        case LoadState::Failed:
+            return nullptr;
+        case LoadState::Unloaded:
+            break;
+        }
+
+        if (async_loading) {
+            QueueLoad(hash, entry, true);
+            return nullptr;
+        }
+        entry.state = LoadState::Loading;
+    }
+
+    auto texture = LoadTexture(path_iter->second);
+    FinishLoad(hash, texture);
+    return texture;
 }
 
-void CustomTexCache::CacheTexture(u64 hash, const std::vector<u8>& tex, u32 width, u32 height) {
-    custom_textures[hash] = {width, height, tex};
+bool CustomTexCache::IsTextureLoading(u64 hash) const {
+    std::scoped_lock lock{mutex};
+    const auto iter = entries.find(hash);
+    return iter != entries.end() && iter->second.state == LoadState::Loading;
 }
 
 void CustomTexCache::AddTexturePath(u64 hash, const std::string& path) {
@@ -40,7 +223,7 @@ void CustomTexCache::AddTexturePath(u64 hash, const std::string& path) {
         custom_texture_paths[hash] = {path, hash};
 }
 
-void CustomTexCache::FindCustomTextures(u64 program_id) {
+void CustomTexCache::FindCustomTextures() {
     // Custom textures are currently stored as
     // [TitleID]/tex1_[width]x[height]_[64-bit hash]_[format].png
 
@@ -65,34 +248,43 @@ void CustomTexCache::FindCustomTextures(u64 program_id) {
             u64 hash;
             u32 format; // unused
             // TODO: more modern way of doing this
-            if (std::sscanf(file.virtualName.c_str(), "tex1_%ux%u_%llX_%u.png", &width, &height,
-                            &hash, &format) == 4) {
+            if (std::sscanf(file.virtualName.c_str(), "tex1_%ux%u_%" SCNx64 "_%u.png", &width,
+                            &height, &hash, &format) == 4) {
                 AddTexturePath(hash, file.physicalName);
             }
         }
     }
+
+    converted_dir = fmt::format("{}custom_textures/{:016X}/",
+                                FileUtil::GetUserPath(FileUtil::UserPath::CacheDir), program_id);
+    if (custom_texture_paths.empty()) {
+        return;
+    }
+    if (!FileUtil::CreateFullPath(converted_dir)) {
+        LOG_ERROR(Render_OpenGL, "Unable to create {}", converted_dir);
+    }
+
+    const std::size_t num_workers =
+        std::clamp<std::size_t>(std::thread::hardware_concurrency() / 2, 1, 8);
+    workers = std::make_unique<Common::ThreadWorker>(num_workers, "CustomTexLoader");
 }
 
-void CustomTexCache::PreloadTextures(Frontend::ImageInterface& image_interface) {
-    for (const auto& path : custom_texture_paths) {
-        const auto& path_info = path.second;
-        Core::CustomTexInfo tex_info;
-        if (image_interface.DecodePNG(tex_info.tex, tex_info.width, tex_info.height,
-                                      path_info.path)) {
-            // Make sure the texture size is a power of 2
-            std::bitset<32> width_bits(tex_info.width);
-            std::bitset<32> height_bits(tex_info.height);
-            if (width_bits.count() == 1 && height_bits.count() == 1) {
-                LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-                Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
-                CacheTexture(path_info.hash, tex_info.tex, tex_info.width, tex_info.height);
-            } else {
-                LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
+void CustomTexCache::PreloadTextures() {
+    if (custom_texture_paths.empty()) {
+        return;
+    }
+    {
+        std::scoped_lock lock{mutex};
+        for (const auto& [hash, path_info] : custom_texture_paths) {
+            Entry& entry = entries[hash];
+            if (entry.state == LoadState::Unloaded) {
+                QueueLoad(hash, entry, false);
             }
-        } else {
-            LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
         }
     }
+    if (!async_loading) {
+        workers->WaitForRequests();
+    }
 }
 
 bool CustomTexCache::CustomTextureExists(u64 hash) const {
@@ -106,4 +298,149 @@ const CustomTexPathInfo& CustomTexCache::LookupTexturePathInfo(u64 hash) const {
 bool CustomTexCache::IsTexturePathMapEmpty() const {
     return custom_texture_paths.size() == 0;
 }
+
+void CustomTexCache::QueueLoad(u64 hash, Entry& entry, bool on_demand) {
+    entry.state = LoadState::Loading;
+    if (on_demand) {
+        requested_queue.push_back(hash);
+    } else {
+        preload_queue.push_back(hash);
+    }
+    workers->QueueWork([this] { LoadNext(); });
+}
+
+void CustomTexCache::LoadNext() {
+    u64 hash;
+    {
+        std::scoped_lock lock{mutex};
+        auto& queue = requested_queue.empty() ? preload_queue : requested_queue;
+        hash = queue.front();
+        queue.pop_front();
+    }
+    if (stop_loading) {
+        return;
+    }
+    FinishLoad(hash, LoadTexture(custom_texture_paths.at(hash)));
+}
+
+std::shared_ptr<const CustomTexInfo> CustomTexCache::LoadTexture(
+    const CustomTexPathInfo& path_info) const {
+    // Hashing the file is still far cheaper than decoding it
+    const SourceInfo source = GetSourceInfo(path_info.path);
+    const std::string converted_path = fmt::format("{}{:016X}.ctex", converted_dir, path_info.hash);
+    if (auto texture = ReadConvertedTexture(converted_path, source)) {
+        LOG_DEBUG(Render_OpenGL, "Loaded converted custom texture from {}", converted_path);
+        return texture;
+    }
+
+    auto texture = std::make_shared<CustomTexInfo>();
+    if (!image_interface->DecodePNG(texture->tex, texture->width, texture->height,
+                                    path_info.path)) {
+        LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
+        return nullptr;
+    }
+
+    // Make sure the texture size is a power of 2
+    if (!IsPowerOfTwo(texture->width) || !IsPowerOfTwo(texture->height)) {
+        LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
+        return nullptr;
+    }
+
+    LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
+    Common::FlipRGBA8Texture(texture->tex, texture->width, texture->height);
+    WriteConvertedTexture(converted_path, *texture, source);
+    return texture;
+}
+
+void CustomTexCache::FinishLoad(u64 hash, std::shared_ptr<const CustomTexInfo> texture) {
+    std::scoped_lock lock{mutex};
+    Entry& entry = entries[hash];
+    if (!texture) {
+        entry.state = LoadState::Failed;
+        return;
+    }
+
+    loaded_size += texture->tex.size();
+    entry.state = LoadState::Loaded;
+    entry.texture = std::move(texture);
+    lru_list.push_front(hash);
+    entry.lru_position = lru_list.begin();
+
+    // Keep the texture that was just loaded even if it alone exceeds the budget
+    while (loaded_size > memory_budget && lru_list.size() > 1) {
+        Entry& evicted = entries.at(lru_list.back());
+        LOG_DEBUG(Render_OpenGL, "Dropping custom texture {:016X} to stay within the budget",
+                  lru_list.back());
+        loaded_size -= evicted.texture->tex.size();
+        evicted.state = LoadState::Unloaded;
+        evicted.texture.reset();
+        lru_list.pop_back();
+    }
+}
+
+void CustomTexCache::LoadDumpIndex() {
+    dump_index_loaded = true;
+    dump_dir = fmt::format("{}textures/{:016X}/",
+                           FileUtil::GetUserPath(FileUtil::UserPath::DumpDir), program_id);
+    if (!FileUtil::CreateFullPath(dump_dir)) {
+        LOG_ERROR(Render, "Unable to create {}", dump_dir);
+        return;
+    }
+
+    const std::string index_path = dump_dir + "dump_index.bin";
+    std::vector<u64_le> hashes;
+    if (FileUtil::Exists(index_path)) {
+        FileUtil::IOFile file(index_path, "rb");
+        hashes.resize(file.GetSize() / sizeof(u64_le));
+        hashes.resize(file.ReadArray(hashes.data(), hashes.size()));
+        dump_index = std::make_unique<FileUtil::IOFile>(index_path, "ab");
+    } else {
+        // Index the textures that were dumped before there was an index
+        FileUtil::FSTEntry dump_entry;
+        FileUtil::ScanDirectoryTree(dump_dir, dump_entry);
+        for (const auto& file : dump_entry.children) {
+            u32 width;
+            u32 height;
+            u64 hash;
+            u32 format;
+            if (!file.isDirectory &&
+                std::sscanf(file.virtualName.c_str(), "tex1_%ux%u_%" SCNx64 "_%u.png", &width,
+                            &height, &hash, &format) == 4) {
+                hashes.push_back(hash);
+            }
+        }
+        dump_index = std::make_unique<FileUtil::IOFile>(index_path, "wb");
+        dump_index->WriteArray(hashes.data(), hashes.size());
+        dump_index->Flush();
+    }
+
+    dumped_textures.insert(hashes.begin(), hashes.end());
+    LOG_INFO(Render_OpenGL, "{} textures were dumped in previous sessions", hashes.size());
+}
+
+void CustomTexCache::WriteDump(u64 hash, const std::string& file_name, std::vector<u8>& texels,
+                               u32 width, u32 height) {
+    const std::size_t size = texels.size();
+    const std::string path = dump_dir + file_name;
+    LOG_INFO(Render_OpenGL, "Dumping texture to {}", path);
+    Common::FlipRGBA8Texture(texels, width, height);
+    const bool written = image_interface->EncodePNG(path, texels, width, height);
+    if (!written) {
+        LOG_ERROR(Render_OpenGL, "Failed to save decoded texture");
+    }
+
+    {
+        std::scoped_lock lock{dump_mutex};
+        dump_queued_size -= size;
+        if (written && dump_index && dump_index->IsOpen()) {
+            dump_index->WriteObject(u64_le{hash});
+            dump_index->Flush();
+        }
+    }
+    dump_cv.notify_all();
+    if (written) {
+        ++written_dumps;
+    }
+}
+
 } // namespace Core
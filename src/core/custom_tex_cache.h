@@ -4,12 +4,26 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include "common/common_types.h"
 
+namespace Common {
+class ThreadWorker;
+}
+
+namespace FileUtil {
+class IOFile;
+}
+
 namespace Frontend {
 class ImageInterface;
 } // namespace Frontend
@@ -30,26 +44,110 @@ struct CustomTexPathInfo {
 // TODO: think of a better name for this class...
 class CustomTexCache {
 public:
-    explicit CustomTexCache();
+    explicit CustomTexCache(std::shared_ptr<Frontend::ImageInterface> image_interface,
+                            u64 program_id);
     ~CustomTexCache();
 
-    bool IsTextureDumped(u64 hash) const;
-    void SetTextureDumped(u64 hash);
+    /**
+     * Returns true if the texture was dumped in this session or, according to the dump index of
+     * the title, in a previous one. Delete dump_index.bin from the dump folder to dump again.
+     */
+    bool IsTextureDumped(u64 hash);
+
+    /**
+     * Queues a texture to be flipped, encoded and written to the dump folder of the title on the
+     * dump workers. The texels are RGBA8 with the bottom row first, as read back from OpenGL.
+     * Blocks while the queued textures take up too much memory.
+     */
+    void DumpTexture(u64 hash, std::string file_name, std::vector<u8> texels, u32 width,
+                     u32 height);
+
+    /// Returns the number of textures queued for dumping in this session
+    std::size_t GetQueuedDumpCount() const;
+
+    /// Returns the number of textures written to the dump folder in this session
+    std::size_t GetWrittenDumpCount() const;
 
-    bool IsTextureCached(u64 hash) const;
-    const CustomTexInfo& LookupTexture(u64 hash) const;
-    void CacheTexture(u64 hash, const std::vector<u8>& tex, u32 width, u32 height);
+    /**
+     * Returns the custom texture with the given hash if it is loaded. Otherwise it is loaded, in
+     * the background if asynchronous loading is enabled, in which case nullptr is returned until
+     * it is ready.
+     */
+    std::shared_ptr<const CustomTexInfo> GetTexture(u64 hash);
+
+    /// Returns true while the custom texture with the given hash is being loaded in the background
+    bool IsTextureLoading(u64 hash) const;
 
     void AddTexturePath(u64 hash, const std::string& path);
-    void FindCustomTextures(u64 program_id);
-    void PreloadTextures(Frontend::ImageInterface& image_interface);
+    void FindCustomTextures();
+    void PreloadTextures();
     bool CustomTextureExists(u64 hash) const;
     const CustomTexPathInfo& LookupTexturePathInfo(u64 hash) const;
     bool IsTexturePathMapEmpty() const;
 
 private:
-    std::unordered_set<u64> dumped_textures;
-    std::unordered_map<u64, CustomTexInfo> custom_textures;
+    enum class LoadState {
+        Unloaded,
+        Loading,
+        Loaded,
+        Failed,
+    };
+
+    struct Entry {
+        LoadState state = LoadState::Unloaded;
+        std::shared_ptr<const CustomTexInfo> texture;
+        std::list<u64>::iterator lru_position;
+    };
+
+    /// Queues the texture for loading on the workers, the mutex must be held
+    void QueueLoad(u64 hash, Entry& entry, bool on_demand);
+
+    /// Loads the next queued texture, requested textures go before preloaded ones
+    void LoadNext();
+
+    /// Decodes a texture from its converted copy if there is one, else from its PNG file
+    std::shared_ptr<const CustomTexInfo> LoadTexture(const CustomTexPathInfo& path_info) const;
+
+    /// Stores a loaded texture, dropping the least recently used ones that exceed the budget
+    void FinishLoad(u64 hash, std::shared_ptr<const CustomTexInfo> texture);
+
+    /// Reads the hashes of the textures dumped in previous sessions, the dump mutex must be held
+    void LoadDumpIndex();
+
+    /// Encodes and writes a queued texture, then records it in the dump index
+    void WriteDump(u64 hash, const std::string& file_name, std::vector<u8>& texels, u32 width,
+                   u32 height);
+
+    std::shared_ptr<Frontend::ImageInterface> image_interface;
+    u64 program_id;
     std::unordered_map<u64, CustomTexPathInfo> custom_texture_paths;
+
+    /// Directory of the zstd-compressed copies of decoded textures
+    std::string converted_dir;
+    bool async_loading;
+    std::size_t memory_budget;
+
+    mutable std::mutex mutex;
+    std::unordered_map<u64, Entry> entries;
+    std::list<u64> lru_list; ///< Loaded textures, most recently used first
+    std::size_t loaded_size = 0;
+    std::deque<u64> requested_queue;
+    std::deque<u64> preload_queue;
+    std::atomic_bool stop_loading{false};
+
+    std::string dump_dir;
+    mutable std::mutex dump_mutex;
+    std::condition_variable dump_cv;
+    bool dump_index_loaded = false;
+    std::unordered_set<u64> dumped_textures;
+    std::unique_ptr<FileUtil::IOFile> dump_index;
+    std::size_t dump_queued_size = 0; ///< Bytes of texels waiting to be written
+    std::atomic<std::size_t> queued_dumps{0};
+    std::atomic<std::size_t> written_dumps{0};
+
+    // Created once custom textures were found or the first texture is dumped. Declared last, so
+    // the workers are joined before anything they use is destroyed
+    std::unique_ptr<Common::ThreadWorker> workers;
+    std::unique_ptr<Common::ThreadWorker> dump_workers;
 };
 } // namespace Core
@@ -316,6 +316,29 @@ void MappedBuffer::Write(const void* src_buffer, std::size_t offset, std::size_t
     memory->WriteBlock(*process, address + static_cast<VAddr>(offset), src_buffer, size);
 }
 
+bool MappedBuffer::VisitSpans(std::size_t offset, std::size_t size, bool write,
+                              const std::function<void(std::span<u8>)>& visitor) {
+    ASSERT(perms & (write ? IPC::W : IPC::R));
+    ASSERT(offset + size <= this->size);
+    return memory->VisitBlock(*process, address + static_cast<VAddr>(offset), size,
+                              write ? Memory::FlushMode::FlushAndInvalidate
+                                    : Memory::FlushMode::Flush,
+                              visitor);
+}
+
+std::span<u8> MappedBuffer::GetSpan(std::size_t offset, std::size_t size, bool write) {
+    std::span<u8> result;
+    std::size_t num_spans = 0;
+    const bool is_mapped = VisitSpans(offset, size, write, [&](std::span<u8> span) {
+        result = span;
+        ++num_spans;
+    });
+    if (!is_mapped || num_spans != 1) {
+        return {};
+    }
+    return result;
+}
+
 } // namespace Kernel
 
 SERIALIZE_EXPORT_IMPL(Kernel::HLERequestContext::ThreadCallback)
@@ -7,7 +7,9 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <functional>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 #include <boost/container/small_vector.hpp>
@@ -132,6 +134,22 @@ public:
     // interface for service
     void Read(void* dest_buffer, std::size_t offset, std::size_t size);
     void Write(const void* src_buffer, std::size_t offset, std::size_t size);
+
+    /**
+     * Calls visitor with each part of the range of the buffer that is contiguous in host memory,
+     * in order, so that the service can read or write the guest memory in place.
+     * @returns False, without calling visitor, when part of the range isn't backed by memory, in
+     *          which case Read or Write has to be used.
+     */
+    bool VisitSpans(std::size_t offset, std::size_t size, bool write,
+                    const std::function<void(std::span<u8>)>& visitor);
+
+    /**
+     * Returns the range of the buffer as a span over guest memory, or an empty span when it is
+     * not contiguous in host memory, in which case Read or Write has to be used.
+     */
+    std::span<u8> GetSpan(std::size_t offset, std::size_t size, bool write);
+
     std::size_t GetSize() const {
         return size;
     }
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <span>
 #include <boost/serialization/unique_ptr.hpp>
 #include "common/archives.h"
 #include "common/logging/log.h"
@@ -78,15 +79,43 @@ void File::Read(Kernel::HLERequestContext& ctx) {
 
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
 
-    std::vector<u8> data(length);
-    ResultVal<std::size_t> read = backend->Read(offset, data.size(), data.data());
-    if (read.Failed()) {
-        rb.Push(read.Code());
+    // Read straight into the guest memory of the buffer, one part contiguous in host memory at a
+    // time, unless it is not all backed by memory
+    ResultCode result = RESULT_SUCCESS;
+    std::size_t total_read = 0;
+    bool end_reached = false;
+    const bool read_in_place =
+        length <= buffer.GetSize() && buffer.VisitSpans(0, length, true, [&](std::span<u8> span) {
+            if (end_reached) {
+                return;
+            }
+            const ResultVal<std::size_t> read =
+                backend->Read(offset + total_read, span.size(), span.data());
+            if (read.Failed()) {
+                result = read.Code();
+                end_reached = true;
+                return;
+            }
+            total_read += *read;
+            end_reached = *read < span.size();
+        });
+    if (!read_in_place) {
+        std::vector<u8> data(length);
+        const ResultVal<std::size_t> read = backend->Read(offset, data.size(), data.data());
+        if (read.Failed()) {
+            result = read.Code();
+        } else {
+            total_read = *read;
+            buffer.Write(data.data(), 0, total_read);
+        }
+    }
+
+    if (result.IsError()) {
+        rb.Push(result);
         rb.Push<u32>(0);
     } else {
-        buffer.Write(data.data(), 0, *read);
         rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(static_cast<u32>(*read));
+        rb.Push<u32>(static_cast<u32>(total_read));
     }
     rb.PushMappedBuffer(buffer);
 
@@ -115,9 +144,18 @@ void File::Write(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    std::vector<u8> data(length);
-    buffer.Read(data.data(), 0, data.size());
-    ResultVal<std::size_t> written = backend->Write(offset, data.size(), flush != 0, data.data());
+    // Write straight from guest memory when the buffer is contiguous in host memory, so that the
+    // backend still gets a single write
+    const std::span<u8> span =
+        length <= buffer.GetSize() ? buffer.GetSpan(0, length, false) : std::span<u8>{};
+    std::vector<u8> data;
+    const u8* src = span.data();
+    if (span.empty()) {
+        data.resize(length);
+        buffer.Read(data.data(), 0, data.size());
+        src = data.data();
+    }
+    ResultVal<std::size_t> written = backend->Write(offset, length, flush != 0, src);
 
     // Update file size
     file->size = backend->GetSize();
@@ -0,0 +1,538 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "common/arch.h"
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "common/thread_worker.h"
+#include "common/vector_math.h"
+#include "core/hw/display_transfer.h"
+#include "video_core/utils.h"
+
+#if CITRA_ARCH(x86_64)
+#include <emmintrin.h>
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
+namespace GPU {
+
+namespace {
+
+using PixelFormat = Regs::PixelFormat;
+using Config = Regs::DisplayTransferConfig;
+
+/// Output pixels from which a transfer is split among the worker threads
+constexpr u32 MULTITHREAD_MIN_PIXELS = 256 * 256;
+
+/*
+ * Bands are converted through rows of RGBA8 pixels packed into u32 with red in the lowest byte,
+ * the byte order of Common::Vec4<u8>. The formats are decoded and encoded a whole tile or row at
+ * a time, so the format is only dispatched once per band. The RGBA8 byte swap and the box filter
+ * of the scaling modes use SSE2 on x86_64 and NEON on arm64, which every such host supports.
+ */
+
+/// Position of every pixel of a tile in its rows, indexed by its position in the tile
+constexpr std::array<u8, 64> TILE_PIXEL_POSITIONS = [] {
+    std::array<u8, 64> positions{};
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; ++x) {
+            positions[VideoCore::MortonInterleave(x, y)] = static_cast<u8>(y * 8 + x);
+        }
+    }
+    return positions;
+}();
+
+u32 PackColor(const Common::Vec4<u8>& color) {
+    return color.r() | (color.g() << 8) | (color.b() << 16) | (static_cast<u32>(color.a()) << 24);
+}
+
+Common::Vec4<u8> UnpackColor(u32 color) {
+    return {static_cast<u8>(color), static_cast<u8>(color >> 8), static_cast<u8>(color >> 16),
+            static_cast<u8>(color >> 24)};
+}
+
+/// Reverses the bytes of every pixel, which converts between RGBA8 in memory and packed colors
+void SwapPixelBytes(const u8* src, u8* dst, std::size_t count) {
+    std::size_t i = 0;
+#if CITRA_ARCH(x86_64)
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        pixels = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0xB1), 0xB1);
+        pixels = _mm_or_si128(_mm_slli_epi16(pixels, 8), _mm_srli_epi16(pixels, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), pixels);
+    }
+#elif CITRA_ARCH(arm64)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u8(dst + i * 4, vrev32q_u8(vld1q_u8(src + i * 4)));
+    }
+#endif
+    for (; i < count; ++i) {
+        u32 pixel;
+        std::memcpy(&pixel, src + i * 4, sizeof(pixel));
+        pixel = Common::swap32(pixel);
+        std::memcpy(dst + i * 4, &pixel, sizeof(pixel));
+    }
+}
+
+template <PixelFormat format>
+void DecodePixels(const u8* src, u32* dst, std::size_t count) {
+    if constexpr (format == PixelFormat::RGBA8) {
+        SwapPixelBytes(src, reinterpret_cast<u8*>(dst), count);
+    } else {
+        for (std::size_t i = 0; i < count; ++i) {
+            if constexpr (format == PixelFormat::RGB8) {
+                const u8* pixel = src + i * 3;
+                dst[i] = pixel[2] | (pixel[1] << 8) | (pixel[0] << 16) | 0xFF000000;
+            } else if constexpr (format == PixelFormat::RGB565) {
+                dst[i] = PackColor(Common::Color::DecodeRGB565(src + i * 2));
+            } else if constexpr (format == PixelFormat::RGB5A1) {
+                dst[i] = PackColor(Common::Color::DecodeRGB5A1(src + i * 2));
+            } else {
+                dst[i] = PackColor(Common::Color::DecodeRGBA4(src + i * 2));
+            }
+        }
+    }
+}
+
+template <PixelFormat format>
+void EncodePixels(const u32* src, u8* dst, std::size_t count) {
+    if constexpr (format == PixelFormat::RGBA8) {
+        SwapPixelBytes(reinterpret_cast<const u8*>(src), dst, count);
+    } else {
+        for (std::size_t i = 0; i < count; ++i) {
+            if constexpr (format == PixelFormat::RGB8) {
+                u8* pixel = dst + i * 3;
+                pixel[0] = static_cast<u8>(src[i] >> 16);
+                pixel[1] = static_cast<u8>(src[i] >> 8);
+                pixel[2] = static_cast<u8>(src[i]);
+            } else if constexpr (format == PixelFormat::RGB565) {
+                Common::Color::EncodeRGB565(UnpackColor(src[i]), dst + i * 2);
+            } else if constexpr (format == PixelFormat::RGB5A1) {
+                Common::Color::EncodeRGB5A1(UnpackColor(src[i]), dst + i * 2);
+            } else {
+                Common::Color::EncodeRGBA4(UnpackColor(src[i]), dst + i * 2);
+            }
+        }
+    }
+}
+
+using DecodeFunc = void (*)(const u8* src, u32* dst, std::size_t count);
+using EncodeFunc = void (*)(const u32* src, u8* dst, std::size_t count);
+
+template <template <PixelFormat> typename Func, typename Ptr>
+Ptr GetFormatFunc(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return &Func<PixelFormat::RGBA8>::Call;
+    case PixelFormat::RGB8:
+        return &Func<PixelFormat::RGB8>::Call;
+    case PixelFormat::RGB565:
+        return &Func<PixelFormat::RGB565>::Call;
+    case PixelFormat::RGB5A1:
+        return &Func<PixelFormat::RGB5A1>::Call;
+    case PixelFormat::RGBA4:
+        return &Func<PixelFormat::RGBA4>::Call;
+    default:
+        return nullptr;
+    }
+}
+
+template <PixelFormat format>
+struct Decoder {
+    static void Call(const u8* src, u32* dst, std::size_t count) {
+        DecodePixels<format>(src, dst, count);
+    }
+};
+
+template <PixelFormat format>
+struct Encoder {
+    static void Call(const u32* src, u8* dst, std::size_t count) {
+        EncodePixels<format>(src, dst, count);
+    }
+};
+
+/**
+ * Averages every pair of horizontally adjacent pixels of the row, and of the next row when it is
+ * given, rounding down like the box filter of the hardware.
+ */
+void DownscaleRow(const u32* row, const u32* next_row, u32* dst, std::size_t count) {
+    std::size_t i = 0;
+#if CITRA_ARCH(x86_64)
+    const __m128i zero = _mm_setzero_si128();
+    const auto load_pairs = [&](const u32* src, __m128i& lo, __m128i& hi) {
+        const __m128 first = _mm_loadu_ps(reinterpret_cast<const float*>(src));
+        const __m128 second = _mm_loadu_ps(reinterpret_cast<const float*>(src + 4));
+        const __m128i even = _mm_castps_si128(_mm_shuffle_ps(first, second, 0x88));
+        const __m128i odd = _mm_castps_si128(_mm_shuffle_ps(first, second, 0xDD));
+        lo = _mm_add_epi16(_mm_unpacklo_epi8(even, zero), _mm_unpacklo_epi8(odd, zero));
+        hi = _mm_add_epi16(_mm_unpackhi_epi8(even, zero), _mm_unpackhi_epi8(odd, zero));
+    };
+    for (; i + 4 <= count; i += 4) {
+        __m128i lo, hi;
+        load_pairs(row + i * 2, lo, hi);
+        if (next_row) {
+            __m128i next_lo, next_hi;
+            load_pairs(next_row + i * 2, next_lo, next_hi);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, next_lo), 2);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, next_hi), 2);
+        } else {
+            lo = _mm_srli_epi16(lo, 1);
+            hi = _mm_srli_epi16(hi, 1);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#elif CITRA_ARCH(arm64)
+    const auto load_pairs = [](const u32* src, uint16x8_t& lo, uint16x8_t& hi) {
+        const uint32x4x2_t pairs = vld2q_u32(src);
+        const uint8x16_t even = vreinterpretq_u8_u32(pairs.val[0]);
+        const uint8x16_t odd = vreinterpretq_u8_u32(pairs.val[1]);
+        lo = vaddl_u8(vget_low_u8(even), vget_low_u8(odd));
+        hi = vaddl_u8(vget_high_u8(even), vget_high_u8(odd));
+    };
+    for (; i + 4 <= count; i += 4) {
+        uint16x8_t lo, hi;
+        load_pairs(row + i * 2, lo, hi);
+        uint8x16_t result;
+        if (next_row) {
+            uint16x8_t next_lo, next_hi;
+            load_pairs(next_row + i * 2, next_lo, next_hi);
+            result = vcombine_u8(vshrn_n_u16(vaddq_u16(lo, next_lo), 2),
+                                 vshrn_n_u16(vaddq_u16(hi, next_hi), 2));
+        } else {
+            result = vcombine_u8(vshrn_n_u16(lo, 1), vshrn_n_u16(hi, 1));
+        }
+        vst1q_u8(reinterpret_cast<u8*>(dst + i), result);
+    }
+#endif
+    for (; i < count; ++i) {
+        auto sum = UnpackColor(row[i * 2]).Cast<u32>() + UnpackColor(row[i * 2 + 1]).Cast<u32>();
+        if (next_row) {
+            sum += UnpackColor(next_row[i * 2]).Cast<u32>() +
+                   UnpackColor(next_row[i * 2 + 1]).Cast<u32>();
+            dst[i] = PackColor((sum / 4).Cast<u8>());
+        } else {
+            dst[i] = PackColor((sum / 2).Cast<u8>());
+        }
+    }
+}
+
+/// Everything the bands of a transfer share
+struct TransferLayout {
+    const u8* src;
+    u8* dst;
+    DecodeFunc decode;
+    EncodeFunc encode;
+    u32 src_bpp;
+    u32 dst_bpp;
+    bool src_tiled;
+    bool dst_tiled;
+    bool flip;
+    u32 horizontal_scale;
+    u32 vertical_scale;
+    u32 input_width;
+    u32 output_width;
+    u32 output_height;
+};
+
+/// Rows of RGBA8 pixels a band goes through, allocated once per thread
+struct BandBuffers {
+    std::vector<u32> input_rows; ///< The input rows of the band, before downscaling
+    std::vector<u32> rows;       ///< The output rows of the band
+    std::array<u32, 64> tile;
+};
+
+/// Converts the output rows [first_row, first_row + 8), or until the end of the output
+void ConvertBand(const TransferLayout& layout, BandBuffers& buffers, u32 first_row) {
+    const u32 num_rows = std::min(8u, layout.output_height - first_row);
+    const u32 scaled_width = layout.output_width << layout.horizontal_scale;
+    const u32 num_input_rows = num_rows << layout.vertical_scale;
+    const u32 first_input_row = first_row << layout.vertical_scale;
+    const bool scaled = layout.horizontal_scale != 0;
+
+    // Decode the input rows, the output rows directly when there is no scaling
+    u32* input_rows = scaled ? buffers.input_rows.data() : buffers.rows.data();
+    if (layout.src_tiled) {
+        // Tiled inputs are whole tiles, so the band covers one or two rows of tiles
+        for (u32 tile_y = 0; tile_y < num_input_rows; tile_y += 8) {
+            const u8* tile_row =
+                layout.src + (first_input_row + tile_y) * layout.input_width * layout.src_bpp;
+            u32* rows = input_rows + tile_y * scaled_width;
+            for (u32 tile_x = 0; tile_x < scaled_width; tile_x += 8) {
+                layout.decode(tile_row + tile_x * 8 * layout.src_bpp, buffers.tile.data(), 64);
+                for (u32 i = 0; i < 64; ++i) {
+                    const u32 position = TILE_PIXEL_POSITIONS[i];
+                    rows[(position / 8) * scaled_width + tile_x + position % 8] = buffers.tile[i];
+                }
+            }
+        }
+    } else {
+        for (u32 y = 0; y < num_input_rows; ++y) {
+            const u8* row =
+                layout.src + (first_input_row + y) * layout.input_width * layout.src_bpp;
+            layout.decode(row, input_rows + y * scaled_width, scaled_width);
+        }
+    }
+
+    if (scaled) {
+        for (u32 y = 0; y < num_rows; ++y) {
+            const u32* row = input_rows + (y << layout.vertical_scale) * scaled_width;
+            const u32* next_row = layout.vertical_scale != 0 ? row + scaled_width : nullptr;
+            DownscaleRow(row, next_row, buffers.rows.data() + y * layout.output_width,
+                         layout.output_width);
+        }
+    }
+
+    // Encode the output rows, flipping happens after scaling
+    const auto output_y = [&](u32 y) {
+        return layout.flip ? layout.output_height - first_row - y - 1 : first_row + y;
+    };
+    if (layout.dst_tiled) {
+        // The band is exactly one row of tiles, either way around when flipped
+        const u32 tile_row_y = output_y(0) & ~7u;
+        u8* tile_row = layout.dst + tile_row_y * layout.output_width * layout.dst_bpp;
+        for (u32 tile_x = 0; tile_x < layout.output_width; tile_x += 8) {
+            for (u32 i = 0; i < 64; ++i) {
+                const u32 position = TILE_PIXEL_POSITIONS[i];
+                const u32 y = layout.flip ? 7 - position / 8 : position / 8;
+                buffers.tile[i] = buffers.rows[y * layout.output_width + tile_x + position % 8];
+            }
+            layout.encode(buffers.tile.data(), tile_row + tile_x * 8 * layout.dst_bpp, 64);
+        }
+    } else {
+        for (u32 y = 0; y < num_rows; ++y) {
+            u8* row = layout.dst + output_y(y) * layout.output_width * layout.dst_bpp;
+            layout.encode(buffers.rows.data() + y * layout.output_width, row,
+                          layout.output_width);
+        }
+    }
+}
+
+void ConvertBands(const TransferLayout& layout, u32 first_band, u32 end_band) {
+    BandBuffers buffers;
+    buffers.rows.resize(layout.output_width * 8);
+    buffers.input_rows.resize((layout.output_width << layout.horizontal_scale) *
+                              (8 << layout.vertical_scale));
+    for (u32 band = first_band; band < end_band; ++band) {
+        ConvertBand(layout, buffers, band * 8);
+    }
+}
+
+Common::ThreadWorker& GetTransferWorkers() {
+    static const std::size_t num_workers =
+        std::clamp<std::size_t>(std::thread::hardware_concurrency(), 2, 8) - 1;
+    static Common::ThreadWorker workers(num_workers, "DisplayTransfer");
+    return workers;
+}
+
+bool RangesOverlap(const u8* first, std::size_t first_size, const u8* second,
+                   std::size_t second_size) {
+    return first < second + second_size && second < first + first_size;
+}
+
+Common::Vec4<u8> DecodePixel(PixelFormat input_format, const u8* src_pixel) {
+    switch (input_format) {
+    case PixelFormat::RGBA8:
+        return Common::Color::DecodeRGBA8(src_pixel);
+
+    case PixelFormat::RGB8:
+        return Common::Color::DecodeRGB8(src_pixel);
+
+    case PixelFormat::RGB565:
+        return Common::Color::DecodeRGB565(src_pixel);
+
+    case PixelFormat::RGB5A1:
+        return Common::Color::DecodeRGB5A1(src_pixel);
+
+    case PixelFormat::RGBA4:
+        return Common::Color::DecodeRGBA4(src_pixel);
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", input_format);
+        return {0, 0, 0, 0};
+    }
+}
+
+} // Anonymous namespace
+
+void ConvertDisplayTransfer(const Config& config, const u8* src, u8* dst,
+                            bool allow_multithreading) {
+    const DecodeFunc decode = GetFormatFunc<Decoder, DecodeFunc>(config.input_format);
+    const EncodeFunc encode = GetFormatFunc<Encoder, EncodeFunc>(config.output_format);
+    if (!decode || !encode) {
+        ConvertDisplayTransferPixels(config, src, dst);
+        return;
+    }
+
+    TransferLayout layout{};
+    layout.src = src;
+    layout.dst = dst;
+    layout.decode = decode;
+    layout.encode = encode;
+    layout.src_bpp = Regs::BytesPerPixel(config.input_format);
+    layout.dst_bpp = Regs::BytesPerPixel(config.output_format);
+    layout.src_tiled = !config.input_linear;
+    layout.dst_tiled = config.input_linear.Value() != config.dont_swizzle.Value();
+    layout.flip = config.flip_vertically != 0;
+    layout.horizontal_scale = config.scaling != Config::NoScale ? 1 : 0;
+    layout.vertical_scale = config.scaling == Config::ScaleXY ? 1 : 0;
+    layout.input_width = config.input_width;
+    layout.output_width = config.output_width >> layout.horizontal_scale;
+    layout.output_height = config.output_height >> layout.vertical_scale;
+
+    const std::size_t input_size =
+        static_cast<std::size_t>(config.input_width) * config.input_height * layout.src_bpp;
+    const std::size_t output_size =
+        static_cast<std::size_t>(layout.output_width) * layout.output_height * layout.dst_bpp;
+    const bool whole_tiles = layout.output_width % 8 == 0 && layout.output_height % 8 == 0;
+    if (RangesOverlap(src, input_size, dst, output_size) ||
+        ((layout.src_tiled || layout.dst_tiled) && !whole_tiles)) {
+        ConvertDisplayTransferPixels(config, src, dst);
+        return;
+    }
+
+    const u32 num_bands = (layout.output_height + 7) / 8;
+    if (!allow_multithreading || layout.output_width * layout.output_height <
+                                     MULTITHREAD_MIN_PIXELS) {
+        ConvertBands(layout, 0, num_bands);
+        return;
+    }
+
+    // Split the bands evenly among the workers and this thread, which takes the last share
+    auto& workers = GetTransferWorkers();
+    const u32 num_shares = static_cast<u32>(std::min<std::size_t>(num_bands, 8));
+    for (u32 share = 0; share + 1 < num_shares; ++share) {
+        workers.QueueWork([&layout, share, num_shares, num_bands] {
+            ConvertBands(layout, share * num_bands / num_shares,
+                         (share + 1) * num_bands / num_shares);
+        });
+    }
+    ConvertBands(layout, (num_shares - 1) * num_bands / num_shares, num_bands);
+    workers.WaitForRequests();
+}
+
+void ConvertDisplayTransferPixels(const Config& config, const u8* src_pointer, u8* dst_pointer) {
+    int horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    int vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+
+    u32 output_width = config.output_width >> horizontal_scale;
+    u32 output_height = config.output_height >> vertical_scale;
+
+    for (u32 y = 0; y < output_height; ++y) {
+        for (u32 x = 0; x < output_width; ++x) {
+            Common::Vec4<u8> src_color;
+
+            // Calculate the [x,y] position of the input image
+            // based on the current output position and the scale
+            u32 input_x = x << horizontal_scale;
+            u32 input_y = y << vertical_scale;
+
+            u32 output_y;
+            if (config.flip_vertically) {
+                // Flip the y value of the output data,
+                // we do this after calculating the [x,y] position of the input image
+                // to account for the scaling options.
+                output_y = output_height - y - 1;
+            } else {
+                output_y = y;
+            }
+
+            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
+            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
+            u32 src_offset;
+            u32 dst_offset;
+
+            if (config.input_linear) {
+                if (!config.dont_swizzle) {
+                    // Interpret the input as linear and the output as tiled
+                    u32 coarse_y = output_y & ~7;
+                    u32 stride = output_width * dst_bytes_per_pixel;
+
+                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
+                                 coarse_y * stride;
+                } else {
+                    // Both input and output are linear
+                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                }
+            } else {
+                if (!config.dont_swizzle) {
+                    // Interpret the input as tiled and the output as linear
+                    u32 coarse_y = input_y & ~7;
+                    u32 stride = config.input_width * src_bytes_per_pixel;
+
+                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
+                                 coarse_y * stride;
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                } else {
+                    // Both input and output are tiled
+                    u32 out_coarse_y = output_y & ~7;
+                    u32 out_stride = output_width * dst_bytes_per_pixel;
+
+                    u32 in_coarse_y = input_y & ~7;
+                    u32 in_stride = config.input_width * src_bytes_per_pixel;
+
+                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
+                                 in_coarse_y * in_stride;
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
+                                 out_coarse_y * out_stride;
+                }
+            }
+
+            const u8* src_pixel = src_pointer + src_offset;
+            src_color = DecodePixel(config.input_format, src_pixel);
+            if (config.scaling == config.ScaleX) {
+                Common::Vec4<u8> pixel =
+                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
+                src_color = ((src_color + pixel) / 2).Cast<u8>();
+            } else if (config.scaling == config.ScaleXY) {
+                Common::Vec4<u8> pixel1 =
+                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
+                Common::Vec4<u8> pixel2 =
+                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
+                Common::Vec4<u8> pixel3 =
+                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
+                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+            }
+
+            u8* dst_pixel = dst_pointer + dst_offset;
+            switch (config.output_format) {
+            case Regs::PixelFormat::RGBA8:
+                Common::Color::EncodeRGBA8(src_color, dst_pixel);
+                break;
+
+            case Regs::PixelFormat::RGB8:
+                Common::Color::EncodeRGB8(src_color, dst_pixel);
+                break;
+
+            case Regs::PixelFormat::RGB565:
+                Common::Color::EncodeRGB565(src_color, dst_pixel);
+                break;
+
+            case Regs::PixelFormat::RGB5A1:
+                Common::Color::EncodeRGB5A1(src_color, dst_pixel);
+                break;
+
+            case Regs::PixelFormat::RGBA4:
+                Common::Color::EncodeRGBA4(src_color, dst_pixel);
+                break;
+
+            default:
+                LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
+                          static_cast<u32>(config.output_format.Value()));
+                break;
+            }
+        }
+    }
+}
+
+} // namespace GPU
@@ -0,0 +1,26 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "core/hw/gpu.h"
+
+namespace GPU {
+
+/**
+ * Converts the pixels of a display transfer on the CPU, one band of eight output rows at a time.
+ * Each band is decoded tile by tile to RGBA8, downscaled and encoded to the output format, and
+ * large transfers are split among worker threads if allowed. Transfers whose input and output
+ * overlap or whose tiled side is not made of whole tiles are converted pixel by pixel instead.
+ * The scaling mode must be supported, see DisplayTransfer.
+ */
+void ConvertDisplayTransfer(const Regs::DisplayTransferConfig& config, const u8* src, u8* dst,
+                            bool allow_multithreading = true);
+
+/// Converts the pixels of a display transfer one at a time, in the order the hardware does
+void ConvertDisplayTransferPixels(const Regs::DisplayTransferConfig& config, const u8* src,
+                                  u8* dst);
+
+} // namespace GPU
@@ -5,24 +5,26 @@
 #include <cstring>
 #include <numeric>
 #include <type_traits>
+#include <utility>
 #include "common/alignment.h"
-#include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
-#include "common/vector_math.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/service/gsp/gsp.h"
+#include "core/hw/display_transfer.h"
 #include "core/hw/gpu.h"
 #include "core/hw/hw.h"
+#include "core/hw/lcd.h"
 #include "core/memory.h"
+#include "core/rewind.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
-#include "video_core/utils.h"
 #include "video_core/video_core.h"
 
 namespace GPU {
@@ -32,6 +34,10 @@ Memory::MemorySystem* g_memory;
 
 /// Event id for CoreTiming
 static Core::TimingEventType* vblank_event;
+/// Event signalling the interrupts raised on the GPU thread
+static Core::TimingEventType* interrupt_event;
+
+static DeferredInterrupts deferred_interrupts;
 
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
@@ -47,33 +53,10 @@ inline void Read(T& var, const u32 raw_addr) {
     var = g_regs[addr / 4];
 }
 
-static Common::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
-    switch (input_format) {
-    case Regs::PixelFormat::RGBA8:
-        return Common::Color::DecodeRGBA8(src_pixel);
-
-    case Regs::PixelFormat::RGB8:
-        return Common::Color::DecodeRGB8(src_pixel);
-
-    case Regs::PixelFormat::RGB565:
-        return Common::Color::DecodeRGB565(src_pixel);
-
-    case Regs::PixelFormat::RGB5A1:
-        return Common::Color::DecodeRGB5A1(src_pixel);
-
-    case Regs::PixelFormat::RGBA4:
-        return Common::Color::DecodeRGBA4(src_pixel);
-
-    default:
-        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", input_format);
-        return {0, 0, 0, 0};
-    }
-}
-
 MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
 MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
 
-static void MemoryFill(const Regs::MemoryFillConfig& config) {
+void MemoryFill(const Regs::MemoryFillConfig& config) {
     const PAddr start_addr = config.GetStartAddress();
     const PAddr end_addr = config.GetEndAddress();
 
@@ -126,7 +109,7 @@ static void MemoryFill(const Regs::MemoryFillConfig& config) {
     }
 }
 
-static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
+void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     const PAddr src_addr = config.GetPhysicalInputAddress();
     const PAddr dst_addr = config.GetPhysicalOutputAddress();
 
@@ -193,116 +176,10 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
 
-    for (u32 y = 0; y < output_height; ++y) {
-        for (u32 x = 0; x < output_width; ++x) {
-            Common::Vec4<u8> src_color;
-
-            // Calculate the [x,y] position of the input image
-            // based on the current output position and the scale
-            u32 input_x = x << horizontal_scale;
-            u32 input_y = y << vertical_scale;
-
-            u32 output_y;
-            if (config.flip_vertically) {
-                // Flip the y value of the output data,
-                // we do this after calculating the [x,y] position of the input image
-                // to account for the scaling options.
-                output_y = output_height - y - 1;
-            } else {
-                output_y = y;
-            }
-
-            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
-            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
-            u32 src_offset;
-            u32 dst_offset;
-
-            if (config.input_linear) {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as linear and the output as tiled
-                    u32 coarse_y = output_y & ~7;
-                    u32 stride = output_width * dst_bytes_per_pixel;
-
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 coarse_y * stride;
-                } else {
-                    // Both input and output are linear
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                }
-            } else {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as tiled and the output as linear
-                    u32 coarse_y = input_y & ~7;
-                    u32 stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 coarse_y * stride;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                } else {
-                    // Both input and output are tiled
-                    u32 out_coarse_y = output_y & ~7;
-                    u32 out_stride = output_width * dst_bytes_per_pixel;
-
-                    u32 in_coarse_y = input_y & ~7;
-                    u32 in_stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 in_coarse_y * in_stride;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 out_coarse_y * out_stride;
-                }
-            }
-
-            const u8* src_pixel = src_pointer + src_offset;
-            src_color = DecodePixel(config.input_format, src_pixel);
-            if (config.scaling == config.ScaleX) {
-                Common::Vec4<u8> pixel =
-                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
-                src_color = ((src_color + pixel) / 2).Cast<u8>();
-            } else if (config.scaling == config.ScaleXY) {
-                Common::Vec4<u8> pixel1 =
-                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel2 =
-                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel3 =
-                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
-                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
-            }
-
-            u8* dst_pixel = dst_pointer + dst_offset;
-            switch (config.output_format) {
-            case Regs::PixelFormat::RGBA8:
-                Common::Color::EncodeRGBA8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB8:
-                Common::Color::EncodeRGB8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB565:
-                Common::Color::EncodeRGB565(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB5A1:
-                Common::Color::EncodeRGB5A1(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGBA4:
-                Common::Color::EncodeRGBA4(src_color, dst_pixel);
-                break;
-
-            default:
-                LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
-                          static_cast<u32>(config.output_format.Value()));
-                break;
-            }
-        }
-    }
+    ConvertDisplayTransfer(config, src_pointer, dst_pointer);
 }
 
-static void TextureCopy(const Regs::DisplayTransferConfig& config) {
+void TextureCopy(const Regs::DisplayTransferConfig& config) {
     const PAddr src_addr = config.GetPhysicalInputAddress();
     const PAddr dst_addr = config.GetPhysicalOutputAddress();
 
@@ -406,20 +283,18 @@ inline void Write(u32 addr, const T data) {
         auto& config = g_regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
-            MemoryFill(config);
+            g_memory->InvalidateWrittenRegions();
+            // The GPU thread signals the interrupt once it has performed the fill
+            if (VideoCore::g_gpu_thread) {
+                QueueOnGPUThread([&](bool block) {
+                    VideoCore::g_gpu_thread->MemoryFill(config, is_second_filler, block);
+                });
+            } else {
+                ProcessMemoryFill(config, is_second_filler);
+            }
             LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
                       config.GetEndAddress());
 
-            // It seems that it won't signal interrupt if "address_start" is zero.
-            // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
-                if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
-                } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
-                }
-            }
-
             // Reset "trigger" flag and set the "finish" flag
             // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
             config.trigger.Assign(0);
@@ -438,8 +313,17 @@ inline void Write(u32 addr, const T data) {
                 Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
                                                nullptr);
 
+            g_memory->InvalidateWrittenRegions();
+            // The GPU thread signals the interrupt once it has performed the transfer
+            if (VideoCore::g_gpu_thread) {
+                QueueOnGPUThread([&](bool block) {
+                    VideoCore::g_gpu_thread->DisplayTransfer(config, block);
+                });
+            } else {
+                ProcessDisplayTransfer(config);
+            }
+
             if (config.is_texture_copy) {
-                TextureCopy(config);
                 LOG_TRACE(HW_GPU,
                           "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
                           "{:#010X}({}+{}), flags {:#010X}",
@@ -448,7 +332,6 @@ inline void Write(u32 addr, const T data) {
                           config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
                           config.texture_copy.output_gap * 16, config.flags);
             } else {
-                DisplayTransfer(config);
                 LOG_TRACE(HW_GPU,
                           "DisplayTransfer: {:#010X}({}x{})-> "
                           "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
@@ -459,7 +342,6 @@ inline void Write(u32 addr, const T data) {
             }
 
             g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
         }
         break;
     }
@@ -470,7 +352,16 @@ inline void Write(u32 addr, const T data) {
         if (config.trigger & 1) {
             MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
 
-            Pica::CommandProcessor::ProcessCommandList(config.GetPhysicalAddress(), config.size);
+            g_memory->InvalidateWrittenRegions();
+            if (VideoCore::g_gpu_thread) {
+                QueueOnGPUThread([&](bool block) {
+                    VideoCore::g_gpu_thread->SubmitList(config.GetPhysicalAddress(), config.size,
+                                                        block);
+                });
+            } else {
+                Pica::CommandProcessor::ProcessCommandList(config.GetPhysicalAddress(),
+                                                           config.size);
+            }
 
             g_regs.command_processor_config.trigger = 0;
         }
@@ -502,9 +393,102 @@ template void Write<u32>(u32 addr, const u32 data);
 template void Write<u16>(u32 addr, const u16 data);
 template void Write<u8>(u32 addr, const u8 data);
 
+void ProcessMemoryFill(const Regs::MemoryFillConfig& config, bool is_second_filler) {
+    MemoryFill(config);
+
+    // It seems that it won't signal interrupt if "address_start" is zero.
+    // TODO: hwtest this
+    if (config.GetStartAddress() != 0) {
+        GPU::SignalInterrupt(is_second_filler ? Service::GSP::InterruptId::PSC1
+                                              : Service::GSP::InterruptId::PSC0);
+    }
+}
+
+void ProcessDisplayTransfer(const Regs::DisplayTransferConfig& config) {
+    if (config.is_texture_copy) {
+        TextureCopy(config);
+    } else {
+        DisplayTransfer(config);
+    }
+    GPU::SignalInterrupt(Service::GSP::InterruptId::PPF);
+}
+
+static void InterruptCallback(std::uintptr_t user_data, s64 cycles_late) {
+    Service::GSP::SignalInterrupt(static_cast<Service::GSP::InterruptId>(user_data));
+}
+
+void SignalInterrupt(Service::GSP::InterruptId interrupt_id) {
+    if (VideoCore::g_gpu_thread && VideoCore::g_gpu_thread->IsGPUThread()) {
+        if (deferred_interrupts.Defer(interrupt_id)) {
+            return;
+        }
+        Core::System::GetInstance().CoreTiming().ScheduleEventThreadsafe(
+            interrupt_event, static_cast<std::uintptr_t>(interrupt_id));
+        return;
+    }
+    Service::GSP::SignalInterrupt(interrupt_id);
+}
+
+void DeferredInterrupts::Begin() {
+    std::scoped_lock lock{mutex};
+    is_deferring = true;
+}
+
+bool DeferredInterrupts::Defer(Service::GSP::InterruptId interrupt_id) {
+    std::scoped_lock lock{mutex};
+    if (!is_deferring) {
+        return false;
+    }
+    interrupts.push_back(interrupt_id);
+    return true;
+}
+
+std::vector<Service::GSP::InterruptId> DeferredInterrupts::End() {
+    std::scoped_lock lock{mutex};
+    is_deferring = false;
+    return std::exchange(interrupts, {});
+}
+
+/**
+ * Queues an operation on the GPU thread with queue(block). While movies or rewind need a
+ * deterministic emulation, the emulation thread waits for the operation and signals its interrupts
+ * itself, as if there was no GPU thread.
+ */
+template <typename Queue>
+static void QueueOnGPUThread(Queue&& queue) {
+    if (!Core::System::GetInstance().RequiresDeterminism()) {
+        queue(false);
+        return;
+    }
+    deferred_interrupts.Begin();
+    queue(true);
+    for (const auto interrupt_id : deferred_interrupts.End()) {
+        Service::GSP::SignalInterrupt(interrupt_id);
+    }
+}
+
+/// Captures the registers the frame is presented with
+static VideoCore::FrameInfo CaptureFrameInfo() {
+    VideoCore::FrameInfo frame{};
+    frame.framebuffer_config = {g_regs.framebuffer_config[0], g_regs.framebuffer_config[1]};
+    // Main LCD (0): 0x1ED02204, Sub LCD (1): 0x1ED02A04
+    LCD::Read(frame.color_fill[0].raw, HW::VADDR_LCD + 4 * LCD_REG_INDEX(color_fill_top));
+    LCD::Read(frame.color_fill[1].raw, HW::VADDR_LCD + 4 * LCD_REG_INDEX(color_fill_bottom));
+    frame.system_time = Core::System::GetInstance().CoreTiming().GetGlobalTimeUs();
+    return frame;
+}
+
 /// Update hardware
 static void VBlankCallback(std::uintptr_t user_data, s64 cycles_late) {
-    VideoCore::g_renderer->SwapBuffers();
+    Core::System::GetInstance().RewindBuffer().OnFrameEnd();
+
+    // The renderer may present framebuffers straight from the rasterizer cache
+    g_memory->InvalidateWrittenRegions();
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->SwapBuffers(CaptureFrameInfo());
+    } else {
+        VideoCore::g_renderer->SwapBuffers(CaptureFrameInfo());
+    }
 
     // Signal to GSP that GPU interrupt has occurred
     // TODO(yuriks): hwtest to determine if PDC0 is for the Top screen and PDC1 for the Sub
@@ -552,6 +536,7 @@ void Init(Memory::MemorySystem& memory) {
     Core::Timing& timing = Core::System::GetInstance().CoreTiming();
     vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
     timing.ScheduleEvent(frame_ticks, vblank_event);
+    interrupt_event = timing.RegisterEvent("GPU::InterruptCallback", InterruptCallback);
 
     LOG_DEBUG(HW_GPU, "initialized OK");
 }
@@ -5,7 +5,9 @@
 #pragma once
 
 #include <cstddef>
+#include <mutex>
 #include <type_traits>
+#include <vector>
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/binary_object.hpp>
 #include "common/assert.h"
@@ -18,6 +20,10 @@ namespace Memory {
 class MemorySystem;
 }
 
+namespace Service::GSP {
+enum class InterruptId : u8;
+}
+
 namespace GPU {
 
 // Measured on hardware to be 2240568 timer cycles or 4481136 ARM11 cycles
@@ -322,6 +328,49 @@ void Read(T& var, const u32 addr);
 template <typename T>
 void Write(u32 addr, const T data);
 
+/// Performs a memory fill, using the rasterizer if possible
+void MemoryFill(const Regs::MemoryFillConfig& config);
+
+/// Performs a display transfer, using the rasterizer if possible
+void DisplayTransfer(const Regs::DisplayTransferConfig& config);
+
+/// Performs a texture copy, using the rasterizer if possible
+void TextureCopy(const Regs::DisplayTransferConfig& config);
+
+/// Performs a memory fill and signals its completion interrupt
+void ProcessMemoryFill(const Regs::MemoryFillConfig& config, bool is_second_filler);
+
+/// Performs a display transfer or texture copy and signals its completion interrupt
+void ProcessDisplayTransfer(const Regs::DisplayTransferConfig& config);
+
+/**
+ * Signals a GSP interrupt. Interrupts wake up guest threads, so those raised on the GPU thread are
+ * signalled on the emulation thread instead: right after the operation if the emulation thread
+ * waits for it, at its next slice boundary otherwise.
+ */
+void SignalInterrupt(Service::GSP::InterruptId interrupt_id);
+
+/**
+ * Collects the interrupts raised by the GPU thread while the emulation thread waits for it, so
+ * they can be signalled at the same point of emulation as when there is no GPU thread.
+ */
+class DeferredInterrupts {
+public:
+    /// Starts deferring interrupts, before the operation is queued
+    void Begin();
+
+    /// Defers the interrupt if Begin was called, returns false otherwise
+    bool Defer(Service::GSP::InterruptId interrupt_id);
+
+    /// Stops deferring and returns the interrupts raised in the meantime, in order
+    std::vector<Service::GSP::InterruptId> End();
+
+private:
+    std::mutex mutex;
+    bool is_deferring = false;
+    std::vector<Service::GSP::InterruptId> interrupts;
+};
+
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory);
 
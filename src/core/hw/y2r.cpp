@@ -5,16 +5,28 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+#include "common/arch.h"
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
+#include "common/thread_worker.h"
 #include "common/vector_math.h"
 #include "core/core.h"
 #include "core/hle/service/y2r_u.h"
 #include "core/hw/y2r.h"
 #include "core/memory.h"
 
+#if CITRA_ARCH(x86_64)
+#include <emmintrin.h>
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
 namespace HW::Y2R {
 
 using namespace Service::Y2R;
@@ -23,55 +35,197 @@ static const std::size_t MAX_TILES = 1024 / 8;
 static const std::size_t TILE_SIZE = 8 * 8;
 using ImageTile = std::array<u32, TILE_SIZE>;
 
+/// Conversions of at least this many pixels are split among worker threads when possible
+static constexpr std::size_t MULTITHREAD_MIN_PIXELS = 256 * 256;
+
+/// Converts one pixel to RGB32, with red in the most significant byte
+[[maybe_unused]] static u32 ConvertPixel(s32 Y, s32 U, s32 V, const CoefficientSet& coefficients) {
+    // This conversion process is bit-exact with hardware, as far as could be tested.
+    auto& c = coefficients;
+    s32 cY = c[0] * Y;
+
+    s32 r = cY + c[1] * V;
+    s32 g = cY - c[2] * V - c[3] * U;
+    s32 b = cY + c[4] * U;
+
+    const s32 rounding_offset = 0x18;
+    r = (r >> 3) + c[5] + rounding_offset;
+    g = (g >> 3) + c[6] + rounding_offset;
+    b = (b >> 3) + c[7] + rounding_offset;
+
+    return ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) | ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
+           ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
+}
+
+// The line converters below convert the eight pixels of a tile line. Planar lines take the Y
+// values of the pixels and the U and V values shared by each pair of pixels, interleaved lines
+// take the YUYV data of the pixels. SSE2 and NEON are part of the baseline of their
+// architectures, so no runtime dispatch is needed.
+
+#if CITRA_ARCH(x86_64)
+
+/// Returns a vector multiplying the low and high 16 bits of each lane by a and b with madd
+static __m128i CoefficientPair(s16 a, s16 b) {
+    return _mm_set1_epi32(static_cast<int>(static_cast<u16>(a) | static_cast<u32>(b) << 16));
+}
+
+/// Converts eight pixels given as 16-bit Y, U and V values to RGB32
+static void ConvertLine(__m128i Y, __m128i U, __m128i V, const CoefficientSet& c, u32* output) {
+    // Every product of a coefficient and a 8-bit value fits in 32 bits, as in the scalar code
+    const auto convert = [&](__m128i YV, __m128i YU, __m128i VU, __m128i& r, __m128i& g,
+                             __m128i& b) {
+        const __m128i cY = _mm_madd_epi16(YV, CoefficientPair(c[0], 0));
+        r = _mm_madd_epi16(YV, CoefficientPair(c[0], c[1]));
+        g = _mm_sub_epi32(cY, _mm_madd_epi16(VU, CoefficientPair(c[2], c[3])));
+        b = _mm_madd_epi16(YU, CoefficientPair(c[0], c[4]));
+    };
+    const auto scale = [](__m128i low, __m128i high, s16 offset) {
+        const __m128i rounding = _mm_set1_epi32(offset + 0x18);
+        low = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(low, 3), rounding), 5);
+        high = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(high, 3), rounding), 5);
+        // Saturating packs clamp to [0, 255]
+        const __m128i words = _mm_packs_epi32(low, high);
+        return _mm_packus_epi16(words, words);
+    };
+
+    __m128i r_low, g_low, b_low, r_high, g_high, b_high;
+    convert(_mm_unpacklo_epi16(Y, V), _mm_unpacklo_epi16(Y, U), _mm_unpacklo_epi16(V, U), r_low,
+            g_low, b_low);
+    convert(_mm_unpackhi_epi16(Y, V), _mm_unpackhi_epi16(Y, U), _mm_unpackhi_epi16(V, U), r_high,
+            g_high, b_high);
+    const __m128i r = scale(r_low, r_high, c[5]);
+    const __m128i g = scale(g_low, g_high, c[6]);
+    const __m128i b = scale(b_low, b_high, c[7]);
+
+    const __m128i zero_b = _mm_unpacklo_epi8(_mm_setzero_si128(), b);
+    const __m128i g_r = _mm_unpacklo_epi8(g, r);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi16(zero_b, g_r));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), _mm_unpackhi_epi16(zero_b, g_r));
+}
+
+static void ConvertPlanarLine(const u8* Y, const u8* U, const u8* V, const CoefficientSet& c,
+                              u32* output) {
+    const auto load_shared = [](const u8* values) {
+        u32 raw;
+        std::memcpy(&raw, values, sizeof(raw));
+        const __m128i bytes = _mm_cvtsi32_si128(static_cast<int>(raw));
+        return _mm_unpacklo_epi8(_mm_unpacklo_epi8(bytes, bytes), _mm_setzero_si128());
+    };
+    const __m128i Y_words = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(Y)), _mm_setzero_si128());
+    ConvertLine(Y_words, load_shared(U), load_shared(V), c, output);
+}
+
+static void ConvertInterleavedLine(const u8* YUYV, const CoefficientSet& c, u32* output) {
+    const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(YUYV));
+    const __m128i Y = _mm_and_si128(data, _mm_set1_epi16(0xFF));
+    // Each 32-bit lane holds the U and V values of a pair of pixels
+    const __m128i UV = _mm_srli_epi16(data, 8);
+    const __m128i U = _mm_and_si128(UV, _mm_set1_epi32(0xFFFF));
+    const __m128i V = _mm_srli_epi32(UV, 16);
+    ConvertLine(Y, _mm_or_si128(U, _mm_slli_epi32(U, 16)), _mm_or_si128(V, _mm_slli_epi32(V, 16)),
+                c, output);
+}
+
+#elif CITRA_ARCH(arm64)
+
+/// Converts eight pixels given as 8-bit Y, U and V values to RGB32
+static void ConvertLine(uint8x8_t Y, uint8x8_t U, uint8x8_t V, const CoefficientSet& c,
+                        u32* output) {
+    const int16x8_t Y_words = vreinterpretq_s16_u16(vmovl_u8(Y));
+    const int16x8_t U_words = vreinterpretq_s16_u16(vmovl_u8(U));
+    const int16x8_t V_words = vreinterpretq_s16_u16(vmovl_u8(V));
+
+    // Every product of a coefficient and a 8-bit value fits in 32 bits, as in the scalar code
+    const auto convert = [&](int16x4_t y, int16x4_t u, int16x4_t v, int32x4_t& r, int32x4_t& g,
+                             int32x4_t& b) {
+        const int32x4_t cY = vmull_n_s16(y, c[0]);
+        r = vmlal_n_s16(cY, v, c[1]);
+        g = vmlsl_n_s16(vmlsl_n_s16(cY, v, c[2]), u, c[3]);
+        b = vmlal_n_s16(cY, u, c[4]);
+    };
+    const auto scale = [](int32x4_t low, int32x4_t high, s16 offset) {
+        const int32x4_t rounding = vdupq_n_s32(offset + 0x18);
+        low = vshrq_n_s32(vaddq_s32(vshrq_n_s32(low, 3), rounding), 5);
+        high = vshrq_n_s32(vaddq_s32(vshrq_n_s32(high, 3), rounding), 5);
+        // Saturating narrows clamp to [0, 255]
+        return vqmovun_s16(vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    };
+
+    int32x4_t r_low, g_low, b_low, r_high, g_high, b_high;
+    convert(vget_low_s16(Y_words), vget_low_s16(U_words), vget_low_s16(V_words), r_low, g_low,
+            b_low);
+    convert(vget_high_s16(Y_words), vget_high_s16(U_words), vget_high_s16(V_words), r_high,
+            g_high, b_high);
+
+    const uint8x8x4_t pixels{{vdup_n_u8(0), scale(b_low, b_high, c[7]),
+                              scale(g_low, g_high, c[6]), scale(r_low, r_high, c[5])}};
+    vst4_u8(reinterpret_cast<u8*>(output), pixels);
+}
+
+static void ConvertPlanarLine(const u8* Y, const u8* U, const u8* V, const CoefficientSet& c,
+                              u32* output) {
+    const auto load_shared = [](const u8* values) {
+        u32 raw;
+        std::memcpy(&raw, values, sizeof(raw));
+        const uint8x8_t bytes = vcreate_u8(raw);
+        return vzip1_u8(bytes, bytes);
+    };
+    ConvertLine(vld1_u8(Y), load_shared(U), load_shared(V), c, output);
+}
+
+static void ConvertInterleavedLine(const u8* YUYV, const CoefficientSet& c, u32* output) {
+    const uint8x8x2_t data = vld2_u8(YUYV);
+    // The second half holds the U and V values of each pair of pixels in turn
+    const uint8x8_t U = vuzp1_u8(data.val[1], data.val[1]);
+    const uint8x8_t V = vuzp2_u8(data.val[1], data.val[1]);
+    ConvertLine(data.val[0], vzip1_u8(U, U), vzip1_u8(V, V), c, output);
+}
+
+#else
+
+static void ConvertPlanarLine(const u8* Y, const u8* U, const u8* V, const CoefficientSet& c,
+                              u32* output) {
+    for (unsigned int x = 0; x < 8; ++x) {
+        output[x] = ConvertPixel(Y[x], U[x / 2], V[x / 2], c);
+    }
+}
+
+static void ConvertInterleavedLine(const u8* YUYV, const CoefficientSet& c, u32* output) {
+    for (unsigned int x = 0; x < 8; ++x) {
+        output[x] = ConvertPixel(YUYV[x * 2], YUYV[(x / 2) * 4 + 1], YUYV[(x / 2) * 4 + 3], c);
+    }
+}
+
+#endif
+
 /// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
 static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
                             const u8* input_V, ImageTile output[], unsigned int width,
                             unsigned int height, const CoefficientSet& coefficients) {
 
     for (unsigned int y = 0; y < height; ++y) {
-        for (unsigned int x = 0; x < width; ++x) {
-            s32 Y = 0;
-            s32 U = 0;
-            s32 V = 0;
+        for (unsigned int x = 0; x < width; x += 8) {
+            u32* out = &output[x / 8][y * 8];
             switch (input_format) {
             case InputFormat::YUV422_Indiv8:
-            case InputFormat::YUV422_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[(y * width + x) / 2];
-                V = input_V[(y * width + x) / 2];
+            case InputFormat::YUV422_Indiv16: {
+                const std::size_t shared = (y * width + x) / 2;
+                ConvertPlanarLine(input_Y + y * width + x, input_U + shared, input_V + shared,
+                                  coefficients, out);
                 break;
+            }
             case InputFormat::YUV420_Indiv8:
-            case InputFormat::YUV420_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[((y / 2) * width + x) / 2];
-                V = input_V[((y / 2) * width + x) / 2];
+            case InputFormat::YUV420_Indiv16: {
+                const std::size_t shared = ((y / 2) * width + x) / 2;
+                ConvertPlanarLine(input_Y + y * width + x, input_U + shared, input_V + shared,
+                                  coefficients, out);
                 break;
+            }
             case InputFormat::YUYV422_Interleaved:
-                Y = input_Y[(y * width + x) * 2];
-                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
-                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
+                ConvertInterleavedLine(input_Y + (y * width + x) * 2, coefficients, out);
                 break;
             }
-
-            // This conversion process is bit-exact with hardware, as far as could be tested.
-            auto& c = coefficients;
-            s32 cY = c[0] * Y;
-
-            s32 r = cY + c[1] * V;
-            s32 g = cY - c[2] * V - c[3] * U;
-            s32 b = cY + c[4] * U;
-
-            const s32 rounding_offset = 0x18;
-            r = (r >> 3) + c[5] + rounding_offset;
-            g = (g >> 3) + c[6] + rounding_offset;
-            b = (b >> 3) + c[7] + rounding_offset;
-
-            unsigned int tile = x / 8;
-            unsigned int tile_x = x % 8;
-            u32* out = &output[tile][y * 8 + tile_x];
-            *out = ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) |
-                   ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
-                   ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
         }
     }
 }
@@ -87,8 +241,12 @@ static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuff
     ASSERT(amount_of_data % output_unit == 0);
 
     while (amount_of_data > 0) {
-        for (std::size_t i = 0; i < output_unit; ++i) {
-            output[i] = input[i * N];
+        if constexpr (N == 1) {
+            std::memcpy(output, input, output_unit);
+        } else {
+            for (std::size_t i = 0; i < output_unit; ++i) {
+                output[i] = input[i * N];
+            }
         }
 
         output += output_unit;
@@ -100,38 +258,85 @@ static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuff
     }
 }
 
+template <OutputFormat output_format>
+static void EncodePixels(const u32* input, u8* output, std::size_t count, u8 alpha) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const u32 color = input[i];
+        if constexpr (output_format == OutputFormat::RGBA8) {
+            const u32_le pixel = (color & 0xFFFFFF00) | alpha;
+            std::memcpy(output + i * 4, &pixel, sizeof(pixel));
+        } else if constexpr (output_format == OutputFormat::RGB8) {
+            output[i * 3] = static_cast<u8>(color >> 8);
+            output[i * 3 + 1] = static_cast<u8>(color >> 16);
+            output[i * 3 + 2] = static_cast<u8>(color >> 24);
+        } else {
+            const Common::Vec4<u8> col_vec{static_cast<u8>(color >> 24),
+                                           static_cast<u8>(color >> 16),
+                                           static_cast<u8>(color >> 8), alpha};
+            if constexpr (output_format == OutputFormat::RGB5A1) {
+                Common::Color::EncodeRGB5A1(col_vec, output + i * 2);
+            } else {
+                Common::Color::EncodeRGB565(col_vec, output + i * 2);
+            }
+        }
+    }
+}
+
+void EncodeRGB(OutputFormat output_format, const u32* input, u8* output, std::size_t count,
+               u8 alpha) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        return EncodePixels<OutputFormat::RGBA8>(input, output, count, alpha);
+    case OutputFormat::RGB8:
+        return EncodePixels<OutputFormat::RGB8>(input, output, count, alpha);
+    case OutputFormat::RGB5A1:
+        return EncodePixels<OutputFormat::RGB5A1>(input, output, count, alpha);
+    case OutputFormat::RGB565:
+        return EncodePixels<OutputFormat::RGB565>(input, output, count, alpha);
+    }
+}
+
+static std::size_t GetBytesPerPixel(OutputFormat output_format) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        return 4;
+    case OutputFormat::RGB8:
+        return 3;
+    case OutputFormat::RGB5A1:
+    case OutputFormat::RGB565:
+        return 2;
+    }
+    UNREACHABLE();
+}
+
 /// Convert intermediate RGB32 format to the final output format while simulating an outgoing CDMA
 /// transfer.
 static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionBuffer& buf,
                      int amount_of_data, OutputFormat output_format, u8 alpha) {
 
     u8* output = memory.GetPointer(buf.address);
+    const std::size_t bytes_per_pixel = GetBytesPerPixel(output_format);
+
+    // Transfer units holding whole pixels are encoded in one go
+    if (buf.transfer_unit % bytes_per_pixel == 0) {
+        const std::size_t unit_pixels = buf.transfer_unit / bytes_per_pixel;
+        while (amount_of_data > 0) {
+            EncodeRGB(output_format, input, output, unit_pixels, alpha);
+            input += unit_pixels;
+            amount_of_data -= static_cast<int>(unit_pixels);
+
+            output += buf.transfer_unit + buf.gap;
+            buf.address += buf.transfer_unit + buf.gap;
+            buf.image_size -= buf.transfer_unit;
+        }
+        return;
+    }
 
     while (amount_of_data > 0) {
         u8* unit_end = output + buf.transfer_unit;
         while (output < unit_end) {
-            u32 color = *input++;
-            Common::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8), alpha};
-
-            switch (output_format) {
-            case OutputFormat::RGBA8:
-                Common::Color::EncodeRGBA8(col_vec, output);
-                output += 4;
-                break;
-            case OutputFormat::RGB8:
-                Common::Color::EncodeRGB8(col_vec, output);
-                output += 3;
-                break;
-            case OutputFormat::RGB5A1:
-                Common::Color::EncodeRGB5A1(col_vec, output);
-                output += 2;
-                break;
-            case OutputFormat::RGB565:
-                Common::Color::EncodeRGB565(col_vec, output);
-                output += 2;
-                break;
-            }
-
+            EncodeRGB(output_format, input++, output, 1, alpha);
+            output += bytes_per_pixel;
             amount_of_data -= 1;
         }
 
@@ -202,14 +407,170 @@ static void RotateTile270(const ImageTile& input, ImageTile& output, int height,
     }
 }
 
-static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, int line_stride) {
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            output[y * line_stride + x] = tile[y * 8 + x];
+/// Receives the YUV data of a strip into the input buffer layout expected by ConvertStrip
+static void ReceiveStrip(Memory::MemorySystem& memory, ConversionConfiguration& cvt, u8* input,
+                         unsigned int row_height) {
+    // Total size in pixels of incoming data required for this strip.
+    const std::size_t row_data_size = row_height * cvt.input_line_width;
+
+    u8* input_Y = input;
+    u8* input_U = input_Y + 8 * cvt.input_line_width;
+    u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+        ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv8:
+        ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUV422_Indiv16:
+        ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv16:
+        ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        ReceiveData<1>(memory, input_Y, cvt.src_YUYV, row_data_size * 2);
+        break;
+    }
+}
+
+void ConvertStrip(const ConversionConfiguration& cvt, const u8* input, u32* output,
+                  unsigned int row_height) {
+    // Tiles per row
+    const std::size_t num_tiles = cvt.input_line_width / 8;
+
+    // Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
+    std::array<ImageTile, MAX_TILES> tiles;
+
+    const u8* input_Y = input;
+    const u8* input_U = input_Y + 8 * cvt.input_line_width;
+    const u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+    ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles.data(),
+                    cvt.input_line_width, row_height, cvt.coefficients);
+
+    // Unrotated linear lines are copied as they are
+    if (cvt.rotation == Rotation::None && cvt.block_alignment == BlockAlignment::Linear) {
+        for (std::size_t i = 0; i < num_tiles; ++i) {
+            for (unsigned int y = 0; y < row_height; ++y) {
+                std::memcpy(output + y * cvt.input_line_width + i * 8, &tiles[i][y * 8],
+                            8 * sizeof(u32));
+            }
+        }
+        return;
+    }
+
+    // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
+    // requiring two different code paths.
+    const u8* tile_remap = nullptr;
+    switch (cvt.block_alignment) {
+    case BlockAlignment::Linear:
+        tile_remap = linear_lut;
+        break;
+    case BlockAlignment::Block8x8:
+        tile_remap = morton_lut;
+        break;
+    }
+
+    // The rotation and remapping are the same for every tile of the strip, so they are applied
+    // once to a tile of pixel indices, which then tells each output pixel where to read from.
+    ImageTile index_tile;
+    ImageTile source_index{};
+    std::iota(index_tile.begin(), index_tile.end(), 0u);
+
+    int image_strip_width = 0;
+    int output_stride = 0;
+    bool reverse_tiles = false;
+    switch (cvt.rotation) {
+    case Rotation::None:
+        RotateTile0(index_tile, source_index, row_height, tile_remap);
+        image_strip_width = cvt.input_line_width;
+        output_stride = 8;
+        break;
+    case Rotation::Clockwise_90:
+        RotateTile90(index_tile, source_index, row_height, tile_remap);
+        image_strip_width = 8;
+        output_stride = 8 * row_height;
+        break;
+    case Rotation::Clockwise_180:
+        // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
+        // since the rotates are done individually on each tile.
+        RotateTile180(index_tile, source_index, row_height, tile_remap);
+        image_strip_width = cvt.input_line_width;
+        output_stride = 8;
+        reverse_tiles = true;
+        break;
+    case Rotation::Clockwise_270:
+        RotateTile270(index_tile, source_index, row_height, tile_remap);
+        image_strip_width = 8;
+        output_stride = 8 * row_height;
+        reverse_tiles = true;
+        break;
+    }
+
+    for (std::size_t i = 0; i < num_tiles; ++i) {
+        const ImageTile& tile = tiles[reverse_tiles ? num_tiles - i - 1 : i];
+        switch (cvt.block_alignment) {
+        case BlockAlignment::Linear:
+            for (unsigned int y = 0; y < row_height; ++y) {
+                for (int x = 0; x < 8; ++x) {
+                    output[y * image_strip_width + x] = tile[source_index[y * 8 + x]];
+                }
+            }
+            output += output_stride;
+            break;
+        case BlockAlignment::Block8x8:
+            for (std::size_t j = 0; j < TILE_SIZE; ++j) {
+                output[j] = tile[source_index[j]];
+            }
+            output += TILE_SIZE;
+            break;
         }
     }
 }
 
+static Common::ThreadWorker& GetConversionWorkers() {
+    static const std::size_t num_workers =
+        std::clamp<std::size_t>(std::thread::hardware_concurrency(), 2, 8) - 1;
+    static Common::ThreadWorker workers(num_workers, "Y2R");
+    return workers;
+}
+
+/// Returns the end of the memory touched by the transfers of a buffer, zero if they never end
+static u64 GetTransferEnd(const ConversionBuffer& buf) {
+    if (buf.transfer_unit == 0) {
+        return 0;
+    }
+    const u64 num_units = (static_cast<u64>(buf.image_size) + buf.transfer_unit - 1) /
+                          buf.transfer_unit;
+    return buf.address + num_units * (static_cast<u64>(buf.transfer_unit) + buf.gap);
+}
+
+/// Returns true if converting the strips out of order cannot change the result
+static bool CanConvertOutOfOrder(const ConversionConfiguration& cvt) {
+    const u64 dst_end = GetTransferEnd(cvt.dst);
+    if (dst_end == 0) {
+        return false;
+    }
+    const auto overlaps_dst = [&](const ConversionBuffer& src) {
+        const u64 src_end = GetTransferEnd(src);
+        return src_end == 0 || (src.address < dst_end && cvt.dst.address < src_end);
+    };
+    if (cvt.input_format == InputFormat::YUYV422_Interleaved) {
+        return !overlaps_dst(cvt.src_YUYV);
+    }
+    return !overlaps_dst(cvt.src_Y) && !overlaps_dst(cvt.src_U) && !overlaps_dst(cvt.src_V);
+}
+
 /**
  * Performs a Y2R colorspace conversion.
  *
@@ -267,114 +628,57 @@ void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cv
     std::size_t num_tiles = cvt.input_line_width / 8;
     ASSERT(num_tiles <= MAX_TILES);
 
-    // Buffer used as a CDMA source/target.
-    std::unique_ptr<u8[]> data_buffer(new u8[cvt.input_line_width * 8 * 4]);
-    // Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
-    std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
-    ImageTile tmp_tile;
-
-    // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
-    // requiring two different code paths.
-    const u8* tile_remap = nullptr;
-    switch (cvt.block_alignment) {
-    case BlockAlignment::Linear:
-        tile_remap = linear_lut;
-        break;
-    case BlockAlignment::Block8x8:
-        tile_remap = morton_lut;
-        break;
-    }
-
-    for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
-        unsigned int row_height = std::min(cvt.input_lines - y, 8u);
-
-        // Total size in pixels of incoming data required for this strip.
-        const std::size_t row_data_size = row_height * cvt.input_line_width;
-
-        u8* input_Y = data_buffer.get();
-        u8* input_U = input_Y + 8 * cvt.input_line_width;
-        u8* input_V = input_U + 8 * cvt.input_line_width / 2;
-
-        switch (cvt.input_format) {
-        case InputFormat::YUV422_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 2);
-            break;
-        case InputFormat::YUV420_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 4);
-            break;
-        case InputFormat::YUV422_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 2);
-            break;
-        case InputFormat::YUV420_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 4);
-            break;
-        case InputFormat::YUYV422_Interleaved:
-            input_U = nullptr;
-            input_V = nullptr;
-            ReceiveData<1>(memory, input_Y, cvt.src_YUYV, row_data_size * 2);
-            break;
+    const unsigned int num_strips = (cvt.input_lines + 7) / 8;
+    // Sizes of the buffers used as a CDMA target and source for a strip
+    const std::size_t strip_input_size = cvt.input_line_width * 8 * 4;
+    const std::size_t strip_output_size = cvt.input_line_width * 8;
+    const auto get_row_height = [&cvt](unsigned int strip) {
+        return std::min(cvt.input_lines - strip * 8, 8u);
+    };
+    const auto send_strip = [&](const u32* output, unsigned int strip) {
+        const std::size_t row_data_size = get_row_height(strip) * cvt.input_line_width;
+        SendData(memory, output, cvt.dst, static_cast<int>(row_data_size), cvt.output_format,
+                 static_cast<u8>(cvt.alpha));
+    };
+
+    const std::size_t num_pixels = static_cast<std::size_t>(cvt.input_line_width) * cvt.input_lines;
+    if (num_pixels < MULTITHREAD_MIN_PIXELS || num_strips < 2 || !CanConvertOutOfOrder(cvt)) {
+        std::vector<u8> input(strip_input_size);
+        std::vector<u32> output(strip_output_size);
+        for (unsigned int strip = 0; strip < num_strips; ++strip) {
+            ReceiveStrip(memory, cvt, input.data(), get_row_height(strip));
+            ConvertStrip(cvt, input.data(), output.data(), get_row_height(strip));
+            send_strip(output.data(), strip);
         }
+        return;
+    }
 
-        // Note(yuriks): If additional optimization is required, input_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles.get(),
-                        cvt.input_line_width, row_height, cvt.coefficients);
-
-        u32* output_buffer = reinterpret_cast<u32*>(data_buffer.get());
-
-        for (std::size_t i = 0; i < num_tiles; ++i) {
-            int image_strip_width = 0;
-            int output_stride = 0;
-
-            switch (cvt.rotation) {
-            case Rotation::None:
-                RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_90:
-                RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
-            case Rotation::Clockwise_180:
-                // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
-                // since the rotates are done individually on each tile.
-                RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_270:
-                RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
-            }
+    // The output doesn't overlap the input, so all strips are received first, converted on the
+    // workers and this thread, which takes the last share, and then sent in order.
+    std::vector<u8> input(strip_input_size * num_strips);
+    std::vector<u32> output(strip_output_size * num_strips);
+    for (unsigned int strip = 0; strip < num_strips; ++strip) {
+        ReceiveStrip(memory, cvt, &input[strip * strip_input_size], get_row_height(strip));
+    }
 
-            switch (cvt.block_alignment) {
-            case BlockAlignment::Linear:
-                WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
-                output_buffer += output_stride;
-                break;
-            case BlockAlignment::Block8x8:
-                WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
-                output_buffer += TILE_SIZE;
-                break;
-            }
+    const auto convert_strips = [&](unsigned int first_strip, unsigned int end_strip) {
+        for (unsigned int strip = first_strip; strip < end_strip; ++strip) {
+            ConvertStrip(cvt, &input[strip * strip_input_size], &output[strip * strip_output_size],
+                         get_row_height(strip));
         }
+    };
+    auto& workers = GetConversionWorkers();
+    const unsigned int num_shares = std::min(num_strips, 8u);
+    for (unsigned int share = 0; share + 1 < num_shares; ++share) {
+        workers.QueueWork([&convert_strips, share, num_shares, num_strips] {
+            convert_strips(share * num_strips / num_shares, (share + 1) * num_strips / num_shares);
+        });
+    }
+    convert_strips((num_shares - 1) * num_strips / num_shares, num_strips);
+    workers.WaitForRequests();
 
-        // Note(yuriks): If additional optimization is required, output_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        SendData(memory, reinterpret_cast<u32*>(data_buffer.get()), cvt.dst, (int)row_data_size,
-                 cvt.output_format, (u8)cvt.alpha);
+    for (unsigned int strip = 0; strip < num_strips; ++strip) {
+        send_strip(&output[strip * strip_output_size], strip);
     }
 }
 } // namespace HW::Y2R
@@ -4,14 +4,31 @@
 
 #pragma once
 
+#include <cstddef>
+#include "common/common_types.h"
+
 namespace Memory {
 class MemorySystem;
 }
 
 namespace Service::Y2R {
+enum class OutputFormat : u8;
 struct ConversionConfiguration;
 } // namespace Service::Y2R
 
 namespace HW::Y2R {
 void PerformConversion(Memory::MemorySystem& memory, Service::Y2R::ConversionConfiguration& cvt);
+
+/**
+ * Converts a strip of at most 8 lines of YUV data, as received from CDMA, to RGB32 pixels in the
+ * order they are sent out, applying the rotation and block alignment of the conversion.
+ * The Y data is at the start of the input, followed by 8 lines of U and V data each for separate
+ * planes. The output holds 8 lines of pixels.
+ */
+void ConvertStrip(const Service::Y2R::ConversionConfiguration& cvt, const u8* input, u32* output,
+                  unsigned int row_height);
+
+/// Encodes RGB32 pixels, with red in the most significant byte, to the output format
+void EncodeRGB(Service::Y2R::OutputFormat output_format, const u32* input, u8* output,
+               std::size_t count, u8 alpha);
 } // namespace HW::Y2R
@@ -2,8 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/binary_object.hpp>
 #include "audio_core/dsp_interface.h"
@@ -11,9 +16,12 @@
 #include "common/assert.h"
 #include "common/atomic_ops.h"
 #include "common/common_types.h"
+#include "common/host_memory.h"
 #include "common/logging/log.h"
 #include "common/settings.h"
 #include "common/swap.h"
+#include "common/virtual_buffer.h"
+#include "common/write_watch.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/global.h"
@@ -23,6 +31,7 @@
 #include "core/hle/service/plgldr/plgldr.h"
 #include "core/hw/hw.h"
 #include "core/memory.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -89,16 +98,47 @@ private:
 
 class MemorySystem::Impl {
 public:
-    // Visual Studio would try to allocate these on compile time if they are std::array, which would
-    // exceed the memory limit.
-    std::unique_ptr<u8[]> fcram = std::make_unique<u8[]>(Memory::FCRAM_N3DS_SIZE);
-    std::unique_ptr<u8[]> vram = std::make_unique<u8[]>(Memory::VRAM_SIZE);
-    std::unique_ptr<u8[]> n3ds_extra_ram = std::make_unique<u8[]>(Memory::N3DS_EXTRA_RAM_SIZE);
+    // FCRAM, VRAM and the N3DS extra RAM, in this order. Allocated from whole host pages so that
+    // writes to them can be watched, and shared with fastmem so that they can be mapped into the
+    // fastmem arenas.
+    Common::HostMemory backing;
+    std::span<u8> fcram;
+    std::span<u8> vram;
+    std::span<u8> n3ds_extra_ram;
+
+    // Host mappings of the address spaces of the page tables for the JIT, see GetFastmemArena
+    struct FastmemArena {
+        std::unique_ptr<Common::HostMemoryArena> memory;
+        // The virtual pages mapping watched backing memory and the reverse, to find the mappings
+        // of a backing page when its watch changes. Only kept with host write tracking.
+        std::unordered_map<u32, u32> backing_pages;
+        std::unordered_multimap<u32, u32> virtual_pages;
+    };
+    // The CPU threads create arenas while the emulation thread updates them
+    std::mutex fastmem_mutex;
+    std::unordered_map<const PageTable*, FastmemArena> fastmem_arenas;
 
     std::shared_ptr<PageTable> current_page_table = nullptr;
     RasterizerCacheMarker cache_marker;
+
+    // Host write tracking of rasterizer-cached memory. Only pages in dirty_marker, which the
+    // rasterizer cache has not written back yet, are accessed through the cache, the other cached
+    // pages are mapped directly and CPU writes to them are caught by the watches instead.
+    std::unique_ptr<Common::WriteWatch> fcram_watch;
+    std::unique_ptr<Common::WriteWatch> vram_watch;
+    RasterizerCacheMarker dirty_marker;
     std::vector<std::shared_ptr<PageTable>> page_table_list;
 
+    // Cache and dirty marks made on the GPU thread, waiting for ApplyRasterizerMarks
+    struct RasterizerMark {
+        PAddr start;
+        u32 size;
+        bool is_dirty_mark;
+        bool value;
+    };
+    std::mutex rasterizer_marks_mutex;
+    std::vector<RasterizerMark> rasterizer_marks;
+
     AudioCore::DspInterface* dsp = nullptr;
 
     std::shared_ptr<BackingMem> fcram_mem;
@@ -108,16 +148,35 @@ public:
 
     Impl();
 
+    /// Returns true if CPU accesses to the page must go through the rasterizer cache
+    bool NeedsRasterizerAccess(VAddr vaddr) {
+        if (!cache_marker.IsCached(vaddr)) {
+            return false;
+        }
+        return !fcram_watch || dirty_marker.IsCached(vaddr);
+    }
+
+    /// Returns the watch of the region containing the physical address and the offset in it
+    std::pair<Common::WriteWatch*, std::size_t> GetWriteWatch(PAddr addr) const {
+        if (addr >= VRAM_PADDR && addr < VRAM_PADDR_END) {
+            return {vram_watch.get(), addr - VRAM_PADDR};
+        }
+        if (addr >= FCRAM_PADDR && addr < FCRAM_N3DS_PADDR_END) {
+            return {fcram_watch.get(), addr - FCRAM_PADDR};
+        }
+        return {nullptr, 0};
+    }
+
     const u8* GetPtr(Region r) const {
         switch (r) {
         case Region::VRAM:
-            return vram.get();
+            return vram.data();
         case Region::DSP:
             return dsp->GetDspMemory().data();
         case Region::FCRAM:
-            return fcram.get();
+            return fcram.data();
         case Region::N3DS:
-            return n3ds_extra_ram.get();
+            return n3ds_extra_ram.data();
         default:
             UNREACHABLE();
         }
@@ -126,13 +185,13 @@ public:
     u8* GetPtr(Region r) {
         switch (r) {
         case Region::VRAM:
-            return vram.get();
+            return vram.data();
         case Region::DSP:
             return dsp->GetDspMemory().data();
         case Region::FCRAM:
-            return fcram.get();
+            return fcram.data();
         case Region::N3DS:
-            return n3ds_extra_ram.get();
+            return n3ds_extra_ram.data();
         default:
             UNREACHABLE();
         }
@@ -153,6 +212,133 @@ public:
         }
     }
 
+    /// Returns true if writes to the backing memory at the offset must be caught by a watch
+    bool IsBackingWatched(std::size_t offset) const {
+        if (!fcram_watch) {
+            return false;
+        }
+        if (offset < fcram.size()) {
+            return fcram_watch->IsWatched(offset);
+        }
+        offset -= fcram.size();
+        return offset < vram.size() && vram_watch->IsWatched(offset);
+    }
+
+    /// Records the backing memory as written for the watch covering it, see MarkWritten
+    void MarkBackingWritten(const u8* ptr, std::size_t size) {
+        if (!fcram_watch) {
+            return;
+        }
+        if (ptr >= fcram.data() && ptr < fcram.data() + fcram.size()) {
+            fcram_watch->MarkWritten(ptr - fcram.data(), size);
+        } else if (ptr >= vram.data() && ptr < vram.data() + vram.size()) {
+            vram_watch->MarkWritten(ptr - vram.data(), size);
+        }
+    }
+
+    /// Maps the pages of the fastmem arena of the page table again, see MapFastmemPages
+    void UpdateFastmemArena(const PageTable& page_table, u32 first_page, u32 num_pages) {
+        std::scoped_lock lock{fastmem_mutex};
+        const auto it = fastmem_arenas.find(&page_table);
+        if (it != fastmem_arenas.end()) {
+            MapFastmemPages(it->second, page_table, first_page, num_pages);
+        }
+    }
+
+    /// Maps the pages showing the backing page again in every arena after its watch changed
+    void UpdateFastmemBackingPage(const Common::WriteWatch* watch, std::size_t watch_offset) {
+        const u8* const watched = watch == vram_watch.get() ? vram.data() : fcram.data();
+        const auto backing_page =
+            static_cast<u32>((watched - backing.data() + watch_offset) >> CITRA_PAGE_BITS);
+
+        std::scoped_lock lock{fastmem_mutex};
+        for (auto& [page_table, arena] : fastmem_arenas) {
+            const auto [begin, end] = arena.virtual_pages.equal_range(backing_page);
+            std::vector<u32> pages;
+            for (auto it = begin; it != end; ++it) {
+                pages.push_back(it->second);
+            }
+            for (const u32 page : pages) {
+                MapFastmemPages(arena, *page_table, page, 1);
+            }
+        }
+    }
+
+    /**
+     * Maps the pages of the fastmem arena like the page table maps them. Only directly mapped
+     * pages of the backing memory are accessible. Pages whose backing memory is watched are
+     * read-only wherever they are mapped, so that writes to them take the slow path, which writes
+     * through the watched memory. fastmem_mutex must be held.
+     */
+    void MapFastmemPages(FastmemArena& arena, const PageTable& page_table, u32 first_page,
+                         u32 num_pages) {
+        const u8* const backing_begin = backing.data();
+        const u8* const backing_end = backing_begin + backing.size();
+
+        // Consecutive pages mapping consecutive memory the same way are mapped in one go
+        constexpr std::size_t UNMAPPED = ~std::size_t{0};
+        std::size_t run_offset = UNMAPPED;
+        bool run_writable = false;
+        u32 run_start = first_page;
+        const auto flush_run = [&](u32 end_page) {
+            if (end_page == run_start) {
+                return;
+            }
+            const std::size_t length = std::size_t{end_page - run_start} * CITRA_PAGE_SIZE;
+            if (run_offset == UNMAPPED) {
+                arena.memory->Unmap(std::size_t{run_start} * CITRA_PAGE_SIZE, length);
+            } else {
+                arena.memory->Map(std::size_t{run_start} * CITRA_PAGE_SIZE, run_offset, length,
+                                  run_writable);
+            }
+        };
+
+        for (u32 page = first_page; page < first_page + num_pages; ++page) {
+            const u8* const pointer = page_table.GetPointerArray()[page];
+            std::size_t offset = UNMAPPED;
+            bool writable = false;
+            if (page_table.attributes[page] == PageType::Memory && pointer >= backing_begin &&
+                pointer < backing_end) {
+                offset = static_cast<std::size_t>(pointer - backing_begin);
+                writable = !IsBackingWatched(offset);
+            }
+            if (fcram_watch) {
+                TrackFastmemPage(arena, page, offset);
+            }
+
+            const std::size_t expected_offset =
+                run_offset == UNMAPPED
+                    ? UNMAPPED
+                    : run_offset + std::size_t{page - run_start} * CITRA_PAGE_SIZE;
+            if (offset != expected_offset || (offset != UNMAPPED && writable != run_writable)) {
+                flush_run(page);
+                run_start = page;
+                run_offset = offset;
+                run_writable = writable;
+            }
+        }
+        flush_run(first_page + num_pages);
+    }
+
+    /// Records the backing memory mapped at the virtual page, if it can be watched
+    void TrackFastmemPage(FastmemArena& arena, u32 page, std::size_t offset) {
+        const bool watchable = offset < fcram.size() + vram.size();
+        const auto backing_page = static_cast<u32>(offset >> CITRA_PAGE_BITS);
+        if (const auto it = arena.backing_pages.find(page); it != arena.backing_pages.end()) {
+            if (watchable && it->second == backing_page) {
+                return;
+            }
+            const auto [begin, end] = arena.virtual_pages.equal_range(it->second);
+            arena.virtual_pages.erase(std::find_if(
+                begin, end, [page](const auto& entry) { return entry.second == page; }));
+            arena.backing_pages.erase(it);
+        }
+        if (watchable) {
+            arena.backing_pages.emplace(page, backing_page);
+            arena.virtual_pages.emplace(backing_page, page);
+        }
+    }
+
     /**
      * This function should only be called for virtual addreses with attribute `PageType::Special`.
      */
@@ -302,11 +488,13 @@ private:
     void serialize(Archive& ar, const unsigned int file_version) {
         bool save_n3ds_ram = Settings::values.is_new_3ds.GetValue();
         ar& save_n3ds_ram;
-        ar& boost::serialization::make_binary_object(vram.get(), Memory::VRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            fcram.get(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            n3ds_extra_ram.get(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+        if (GetSerializationOptions(ar).serialize_ram) {
+            ar& boost::serialization::make_binary_object(vram.data(), Memory::VRAM_SIZE);
+            ar& boost::serialization::make_binary_object(
+                fcram.data(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
+            ar& boost::serialization::make_binary_object(
+                n3ds_extra_ram.data(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+        }
         ar& cache_marker;
         ar& page_table_list;
         // dsp is set from Core::System at startup
@@ -315,6 +503,13 @@ private:
         ar& vram_mem;
         ar& n3ds_extra_ram_mem;
         ar& dsp_mem;
+        if (Archive::is_loading::value) {
+            // The JIT may have created arenas while the cache marker was not loaded yet
+            std::scoped_lock lock{fastmem_mutex};
+            for (auto& [page_table, arena] : fastmem_arenas) {
+                MapFastmemPages(arena, *page_table, 0, PAGE_TABLE_NUM_ENTRIES);
+            }
+        }
     }
 };
 
@@ -345,11 +540,31 @@ private:
     friend class boost::serialization::access;
 };
 
+/// Returns true if the memory can be mapped into fastmem arenas for the JIT
+static bool IsFastmemSupported() {
+    return Settings::values.use_fastmem.GetValue() && Common::HostMemory::IsSharingSupported() &&
+           Common::GetHostPageSize() == CITRA_PAGE_SIZE;
+}
+
 MemorySystem::Impl::Impl()
-    : fcram_mem(std::make_shared<BackingMemImpl<Region::FCRAM>>(*this)),
+    : backing(FCRAM_N3DS_SIZE + VRAM_SIZE + N3DS_EXTRA_RAM_SIZE, IsFastmemSupported()),
+      fcram(backing.data(), FCRAM_N3DS_SIZE), vram(fcram.data() + FCRAM_N3DS_SIZE, VRAM_SIZE),
+      n3ds_extra_ram(vram.data() + VRAM_SIZE, N3DS_EXTRA_RAM_SIZE),
+      fcram_mem(std::make_shared<BackingMemImpl<Region::FCRAM>>(*this)),
       vram_mem(std::make_shared<BackingMemImpl<Region::VRAM>>(*this)),
       n3ds_extra_ram_mem(std::make_shared<BackingMemImpl<Region::N3DS>>(*this)),
-      dsp_mem(std::make_shared<BackingMemImpl<Region::DSP>>(*this)) {}
+      dsp_mem(std::make_shared<BackingMemImpl<Region::DSP>>(*this)) {
+    if (!Settings::values.host_write_tracking.GetValue()) {
+        return;
+    }
+    // The watches protect whole host pages, which must match the pages the cache marks
+    if (!Common::WriteWatch::IsSupported() || Common::GetHostPageSize() != CITRA_PAGE_SIZE) {
+        LOG_WARNING(HW_Memory, "Host write tracking is not supported on this host");
+        return;
+    }
+    fcram_watch = std::make_unique<Common::WriteWatch>(fcram.data(), fcram.size());
+    vram_watch = std::make_unique<Common::WriteWatch>(vram.data(), vram.size());
+}
 
 MemorySystem::MemorySystem() : impl(std::make_unique<Impl>()) {}
 MemorySystem::~MemorySystem() = default;
@@ -385,7 +600,7 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
         page_table.pointers[base] = memory;
 
         // If the memory to map is already rasterizer-cached, mark the page
-        if (type == PageType::Memory && impl->cache_marker.IsCached(base * CITRA_PAGE_SIZE)) {
+        if (type == PageType::Memory && impl->NeedsRasterizerAccess(base * CITRA_PAGE_SIZE)) {
             page_table.attributes[base] = PageType::RasterizerCachedMemory;
             page_table.pointers[base] = nullptr;
         }
@@ -394,6 +609,8 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
         if (memory != nullptr && memory.GetSize() > CITRA_PAGE_SIZE)
             memory += CITRA_PAGE_SIZE;
     }
+
+    impl->UpdateFastmemArena(page_table, end - size, size);
 }
 
 void MemorySystem::MapMemoryRegion(PageTable& page_table, VAddr base, u32 size, MemoryRef target) {
@@ -432,6 +649,28 @@ void MemorySystem::UnregisterPageTable(std::shared_ptr<PageTable> page_table) {
     if (it != impl->page_table_list.end()) {
         impl->page_table_list.erase(it);
     }
+    std::scoped_lock lock{impl->fastmem_mutex};
+    impl->fastmem_arenas.erase(page_table.get());
+}
+
+u8* MemorySystem::GetFastmemArena(const PageTable& page_table) {
+    if (!impl->backing.IsShared()) {
+        return nullptr;
+    }
+    std::scoped_lock lock{impl->fastmem_mutex};
+    auto& arena = impl->fastmem_arenas[&page_table];
+    if (!arena.memory) {
+        try {
+            arena.memory = std::make_unique<Common::HostMemoryArena>(impl->backing,
+                                                                     std::size_t{1} << 32);
+        } catch (const std::bad_alloc&) {
+            LOG_WARNING(HW_Memory, "Could not reserve a fastmem arena");
+            impl->fastmem_arenas.erase(&page_table);
+            return nullptr;
+        }
+        impl->MapFastmemPages(arena, page_table, 0, PAGE_TABLE_NUM_ENTRIES);
+    }
+    return arena.memory->data();
 }
 
 template <typename T>
@@ -718,61 +957,160 @@ static std::vector<VAddr> PhysicalToVirtualAddressForRasterizer(PAddr addr) {
     return {};
 }
 
+/// Returns true when called from the GPU thread, which must leave the page tables alone
+static bool IsGPUThread() {
+    return VideoCore::g_gpu_thread && VideoCore::g_gpu_thread->IsGPUThread();
+}
+
 void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached) {
     if (start == 0) {
         return;
     }
+    if (IsGPUThread()) {
+        std::scoped_lock lock{impl->rasterizer_marks_mutex};
+        impl->rasterizer_marks.push_back({start, size, false, cached});
+        return;
+    }
+    MarkRegionCached(start, size, cached);
+}
+
+void MemorySystem::RasterizerMarkRegionDirty(PAddr start, u32 size, bool dirty) {
+    if (start == 0 || !IsHostWriteTrackingEnabled()) {
+        return;
+    }
+    if (IsGPUThread()) {
+        std::scoped_lock lock{impl->rasterizer_marks_mutex};
+        impl->rasterizer_marks.push_back({start, size, true, dirty});
+        return;
+    }
+    MarkRegionDirty(start, size, dirty);
+}
+
+void MemorySystem::ApplyRasterizerMarks() {
+    std::vector<Impl::RasterizerMark> marks;
+    {
+        std::scoped_lock lock{impl->rasterizer_marks_mutex};
+        marks.swap(impl->rasterizer_marks);
+    }
+    for (const auto& mark : marks) {
+        if (mark.is_dirty_mark) {
+            MarkRegionDirty(mark.start, mark.size, mark.value);
+        } else {
+            MarkRegionCached(mark.start, mark.size, mark.value);
+        }
+    }
+}
+
+void MemorySystem::MarkRegionCached(PAddr start, u32 size, bool cached) {
 
     u32 num_pages = ((start + size - 1) >> CITRA_PAGE_BITS) - (start >> CITRA_PAGE_BITS) + 1;
     PAddr paddr = start;
 
     for (unsigned i = 0; i < num_pages; ++i, paddr += CITRA_PAGE_SIZE) {
-        for (VAddr vaddr : PhysicalToVirtualAddressForRasterizer(paddr)) {
+        const auto vaddrs = PhysicalToVirtualAddressForRasterizer(paddr);
+        if (vaddrs.empty()) {
+            continue;
+        }
+        if (impl->cache_marker.IsCached(vaddrs[0]) != cached) {
+            if (auto [watch, offset] = impl->GetWriteWatch(paddr); watch) {
+                watch->Watch(offset, CITRA_PAGE_SIZE, cached);
+                // The page may be mapped at other addresses than the ones updated below
+                impl->UpdateFastmemBackingPage(watch, offset);
+            }
+        }
+        for (VAddr vaddr : vaddrs) {
             impl->cache_marker.Mark(vaddr, cached);
-            for (auto page_table : impl->page_table_list) {
-                PageType& page_type = page_table->attributes[vaddr >> CITRA_PAGE_BITS];
-
-                if (cached) {
-                    // Switch page type to cached if now cached
-                    switch (page_type) {
-                    case PageType::Unmapped:
-                        // It is not necessary for a process to have this region mapped into its
-                        // address space, for example, a system module need not have a VRAM mapping.
-                        break;
-                    case PageType::Memory:
-                        page_type = PageType::RasterizerCachedMemory;
-                        page_table->pointers[vaddr >> CITRA_PAGE_BITS] = nullptr;
-                        break;
-                    default:
-                        UNREACHABLE();
-                    }
-                } else {
-                    // Switch page type to uncached if now uncached
-                    switch (page_type) {
-                    case PageType::Unmapped:
-                        // It is not necessary for a process to have this region mapped into its
-                        // address space, for example, a system module need not have a VRAM mapping.
-                        break;
-                    case PageType::RasterizerCachedMemory: {
-                        page_type = PageType::Memory;
-                        page_table->pointers[vaddr >> CITRA_PAGE_BITS] =
-                            GetPointerForRasterizerCache(vaddr & ~CITRA_PAGE_MASK);
-                        break;
-                    }
-                    default:
-                        UNREACHABLE();
-                    }
-                }
+            UpdateRasterizerPageType(vaddr);
+        }
+    }
+}
+
+void MemorySystem::MarkRegionDirty(PAddr start, u32 size, bool dirty) {
+    u32 num_pages = ((start + size - 1) >> CITRA_PAGE_BITS) - (start >> CITRA_PAGE_BITS) + 1;
+    PAddr paddr = start;
+
+    for (unsigned i = 0; i < num_pages; ++i, paddr += CITRA_PAGE_SIZE) {
+        const auto vaddrs = PhysicalToVirtualAddressForRasterizer(paddr);
+        if (vaddrs.empty() || impl->dirty_marker.IsCached(vaddrs[0]) == dirty) {
+            continue;
+        }
+        // The rasterizer cache writes dirty pages back itself, those writes must not be caught
+        if (auto [watch, offset] = impl->GetWriteWatch(paddr); watch) {
+            watch->Suspend(offset, CITRA_PAGE_SIZE, dirty);
+        }
+        for (VAddr vaddr : vaddrs) {
+            impl->dirty_marker.Mark(vaddr, dirty);
+            UpdateRasterizerPageType(vaddr);
+        }
+    }
+}
+
+bool MemorySystem::IsHostWriteTrackingEnabled() const {
+    return impl->fcram_watch != nullptr;
+}
+
+void MemorySystem::InvalidateWrittenRegions() {
+    if (!IsHostWriteTrackingEnabled()) {
+        return;
+    }
+    const std::array<std::pair<PAddr, Common::WriteWatch*>, 2> watches{{
+        {VRAM_PADDR, impl->vram_watch.get()},
+        {FCRAM_PADDR, impl->fcram_watch.get()},
+    }};
+    for (const auto& [base, watch] : watches) {
+        for (const auto& [offset, size] : watch->ConsumeWrites()) {
+            RasterizerInvalidateRegion(base + static_cast<PAddr>(offset), static_cast<u32>(size));
+        }
+    }
+}
+
+void MemorySystem::UpdateRasterizerPageType(VAddr vaddr) {
+    const bool rasterizer_access = impl->NeedsRasterizerAccess(vaddr);
+    const u32 page = vaddr >> CITRA_PAGE_BITS;
+    for (auto page_table : impl->page_table_list) {
+        PageType& page_type = page_table->attributes[page];
+        switch (page_type) {
+        case PageType::Unmapped:
+            // It is not necessary for a process to have this region mapped into its
+            // address space, for example, a system module need not have a VRAM mapping.
+            break;
+        case PageType::Memory:
+            if (rasterizer_access) {
+                page_type = PageType::RasterizerCachedMemory;
+                page_table->pointers[page] = nullptr;
+            }
+            break;
+        case PageType::RasterizerCachedMemory:
+            if (!rasterizer_access) {
+                page_type = PageType::Memory;
+                page_table->pointers[page] =
+                    GetPointerForRasterizerCache(vaddr & ~CITRA_PAGE_MASK);
             }
+            break;
+        default:
+            UNREACHABLE();
+        }
+        if (page_type != PageType::Unmapped) {
+            impl->UpdateFastmemArena(*page_table, page, 1);
         }
     }
 }
 
+/// Returns true if rasterizer requests must be forwarded to the GPU thread
+static bool UseGPUThread() {
+    return VideoCore::g_gpu_thread && !VideoCore::g_gpu_thread->IsGPUThread();
+}
+
 void RasterizerFlushRegion(PAddr start, u32 size) {
     if (VideoCore::g_renderer == nullptr) {
         return;
     }
 
+    if (UseGPUThread()) {
+        VideoCore::g_gpu_thread->FlushRegion(start, size);
+        return;
+    }
+
     VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
 }
 
@@ -781,6 +1119,11 @@ void RasterizerInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
+    if (UseGPUThread()) {
+        VideoCore::g_gpu_thread->InvalidateRegion(start, size);
+        return;
+    }
+
     VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
 }
 
@@ -791,6 +1134,11 @@ void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
+    if (UseGPUThread()) {
+        VideoCore::g_gpu_thread->FlushAndInvalidateRegion(start, size);
+        return;
+    }
+
     VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
 }
 
@@ -801,6 +1149,11 @@ void RasterizerClearAll(bool flush) {
         return;
     }
 
+    if (UseGPUThread()) {
+        VideoCore::g_gpu_thread->ClearAll(flush);
+        return;
+    }
+
     VideoCore::g_renderer->Rasterizer()->ClearAll(flush);
 }
 
@@ -824,16 +1177,15 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         PAddr physical_start = paddr_region_start + (overlap_start - region_start);
         u32 overlap_size = overlap_end - overlap_start;
 
-        auto* rasterizer = VideoCore::g_renderer->Rasterizer();
         switch (mode) {
         case FlushMode::Flush:
-            rasterizer->FlushRegion(physical_start, overlap_size);
+            RasterizerFlushRegion(physical_start, overlap_size);
             break;
         case FlushMode::Invalidate:
-            rasterizer->InvalidateRegion(physical_start, overlap_size);
+            RasterizerInvalidateRegion(physical_start, overlap_size);
             break;
         case FlushMode::FlushAndInvalidate:
-            rasterizer->FlushAndInvalidateRegion(physical_start, overlap_size);
+            RasterizerFlushAndInvalidateRegion(physical_start, overlap_size);
             break;
         }
     };
@@ -915,6 +1267,64 @@ void MemorySystem::WriteBlock(const VAddr dest_addr, const void* src_buffer,
     return impl->WriteBlockImpl<false>(process, dest_addr, src_buffer, size);
 }
 
+bool MemorySystem::VisitBlock(const Kernel::Process& process, const VAddr addr,
+                              const std::size_t size, FlushMode mode,
+                              const std::function<void(std::span<u8>)>& visitor) {
+    // A range wrapping around the address space would run past the end of the page table
+    if (u64{addr} + size > PAGE_TABLE_NUM_ENTRIES * CITRA_PAGE_SIZE) {
+        return false;
+    }
+    auto& page_table = *process.vm_manager.page_table;
+    const std::size_t first_page = addr >> CITRA_PAGE_BITS;
+    const std::size_t end_page =
+        static_cast<std::size_t>((u64{addr} + size + CITRA_PAGE_MASK) >> CITRA_PAGE_BITS);
+
+    // Check the whole range first, so that nothing is visited when it has to be copied instead
+    bool is_cached = false;
+    for (std::size_t page_index = first_page; page_index < end_page; ++page_index) {
+        const PageType type = page_table.attributes[page_index];
+        if (type != PageType::Memory && type != PageType::RasterizerCachedMemory) {
+            return false;
+        }
+        is_cached |= type == PageType::RasterizerCachedMemory;
+    }
+    if (is_cached) {
+        RasterizerFlushVirtualRegion(addr, static_cast<u32>(size), mode);
+    }
+
+    u8* run_start = nullptr;
+    std::size_t run_size = 0;
+    std::size_t remaining_size = size;
+    std::size_t page_offset = addr & CITRA_PAGE_MASK;
+    for (std::size_t page_index = first_page; page_index < end_page; ++page_index) {
+        const std::size_t amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
+        const VAddr current_vaddr =
+            static_cast<VAddr>((page_index << CITRA_PAGE_BITS) + page_offset);
+        u8* ptr = page_table.attributes[page_index] == PageType::Memory
+                      ? page_table.pointers[page_index] + page_offset
+                      : static_cast<u8*>(impl->GetPointerForRasterizerCache(current_vaddr));
+        // Watched pages are read-only on the host, and writes made by the host kernel into them
+        // do not fault, so they are recorded up front
+        if (mode != FlushMode::Flush) {
+            impl->MarkBackingWritten(ptr, amount);
+        }
+        if (run_start == nullptr || run_start + run_size != ptr) {
+            if (run_size != 0) {
+                visitor({run_start, run_size});
+            }
+            run_start = ptr;
+            run_size = 0;
+        }
+        run_size += amount;
+        remaining_size -= amount;
+        page_offset = 0;
+    }
+    if (run_size != 0) {
+        visitor({run_start, run_size});
+    }
+    return true;
+}
+
 void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_addr,
                              const std::size_t size) {
     auto& page_table = *process.vm_manager.page_table;
@@ -1067,18 +1477,19 @@ void WriteMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr, const u64 data)
 }
 
 u32 MemorySystem::GetFCRAMOffset(const u8* pointer) const {
-    ASSERT(pointer >= impl->fcram.get() && pointer <= impl->fcram.get() + Memory::FCRAM_N3DS_SIZE);
-    return static_cast<u32>(pointer - impl->fcram.get());
+    ASSERT(pointer >= impl->fcram.data() &&
+           pointer <= impl->fcram.data() + Memory::FCRAM_N3DS_SIZE);
+    return static_cast<u32>(pointer - impl->fcram.data());
 }
 
 u8* MemorySystem::GetFCRAMPointer(std::size_t offset) {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram.data() + offset;
 }
 
 const u8* MemorySystem::GetFCRAMPointer(std::size_t offset) const {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram.data() + offset;
 }
 
 MemoryRef MemorySystem::GetFCRAMRef(std::size_t offset) const {
@@ -1090,4 +1501,13 @@ void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
     impl->dsp = &dsp;
 }
 
+std::array<std::span<u8>, 3> MemorySystem::GetRAMRegions() {
+    const bool is_new_3ds = Settings::values.is_new_3ds.GetValue();
+    return {
+        std::span{impl->vram.data(), Memory::VRAM_SIZE},
+        std::span{impl->fcram.data(), is_new_3ds ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE},
+        std::span{impl->n3ds_extra_ram.data(), is_new_3ds ? Memory::N3DS_EXTRA_RAM_SIZE : 0},
+    };
+}
+
 } // namespace Memory
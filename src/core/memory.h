@@ -5,6 +5,8 @@
 #pragma once
 #include <array>
 #include <cstddef>
+#include <functional>
+#include <span>
 #include <string>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/vector.hpp>
@@ -122,6 +124,10 @@ struct PageTable {
         return pointers.raw;
     }
 
+    const std::array<u8*, PAGE_TABLE_NUM_ENTRIES>& GetPointerArray() const {
+        return pointers.raw;
+    }
+
     void Clear();
 
 private:
@@ -285,6 +291,22 @@ void RasterizerClearAll(bool flush);
  */
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode);
 
+/// Archive helper with the options of the memory system serialization
+struct SerializationOptions {
+    /// Whether the regions returned by MemorySystem::GetRAMRegions are serialized. In-memory
+    /// snapshots exclude them and store RAM separately, page by page.
+    bool serialize_ram = true;
+};
+
+/// Identifies the SerializationOptions among the helpers of an archive
+inline char serialization_options_key;
+
+/// Returns the memory serialization options of an archive, set them before serializing
+template <class Archive>
+SerializationOptions& GetSerializationOptions(Archive& ar) {
+    return ar.template get_helper<SerializationOptions>(&serialization_options_key);
+}
+
 class MemorySystem {
 public:
     MemorySystem();
@@ -566,7 +588,27 @@ public:
                    VAddr dest_addr, VAddr src_addr, std::size_t size);
 
     /**
-     * Marks each page within the specified address range as cached or uncached.
+     * Gives direct access to a range of a given process' address space, instead of copying it
+     * with ReadBlock or WriteBlock. The range is split in runs of pages that are contiguous in
+     * host memory, which are passed to the visitor in order.
+     *
+     * @param process The process whose address space is accessed.
+     * @param addr    The virtual address the range starts at.
+     * @param size    The size of the range, in bytes.
+     * @param mode    FlushMode::Flush when the range will be read, FlushMode::FlushAndInvalidate
+     *                when it will be written, which the rasterizer caches over the range are told
+     *                of. Pages watched by host write tracking are made writable for the latter.
+     * @param visitor The function called with each run of host memory.
+     *
+     * @returns False, without calling the visitor or touching the rasterizer, if part of the range
+     *          is unmapped or MMIO, in which case it has to be copied instead.
+     */
+    bool VisitBlock(const Kernel::Process& process, VAddr addr, std::size_t size, FlushMode mode,
+                    const std::function<void(std::span<u8>)>& visitor);
+
+    /**
+     * Marks each page within the specified address range as cached or uncached. Marks made on
+     * the GPU thread are deferred until ApplyRasterizerMarks is called.
      *
      * @param vaddr  The virtual address indicating the start of the address range.
      * @param size   The size of the address range in bytes.
@@ -575,6 +617,30 @@ public:
      */
     void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached);
 
+    /**
+     * Marks each page within the specified physical range as holding data that the rasterizer
+     * cache has not written back to memory yet. Only used with host write tracking, where CPU
+     * accesses go through the rasterizer cache only for these pages. Marks made on the GPU
+     * thread are deferred until ApplyRasterizerMarks is called.
+     */
+    void RasterizerMarkRegionDirty(PAddr start, u32 size, bool dirty);
+
+    /**
+     * Applies the marks made on the GPU thread to the page tables, in the order they were made.
+     * The CPU reads the page tables without locking, so this must be called on the emulation
+     * thread while no CPU core is running.
+     */
+    void ApplyRasterizerMarks();
+
+    /// Returns true if CPU writes to rasterizer-cached memory are detected with the host MMU
+    bool IsHostWriteTrackingEnabled() const;
+
+    /**
+     * Invalidates the rasterizer cache for the memory the CPU wrote to since the last call.
+     * Must be called before the GPU accesses memory when host write tracking is enabled.
+     */
+    void InvalidateWrittenRegions();
+
     /// Gets a pointer to the memory region beginning at the specified physical address.
     u8* GetPhysicalPointer(PAddr address);
 
@@ -605,8 +671,19 @@ public:
     /// Unregisters page table for rasterizer cache marking
     void UnregisterPageTable(std::shared_ptr<PageTable> page_table);
 
+    /**
+     * Returns the base of the host mapping of the address space of the page table, in which the
+     * JIT accesses guest memory directly, or nullptr if fastmem is not available. Pages that must
+     * not be accessed directly, such as MMIO and rasterizer-cached pages, are inaccessible, and
+     * pages watched for host write tracking are read-only.
+     */
+    u8* GetFastmemArena(const PageTable& page_table);
+
     void SetDSP(AudioCore::DspInterface& dsp);
 
+    /// Returns the FCRAM, VRAM and N3DS extra RAM contents as they are saved in save states
+    std::array<std::span<u8>, 3> GetRAMRegions();
+
 private:
     template <typename T>
     T Read(const VAddr vaddr);
@@ -627,6 +704,12 @@ private:
 
     void MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef memory, PageType type);
 
+    /// Switches the page between direct and rasterizer cache access in every page table
+    void UpdateRasterizerPageType(VAddr vaddr);
+
+    void MarkRegionCached(PAddr start, u32 size, bool cached);
+    void MarkRegionDirty(PAddr start, u32 size, bool dirty);
+
     class Impl;
     std::unique_ptr<Impl> impl;
 
@@ -6,6 +6,7 @@
 #include <cstring>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 #include <boost/optional.hpp>
 #include <cryptopp/hex.h>
@@ -679,9 +680,50 @@ void Movie::Handle(Targs&... Fargs) {
         CheckInputEnd();
     } else if (play_mode == PlayMode::Recording) {
         Record(Fargs...);
+    } else if (play_mode == PlayMode::None && rewind_logging) {
+        HandleRewind(Fargs...);
     }
 }
 
+template <typename... Targs>
+void Movie::HandleRewind(Targs&... Fargs) {
+    // Play and Record work on the movie input, point them at the rewind log for the duration
+    std::swap(recorded_input, rewind_input);
+    std::swap(current_byte, rewind_byte);
+    const u64 movie_input = current_input;
+    if (current_byte < rewind_replay_end) {
+        Play(Fargs...);
+    } else {
+        Record(Fargs...);
+    }
+    current_input = movie_input;
+    std::swap(current_byte, rewind_byte);
+    std::swap(recorded_input, rewind_input);
+}
+
+void Movie::SetRewindLogging(bool enabled) {
+    rewind_logging = enabled;
+    if (!enabled) {
+        rewind_input.clear();
+        rewind_input.shrink_to_fit();
+        rewind_byte = 0;
+        rewind_replay_end = 0;
+    }
+}
+
+void Movie::ReplayRewindLog(std::size_t begin, std::size_t end) {
+    ASSERT(begin <= end && end <= rewind_input.size());
+    rewind_byte = begin;
+    rewind_replay_end = end;
+}
+
+void Movie::TrimRewindLog(std::size_t size) {
+    size = std::min(size, rewind_byte);
+    rewind_input.erase(rewind_input.begin(), rewind_input.begin() + size);
+    rewind_byte -= size;
+    rewind_replay_end -= std::min(size, rewind_replay_end);
+}
+
 void Movie::HandlePadAndCircleStatus(Service::HID::PadState& pad_state, s16& circle_pad_x,
                                      s16& circle_pad_y) {
     Handle(pad_state, circle_pad_x, circle_pad_y);
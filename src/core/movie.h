@@ -131,6 +131,31 @@ public:
      */
     void SaveMovie();
 
+    /**
+     * Starts or stops logging inputs for the rewind buffer. Inputs are only logged while no movie
+     * is being recorded or played. Stopping discards the log.
+     */
+    void SetRewindLogging(bool enabled);
+
+    /// Returns the position in the rewind log where the next input will be logged, in bytes
+    std::size_t GetRewindLogPosition() const {
+        return rewind_byte;
+    }
+
+    /**
+     * Replaces inputs with the ones in the rewind log from `begin` up to `end`. Inputs are logged
+     * again from `end` onwards, overwriting what was logged after it.
+     */
+    void ReplayRewindLog(std::size_t begin, std::size_t end);
+
+    /// Returns the size of the rewind log, including the inputs still to be replayed, in bytes
+    std::size_t GetRewindLogSize() const {
+        return rewind_input.size();
+    }
+
+    /// Drops the first `size` bytes of the rewind log, positions are shifted accordingly
+    void TrimRewindLog(std::size_t size);
+
 private:
     static Movie s_instance;
 
@@ -139,6 +164,9 @@ private:
     template <typename... Targs>
     void Handle(Targs&... Fargs);
 
+    template <typename... Targs>
+    void HandleRewind(Targs&... Fargs);
+
     void Play(Service::HID::PadState& pad_state, s16& circle_pad_x, s16& circle_pad_y);
     void Play(Service::HID::TouchDataEntry& touch_data);
     void Play(Service::HID::AccelerometerDataEntry& accelerometer_data);
@@ -178,6 +206,12 @@ private:
 
     std::function<void()> playback_completion_callback = [] {};
 
+    // Inputs logged outside of movies for the rewind buffer. Not serialized.
+    bool rewind_logging = false;
+    std::vector<u8> rewind_input;
+    std::size_t rewind_byte = 0;
+    std::size_t rewind_replay_end = 0;
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int file_version);
     friend class boost::serialization::access;
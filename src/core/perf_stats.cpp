@@ -74,6 +74,12 @@ void PerfStats::EndGameFrame() {
     game_frames += 1;
 }
 
+void PerfStats::AddUploadedBytes(u64 bytes) {
+    std::lock_guard lock{object_mutex};
+
+    uploaded_bytes += bytes;
+}
+
 double PerfStats::GetMeanFrametime() const {
     std::lock_guard lock{object_mutex};
 
@@ -101,6 +107,8 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
     results.frametime = duration_cast<DoubleSecs>(accumulated_frametime).count() /
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second.count() / 1'000'000.0;
+    results.uploaded_bytes =
+        static_cast<double>(uploaded_bytes) / static_cast<double>(system_frames);
 
     // Reset counters
     reset_point = now;
@@ -108,6 +116,7 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
     accumulated_frametime = Clock::duration::zero();
     system_frames = 0;
     game_frames = 0;
+    uploaded_bytes = 0;
 
     return results;
 }
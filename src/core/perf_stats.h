@@ -34,12 +34,17 @@ public:
         double frametime;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Bytes the renderer uploaded to the GPU per system frame
+        double uploaded_bytes;
     };
 
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
 
+    /// Adds bytes the renderer uploaded to the GPU during the current system frame
+    void AddUploadedBytes(u64 bytes);
+
     Results GetAndResetStats(std::chrono::microseconds current_system_time_us);
 
     /**
@@ -75,6 +80,8 @@ private:
     u32 system_frames = 0;
     /// Cumulative number of game frames (GSP frame submissions) since last reset
     u32 game_frames = 0;
+    /// Cumulative number of bytes uploaded to the GPU since last reset
+    u64 uploaded_bytes = 0;
 
     /// Point when the previous system frame ended
     Clock::time_point previous_frame_end = reset_point;
@@ -0,0 +1,219 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include "common/logging/log.h"
+#include "common/settings.h"
+#include "core/core.h"
+#include "core/hw/gpu.h"
+#include "core/movie.h"
+#include "core/rewind.h"
+#include "core/savestate.h"
+
+namespace Core {
+
+namespace {
+/// Share of the emulated frame time that taking snapshots may use on average
+constexpr double MaxCaptureShare = 0.1;
+constexpr double FrameTimeMs = 1000.0 / GPU::SCREEN_REFRESH_RATE;
+/// How far the capture interval may be raised, as a multiple of the configured interval
+constexpr u32 MaxIntervalScale = 8;
+/// Weight of the latest capture in the average capture time
+constexpr double CaptureTimeWeight = 0.2;
+} // Anonymous namespace
+
+RewindBuffer::RewindBuffer(System& system)
+    : system{system}, capture_interval{Settings::values.rewind_interval.GetValue()} {}
+
+RewindBuffer::~RewindBuffer() {
+    Movie::GetInstance().SetRewindLogging(false);
+}
+
+void RewindBuffer::OnFrameEnd() {
+    frame_count++;
+    PublishStats();
+}
+
+void RewindBuffer::Update() {
+    if (Movie::GetInstance().GetPlayMode() != Movie::PlayMode::None) {
+        // Inputs go to the movie while one is active, so the snapshots could not be replayed
+        if (!entries.empty()) {
+            Clear();
+        }
+        return;
+    }
+
+    RecordFrameOffsets();
+    if (replaying) {
+        if (frame_count < replay_target) {
+            return;
+        }
+        // Log new inputs from here even if the replay did not consume all of the old ones
+        auto& movie = Movie::GetInstance();
+        movie.ReplayRewindLog(movie.GetRewindLogPosition(), movie.GetRewindLogPosition());
+        replaying = false;
+        LOG_DEBUG(Core, "Rewind replay reached frame {}", frame_count);
+    }
+
+    if (Settings::values.rewind_enabled.GetValue() && frame_count >= next_capture) {
+        Capture();
+    }
+}
+
+void RewindBuffer::Capture() {
+    if (!entries.empty() && entries.back().frame == frame_count) {
+        return;
+    }
+    RecordFrameOffsets();
+
+    const auto start = std::chrono::steady_clock::now();
+    const Snapshot* base = entries.empty() ? nullptr : entries.back().snapshot.get();
+    auto snapshot = system.CreateSnapshot(base);
+    last_capture_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    average_capture_ms = entries.empty() ? last_capture_ms
+                                         : average_capture_ms * (1.0 - CaptureTimeWeight) +
+                                               last_capture_ms * CaptureTimeWeight;
+
+    auto& movie = Movie::GetInstance();
+    if (entries.empty()) {
+        movie.SetRewindLogging(true);
+        first_frame = frame_count;
+        frame_offsets.assign(1, movie.GetRewindLogPosition());
+    }
+    const std::size_t changed_pages = snapshot->GetChangedPages();
+    const std::size_t size = snapshot->GetSize();
+    entries.push_back({frame_count, movie.GetRewindLogPosition(), size, std::move(snapshot)});
+
+    UpdateCaptureInterval();
+    next_capture = frame_count + capture_interval;
+    EnforceMemoryLimit();
+
+    PublishStats();
+
+    LOG_DEBUG(Core, "Rewind snapshot of frame {} took {:.2f} ms, {} pages changed, {} KiB total",
+              frame_count, last_capture_ms, changed_pages, GetMemoryUsage() / 1024);
+}
+
+bool RewindBuffer::Rewind(u32 frames) {
+    if (entries.empty()) {
+        return false;
+    }
+    RecordFrameOffsets();
+
+    const u64 target = frame_count - std::min<u64>(frames, frame_count);
+    const auto it = std::find_if(entries.rbegin(), entries.rend(),
+                                 [target](const Entry& entry) { return entry.frame <= target; });
+    if (it == entries.rend()) {
+        return false;
+    }
+
+    system.LoadSnapshot(*it->snapshot);
+
+    const std::size_t replay_begin = it->input_offset;
+    const std::size_t replay_end = std::max(replay_begin, frame_offsets[target - first_frame]);
+    frame_count = it->frame;
+    entries.erase(it.base(), entries.end());
+    frame_offsets.resize(frame_count - first_frame + 1);
+    next_capture = frame_count + capture_interval;
+
+    Movie::GetInstance().ReplayRewindLog(replay_begin, replay_end);
+    replay_target = target;
+    replaying = target > frame_count;
+    PublishStats();
+    LOG_DEBUG(Core, "Rewound to frame {}, replaying {} frames", frame_count, target - frame_count);
+    return true;
+}
+
+void RewindBuffer::Clear() {
+    entries.clear();
+    frame_offsets.clear();
+    replaying = false;
+    next_capture = frame_count;
+    Movie::GetInstance().SetRewindLogging(false);
+    PublishStats();
+}
+
+RewindBuffer::Stats RewindBuffer::GetStats() const {
+    std::scoped_lock lock{stats_mutex};
+    return stats;
+}
+
+void RewindBuffer::RecordFrameOffsets() {
+    if (entries.empty()) {
+        return;
+    }
+    const std::size_t position = Movie::GetInstance().GetRewindLogPosition();
+    while (first_frame + frame_offsets.size() <= frame_count) {
+        frame_offsets.push_back(position);
+    }
+}
+
+void RewindBuffer::EnforceMemoryLimit() {
+    const std::size_t limit = std::size_t{Settings::values.rewind_memory_limit.GetValue()} << 20;
+    while (entries.size() > 1 && GetMemoryUsage() > limit) {
+        // Pages the next snapshot shares with the evicted one are now paid for by the former
+        Entry& next = entries[1];
+        next.size += next.snapshot->GetSharedSize(*entries.front().snapshot);
+        entries.pop_front();
+
+        // Inputs logged before the new oldest snapshot can no longer be replayed
+        frame_offsets.erase(frame_offsets.begin(),
+                            frame_offsets.begin() + (entries.front().frame - first_frame));
+        first_frame = entries.front().frame;
+        const std::size_t dropped = std::min(entries.front().input_offset, frame_offsets.front());
+        Movie::GetInstance().TrimRewindLog(dropped);
+        for (auto& offset : frame_offsets) {
+            offset -= dropped;
+        }
+        for (auto& entry : entries) {
+            entry.input_offset -= dropped;
+        }
+    }
+}
+
+void RewindBuffer::UpdateCaptureInterval() {
+    const u32 configured = Settings::values.rewind_interval.GetValue();
+    const u32 max_interval = configured * MaxIntervalScale;
+    const double budget_ms = FrameTimeMs * MaxCaptureShare;
+    capture_interval = std::clamp(capture_interval, configured, max_interval);
+
+    if (average_capture_ms > budget_ms * capture_interval && capture_interval < max_interval) {
+        capture_interval = std::min(capture_interval * 2, max_interval);
+        LOG_INFO(Core, "Rewind snapshots take {:.2f} ms, capturing every {} frames",
+                 average_capture_ms, capture_interval);
+    } else if (average_capture_ms < budget_ms * capture_interval / 4 &&
+               capture_interval > configured) {
+        capture_interval = std::max(capture_interval / 2, configured);
+        LOG_INFO(Core, "Rewind snapshots take {:.2f} ms, capturing every {} frames",
+                 average_capture_ms, capture_interval);
+    }
+}
+
+std::size_t RewindBuffer::GetMemoryUsage() const {
+    std::size_t usage = Movie::GetInstance().GetRewindLogSize() +
+                        frame_offsets.size() * sizeof(std::size_t);
+    for (const auto& entry : entries) {
+        usage += entry.size;
+    }
+    return usage;
+}
+
+void RewindBuffer::PublishStats() {
+    std::scoped_lock lock{stats_mutex};
+    stats = {
+        .snapshot_count = entries.size(),
+        .memory_usage = GetMemoryUsage(),
+        .memory_limit = std::size_t{Settings::values.rewind_memory_limit.GetValue()} << 20,
+        .frames_available = entries.empty() ? 0 : frame_count - entries.front().frame,
+        .capture_interval = capture_interval,
+        .last_capture_ms = last_capture_ms,
+        .average_capture_ms = average_capture_ms,
+    };
+}
+
+} // namespace Core
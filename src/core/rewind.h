@@ -0,0 +1,103 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include "common/common_types.h"
+
+namespace Core {
+
+class Snapshot;
+class System;
+
+/**
+ * Keeps in-memory snapshots of the emulated system taken every few frames, along with a log of
+ * the inputs received since the oldest one. Rewinding restores the nearest snapshot taken at or
+ * before the target frame and replays the logged inputs until the target frame is reached.
+ */
+class RewindBuffer {
+public:
+    struct Stats {
+        std::size_t snapshot_count;
+        std::size_t memory_usage; ///< Memory held by the snapshots and the input log, in bytes
+        std::size_t memory_limit;
+        u64 frames_available; ///< Number of frames that can be rewound
+        u32 capture_interval; ///< Frames between snapshots, raised while capturing is too slow
+        double last_capture_ms;
+        double average_capture_ms;
+    };
+
+    explicit RewindBuffer(System& system);
+    ~RewindBuffer();
+
+    /// Counts a finished frame. Called by the VBlank event on the emulation thread.
+    void OnFrameEnd();
+
+    /// Takes the snapshots that became due and finishes replays. Called between CPU slices.
+    void Update();
+
+    /// Takes a snapshot of the current frame right away
+    void Capture();
+
+    /**
+     * Steps emulation back by the given number of frames. Snapshots newer than the target are
+     * dropped. Returns false if the buffer does not reach back that far.
+     */
+    bool Rewind(u32 frames);
+
+    /**
+     * Returns true while the frames between a snapshot and the rewind target are being replayed.
+     * May be called from the GPU thread.
+     */
+    bool IsReplaying() const {
+        return replaying.load(std::memory_order_relaxed);
+    }
+
+    /// Drops all snapshots and logged inputs
+    void Clear();
+
+    /// Returns the state of the buffer as of the last frame. May be called from any thread.
+    Stats GetStats() const;
+
+private:
+    struct Entry {
+        u64 frame;
+        std::size_t input_offset;
+        /// Memory attributed to this snapshot, including pages it shares with evicted ones
+        std::size_t size;
+        std::shared_ptr<const Snapshot> snapshot;
+    };
+
+    void RecordFrameOffsets();
+    void EnforceMemoryLimit();
+    void UpdateCaptureInterval();
+    std::size_t GetMemoryUsage() const;
+    void PublishStats();
+
+    System& system;
+
+    std::deque<Entry> entries;
+    /// Input log position at the first CPU slice boundary after each frame since the oldest entry
+    std::deque<std::size_t> frame_offsets;
+    u64 first_frame = 0;
+
+    u64 frame_count = 0;
+    u64 next_capture = 0;
+    u64 replay_target = 0;
+    std::atomic_bool replaying{false};
+
+    u32 capture_interval = 0;
+    double last_capture_ms = 0.0;
+    double average_capture_ms = 0.0;
+
+    mutable std::mutex stats_mutex;
+    Stats stats{};
+};
+
+} // namespace Core
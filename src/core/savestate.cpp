@@ -2,12 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
 #include <chrono>
+#include <cstring>
 #include <boost/serialization/binary_object.hpp>
 #include <cryptopp/hex.h>
 #include "common/archives.h"
 #include "common/logging/log.h"
 #include "common/scm_rev.h"
+#include "common/settings.h"
 #include "common/zstd_compression.h"
 #include "core/cheats/cheats.h"
 #include "core/core.h"
@@ -98,20 +101,29 @@ std::vector<SaveStateInfo> ListSaveStates(u64 program_id) {
 }
 
 void System::SaveState(u32 slot) const {
-    std::ostringstream sstream{std::ios_base::binary};
-    // Serialize
-    oarchive oa{sstream};
-    oa&* this;
-
-    const std::string& str{sstream.str()};
-    auto buffer = Common::Compression::CompressDataZSTDDefault(
-        reinterpret_cast<const u8*>(str.data()), str.size());
-
     const auto path = GetSaveStatePath(title_id, slot);
     if (!FileUtil::CreateFullPath(path)) {
         throw std::runtime_error("Could not create path " + path);
     }
 
+    // Write to a temporary file first, so a failure leaves the previous state in the slot intact
+    const auto temp_path = path + ".tmp";
+    try {
+        WriteSaveState(temp_path);
+    } catch (...) {
+        FileUtil::Delete(temp_path);
+        throw;
+    }
+
+    // Renaming over an existing file fails on some platforms
+    if (!FileUtil::Rename(temp_path, path) &&
+        !(FileUtil::Delete(path) && FileUtil::Rename(temp_path, path))) {
+        FileUtil::Delete(temp_path);
+        throw std::runtime_error("Could not write to file " + path);
+    }
+}
+
+void System::WriteSaveState(const std::string& path) const {
     FileUtil::IOFile file(path, "wb");
     if (!file) {
         throw std::runtime_error("Could not open file " + path);
@@ -128,8 +140,20 @@ void System::SaveState(u32 slot) const {
                       std::chrono::system_clock::now().time_since_epoch())
                       .count();
 
-    if (file.WriteBytes(&header, sizeof(header)) != sizeof(header) ||
-        file.WriteBytes(buffer.data(), buffer.size()) != buffer.size()) {
+    if (file.WriteBytes(&header, sizeof(header)) != sizeof(header)) {
+        throw std::runtime_error("Could not write to file " + path);
+    }
+
+    // Serialize straight into the compressor, which writes to the file as it goes
+    Common::Compression::ZSTDCompressStreamBuffer buffer{
+        file, static_cast<s32>(Settings::values.savestate_compression_level.GetValue()),
+        Settings::values.savestate_compression_threads.GetValue()};
+    {
+        std::ostream stream{&buffer};
+        oarchive oa{stream};
+        oa&* this;
+    }
+    if (!buffer.Finish()) {
         throw std::runtime_error("Could not write to file " + path);
     }
 }
@@ -141,25 +165,138 @@ void System::LoadState(u32 slot) {
 
     const auto path = GetSaveStatePath(title_id, slot);
 
-    std::vector<u8> decompressed;
+    FileUtil::IOFile file(path, "rb");
+    CSTHeader header;
+    if (!file || file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
+        throw std::runtime_error("Could not read from file at " + path);
+    }
+    if (header.filetype != header_magic_bytes) {
+        throw std::runtime_error("Invalid save state file " + path);
+    }
+
+    // Loading shuts the system down first, so make sure the state can be read in full before
+    if (!Common::Compression::ValidateZSTDStream(file)) {
+        throw std::runtime_error("Save state file is corrupted or incomplete " + path);
+    }
+
+    // Deserialize while decompressing
+    Common::Compression::ZSTDDecompressStreamBuffer buffer{file};
+    std::istream stream{&buffer};
+    iarchive ia{stream};
+    ia&* this;
+}
+
+/// Compression level of the RAM pages in snapshots, favouring speed as they are taken often
+constexpr s32 SnapshotPageCompressionLevel = 1;
+
+static bool IsZeroPage(const u8* data) {
+    static constexpr std::array<u8, Snapshot::PageSize> zero_page{};
+    return std::memcmp(data, zero_page.data(), zero_page.size()) == 0;
+}
+
+std::shared_ptr<const Snapshot> System::CreateSnapshot(const Snapshot* base) const {
+    auto snapshot = std::make_shared<Snapshot>();
     {
-        std::vector<u8> buffer(FileUtil::GetSize(path) - sizeof(CSTHeader));
+        std::ostringstream sstream{std::ios_base::binary};
+        oarchive oa{sstream};
+        // Snapshots store RAM page by page instead
+        Memory::GetSerializationOptions(oa).serialize_ram = false;
+        oa&* this;
 
-        FileUtil::IOFile file(path, "rb");
-        file.Seek(sizeof(CSTHeader), SEEK_SET); // Skip header
-        if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size()) {
-            throw std::runtime_error("Could not read from file at " + path);
+        const std::string& str{sstream.str()};
+        snapshot->state = Common::Compression::CompressDataZSTDDefault(
+            reinterpret_cast<const u8*>(str.data()), str.size());
+    }
+
+    snapshot->CapturePages(memory->GetRAMRegions(), base);
+
+    LOG_DEBUG(Core, "Snapshot taken, {} pages changed, {} bytes", snapshot->changed_pages,
+              snapshot->GetSize());
+    return snapshot;
+}
+
+void System::LoadSnapshot(const Snapshot& snapshot) {
+    if (Network::GetRoomMember().lock()->IsConnected()) {
+        throw std::runtime_error("Unable to load while connected to multiplayer");
+    }
+
+    {
+        const std::vector<u8> decompressed =
+            Common::Compression::DecompressDataZSTD(snapshot.state);
+        std::istringstream sstream{
+            std::string{reinterpret_cast<const char*>(decompressed.data()), decompressed.size()},
+            std::ios_base::binary};
+
+        iarchive ia{sstream};
+        Memory::GetSerializationOptions(ia).serialize_ram = false;
+        ia&* this;
+    }
+
+    // Deserialization recreated the memory system, so its RAM is filled with zeros
+    snapshot.RestorePages(memory->GetRAMRegions());
+}
+
+void Snapshot::CapturePages(std::span<const std::span<u8>> regions, const Snapshot* base) {
+    std::size_t num_pages = 0;
+    for (const auto& region : regions) {
+        num_pages += region.size() / PageSize;
+    }
+    if (base && base->pages.size() != num_pages) {
+        base = nullptr;
+    }
+
+    pages.assign(num_pages, nullptr);
+    allocated_size = 0;
+    changed_pages = 0;
+    std::size_t index = 0;
+    for (const auto& region : regions) {
+        for (std::size_t offset = 0; offset < region.size(); offset += PageSize, ++index) {
+            const u8* data = region.data() + offset;
+            const bool is_zero = IsZeroPage(data);
+            const Common::uint128 hash =
+                is_zero ? Common::uint128{}
+                        : Common::CityHash128(reinterpret_cast<const char*>(data), PageSize);
+            if (base) {
+                const auto& base_page = base->pages[index];
+                if (base_page ? !is_zero && base_page->hash == hash : is_zero) {
+                    pages[index] = base_page;
+                    continue;
+                }
+            }
+
+            ++changed_pages;
+            if (is_zero) {
+                continue;
+            }
+            const auto compressed =
+                Common::Compression::CompressDataZSTD(data, PageSize, SnapshotPageCompressionLevel);
+            if (compressed.empty()) {
+                throw std::runtime_error("Failed to compress snapshot page");
+            }
+            // Copied so the page does not keep the capacity reserved for the worst case
+            auto page = std::make_shared<Page>(Page{hash, {compressed.begin(), compressed.end()}});
+            allocated_size += sizeof(Page) + page->data.size();
+            pages[index] = std::move(page);
         }
-        decompressed = Common::Compression::DecompressDataZSTD(buffer);
     }
-    std::istringstream sstream{
-        std::string{reinterpret_cast<char*>(decompressed.data()), decompressed.size()},
-        std::ios_base::binary};
-    decompressed.clear();
+}
 
-    // Deserialize
-    iarchive ia{sstream};
-    ia&* this;
+void Snapshot::RestorePages(std::span<const std::span<u8>> regions) const {
+    std::size_t index = 0;
+    for (const auto& region : regions) {
+        for (std::size_t offset = 0; offset < region.size(); offset += PageSize, ++index) {
+            if (index >= pages.size()) {
+                throw std::runtime_error("Snapshot was taken with a different memory layout");
+            }
+            if (const auto& page = pages[index]) {
+                const auto data = Common::Compression::DecompressDataZSTD(page->data);
+                if (data.size() != PageSize) {
+                    throw std::runtime_error("Snapshot page is corrupted");
+                }
+                std::memcpy(region.data() + offset, data.data(), data.size());
+            }
+        }
+    }
 }
 
 } // namespace Core
@@ -4,8 +4,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
 #include <vector>
+#include "common/cityhash.h"
 #include "common/common_types.h"
+#include "core/memory.h"
 
 namespace Core {
 
@@ -24,4 +30,63 @@ constexpr u32 SaveStateSlotCount = 10; // Maximum count of savestate slots
 
 std::vector<SaveStateInfo> ListSaveStates(u64 program_id);
 
+/**
+ * A copy of the emulated system held in host memory. RAM is stored in Zstandard compressed pages
+ * which are shared with the base snapshot while their contents are unchanged, so a snapshot only
+ * costs the memory of the pages written since its base was taken.
+ */
+class Snapshot {
+public:
+    static constexpr std::size_t PageSize = Memory::CITRA_PAGE_SIZE;
+
+    struct Page {
+        /**
+         * Hash of the uncompressed contents, used to find changed pages. Pages with the same
+         * hash are assumed to be equal without comparing them, as decompressing the base page
+         * would cost about as much as compressing it again. With 128 bits the chance of a
+         * changed page being missed is around 2^-128 per page.
+         */
+        Common::uint128 hash;
+        std::vector<u8> data; ///< Compressed contents
+    };
+
+    /// Returns the host memory owned by this snapshot alone, in bytes
+    std::size_t GetSize() const {
+        return state.size() + allocated_size + pages.size() * sizeof(pages[0]);
+    }
+
+    /// Returns the number of RAM pages that differ from the base snapshot
+    std::size_t GetChangedPages() const {
+        return changed_pages;
+    }
+
+    /// Returns the memory of the RAM pages this snapshot shares with `other`, in bytes
+    std::size_t GetSharedSize(const Snapshot& other) const {
+        std::size_t shared = 0;
+        for (std::size_t i = 0; i < std::min(pages.size(), other.pages.size()); i++) {
+            if (pages[i] && pages[i] == other.pages[i]) {
+                shared += sizeof(Page) + pages[i]->data.size();
+            }
+        }
+        return shared;
+    }
+
+    /**
+     * Stores the given RAM regions, sharing the pages which did not change with `base`. The
+     * regions must be multiples of the page size.
+     */
+    void CapturePages(std::span<const std::span<u8>> regions, const Snapshot* base);
+
+    /// Copies the stored RAM pages back to the given regions, which must be filled with zeros
+    void RestorePages(std::span<const std::span<u8>> regions) const;
+
+private:
+    friend class System;
+
+    std::vector<u8> state;                          ///< Compressed state, excluding RAM
+    std::vector<std::shared_ptr<const Page>> pages; ///< RAM pages, null if filled with zeros
+    std::size_t allocated_size = 0; ///< Memory of the pages allocated by this snapshot
+    std::size_t changed_pages = 0;
+};
+
 } // namespace Core
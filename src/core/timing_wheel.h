@@ -0,0 +1,320 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include "common/assert.h"
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * The pending events of a timer, kept in a hierarchical timing wheel. Each of the three levels has
+ * 256 slots covering an interval of 2^12, 2^20 and 2^28 ticks respectively, relative to the current
+ * time of the wheel, and events further away than that are kept in an overflow list. An event sits
+ * in the lowest level whose current span contains it, so the earliest event is found in the first
+ * occupied slot, and events move down a level when the wheel reaches their span.
+ *
+ * Events are stored in a pool and linked into their slot and into a list of the events of their
+ * type, which makes scheduling and cancelling constant time, no matter how many events are pending.
+ *
+ * Event must have the members time, fifo_order, type and user_data, and be ordered by its
+ * operator< from the earliest to the latest.
+ */
+template <typename Event>
+class TimingWheel {
+    using Type = decltype(Event::type);
+
+public:
+    [[nodiscard]] bool Empty() const {
+        return num_events == 0;
+    }
+
+    [[nodiscard]] std::size_t Size() const {
+        return num_events;
+    }
+
+    /// Returns the earliest event, the wheel must not be empty
+    [[nodiscard]] const Event& Front() const {
+        ASSERT(!Empty());
+        if (front == INVALID) {
+            front = FindFront();
+        }
+        return nodes[front].event;
+    }
+
+    /// Adds an event, which may be earlier than the current time of the wheel
+    void Push(const Event& event) {
+        u32 index;
+        if (free_nodes != INVALID) {
+            index = free_nodes;
+            free_nodes = nodes[index].next;
+            nodes[index].event = event;
+        } else {
+            index = static_cast<u32>(nodes.size());
+            nodes.push_back(Node{.event = event});
+        }
+        LinkSlot(index);
+        LinkType(index);
+        ++num_events;
+        if (front != INVALID && event < nodes[front].event) {
+            front = index;
+        }
+    }
+
+    /// Removes and returns the earliest event
+    Event PopFront() {
+        Event event = Front();
+        Erase(front);
+        return event;
+    }
+
+    /// Removes the events of the given type for which pred returns true
+    template <typename Pred>
+    void RemoveIf(Type type, Pred pred) {
+        const auto it = type_heads.find(type);
+        if (it == type_heads.end()) {
+            return;
+        }
+        for (u32 index = it->second; index != INVALID;) {
+            const u32 next = nodes[index].type_next;
+            if (pred(nodes[index].event)) {
+                // Erasing the last event of the type invalidates the iterator
+                Erase(index);
+            }
+            index = next;
+        }
+    }
+
+    /**
+     * Moves the current time of the wheel forward, at most up to the earliest event, moving the
+     * events that are now within the span of a lower level there.
+     */
+    void AdvanceTo(s64 time) {
+        if (!Empty()) {
+            time = std::min(time, Front().time);
+        }
+        if (time <= now) {
+            return;
+        }
+        const u64 old_now = static_cast<u64>(now);
+        now = time;
+        const u64 new_now = static_cast<u64>(now);
+
+        // Higher levels first, as their events may cascade into the slots checked after them
+        if ((old_now >> SpanShift(NUM_LEVELS - 1)) != (new_now >> SpanShift(NUM_LEVELS - 1))) {
+            Relink(overflow_slot);
+        }
+        for (std::size_t level = NUM_LEVELS; level-- > 1;) {
+            if ((old_now >> SpanShift(level - 1)) != (new_now >> SpanShift(level - 1))) {
+                Relink(SlotOf(level, new_now));
+            }
+        }
+    }
+
+    /// Returns every event in order, which is also a valid min-heap of them
+    [[nodiscard]] std::vector<Event> GetSortedEvents() const {
+        std::vector<Event> events;
+        events.reserve(num_events);
+        for (const auto& [type, head] : type_heads) {
+            for (u32 index = head; index != INVALID; index = nodes[index].type_next) {
+                events.push_back(nodes[index].event);
+            }
+        }
+        std::sort(events.begin(), events.end());
+        return events;
+    }
+
+    /// Removes every event and sets the current time of the wheel
+    void Reset(s64 time) {
+        nodes.clear();
+        type_heads.clear();
+        slots.fill(INVALID);
+        overflow = INVALID;
+        occupied = {};
+        free_nodes = INVALID;
+        front = INVALID;
+        num_events = 0;
+        now = time;
+    }
+
+private:
+    static constexpr u32 INVALID = std::numeric_limits<u32>::max();
+    static constexpr std::size_t NUM_LEVELS = 3;
+    static constexpr std::size_t SLOT_BITS = 8;
+    static constexpr std::size_t NUM_SLOTS = std::size_t{1} << SLOT_BITS;
+    static constexpr std::size_t FIRST_SHIFT = 12;
+    static constexpr std::size_t LEVEL_SHIFT = 8;
+
+    struct Node {
+        Event event;
+        u32 prev = INVALID;
+        u32 next = INVALID;
+        u32 type_prev = INVALID;
+        u32 type_next = INVALID;
+        // Index of the slot holding the node in slots, or NUM_LEVELS * NUM_SLOTS for overflow
+        u32 slot = INVALID;
+    };
+
+    /// Returns the shift of the time to get the slot index in the level
+    static constexpr std::size_t SlotShift(std::size_t level) {
+        return FIRST_SHIFT + level * LEVEL_SHIFT;
+    }
+
+    /// Returns the shift of the time to get the span covered by the level
+    static constexpr std::size_t SpanShift(std::size_t level) {
+        return SlotShift(level) + SLOT_BITS;
+    }
+
+    static u32 SlotOf(std::size_t level, u64 time) {
+        return static_cast<u32>(level * NUM_SLOTS + ((time >> SlotShift(level)) & (NUM_SLOTS - 1)));
+    }
+
+    u32& Head(u32 slot) {
+        return slot == overflow_slot ? overflow : slots[slot];
+    }
+
+    void LinkSlot(u32 index) {
+        Node& node = nodes[index];
+        // Late events are kept with the ones due now
+        const u64 time = static_cast<u64>(std::max(node.event.time, now));
+        const u64 current = static_cast<u64>(now);
+        node.slot = overflow_slot;
+        for (std::size_t level = 0; level < NUM_LEVELS; ++level) {
+            if ((time >> SpanShift(level)) == (current >> SpanShift(level))) {
+                node.slot = SlotOf(level, time);
+                occupied[node.slot / 64] |= u64{1} << (node.slot % 64);
+                break;
+            }
+        }
+        u32& head = Head(node.slot);
+        node.prev = INVALID;
+        node.next = head;
+        if (head != INVALID) {
+            nodes[head].prev = index;
+        }
+        head = index;
+    }
+
+    void UnlinkSlot(u32 index) {
+        Node& node = nodes[index];
+        if (node.prev != INVALID) {
+            nodes[node.prev].next = node.next;
+        } else {
+            Head(node.slot) = node.next;
+            if (node.next == INVALID && node.slot != overflow_slot) {
+                occupied[node.slot / 64] &= ~(u64{1} << (node.slot % 64));
+            }
+        }
+        if (node.next != INVALID) {
+            nodes[node.next].prev = node.prev;
+        }
+    }
+
+    void LinkType(u32 index) {
+        Node& node = nodes[index];
+        u32& head = type_heads.try_emplace(node.event.type, INVALID).first->second;
+        node.type_prev = INVALID;
+        node.type_next = head;
+        if (head != INVALID) {
+            nodes[head].type_prev = index;
+        }
+        head = index;
+    }
+
+    void UnlinkType(u32 index) {
+        Node& node = nodes[index];
+        if (node.type_prev != INVALID) {
+            nodes[node.type_prev].type_next = node.type_next;
+        } else if (node.type_next != INVALID) {
+            type_heads[node.event.type] = node.type_next;
+        } else {
+            type_heads.erase(node.event.type);
+        }
+        if (node.type_next != INVALID) {
+            nodes[node.type_next].type_prev = node.type_prev;
+        }
+    }
+
+    void Erase(u32 index) {
+        UnlinkSlot(index);
+        UnlinkType(index);
+        nodes[index].next = free_nodes;
+        free_nodes = index;
+        --num_events;
+        if (front == index) {
+            front = INVALID;
+        }
+    }
+
+    /// Puts the events of a slot back into the wheel, after its current time changed
+    void Relink(u32 slot) {
+        u32 index = Head(slot);
+        Head(slot) = INVALID;
+        if (slot != overflow_slot) {
+            occupied[slot / 64] &= ~(u64{1} << (slot % 64));
+        }
+        while (index != INVALID) {
+            const u32 next = nodes[index].next;
+            LinkSlot(index);
+            index = next;
+        }
+    }
+
+    /// Returns the earliest event of a slot list
+    u32 FindEarliest(u32 index) const {
+        u32 earliest = index;
+        for (index = nodes[index].next; index != INVALID; index = nodes[index].next) {
+            if (nodes[index].event < nodes[earliest].event) {
+                earliest = index;
+            }
+        }
+        return earliest;
+    }
+
+    u32 FindFront() const {
+        // Every event of a level is in the current slot or after it, and before those of the
+        // levels above, so the first occupied slot holds the earliest event
+        const u64 current = static_cast<u64>(now);
+        for (std::size_t level = 0; level < NUM_LEVELS; ++level) {
+            const u32 first = SlotOf(level, current);
+            const u32 end = static_cast<u32>((level + 1) * NUM_SLOTS);
+            for (u32 slot = first; slot < end;) {
+                const u64 bits = occupied[slot / 64] >> (slot % 64);
+                if (bits != 0) {
+                    const u32 found = slot + static_cast<u32>(std::countr_zero(bits));
+                    return FindEarliest(slots[found]);
+                }
+                slot = (slot / 64 + 1) * 64;
+            }
+        }
+        return FindEarliest(overflow);
+    }
+
+    static constexpr u32 overflow_slot = static_cast<u32>(NUM_LEVELS * NUM_SLOTS);
+
+    std::vector<Node> nodes;
+    std::unordered_map<Type, u32> type_heads;
+    std::array<u32, NUM_LEVELS * NUM_SLOTS> slots = MakeEmptySlots();
+    std::array<u64, NUM_LEVELS * NUM_SLOTS / 64> occupied{};
+    u32 overflow = INVALID;
+    u32 free_nodes = INVALID;
+    mutable u32 front = INVALID;
+    std::size_t num_events = 0;
+    s64 now = 0;
+
+    static constexpr std::array<u32, NUM_LEVELS * NUM_SLOTS> MakeEmptySlots() {
+        std::array<u32, NUM_LEVELS * NUM_SLOTS> empty{};
+        empty.fill(INVALID);
+        return empty;
+    }
+};
+
+} // namespace Core
@@ -0,0 +1,42 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch_test_macros.hpp>
+#include "common/host_memory.h"
+#include "common/virtual_buffer.h"
+
+TEST_CASE("HostMemoryArena aliases the backing memory", "[common]") {
+    if (!Common::HostMemory::IsSharingSupported()) {
+        return;
+    }
+    const std::size_t page_size = Common::GetHostPageSize();
+    Common::HostMemory backing(page_size * 4, true);
+    REQUIRE(backing.IsShared());
+    Common::HostMemoryArena arena(backing, page_size * 16);
+
+    // Pages are mapped in any order and at any place
+    arena.Map(page_size * 8, page_size * 2, page_size * 2, true);
+    arena.Map(page_size * 3, 0, page_size, false);
+
+    backing.data()[page_size * 2 + 5] = 0x12;
+    CHECK(arena.data()[page_size * 8 + 5] == 0x12);
+    arena.data()[page_size * 9 + 7] = 0x34;
+    CHECK(backing.data()[page_size * 3 + 7] == 0x34);
+    backing.data()[3] = 0x56;
+    CHECK(arena.data()[page_size * 3 + 3] == 0x56);
+
+    // Remapping replaces the previous mapping
+    arena.Unmap(page_size * 8, page_size * 2);
+    arena.Map(page_size * 8, page_size, page_size, true);
+    arena.data()[page_size * 8] = 0x78;
+    CHECK(backing.data()[page_size] == 0x78);
+}
+
+TEST_CASE("HostMemory without sharing is zero-filled", "[common]") {
+    const std::size_t page_size = Common::GetHostPageSize();
+    Common::HostMemory memory(page_size * 2, false);
+    CHECK_FALSE(memory.IsShared());
+    CHECK(memory.data()[0] == 0);
+    CHECK(memory.data()[page_size * 2 - 1] == 0);
+}
@@ -0,0 +1,114 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch_test_macros.hpp>
+#include "common/host_memory.h"
+#include "common/virtual_buffer.h"
+#include "common/write_watch.h"
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using WrittenRanges = Common::WriteWatch::WrittenRanges;
+
+TEST_CASE("WriteWatch records writes to watched pages", "[common]") {
+    if (!Common::WriteWatch::IsSupported()) {
+        return;
+    }
+    const std::size_t page_size = Common::GetHostPageSize();
+    Common::HostMemory memory(page_size * 4, false);
+    Common::WriteWatch watch(memory.data(), page_size * 4);
+    watch.Watch(page_size, page_size * 2, true);
+
+    // The test runner installs its crash handler again for every run of a test case, hiding the
+    // handler installed by the first watch, so everything relying on write faults is checked in
+    // the first run
+    SECTION("writes caught by the fault handler") {
+        memory.data()[0] = 1;
+        memory.data()[page_size + 1] = 2;
+        memory.data()[page_size + 2] = 3;
+        CHECK(watch.ConsumeWrites() == WrittenRanges{{page_size, page_size}});
+        CHECK(watch.ConsumeWrites().empty());
+        CHECK(memory.data()[page_size + 2] == 3);
+
+        // Consumed pages are protected again
+        memory.data()[page_size] = 4;
+        memory.data()[page_size * 2] = 5;
+        CHECK(watch.ConsumeWrites() == WrittenRanges{{page_size, page_size * 2}});
+
+        // Suspended pages stay writable while they are watched
+        watch.Suspend(page_size, page_size, true);
+        memory.data()[page_size] = 6;
+        memory.data()[page_size * 2] = 7;
+        CHECK(watch.ConsumeWrites() == WrittenRanges{{page_size * 2, page_size}});
+        CHECK(watch.IsWatched(page_size));
+        watch.Suspend(page_size, page_size, false);
+        memory.data()[page_size] = 8;
+        CHECK(watch.ConsumeWrites() == WrittenRanges{{page_size, page_size}});
+
+#ifndef _WIN32
+        // Faults outside of the watched block go to the previous handler, which is the one of the
+        // test runner here. It kills the process, so the fault is raised in a child.
+        const pid_t pid = fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0) {
+            // Keep the expected crash out of the report, and don't hang if the fault is swallowed
+            close(STDOUT_FILENO);
+            close(STDERR_FILENO);
+            alarm(10);
+            memory.data()[page_size] = 9;
+            if (watch.ConsumeWrites() != WrittenRanges{{page_size, page_size}}) {
+                _exit(1);
+            }
+            void* const read_only =
+                mmap(nullptr, page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (read_only == MAP_FAILED) {
+                _exit(1);
+            }
+            *static_cast<volatile u8*>(read_only) = 10;
+            _exit(0);
+        }
+        int status = 0;
+        REQUIRE(waitpid(pid, &status, 0) == pid);
+        REQUIRE(WIFSIGNALED(status));
+        CHECK((WTERMSIG(status) == SIGSEGV || WTERMSIG(status) == SIGBUS));
+#endif
+
+        // Pages no longer watched stay writable
+        watch.Watch(page_size, page_size * 2, false);
+        memory.data()[page_size] = 11;
+        CHECK(watch.ConsumeWrites().empty());
+        CHECK_FALSE(watch.IsWatched(page_size));
+        watch.Watch(page_size, page_size * 2, true);
+    }
+
+    SECTION("writes marked ahead") {
+        // Only the watched pages are recorded
+        watch.MarkWritten(page_size - 1, page_size * 3);
+        CHECK(watch.ConsumeWrites() == WrittenRanges{{page_size, page_size * 2}});
+        watch.MarkWritten(page_size * 3, page_size);
+        CHECK(watch.ConsumeWrites().empty());
+    }
+
+#ifndef _WIN32
+    SECTION("writes made by the host kernel") {
+        // The kernel fails a system call writing into a read-only page instead of faulting
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        constexpr char message[] = "citra";
+        REQUIRE(write(fds[1], message, sizeof(message)) == sizeof(message));
+        u8* const dest = memory.data() + page_size * 2 + 10;
+        watch.MarkWritten(page_size * 2 + 10, sizeof(message));
+        CHECK(read(fds[0], dest, sizeof(message)) == sizeof(message));
+        close(fds[0]);
+        close(fds[1]);
+        CHECK(dest[0] == 'c');
+        CHECK(watch.ConsumeWrites() == WrittenRanges{{page_size * 2, page_size}});
+    }
+#endif
+}
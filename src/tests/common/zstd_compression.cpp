@@ -0,0 +1,105 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <filesystem>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "common/file_util.h"
+#include "common/zstd_compression.h"
+
+using namespace Common::Compression;
+
+namespace {
+
+/// Data spanning several compressor chunks, half random and half compressible
+std::vector<char> MakeTestData() {
+    std::vector<char> data(9 * 1024 * 1024);
+    std::mt19937 rng{42};
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i < data.size() / 2 ? rng() : i / 4096);
+    }
+    return data;
+}
+
+std::string TempPath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void WriteCompressed(const std::string& path, const std::vector<char>& data) {
+    FileUtil::IOFile file(path, "wb");
+    REQUIRE(file.IsOpen());
+    ZSTDCompressStreamBuffer buffer{file, 3, 0};
+    std::ostream stream{&buffer};
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+    REQUIRE(stream.good());
+    REQUIRE(buffer.Finish());
+}
+
+std::vector<char> ReadDecompressed(FileUtil::IOFile& file) {
+    ZSTDDecompressStreamBuffer buffer{file};
+    std::istream stream{&buffer};
+    return {std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ZSTD stream round trip", "[common][zstd]") {
+    const auto path = TempPath("citra_zstd_round_trip.zst");
+    const auto data = MakeTestData();
+    WriteCompressed(path, data);
+
+    {
+        FileUtil::IOFile file(path, "rb");
+        REQUIRE(ValidateZSTDStream(file));
+        REQUIRE(file.Tell() == 0);
+        REQUIRE(ReadDecompressed(file) == data);
+    }
+    FileUtil::Delete(path);
+}
+
+TEST_CASE("ZSTD stream truncation and corruption", "[common][zstd]") {
+    const auto path = TempPath("citra_zstd_damaged.zst");
+    const auto data = MakeTestData();
+    WriteCompressed(path, data);
+    const u64 size = FileUtil::GetSize(path);
+
+    SECTION("truncated") {
+        for (const u64 cut : {u64{1}, u64{4}, size / 2, size - 1}) {
+            {
+                FileUtil::IOFile file(path, "r+b");
+                REQUIRE(file.Resize(size - cut));
+            }
+            FileUtil::IOFile file(path, "rb");
+            REQUIRE_FALSE(ValidateZSTDStream(file));
+        }
+    }
+
+    SECTION("corrupted") {
+        {
+            FileUtil::IOFile file(path, "r+b");
+            REQUIRE(file.Seek(static_cast<s64>(size / 2), SEEK_SET));
+            u8 byte{};
+            REQUIRE(file.ReadBytes(&byte, 1) == 1);
+            byte ^= 0xFF;
+            REQUIRE(file.Seek(static_cast<s64>(size / 2), SEEK_SET));
+            REQUIRE(file.WriteBytes(&byte, 1) == 1);
+        }
+        FileUtil::IOFile file(path, "rb");
+        REQUIRE_FALSE(ValidateZSTDStream(file));
+    }
+
+    SECTION("empty") {
+        {
+            FileUtil::IOFile file(path, "wb");
+        }
+        FileUtil::IOFile file(path, "rb");
+        REQUIRE_FALSE(ValidateZSTDStream(file));
+    }
+    FileUtil::Delete(path);
+}
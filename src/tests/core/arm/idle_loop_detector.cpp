@@ -0,0 +1,85 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <initializer_list>
+#include <catch2/catch_test_macros.hpp>
+#include "core/arm/dyncom/arm_dyncom.h"
+#include "core/arm/idle_loop_detector.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "tests/core/arm/arm_test_common.h"
+
+namespace ArmTests {
+
+namespace {
+
+/// Polled address, which reads as zero
+constexpr VAddr FLAG_ADDRESS = 0x1000;
+
+/// Not a multiple of the length of the polling loop, so that each slice ends at another point of it
+constexpr s64 SLICE_LENGTH = 10000;
+
+/// Runs the program from address 0 for the given number of slices
+bool RunSlices(std::initializer_list<u32> program, u32 num_slices) {
+    TestEnvironment test_env(false);
+    VAddr addr = 0;
+    for (const u32 instruction : program) {
+        test_env.SetMemory32(addr, instruction);
+        addr += 4;
+    }
+    test_env.SetMemory32(FLAG_ADDRESS, 0);
+
+    Core::Timing timing(1, 100);
+    ARM_DynCom dyncom(&Core::System::GetInstance(), test_env.GetMemory(), USER32MODE, 0,
+                      timing.GetTimer(0));
+    dyncom.SetPC(0);
+    dyncom.SetReg(0, FLAG_ADDRESS);
+    dyncom.SetVFPReg(4, 0x3F800000); // 1.0f
+
+    Core::IdleLoopDetector detector;
+    for (u32 i = 0; i < num_slices; ++i) {
+        timing.GetTimer(0)->Advance();
+        timing.GetTimer(0)->SetNextSlice(SLICE_LENGTH);
+        detector.Run(dyncom);
+    }
+    return detector.IsPolling();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("IdleLoopDetector", "[core][arm]") {
+    SECTION("loop polling memory") {
+        // The first sample only records the registers
+        constexpr u32 num_slices = Core::IdleLoopDetector::POLLING_THRESHOLD + 1;
+        const std::initializer_list<u32> program{
+            0xE5901000, // ldr r1, [r0]
+            0xE3510000, // cmp r1, #0
+            0x0AFFFFFC, // beq #0
+        };
+        REQUIRE_FALSE(RunSlices(program, num_slices - 1));
+        REQUIRE(RunSlices(program, num_slices));
+        // Probing keeps the core polling
+        REQUIRE(RunSlices(program, num_slices + 4));
+    }
+
+    SECTION("loop incrementing a counter") {
+        REQUIRE_FALSE(RunSlices(
+            {
+                0xE2811001, // add r1, r1, #1
+                0xEAFFFFFD, // b #0
+            },
+            8));
+    }
+
+    SECTION("loop accumulating a float") {
+        REQUIRE_FALSE(RunSlices(
+            {
+                0xEE311A02, // vadd.f32 s2, s2, s4
+                0xEAFFFFFD, // b #0
+            },
+            8));
+    }
+}
+
+} // namespace ArmTests
@@ -7,6 +7,7 @@
 #include <array>
 #include <bitset>
 #include <string>
+#include <thread>
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -196,4 +197,65 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(MAX_SLICE_LENGTH == timing.GetTimer(0)->GetDowncount());
 }
 
+TEST_CASE("CoreTiming[IdleAfter]", "[core]") {
+    Core::Timing timing(1, 100);
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+
+    // Enter slice 0
+    timing.GetTimer(0)->Advance();
+    timing.GetTimer(0)->SetNextSlice();
+
+    timing.ScheduleEvent(5000, cb_a, CB_IDS[0], 0);
+    REQUIRE(5000 == timing.GetTimer(0)->GetDowncount());
+
+    // Only the probed ticks are executed, the rest of the slice still passes
+    const u64 start_ticks = timing.GetTimer(0)->GetTicks();
+    timing.GetTimer(0)->IdleAfter(1000);
+    REQUIRE(1000 == timing.GetTimer(0)->GetDowncount());
+    REQUIRE(4000 == timing.GetTimer(0)->GetIdleTicks());
+    timing.GetTimer(0)->IdleAfter(2000);
+    REQUIRE(1000 == timing.GetTimer(0)->GetDowncount());
+
+    AdvanceAndCheck(timing, 0, MAX_SLICE_LENGTH);
+    REQUIRE(start_ticks + 5000 == timing.GetTimer(0)->GetTicks());
+}
+
+TEST_CASE("CoreTiming[UnscheduleOtherThread]", "[core]") {
+    Core::Timing timing(2, 100);
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+
+    timing.GetTimer(0)->Advance();
+    timing.GetTimer(0)->SetNextSlice();
+    timing.GetTimer(1)->Advance();
+    timing.GetTimer(1)->SetNextSlice();
+
+    // Events for another core wait in its thread-safe queue until it advances
+    timing.SetCurrentTimer(0);
+    timing.ScheduleEvent(100, cb_a, CB_IDS[0], 1);
+    timing.ScheduleEvent(200, cb_b, CB_IDS[1], 1);
+    timing.UnscheduleEvent(cb_a, CB_IDS[0]);
+    timing.RemoveEvent(cb_b);
+
+    callbacks_ran_flags = 0;
+    timing.GetTimer(1)->AddTicks(1000);
+    timing.GetTimer(1)->Advance();
+    REQUIRE(callbacks_ran_flags.none());
+}
+
+TEST_CASE("CoreTiming[ScheduleThreadsafe]", "[core]") {
+    Core::Timing timing(1, 100);
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+
+    timing.GetTimer(0)->Advance();
+    timing.GetTimer(0)->SetNextSlice();
+
+    // The event is due as soon as it reaches the timer, and late by the slice it was queued in
+    std::thread{[&] { timing.ScheduleEventThreadsafe(cb_a, CB_IDS[0]); }}.join();
+    AdvanceAndCheck(timing, 0, MAX_SLICE_LENGTH, MAX_SLICE_LENGTH - 100, 100);
+}
+
 // TODO: Add tests for multiple timers
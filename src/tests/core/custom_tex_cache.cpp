@@ -0,0 +1,93 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/settings.h"
+#include "core/custom_tex_cache.h"
+#include "core/frontend/image_interface.h"
+
+namespace {
+
+constexpr u64 PROGRAM_ID = 0x0004000000123400;
+constexpr u64 TEXTURE_HASH = 0x1234567890ABCDEF;
+
+/// A single row of four texels, so flipping the texture leaves it as it is
+constexpr u32 WIDTH = 4;
+constexpr u32 HEIGHT = 1;
+
+/// Stands in for a PNG decoder by taking the contents of the file as the texels
+class FakeImageInterface final : public Frontend::ImageInterface {
+public:
+    bool DecodePNG(std::vector<u8>& dst, u32& width, u32& height,
+                   const std::string& path) override {
+        ++decode_count;
+        std::string contents;
+        if (FileUtil::ReadFileToString(false, path, contents) != WIDTH * HEIGHT * 4) {
+            return false;
+        }
+        dst.assign(contents.begin(), contents.end());
+        width = WIDTH;
+        height = HEIGHT;
+        return true;
+    }
+
+    bool EncodePNG(const std::string& path, const std::vector<u8>& src, u32 width,
+                   u32 height) override {
+        return false;
+    }
+
+    int decode_count = 0;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("CustomTexCache converted textures", "[core]") {
+    const std::string user_dir =
+        (std::filesystem::temp_directory_path() / "citra_custom_tex_cache_test").string();
+    std::filesystem::remove_all(user_dir);
+    const std::string texture_dir =
+        fmt::format("{}" DIR_SEP "load" DIR_SEP "textures" DIR_SEP "{:016X}" DIR_SEP, user_dir,
+                    PROGRAM_ID);
+    REQUIRE(FileUtil::CreateFullPath(texture_dir));
+    REQUIRE(FileUtil::CreateFullPath(user_dir + DIR_SEP "cache" DIR_SEP));
+    FileUtil::UpdateUserPath(FileUtil::UserPath::LoadDir, user_dir + DIR_SEP "load");
+    FileUtil::UpdateUserPath(FileUtil::UserPath::CacheDir, user_dir + DIR_SEP "cache");
+    Settings::values.async_custom_loading.SetValue(false);
+
+    const std::string png_path =
+        fmt::format("{}tex1_{}x{}_{:016x}_13.png", texture_dir, WIDTH, HEIGHT, TEXTURE_HASH);
+    const auto image_interface = std::make_shared<FakeImageInterface>();
+    const auto LoadTexels = [&image_interface] {
+        Core::CustomTexCache cache(image_interface, PROGRAM_ID);
+        cache.FindCustomTextures();
+        const auto texture = cache.GetTexture(TEXTURE_HASH);
+        REQUIRE(texture);
+        return std::string(texture->tex.begin(), texture->tex.end());
+    };
+
+    const std::string first = "0123456789ABCDEF";
+    REQUIRE(FileUtil::WriteStringToFile(false, png_path, first) == first.size());
+    CHECK(LoadTexels() == first);
+    CHECK(image_interface->decode_count == 1);
+
+    // Loaded from the converted copy
+    CHECK(LoadTexels() == first);
+    CHECK(image_interface->decode_count == 1);
+
+    // An edited texture of the same size is converted again
+    const std::string second = "FEDCBA9876543210";
+    REQUIRE(FileUtil::WriteStringToFile(false, png_path, second) == second.size());
+    CHECK(LoadTexels() == second);
+    CHECK(image_interface->decode_count == 2);
+    CHECK(LoadTexels() == second);
+    CHECK(image_interface->decode_count == 2);
+
+    std::filesystem::remove_all(user_dir);
+}
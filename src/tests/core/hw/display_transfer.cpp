@@ -0,0 +1,179 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "core/hw/display_transfer.h"
+
+using GPU::Regs;
+using Config = Regs::DisplayTransferConfig;
+
+namespace {
+
+constexpr std::array FORMATS = {
+    Regs::PixelFormat::RGBA8,  Regs::PixelFormat::RGB8,  Regs::PixelFormat::RGB565,
+    Regs::PixelFormat::RGB5A1, Regs::PixelFormat::RGBA4,
+};
+
+const char* GetFormatName(Regs::PixelFormat format) {
+    switch (format) {
+    case Regs::PixelFormat::RGBA8:
+        return "RGBA8";
+    case Regs::PixelFormat::RGB8:
+        return "RGB8";
+    case Regs::PixelFormat::RGB565:
+        return "RGB565";
+    case Regs::PixelFormat::RGB5A1:
+        return "RGB5A1";
+    default:
+        return "RGBA4";
+    }
+}
+
+/// Input and output layouts, as the input_linear and dont_swizzle flags
+enum class Layout {
+    TiledToLinear,
+    LinearToTiled,
+    LinearToLinear,
+    TiledToTiled,
+};
+
+constexpr std::array LAYOUTS = {Layout::TiledToLinear, Layout::LinearToTiled,
+                                Layout::LinearToLinear, Layout::TiledToTiled};
+
+const char* GetLayoutName(Layout layout) {
+    switch (layout) {
+    case Layout::TiledToLinear:
+        return "tiled to linear";
+    case Layout::LinearToTiled:
+        return "linear to tiled";
+    case Layout::LinearToLinear:
+        return "linear to linear";
+    default:
+        return "tiled to tiled";
+    }
+}
+
+Config MakeConfig(Layout layout, Regs::PixelFormat input_format, Regs::PixelFormat output_format,
+                  Config::ScalingMode scaling, bool flip, u32 width, u32 height) {
+    Config config{};
+    config.input_width.Assign(width);
+    config.input_height.Assign(height);
+    config.output_width.Assign(width);
+    config.output_height.Assign(height);
+    config.input_linear.Assign(layout == Layout::LinearToTiled || layout == Layout::LinearToLinear);
+    config.dont_swizzle.Assign(layout == Layout::LinearToLinear || layout == Layout::TiledToTiled);
+    config.input_format.Assign(input_format);
+    config.output_format.Assign(output_format);
+    config.scaling.Assign(scaling);
+    config.flip_vertically.Assign(flip);
+    return config;
+}
+
+std::vector<u8> MakeInput(const Config& config, std::mt19937& rng) {
+    std::vector<u8> input(config.input_width * config.input_height *
+                          Regs::BytesPerPixel(config.input_format));
+    for (auto& byte : input) {
+        byte = static_cast<u8>(rng());
+    }
+    return input;
+}
+
+std::size_t GetOutputSize(const Config& config) {
+    const u32 width = config.scaling != Config::NoScale ? config.output_width / 2
+                                                          : config.output_width.Value();
+    const u32 height = config.scaling == Config::ScaleXY ? config.output_height / 2
+                                                           : config.output_height.Value();
+    return width * height * Regs::BytesPerPixel(config.output_format);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ConvertDisplayTransfer matches the per-pixel conversion", "[core][display_transfer]") {
+    std::mt19937 rng(0x3D5);
+    for (const Layout layout : LAYOUTS) {
+        const bool tiled_input = layout == Layout::TiledToLinear || layout == Layout::TiledToTiled;
+        for (const auto scaling : {Config::NoScale, Config::ScaleX, Config::ScaleXY}) {
+            // Scaling is only implemented on tiled input
+            if (!tiled_input && scaling != Config::NoScale) {
+                continue;
+            }
+            for (const auto input_format : FORMATS) {
+                for (const auto output_format : FORMATS) {
+                    for (const bool flip : {false, true}) {
+                        // Large enough to be split among the worker threads when unscaled
+                        const Config config = MakeConfig(layout, input_format, output_format,
+                                                         scaling, flip, 256, 272);
+                        const std::vector<u8> input = MakeInput(config, rng);
+                        std::vector<u8> expected(GetOutputSize(config));
+                        GPU::ConvertDisplayTransferPixels(config, input.data(), expected.data());
+
+                        INFO(GetLayoutName(layout)
+                             << ", scaling " << static_cast<u32>(scaling) << ", "
+                             << GetFormatName(input_format) << " to "
+                             << GetFormatName(output_format) << ", flip " << flip);
+                        for (const bool multithreaded : {false, true}) {
+                            std::vector<u8> result(expected.size());
+                            GPU::ConvertDisplayTransfer(config, input.data(), result.data(),
+                                                        multithreaded);
+                            REQUIRE(result == expected);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("ConvertDisplayTransfer handles unaligned linear transfers",
+          "[core][display_transfer]") {
+    std::mt19937 rng(0x3D5);
+    const Config config = MakeConfig(Layout::LinearToLinear, Regs::PixelFormat::RGB8,
+                                     Regs::PixelFormat::RGBA8, Config::NoScale, true, 13, 7);
+    const std::vector<u8> input = MakeInput(config, rng);
+    std::vector<u8> expected(GetOutputSize(config));
+    std::vector<u8> result(expected.size());
+    GPU::ConvertDisplayTransferPixels(config, input.data(), expected.data());
+    GPU::ConvertDisplayTransfer(config, input.data(), result.data());
+    REQUIRE(result == expected);
+}
+
+TEST_CASE("DisplayTransfer fallback throughput", "[.][benchmark][core][display_transfer]") {
+    std::mt19937 rng(0x3D5);
+    for (const Layout layout : LAYOUTS) {
+        const bool tiled_input = layout == Layout::TiledToLinear || layout == Layout::TiledToTiled;
+        for (const auto scaling : {Config::NoScale, Config::ScaleX, Config::ScaleXY}) {
+            if (!tiled_input && scaling != Config::NoScale) {
+                continue;
+            }
+            for (const auto input_format : FORMATS) {
+                for (const auto output_format : FORMATS) {
+                    // The size of the top screen framebuffer, before downscaling
+                    const Config config = MakeConfig(layout, input_format, output_format,
+                                                     scaling, true, 240, 400);
+                    const std::vector<u8> input = MakeInput(config, rng);
+                    std::vector<u8> output(GetOutputSize(config));
+                    const std::string name = fmt::format(
+                        "{}, scaling {}, {} to {}", GetLayoutName(layout),
+                        static_cast<u32>(scaling), GetFormatName(input_format),
+                        GetFormatName(output_format));
+                    BENCHMARK(name + " per pixel") {
+                        GPU::ConvertDisplayTransferPixels(config, input.data(), output.data());
+                    };
+                    BENCHMARK(name + " banded") {
+                        GPU::ConvertDisplayTransfer(config, input.data(), output.data(), false);
+                    };
+                    BENCHMARK(name + " multithreaded") {
+                        GPU::ConvertDisplayTransfer(config, input.data(), output.data(), true);
+                    };
+                }
+            }
+        }
+    }
+}
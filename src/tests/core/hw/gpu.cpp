@@ -0,0 +1,95 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <span>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "core/hle/service/gsp/gsp_gpu.h"
+#include "core/hw/gpu.h"
+#include "core/savestate.h"
+
+using Service::GSP::InterruptId;
+
+namespace {
+
+constexpr std::size_t NumPages = 4;
+
+/// Interrupts are logged to the last page as they are signalled
+constexpr std::size_t LogOffset = (NumPages - 1) * Core::Snapshot::PageSize;
+
+/**
+ * Runs one GPU operation on another thread the way the emulation thread does while it has to be
+ * deterministic: the operation writes guest memory and raises its interrupt, and the emulation
+ * thread signals the deferred interrupts once it is done.
+ */
+void RunOperation(GPU::DeferredInterrupts& deferred, std::vector<u8>& ram, std::size_t step,
+                  std::size_t& log_size) {
+    deferred.Begin();
+    bool is_deferred = false;
+    std::thread gpu_thread([&deferred, &ram, &is_deferred, step] {
+        const std::size_t offset = (step % (NumPages - 1)) * Core::Snapshot::PageSize;
+        for (std::size_t i = 0; i < Core::Snapshot::PageSize; ++i) {
+            ram[offset + i] = static_cast<u8>(ram[offset + i] * 3 + step + i);
+        }
+        is_deferred = deferred.Defer(step % 2 ? InterruptId::PPF : InterruptId::P3D);
+    });
+    gpu_thread.join();
+    REQUIRE(is_deferred);
+
+    for (const InterruptId interrupt_id : deferred.End()) {
+        // The guest reacts to the interrupt by reading the memory the operation wrote
+        const std::size_t offset = (step % (NumPages - 1)) * Core::Snapshot::PageSize;
+        ram[LogOffset + log_size++] = static_cast<u8>(interrupt_id) ^ ram[offset];
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("DeferredInterrupts", "[core][hw]") {
+    GPU::DeferredInterrupts deferred;
+
+    SECTION("not waiting for the GPU thread") {
+        REQUIRE_FALSE(deferred.Defer(InterruptId::PSC0));
+        REQUIRE(deferred.End().empty());
+    }
+
+    SECTION("interrupts are returned in order") {
+        deferred.Begin();
+        bool is_deferred = false;
+        std::thread gpu_thread([&deferred, &is_deferred] {
+            is_deferred = deferred.Defer(InterruptId::PSC0) && deferred.Defer(InterruptId::P3D);
+        });
+        gpu_thread.join();
+        REQUIRE(is_deferred);
+        REQUIRE(deferred.End() == std::vector{InterruptId::PSC0, InterruptId::P3D});
+        REQUIRE_FALSE(deferred.Defer(InterruptId::PPF));
+    }
+
+    SECTION("rewinding replays the same state") {
+        std::vector<u8> ram(NumPages * Core::Snapshot::PageSize);
+        const std::array regions{std::span<u8>{ram}};
+        std::size_t log_size = 0;
+        for (std::size_t step = 0; step < 4; ++step) {
+            RunOperation(deferred, ram, step, log_size);
+        }
+
+        Core::Snapshot snapshot;
+        snapshot.CapturePages(regions, nullptr);
+        const std::size_t snapshot_log_size = log_size;
+        for (std::size_t step = 4; step < 8; ++step) {
+            RunOperation(deferred, ram, step, log_size);
+        }
+        const std::vector<u8> expected = ram;
+
+        snapshot.RestorePages(regions);
+        log_size = snapshot_log_size;
+        for (std::size_t step = 4; step < 8; ++step) {
+            RunOperation(deferred, ram, step, log_size);
+        }
+        REQUIRE(log_size == 8);
+        REQUIRE(ram == expected);
+    }
+}
@@ -0,0 +1,320 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "common/color.h"
+#include "common/vector_math.h"
+#include "core/hle/service/y2r_u.h"
+#include "core/hw/y2r.h"
+
+using namespace Service::Y2R;
+
+namespace {
+
+constexpr std::size_t TILE_SIZE = 8 * 8;
+using ImageTile = std::array<u32, TILE_SIZE>;
+
+constexpr std::array INPUT_FORMATS = {
+    InputFormat::YUV422_Indiv8,  InputFormat::YUV420_Indiv8,       InputFormat::YUV422_Indiv16,
+    InputFormat::YUV420_Indiv16, InputFormat::YUYV422_Interleaved,
+};
+
+constexpr std::array OUTPUT_FORMATS = {
+    OutputFormat::RGBA8,
+    OutputFormat::RGB8,
+    OutputFormat::RGB5A1,
+    OutputFormat::RGB565,
+};
+
+constexpr std::array ROTATIONS = {
+    Rotation::None,
+    Rotation::Clockwise_90,
+    Rotation::Clockwise_180,
+    Rotation::Clockwise_270,
+};
+
+// The per-pixel strip conversion and encoding that the vectorized ones replaced, as reference
+
+void ReferenceConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
+                              const u8* input_V, ImageTile output[], unsigned int width,
+                              unsigned int height, const CoefficientSet& coefficients) {
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            s32 Y = 0;
+            s32 U = 0;
+            s32 V = 0;
+            switch (input_format) {
+            case InputFormat::YUV422_Indiv8:
+            case InputFormat::YUV422_Indiv16:
+                Y = input_Y[y * width + x];
+                U = input_U[(y * width + x) / 2];
+                V = input_V[(y * width + x) / 2];
+                break;
+            case InputFormat::YUV420_Indiv8:
+            case InputFormat::YUV420_Indiv16:
+                Y = input_Y[y * width + x];
+                U = input_U[((y / 2) * width + x) / 2];
+                V = input_V[((y / 2) * width + x) / 2];
+                break;
+            case InputFormat::YUYV422_Interleaved:
+                Y = input_Y[(y * width + x) * 2];
+                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
+                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
+                break;
+            }
+
+            const auto& c = coefficients;
+            s32 cY = c[0] * Y;
+
+            s32 r = cY + c[1] * V;
+            s32 g = cY - c[2] * V - c[3] * U;
+            s32 b = cY + c[4] * U;
+
+            const s32 rounding_offset = 0x18;
+            r = (r >> 3) + c[5] + rounding_offset;
+            g = (g >> 3) + c[6] + rounding_offset;
+            b = (b >> 3) + c[7] + rounding_offset;
+
+            unsigned int tile = x / 8;
+            unsigned int tile_x = x % 8;
+            u32* out = &output[tile][y * 8 + tile_x];
+
+            *out = ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) |
+                   ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
+                   ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
+        }
+    }
+}
+
+constexpr u8 linear_lut[TILE_SIZE] = {
+    // clang-format off
+     0,  1,  2,  3,  4,  5,  6,  7,
+     8,  9, 10, 11, 12, 13, 14, 15,
+    16, 17, 18, 19, 20, 21, 22, 23,
+    24, 25, 26, 27, 28, 29, 30, 31,
+    32, 33, 34, 35, 36, 37, 38, 39,
+    40, 41, 42, 43, 44, 45, 46, 47,
+    48, 49, 50, 51, 52, 53, 54, 55,
+    56, 57, 58, 59, 60, 61, 62, 63,
+    // clang-format on
+};
+
+constexpr u8 morton_lut[TILE_SIZE] = {
+    // clang-format off
+     0,  1,  4,  5, 16, 17, 20, 21,
+     2,  3,  6,  7, 18, 19, 22, 23,
+     8,  9, 12, 13, 24, 25, 28, 29,
+    10, 11, 14, 15, 26, 27, 30, 31,
+    32, 33, 36, 37, 48, 49, 52, 53,
+    34, 35, 38, 39, 50, 51, 54, 55,
+    40, 41, 44, 45, 56, 57, 60, 61,
+    42, 43, 46, 47, 58, 59, 62, 63,
+    // clang-format on
+};
+
+void RotateTile0(const ImageTile& input, ImageTile& output, int height, const u8 out_map[64]) {
+    for (int i = 0; i < height * 8; ++i) {
+        output[out_map[i]] = input[i];
+    }
+}
+
+void RotateTile90(const ImageTile& input, ImageTile& output, int height, const u8 out_map[64]) {
+    int out_i = 0;
+    for (int x = 0; x < 8; ++x) {
+        for (int y = height - 1; y >= 0; --y) {
+            output[out_map[out_i++]] = input[y * 8 + x];
+        }
+    }
+}
+
+void RotateTile180(const ImageTile& input, ImageTile& output, int height, const u8 out_map[64]) {
+    int out_i = 0;
+    for (int i = height * 8 - 1; i >= 0; --i) {
+        output[out_map[out_i++]] = input[i];
+    }
+}
+
+void RotateTile270(const ImageTile& input, ImageTile& output, int height, const u8 out_map[64]) {
+    int out_i = 0;
+    for (int x = 8 - 1; x >= 0; --x) {
+        for (int y = 0; y < height; ++y) {
+            output[out_map[out_i++]] = input[y * 8 + x];
+        }
+    }
+}
+
+void WriteTileToOutput(u32* output, const ImageTile& tile, int height, int line_stride) {
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            output[y * line_stride + x] = tile[y * 8 + x];
+        }
+    }
+}
+
+void ReferenceConvertStrip(const ConversionConfiguration& cvt, const u8* input, u32* output_buffer,
+                           unsigned int row_height) {
+    const std::size_t num_tiles = cvt.input_line_width / 8;
+    std::vector<ImageTile> tiles(num_tiles);
+    ImageTile tmp_tile{};
+
+    const u8* tile_remap =
+        cvt.block_alignment == BlockAlignment::Linear ? linear_lut : morton_lut;
+
+    const u8* input_Y = input;
+    const u8* input_U = input_Y + 8 * cvt.input_line_width;
+    const u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+    ReferenceConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles.data(),
+                             cvt.input_line_width, row_height, cvt.coefficients);
+
+    for (std::size_t i = 0; i < num_tiles; ++i) {
+        int image_strip_width = 0;
+        int output_stride = 0;
+
+        switch (cvt.rotation) {
+        case Rotation::None:
+            RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
+            image_strip_width = cvt.input_line_width;
+            output_stride = 8;
+            break;
+        case Rotation::Clockwise_90:
+            RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
+            image_strip_width = 8;
+            output_stride = 8 * row_height;
+            break;
+        case Rotation::Clockwise_180:
+            RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
+            image_strip_width = cvt.input_line_width;
+            output_stride = 8;
+            break;
+        case Rotation::Clockwise_270:
+            RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
+            image_strip_width = 8;
+            output_stride = 8 * row_height;
+            break;
+        }
+
+        switch (cvt.block_alignment) {
+        case BlockAlignment::Linear:
+            WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
+            output_buffer += output_stride;
+            break;
+        case BlockAlignment::Block8x8:
+            WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
+            output_buffer += TILE_SIZE;
+            break;
+        }
+    }
+}
+
+void ReferenceEncodeRGB(OutputFormat output_format, const u32* input, u8* output,
+                        std::size_t count, u8 alpha) {
+    for (std::size_t i = 0; i < count; ++i) {
+        u32 color = *input++;
+        Common::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8), alpha};
+
+        switch (output_format) {
+        case OutputFormat::RGBA8:
+            Common::Color::EncodeRGBA8(col_vec, output);
+            output += 4;
+            break;
+        case OutputFormat::RGB8:
+            Common::Color::EncodeRGB8(col_vec, output);
+            output += 3;
+            break;
+        case OutputFormat::RGB5A1:
+            Common::Color::EncodeRGB5A1(col_vec, output);
+            output += 2;
+            break;
+        case OutputFormat::RGB565:
+            Common::Color::EncodeRGB565(col_vec, output);
+            output += 2;
+            break;
+        }
+    }
+}
+
+std::vector<CoefficientSet> MakeCoefficientSets(std::mt19937& rng) {
+    std::vector<CoefficientSet> sets;
+    for (u8 standard = 0; standard < 4; ++standard) {
+        ConversionConfiguration cvt{};
+        REQUIRE(cvt.SetStandardCoefficient(static_cast<StandardCoefficient>(standard)) ==
+                RESULT_SUCCESS);
+        sets.push_back(cvt.coefficients);
+    }
+    // Extreme values, to check the clamping and the intermediate precision
+    for (int i = 0; i < 4; ++i) {
+        CoefficientSet set;
+        for (auto& coefficient : set) {
+            coefficient = static_cast<s16>(rng());
+        }
+        sets.push_back(set);
+    }
+    return sets;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Y2R ConvertStrip matches the per-pixel conversion", "[core][y2r]") {
+    std::mt19937 rng(0x2F2);
+    const std::vector<CoefficientSet> coefficient_sets = MakeCoefficientSets(rng);
+    for (const u16 width : {8, 64, 1024}) {
+        std::vector<u8> input(width * 8 * 4);
+        for (const auto input_format : INPUT_FORMATS) {
+            for (const auto rotation : ROTATIONS) {
+                for (const auto alignment : {BlockAlignment::Linear, BlockAlignment::Block8x8}) {
+                    for (const unsigned int row_height : {8u, 7u, 2u, 1u}) {
+                        // Block8x8 alignment requires whole tiles
+                        if (alignment == BlockAlignment::Block8x8 && row_height != 8) {
+                            continue;
+                        }
+                        for (const auto& coefficients : coefficient_sets) {
+                            std::generate(input.begin(), input.end(), rng);
+
+                            ConversionConfiguration cvt{};
+                            cvt.input_format = input_format;
+                            cvt.rotation = rotation;
+                            cvt.block_alignment = alignment;
+                            cvt.input_line_width = width;
+                            cvt.coefficients = coefficients;
+
+                            std::vector<u32> expected(width * 8, 0xDEADBEEF);
+                            std::vector<u32> result(width * 8, 0xDEADBEEF);
+                            ReferenceConvertStrip(cvt, input.data(), expected.data(), row_height);
+                            HW::Y2R::ConvertStrip(cvt, input.data(), result.data(), row_height);
+
+                            INFO("width " << width << ", input format "
+                                          << static_cast<u32>(input_format) << ", rotation "
+                                          << static_cast<u32>(rotation) << ", alignment "
+                                          << static_cast<u32>(alignment) << ", height "
+                                          << row_height);
+                            REQUIRE(result == expected);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Y2R EncodeRGB matches the per-pixel encoding", "[core][y2r]") {
+    std::mt19937 rng(0x2F2);
+    std::vector<u32> input(1027);
+    std::generate(input.begin(), input.end(), rng);
+    for (const auto output_format : OUTPUT_FORMATS) {
+        for (const u8 alpha : {0x00, 0x80, 0xFF}) {
+            std::vector<u8> expected(input.size() * 4, 0xCD);
+            std::vector<u8> result(input.size() * 4, 0xCD);
+            ReferenceEncodeRGB(output_format, input.data(), expected.data(), input.size(), alpha);
+            HW::Y2R::EncodeRGB(output_format, input.data(), result.data(), input.size(), alpha);
+
+            INFO("output format " << static_cast<u32>(output_format) << ", alpha "
+                                  << static_cast<u32>(alpha));
+            REQUIRE(result == expected);
+        }
+    }
+}
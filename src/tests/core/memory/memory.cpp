@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <span>
+#include <vector>
 #include <catch2/catch_test_macros.hpp>
 #include "core/core_timing.h"
 #include "core/hle/kernel/process.h"
@@ -52,3 +55,61 @@ TEST_CASE("memory.IsValidVirtualAddress", "[core][memory]") {
         CHECK(memory.IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("memory.GetFastmemArena", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    u8* arena = memory.GetFastmemArena(*process->vm_manager.page_table);
+    if (arena == nullptr) {
+        return;
+    }
+
+    // The arena follows mappings made after it was created
+    kernel.HandleSpecialMapping(process->vm_manager,
+                                {Memory::VRAM_VADDR, Memory::VRAM_SIZE, false, false});
+    arena[Memory::VRAM_VADDR + 0x1234] = 0x56;
+    CHECK(*memory.GetPhysicalPointer(Memory::VRAM_PADDR + 0x1234) == 0x56);
+    *memory.GetPhysicalPointer(Memory::VRAM_PADDR_END - 1) = 0x78;
+    CHECK(arena[Memory::VRAM_VADDR_END - 1] == 0x78);
+}
+
+TEST_CASE("memory.VisitBlock", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    kernel.HandleSpecialMapping(process->vm_manager,
+                                {Memory::VRAM_VADDR, Memory::VRAM_SIZE, false, false});
+
+    SECTION("contiguous memory is visited in a single span") {
+        const VAddr addr = Memory::VRAM_VADDR + 0xF00;
+        const std::array<u8, 4> data{1, 2, 3, 4};
+        memory.WriteBlock(*process, addr + 0x200, data.data(), data.size());
+
+        std::vector<std::span<u8>> spans;
+        CHECK(memory.VisitBlock(*process, addr, 0x300, Memory::FlushMode::Invalidate,
+                                [&](std::span<u8> span) { spans.push_back(span); }));
+        REQUIRE(spans.size() == 1);
+        CHECK(spans[0].size() == 0x300);
+        CHECK(spans[0][0x203] == 4);
+
+        spans[0][0x2FF] = 0x56;
+        u8 value = 0;
+        memory.ReadBlock(*process, addr + 0x2FF, &value, sizeof(value));
+        CHECK(value == 0x56);
+    }
+
+    SECTION("ranges that are not all mapped are not visited") {
+        bool visited = false;
+        CHECK_FALSE(memory.VisitBlock(*process, Memory::VRAM_VADDR_END - 0x10, 0x20,
+                                      Memory::FlushMode::Flush,
+                                      [&](std::span<u8>) { visited = true; }));
+        CHECK_FALSE(memory.VisitBlock(*process, 0xFFFFF000, 0x2000, Memory::FlushMode::Flush,
+                                      [&](std::span<u8>) { visited = true; }));
+        CHECK_FALSE(visited);
+    }
+}
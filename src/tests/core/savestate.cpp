@@ -0,0 +1,73 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "core/savestate.h"
+
+namespace {
+
+constexpr std::size_t NumPages = 16;
+
+std::vector<u8> MakeRAM() {
+    std::vector<u8> ram(NumPages * Core::Snapshot::PageSize);
+    // Leave the first page empty, fill the others with something compressible
+    for (std::size_t i = Core::Snapshot::PageSize; i < ram.size(); ++i) {
+        ram[i] = static_cast<u8>(i / 64);
+    }
+    return ram;
+}
+
+std::vector<u8> Restore(const Core::Snapshot& snapshot) {
+    std::vector<u8> ram(NumPages * Core::Snapshot::PageSize);
+    const std::array regions{std::span<u8>{ram}};
+    snapshot.RestorePages(regions);
+    return ram;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Snapshot pages", "[core][savestate]") {
+    auto ram = MakeRAM();
+    const std::array regions{std::span<u8>{ram}};
+
+    Core::Snapshot first;
+    first.CapturePages(regions, nullptr);
+    REQUIRE(first.GetChangedPages() == NumPages);
+    // The pages are compressed
+    REQUIRE(first.GetSize() < (NumPages - 1) * Core::Snapshot::PageSize / 4);
+    REQUIRE(Restore(first) == ram);
+
+    SECTION("unchanged pages are shared with the base") {
+        const auto original = ram;
+        ram[3 * Core::Snapshot::PageSize + 5] ^= 0xFF;
+        ram[Core::Snapshot::PageSize / 2] = 1;
+
+        Core::Snapshot second;
+        second.CapturePages(regions, &first);
+        REQUIRE(second.GetChangedPages() == 2);
+        REQUIRE(second.GetSharedSize(first) > 0);
+        REQUIRE(second.GetSize() < first.GetSize());
+        REQUIRE(Restore(second) == ram);
+        REQUIRE(Restore(first) == original);
+    }
+
+    SECTION("pages cleared since the base") {
+        std::fill_n(ram.begin() + 2 * Core::Snapshot::PageSize, Core::Snapshot::PageSize, 0);
+
+        Core::Snapshot second;
+        second.CapturePages(regions, &first);
+        REQUIRE(second.GetChangedPages() == 1);
+        REQUIRE(Restore(second) == ram);
+    }
+
+    SECTION("restoring to a different layout") {
+        std::vector<u8> smaller(Core::Snapshot::PageSize);
+        const std::array small_regions{std::span<u8>{smaller}, std::span<u8>{ram}};
+        REQUIRE_THROWS(first.RestorePages(small_regions));
+    }
+}
@@ -0,0 +1,96 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <tuple>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "core/timing_wheel.h"
+
+namespace {
+
+struct TestEvent {
+    s64 time;
+    u64 fifo_order;
+    std::uintptr_t user_data;
+    const int* type;
+
+    bool operator<(const TestEvent& right) const {
+        return std::tie(time, fifo_order) < std::tie(right.time, right.fifo_order);
+    }
+    bool operator==(const TestEvent& right) const {
+        return time == right.time && fifo_order == right.fifo_order;
+    }
+};
+
+constexpr std::array<int, 4> TYPES{};
+
+} // Anonymous namespace
+
+TEST_CASE("TimingWheel keeps events in order", "[core][timing_wheel]") {
+    Core::TimingWheel<TestEvent> wheel;
+    std::vector<TestEvent> reference;
+    std::mt19937_64 rng(0x7131);
+    s64 now = 0;
+    u64 fifo_order = 0;
+
+    for (int step = 0; step < 20000; ++step) {
+        switch (rng() % 8) {
+        case 0:
+        case 1:
+        case 2: {
+            // Spread the delays over every level of the wheel and the overflow list
+            const s64 delay = static_cast<s64>(rng() % (u64{1} << (rng() % 40)));
+            const TestEvent event{now + delay, fifo_order++, rng() % 4, &TYPES[rng() % 4]};
+            wheel.Push(event);
+            reference.push_back(event);
+            break;
+        }
+        case 3: {
+            const int* type = &TYPES[rng() % 4];
+            const std::uintptr_t user_data = rng() % 4;
+            const auto matches = [&](const TestEvent& e) {
+                return e.type == type && e.user_data == user_data;
+            };
+            wheel.RemoveIf(type, matches);
+            std::erase_if(reference, matches);
+            break;
+        }
+        default: {
+            // Advance to a time where events may be due, and pop them like a timer does
+            if (!reference.empty()) {
+                const TestEvent earliest = *std::min_element(reference.begin(), reference.end());
+                REQUIRE(wheel.Front() == earliest);
+                now = std::max(now, earliest.time + static_cast<s64>(rng() % 4096));
+            }
+            while (!reference.empty()) {
+                const auto earliest = std::min_element(reference.begin(), reference.end());
+                if (earliest->time > now) {
+                    break;
+                }
+                REQUIRE(wheel.PopFront() == *earliest);
+                reference.erase(earliest);
+            }
+            wheel.AdvanceTo(now);
+            break;
+        }
+        }
+        REQUIRE(wheel.Size() == reference.size());
+    }
+
+    std::sort(reference.begin(), reference.end());
+    REQUIRE(wheel.GetSortedEvents() == reference);
+}
+
+TEST_CASE("TimingWheel handles late events", "[core][timing_wheel]") {
+    Core::TimingWheel<TestEvent> wheel;
+    wheel.Reset(1 << 20);
+    wheel.Push(TestEvent{(1 << 20) + 100, 0, 0, &TYPES[0]});
+    wheel.Push(TestEvent{5, 1, 0, &TYPES[0]});
+    REQUIRE(wheel.PopFront().fifo_order == 1);
+    REQUIRE(wheel.PopFront().fifo_order == 0);
+    REQUIRE(wheel.Empty());
+}
@@ -0,0 +1,163 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/rasterizer_cache/morton_swizzle.h"
+#include "video_core/rasterizer_cache/morton_swizzle_simd.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+
+using namespace OpenGL;
+
+namespace {
+
+constexpr std::array TILED_FORMATS = {
+    PixelFormat::RGBA8,  PixelFormat::RGB8, PixelFormat::RGB5A1, PixelFormat::RGB565,
+    PixelFormat::RGBA4,  PixelFormat::D16,  PixelFormat::D24,    PixelFormat::D24S8,
+};
+
+/// Instruction sets with tile kernels that the host can run
+std::vector<MortonISA> GetHostISAs() {
+    switch (GetHostMortonISA()) {
+    case MortonISA::AVX2:
+        return {MortonISA::SSE41, MortonISA::AVX2};
+    case MortonISA::SSE41:
+        return {MortonISA::SSE41};
+    case MortonISA::NEON:
+        return {MortonISA::NEON};
+    default:
+        return {};
+    }
+}
+
+std::string GetISAName(MortonISA isa) {
+    switch (isa) {
+    case MortonISA::SSE41:
+        return "SSE4.1";
+    case MortonISA::AVX2:
+        return "AVX2";
+    case MortonISA::NEON:
+        return "NEON";
+    default:
+        return "scalar";
+    }
+}
+
+template <bool morton_to_gl>
+MortonTileFunc GetScalarTileFunc(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return MortonCopyTile<morton_to_gl, PixelFormat::RGBA8>;
+    case PixelFormat::RGB8:
+        return MortonCopyTile<morton_to_gl, PixelFormat::RGB8>;
+    case PixelFormat::RGB5A1:
+        return MortonCopyTile<morton_to_gl, PixelFormat::RGB5A1>;
+    case PixelFormat::RGB565:
+        return MortonCopyTile<morton_to_gl, PixelFormat::RGB565>;
+    case PixelFormat::RGBA4:
+        return MortonCopyTile<morton_to_gl, PixelFormat::RGBA4>;
+    case PixelFormat::D16:
+        return MortonCopyTile<morton_to_gl, PixelFormat::D16>;
+    case PixelFormat::D24:
+        return MortonCopyTile<morton_to_gl, PixelFormat::D24>;
+    case PixelFormat::D24S8:
+        return MortonCopyTile<morton_to_gl, PixelFormat::D24S8>;
+    default:
+        return nullptr;
+    }
+}
+
+MortonTileFunc GetScalarTileFunc(PixelFormat format, bool morton_to_gl) {
+    return morton_to_gl ? GetScalarTileFunc<true>(format) : GetScalarTileFunc<false>(format);
+}
+
+/// Surface made of whole tiles, with the GL buffer offset like MortonCopy does
+struct TiledSurface {
+    TiledSurface(PixelFormat format, u32 width, u32 height)
+        : width{width}, height{height}, bytes_per_pixel{GetFormatBpp(format) / 8},
+          gl_bytes_per_pixel{GetBytesPerPixel(format)},
+          tiled(width * height * bytes_per_pixel), gl(width * height * gl_bytes_per_pixel) {}
+
+    void Randomize(std::mt19937& rng) {
+        for (auto& byte : tiled) {
+            byte = static_cast<u8>(rng());
+        }
+        for (auto& byte : gl) {
+            byte = static_cast<u8>(rng());
+        }
+    }
+
+    void CopyTiles(MortonTileFunc copy_tile) {
+        const u32 tile_size = bytes_per_pixel * 64;
+        u8* const gl_base = gl.data() + gl_bytes_per_pixel - bytes_per_pixel;
+        for (u32 y = 0; y < height; y += 8) {
+            for (u32 x = 0; x < width; x += 8) {
+                const u32 tile_index = (y / 8) * (width / 8) + x / 8;
+                const u32 gl_offset = ((height - 8 - y) * width + x) * gl_bytes_per_pixel;
+                copy_tile(width, tiled.data() + tile_index * tile_size, gl_base + gl_offset);
+            }
+        }
+    }
+
+    u32 width;
+    u32 height;
+    u32 bytes_per_pixel;
+    u32 gl_bytes_per_pixel;
+    std::vector<u8> tiled;
+    std::vector<u8> gl;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("MortonCopyTile SIMD kernels match the scalar one", "[video_core][morton_swizzle]") {
+    const bool gles = GLES;
+    std::mt19937 rng(0x3D5);
+    for (const MortonISA isa : GetHostISAs()) {
+        for (const bool use_gles : {false, true}) {
+            GLES = use_gles;
+            for (const PixelFormat format : TILED_FORMATS) {
+                for (const bool morton_to_gl : {true, false}) {
+                    const MortonTileFunc simd = GetMortonTileFunc(format, morton_to_gl, isa);
+                    REQUIRE(simd != nullptr);
+
+                    TiledSurface expected{format, 24, 16};
+                    expected.Randomize(rng);
+                    TiledSurface result = expected;
+                    expected.CopyTiles(GetScalarTileFunc(format, morton_to_gl));
+                    result.CopyTiles(simd);
+
+                    INFO("Format " << PixelFormatAsString(format) << ", " << GetISAName(isa)
+                                   << ", GLES " << use_gles);
+                    REQUIRE(result.tiled == expected.tiled);
+                    REQUIRE(result.gl == expected.gl);
+                }
+            }
+        }
+    }
+    GLES = gles;
+}
+
+TEST_CASE("MortonCopyTile throughput", "[.][benchmark][video_core][morton_swizzle]") {
+    for (const PixelFormat format : TILED_FORMATS) {
+        const std::string name{PixelFormatAsString(format)};
+        TiledSurface surface{format, 1024, 1024};
+        for (const bool morton_to_gl : {true, false}) {
+            const std::string direction = morton_to_gl ? " upload" : " download";
+            const MortonTileFunc scalar = GetScalarTileFunc(format, morton_to_gl);
+            BENCHMARK(name + direction + " scalar") {
+                surface.CopyTiles(scalar);
+            };
+            for (const MortonISA isa : GetHostISAs()) {
+                const MortonTileFunc simd = GetMortonTileFunc(format, morton_to_gl, isa);
+                BENCHMARK(name + direction + " " + GetISAName(isa)) {
+                    surface.CopyTiles(simd);
+                };
+            }
+        }
+    }
+}
@@ -0,0 +1,33 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/renderer_software/sw_color_simd.h"
+
+using Pica::Rasterizer::MultiplyAddDiv255;
+
+TEST_CASE("MultiplyAddDiv255 matches integer division", "[video_core][renderer_software]") {
+    // The second product is fixed per lane so that every lane covers a different offset,
+    // including the extremes of both the sum and the difference
+    const Common::Vec4<u8> c{0, 1, 128, 255};
+    const Common::Vec4<u8> d{0, 255, 77, 255};
+
+    for (int a = 0; a < 256; ++a) {
+        for (int b = 0; b < 256; ++b) {
+            const Common::Vec4<u8> va{static_cast<u8>(a), static_cast<u8>(a), static_cast<u8>(a),
+                                      static_cast<u8>(a)};
+            const Common::Vec4<u8> vb{static_cast<u8>(b), static_cast<u8>(b), static_cast<u8>(b),
+                                      static_cast<u8>(b)};
+            const auto sum = MultiplyAddDiv255(va, vb, c, d);
+            const auto difference = MultiplyAddDiv255<true>(va, vb, c, d);
+            for (std::size_t i = 0; i < 4; ++i) {
+                const int ab = a * b;
+                const int cd = c[i] * d[i];
+                REQUIRE(sum[i] == std::clamp((ab + cd) / 255, 0, 255));
+                REQUIRE(difference[i] == std::clamp((ab - cd) / 255, 0, 255));
+            }
+        }
+    }
+}
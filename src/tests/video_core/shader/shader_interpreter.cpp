@@ -0,0 +1,148 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <catch2/catch_test_macros.hpp>
+#include <nihstro/inline_assembly.h>
+#include "video_core/shader/shader_interpreter.h"
+
+using float24 = Pica::float24;
+using ShaderInterpreter = Pica::Shader::InterpreterEngine;
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+using Type = nihstro::InlineAsm::Type;
+
+namespace {
+
+std::unique_ptr<Pica::Shader::ShaderSetup> CompileShaderSetup(
+    std::initializer_list<nihstro::InlineAsm> code) {
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary(code);
+
+    auto shader = std::make_unique<Pica::Shader::ShaderSetup>();
+
+    std::transform(shbin.program.begin(), shbin.program.end(), shader->program_code.begin(),
+                   [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(),
+                   shader->swizzle_data.begin(), [](const auto& x) { return x.hex; });
+
+    return shader;
+}
+
+/// Runs the inputs as one batch and checks the results against running them one at a time
+template <std::size_t N>
+void CompareBatchWithScalar(const Pica::Shader::ShaderSetup& setup,
+                            const std::array<float, N>& inputs) {
+    ShaderInterpreter interpreter;
+
+    std::array<Pica::Shader::UnitState, N> batch_units;
+    for (std::size_t i = 0; i < N; ++i) {
+        batch_units[i].registers.input[0].x = float24::FromFloat32(inputs[i]);
+        batch_units[i].registers.temporary[0].x = float24::FromFloat32(0);
+    }
+    interpreter.RunBatch(setup, batch_units);
+
+    for (std::size_t i = 0; i < N; ++i) {
+        Pica::Shader::UnitState shader_unit;
+        shader_unit.registers.input[0].x = float24::FromFloat32(inputs[i]);
+        shader_unit.registers.temporary[0].x = float24::FromFloat32(0);
+        interpreter.Run(setup, shader_unit);
+
+        const float expected = shader_unit.registers.output[0].x.ToFloat32();
+        const float result = batch_units[i].registers.output[0].x.ToFloat32();
+        REQUIRE(std::isnan(result) == std::isnan(expected));
+        if (!std::isnan(expected)) {
+            REQUIRE(result == expected);
+        }
+        REQUIRE(batch_units[i].address_registers[2] == shader_unit.address_registers[2]);
+    }
+}
+
+// Raw encodings of the instructions used by the flow control test, as laid out in
+// nihstro::Instruction
+
+constexpr u32 IDENTITY_OPERAND_DESC = 0x7F;
+
+constexpr u32 Arithmetic(OpCode::Id opcode, u32 dest, u32 src1, u32 src2) {
+    return static_cast<u32>(opcode) << 26 | dest << 21 | src1 << 12 | src2 << 7 |
+           IDENTITY_OPERAND_DESC;
+}
+
+/// Sets the x and y condition codes to src1 < src2
+constexpr u32 CompareLessThan(u32 src1, u32 src2) {
+    constexpr u32 less_than = 2;
+    return static_cast<u32>(OpCode::Id::CMP) << 26 | less_than << 24 | less_than << 21 |
+           src1 << 12 | src2 << 7 | IDENTITY_OPERAND_DESC;
+}
+
+/// Flow control instruction testing the x condition code against true
+constexpr u32 FlowControlX(OpCode::Id opcode, u32 dest_offset, u32 num_instructions) {
+    constexpr u32 just_x = 2;
+    return static_cast<u32>(opcode) << 26 | 1u << 25 | just_x << 22 | dest_offset << 10 |
+           num_instructions;
+}
+
+/// Writes all components, with xyzw selected for every source
+constexpr u32 IDENTITY_SWIZZLE = 0xF | 0x1B << 5 | 0x1B << 14 | 0x1B << 23;
+
+constexpr u32 REG_INPUT_0 = 0x00;
+constexpr u32 REG_OUTPUT_0 = 0x00;
+constexpr u32 REG_UNIFORM_0 = 0x20;
+
+} // Anonymous namespace
+
+TEST_CASE("Batched Interpreter", "[video_core][shader][shader_interpreter]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_temp = SourceRegister::MakeTemporary(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    const auto shader_setup = CompileShaderSetup({
+        // clang-format off
+        {OpCode::Id::MOV, sh_temp, sh_input},
+        {OpCode::Id::LOOP, 0},
+            {OpCode::Id::MUL, sh_temp, sh_temp, sh_input},
+            {OpCode::Id::MAX, sh_temp, sh_temp, sh_input},
+        {Type::EndLoop},
+        {OpCode::Id::ADD, sh_output, sh_temp, sh_input},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+    shader_setup->uniforms.i[0] = {3, 0, 1, 0};
+
+    CompareBatchWithScalar(*shader_setup, std::array{-2.f, -0.5f, 0.f, 0.5f, 1.f, 2.f, 3.f,
+                                                     1.e30f, NAN, -INFINITY, 4.f});
+}
+
+TEST_CASE("Batched Interpreter jumps", "[video_core][shader][shader_interpreter]") {
+    // Inputs above 0.5 jump out of the IF block and square the input, the others double it in
+    // the ELSE block
+    auto shader_setup = std::make_unique<Pica::Shader::ShaderSetup>();
+    constexpr std::array program{
+        CompareLessThan(REG_UNIFORM_0, REG_INPUT_0),
+        FlowControlX(OpCode::Id::IFC, 4, 1),
+        FlowControlX(OpCode::Id::JMPC, 6, 0),
+        Arithmetic(OpCode::Id::MOV, REG_OUTPUT_0, REG_INPUT_0, 0),
+        Arithmetic(OpCode::Id::ADD, REG_OUTPUT_0, REG_INPUT_0, REG_INPUT_0),
+        static_cast<u32>(OpCode::Id::END) << 26,
+        Arithmetic(OpCode::Id::MUL, REG_OUTPUT_0, REG_INPUT_0, REG_INPUT_0),
+        static_cast<u32>(OpCode::Id::END) << 26,
+    };
+    std::copy(program.begin(), program.end(), shader_setup->program_code.begin());
+    shader_setup->swizzle_data[IDENTITY_OPERAND_DESC] = IDENTITY_SWIZZLE;
+    shader_setup->uniforms.f[0].x = float24::FromFloat32(0.5f);
+
+    SECTION("all lanes jump") {
+        CompareBatchWithScalar(*shader_setup, std::array{1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f});
+    }
+    SECTION("lanes diverge before the jump") {
+        // The lanes that jump are all lanes executing the JMPC, while the others wait for the
+        // ELSE block
+        CompareBatchWithScalar(*shader_setup,
+                               std::array{1.f, 0.f, 2.f, 0.25f, 3.f, -1.f, 4.f, 0.f});
+    }
+}
@@ -0,0 +1,103 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <filesystem>
+#include <memory>
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_jit_disk_cache.h"
+
+using namespace Pica::Shader;
+
+namespace {
+
+constexpr u64 PROGRAM_ID = 0x0004000000123400;
+constexpr u64 CACHE_KEY = 0x1234567890ABCDEF;
+
+/// Size of the version and build revision at the start of the file
+constexpr std::size_t HEADER_SIZE = sizeof(u32) + 64;
+
+std::string GetCacheFilePath(const std::string& shader_dir) {
+    return shader_dir + DIR_SEP "jit" DIR_SEP + fmt::format("{:016X}.bin", PROGRAM_ID);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("JitDiskCache", "[video_core][shader]") {
+    const std::string shader_dir =
+        (std::filesystem::temp_directory_path() / "citra_jit_disk_cache_test").string();
+    std::filesystem::remove_all(shader_dir);
+    REQUIRE(FileUtil::CreateFullPath(shader_dir + DIR_SEP));
+    FileUtil::UpdateUserPath(FileUtil::UserPath::ShaderDir, shader_dir);
+    const std::string path = GetCacheFilePath(shader_dir);
+
+    // The rejected file is replaced by one only holding the header
+    const auto LoadsAsEmpty = [&path] {
+        {
+            JitDiskCache cache(PROGRAM_ID);
+            if (!cache.Load().empty()) {
+                return false;
+            }
+        }
+        return FileUtil::GetSize(path) == HEADER_SIZE;
+    };
+
+    auto setup = std::make_unique<ShaderSetup>();
+    setup->program_code[0] = 0x4C000000;
+    setup->program_code[2] = 0x88000000;
+    setup->swizzle_data[0] = 0x1B1B1B0F;
+
+    {
+        JitDiskCache cache(PROGRAM_ID);
+        REQUIRE(cache.IsUsable());
+        REQUIRE(cache.Load().empty());
+        cache.Save(CACHE_KEY, *setup);
+        // Programs are only recorded once
+        cache.Save(CACHE_KEY, *setup);
+    }
+
+    SECTION("round trip") {
+        JitDiskCache cache(PROGRAM_ID);
+        const std::vector<JitDiskCacheEntry> entries = cache.Load();
+        REQUIRE(entries.size() == 1);
+        CHECK(entries[0].cache_key == CACHE_KEY);
+        CHECK(entries[0].program_code == std::vector<u32>{0x4C000000, 0, 0x88000000});
+        CHECK(entries[0].swizzle_data == std::vector<u32>{0x1B1B1B0F});
+    }
+
+    SECTION("stale build revision") {
+        {
+            FileUtil::IOFile file(path, "r+b");
+            REQUIRE(file.Seek(sizeof(u32), SEEK_SET));
+            constexpr char stale_revision[] = "0000000000000000000000000000000000000000";
+            REQUIRE(file.WriteBytes(stale_revision, sizeof(stale_revision)) ==
+                    sizeof(stale_revision));
+        }
+        CHECK(LoadsAsEmpty());
+    }
+
+    SECTION("truncated file") {
+        REQUIRE(FileUtil::GetSize(path) > HEADER_SIZE + 8);
+        {
+            FileUtil::IOFile file(path, "r+b");
+            REQUIRE(file.Resize(file.GetSize() - 2));
+        }
+        CHECK(LoadsAsEmpty());
+    }
+
+    SECTION("corrupt program length") {
+        {
+            FileUtil::IOFile file(path, "r+b");
+            REQUIRE(file.Seek(HEADER_SIZE + sizeof(u64), SEEK_SET));
+            constexpr u64 code_length = MAX_PROGRAM_CODE_LENGTH + 1;
+            REQUIRE(file.WriteObject(code_length) == 1);
+        }
+        CHECK(LoadsAsEmpty());
+    }
+
+    std::filesystem::remove_all(shader_dir);
+}
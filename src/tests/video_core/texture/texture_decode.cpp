@@ -0,0 +1,129 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/texture/texture_decode.h"
+
+using Pica::TexturingRegs;
+using TextureFormat = Pica::TexturingRegs::TextureFormat;
+
+namespace {
+
+constexpr std::array TEXTURE_FORMATS = {
+    TextureFormat::RGBA8, TextureFormat::RGB8, TextureFormat::RGB5A1, TextureFormat::RGB565,
+    TextureFormat::RGBA4, TextureFormat::IA8,  TextureFormat::RG8,    TextureFormat::I8,
+    TextureFormat::A8,    TextureFormat::IA4,  TextureFormat::I4,     TextureFormat::A4,
+    TextureFormat::ETC1,  TextureFormat::ETC1A4,
+};
+
+Pica::Texture::TextureInfo MakeTextureInfo(TextureFormat format, u32 width, u32 height) {
+    Pica::Texture::TextureInfo info{};
+    info.width = width;
+    info.height = height;
+    info.format = format;
+    info.SetDefaultStride();
+    return info;
+}
+
+std::vector<u8> RandomBytes(std::mt19937& rng, std::size_t size) {
+    std::vector<u8> bytes(size);
+    for (auto& byte : bytes) {
+        byte = static_cast<u8>(rng());
+    }
+    return bytes;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("DecodeTile matches LookupTexelInTile", "[video_core][texture_decode]") {
+    std::mt19937 rng(0x7E5);
+    for (const TextureFormat format : TEXTURE_FORMATS) {
+        const auto info = MakeTextureInfo(format, 8, 8);
+        const std::size_t tile_size = Pica::Texture::CalculateTileSize(format);
+        for (u32 iteration = 0; iteration < 1000; iteration++) {
+            const std::vector<u8> tile = RandomBytes(rng, tile_size);
+            std::array<u8, 8 * 8 * 4> decoded{};
+            Pica::Texture::DecodeTile(tile.data(), format, decoded.data(), 8 * 4);
+
+            for (u32 y = 0; y < 8; y++) {
+                for (u32 x = 0; x < 8; x++) {
+                    const auto expected =
+                        Pica::Texture::LookupTexelInTile(tile.data(), x, y, info, false);
+                    const u8* texel = &decoded[(y * 8 + x) * 4];
+                    INFO("Format " << static_cast<u32>(format) << ", texel " << x << ", " << y);
+                    REQUIRE(texel[0] == expected.r());
+                    REQUIRE(texel[1] == expected.g());
+                    REQUIRE(texel[2] == expected.b());
+                    REQUIRE(texel[3] == expected.a());
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("DecodeTexture matches LookupTexture", "[video_core][texture_decode]") {
+    std::mt19937 rng(0x7E6);
+    for (const TextureFormat format : TEXTURE_FORMATS) {
+        const auto info = MakeTextureInfo(format, 32, 16);
+        const std::vector<u8> texture = RandomBytes(rng, info.stride * (info.height / 8));
+        std::vector<u8> decoded(info.width * info.height * 4);
+        Pica::Texture::DecodeTexture(texture.data(), info, decoded.data());
+
+        for (u32 y = 0; y < info.height; y++) {
+            for (u32 x = 0; x < info.width; x++) {
+                const auto expected = Pica::Texture::LookupTexture(texture.data(), x, y, info);
+                const u8* texel = &decoded[(y * info.width + x) * 4];
+                INFO("Format " << static_cast<u32>(format) << ", texel " << x << ", " << y);
+                REQUIRE(texel[0] == expected.r());
+                REQUIRE(texel[1] == expected.g());
+                REQUIRE(texel[2] == expected.b());
+                REQUIRE(texel[3] == expected.a());
+            }
+        }
+    }
+}
+
+TEST_CASE("DecodeTile decodes every texel value", "[video_core][texture_decode]") {
+    // Tiles holding each value of the formats of up to 16 bits once, in increasing order
+    for (const TextureFormat format : TEXTURE_FORMATS) {
+        const std::size_t tile_size = Pica::Texture::CalculateTileSize(format);
+        if (tile_size > 2 * 8 * 8 || format == TextureFormat::ETC1) {
+            continue;
+        }
+        const auto info = MakeTextureInfo(format, 8, 8);
+        const u32 bits_per_texel = static_cast<u32>(tile_size * 8 / (8 * 8));
+        const u32 num_values = 1u << bits_per_texel;
+
+        std::vector<u8> tiles(std::max<std::size_t>(num_values * bits_per_texel / 8, tile_size));
+        for (u32 value = 0; value < num_values; value++) {
+            const u32 bit = value * bits_per_texel;
+            tiles[bit / 8] |= static_cast<u8>(value << (bit % 8));
+            if (bits_per_texel == 16) {
+                tiles[bit / 8 + 1] = static_cast<u8>(value >> 8);
+            }
+        }
+
+        for (std::size_t offset = 0; offset < tiles.size(); offset += tile_size) {
+            const u8* tile = tiles.data() + offset;
+            std::array<u8, 8 * 8 * 4> decoded{};
+            Pica::Texture::DecodeTile(tile, format, decoded.data(), 8 * 4);
+
+            for (u32 y = 0; y < 8; y++) {
+                for (u32 x = 0; x < 8; x++) {
+                    const auto expected = Pica::Texture::LookupTexelInTile(tile, x, y, info, false);
+                    const u8* texel = &decoded[(y * 8 + x) * 4];
+                    INFO("Format " << static_cast<u32>(format) << ", tile at " << offset);
+                    REQUIRE(texel[0] == expected.r());
+                    REQUIRE(texel[1] == expected.g());
+                    REQUIRE(texel[2] == expected.b());
+                    REQUIRE(texel[3] == expected.a());
+                }
+            }
+        }
+    }
+}
@@ -2,10 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
 #include <memory>
+#include <span>
 #include <utility>
 #include "common/assert.h"
 #include "common/logging/log.h"
@@ -113,6 +115,23 @@ static void WriteUniformFloatReg(ShaderRegs& config, Shader::ShaderSetup& setup,
     }
 }
 
+/**
+ * Returns a vertex loader for the current attribute configuration. The loader of the previous
+ * draw is reused as long as the configuration didn't change, which is the common case.
+ */
+static VertexLoader& GetVertexLoader(const PipelineRegs& regs) {
+    using Cache = State::VertexLoaderCache;
+    auto& cache = g_state.vertex_loader_cache;
+
+    const u8* layout = reinterpret_cast<const u8*>(&regs.vertex_attributes) + Cache::LAYOUT_OFFSET;
+    if (!cache.is_valid || std::memcmp(cache.layout.data(), layout, Cache::LAYOUT_SIZE) != 0) {
+        cache.loader = VertexLoader(regs);
+        std::memcpy(cache.layout.data(), layout, Cache::LAYOUT_SIZE);
+        cache.is_valid = true;
+    }
+    return cache.loader;
+}
+
 static void WritePicaReg(u32 id, u32 value, u32 mask) {
     auto& regs = g_state.regs;
 
@@ -143,7 +162,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     switch (id) {
     // Trigger IRQ
     case PICA_REG_INDEX(trigger_irq):
-        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::P3D);
+        GPU::SignalInterrupt(Service::GSP::InterruptId::P3D);
         break;
 
     case PICA_REG_INDEX(pipeline.triangle_topology):
@@ -313,9 +332,8 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         // Processes information about internal vertex attributes to figure out how a vertex is
         // loaded.
-        // Later, these can be compiled and cached.
         const u32 base_address = regs.pipeline.vertex_attributes.GetPhysicalBaseAddress();
-        VertexLoader loader(regs.pipeline);
+        VertexLoader& loader = GetVertexLoader(regs.pipeline);
         Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
 
         // Load vertices
@@ -349,12 +367,18 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         std::array<bool, VERTEX_CACHE_SIZE> vertex_cache_valid{};
         std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
         std::array<Shader::AttributeBuffer, VERTEX_CACHE_SIZE> vertex_cache;
-        Shader::AttributeBuffer vs_output;
 
         unsigned int vertex_cache_pos = 0;
 
+        // Vertices missing from the cache are gathered into chunks, which are then shaded with a
+        // single call so the shader engine can process several vertices at once.
+        constexpr std::size_t VERTEX_BATCH_SIZE = 32;
+        std::array<Shader::UnitState, VERTEX_BATCH_SIZE> batch_units;
+        std::array<Shader::AttributeBuffer, VERTEX_BATCH_SIZE> batch_outputs;
+        std::array<unsigned int, VERTEX_BATCH_SIZE> batch_vertex_ids;
+        std::array<const Shader::AttributeBuffer*, VERTEX_BATCH_SIZE> chunk_outputs;
+
         auto* shader_engine = Shader::GetEngine();
-        Shader::UnitState shader_unit;
 
         shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
 
@@ -363,58 +387,88 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_state.geometry_pipeline.NeedIndexInput())
             ASSERT(is_indexed);
 
-        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+        const auto get_vertex = [&](unsigned int index) -> unsigned int {
             // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
+            return is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
+                              : (index + regs.pipeline.vertex_offset);
+        };
 
-            bool vertex_cache_hit = false;
+        if (g_state.geometry_pipeline.NeedIndexInput()) {
+            for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+                g_state.geometry_pipeline.SubmitIndex(get_vertex(index));
+            }
+        } else {
+            for (unsigned int chunk_start = 0; chunk_start < regs.pipeline.num_vertices;
+                 chunk_start += VERTEX_BATCH_SIZE) {
+                const unsigned int chunk_size = std::min<unsigned int>(
+                    VERTEX_BATCH_SIZE, regs.pipeline.num_vertices - chunk_start);
+                std::size_t batch_size = 0;
+
+                for (unsigned int i = 0; i < chunk_size; ++i) {
+                    const unsigned int index = chunk_start + i;
+                    const unsigned int vertex = get_vertex(index);
+
+                    chunk_outputs[i] = nullptr;
+                    if (is_indexed) {
+                        if (g_debug_context && Pica::g_debug_context->recorder) {
+                            int size = index_u16 ? 2 : 1;
+                            memory_accesses.AddAccess(
+                                base_address + index_info.offset + size * index, size);
+                        }
+
+                        for (unsigned int j = 0; j < VERTEX_CACHE_SIZE; ++j) {
+                            if (vertex_cache_valid[j] && vertex == vertex_cache_ids[j]) {
+                                chunk_outputs[i] = &vertex_cache[j];
+                                break;
+                            }
+                        }
+
+                        // Vertices repeated within the chunk are only shaded once
+                        for (std::size_t j = 0; chunk_outputs[i] == nullptr && j < batch_size;
+                             ++j) {
+                            if (vertex == batch_vertex_ids[j]) {
+                                chunk_outputs[i] = &batch_outputs[j];
+                            }
+                        }
+                    }
 
-            if (is_indexed) {
-                if (g_state.geometry_pipeline.NeedIndexInput()) {
-                    g_state.geometry_pipeline.SubmitIndex(vertex);
-                    continue;
+                    if (chunk_outputs[i] == nullptr) {
+                        // Initialize data for the current vertex
+                        Shader::AttributeBuffer input;
+                        loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+
+                        // Send to vertex shader
+                        if (g_debug_context)
+                            g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                                     (void*)&input);
+                        batch_units[batch_size].LoadInput(regs.vs, input);
+                        batch_vertex_ids[batch_size] = vertex;
+                        chunk_outputs[i] = &batch_outputs[batch_size];
+                        ++batch_size;
+                    }
                 }
 
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
+                shader_engine->RunBatch(g_state.vs, std::span{batch_units.data(), batch_size});
+                for (std::size_t j = 0; j < batch_size; ++j) {
+                    batch_units[j].WriteOutput(regs.vs, batch_outputs[j]);
                 }
 
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
-                        vs_output = vertex_cache[i];
-                        vertex_cache_hit = true;
-                        break;
-                    }
+                // Send to geometry pipeline
+                for (unsigned int i = 0; i < chunk_size; ++i) {
+                    g_state.geometry_pipeline.SubmitVertex(*chunk_outputs[i]);
                 }
-            }
-
-            if (!vertex_cache_hit) {
-                // Initialize data for the current vertex
-                Shader::AttributeBuffer input;
-                loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
-
-                // Send to vertex shader
-                if (g_debug_context)
-                    g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
-                                             (void*)&input);
-                shader_unit.LoadInput(regs.vs, input);
-                shader_engine->Run(g_state.vs, shader_unit);
-                shader_unit.WriteOutput(regs.vs, vs_output);
 
+                // The cache is only updated once the chunk was submitted, as its entries may be
+                // referenced by chunk_outputs until then.
                 if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = vs_output;
-                    vertex_cache_valid[vertex_cache_pos] = true;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                    for (std::size_t j = 0; j < batch_size; ++j) {
+                        vertex_cache[vertex_cache_pos] = batch_outputs[j];
+                        vertex_cache_valid[vertex_cache_pos] = true;
+                        vertex_cache_ids[vertex_cache_pos] = static_cast<u16>(batch_vertex_ids[j]);
+                        vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                    }
                 }
             }
-
-            // Send to geometry pipeline
-            g_state.geometry_pipeline.SubmitVertex(vs_output);
         }
 
         for (auto& range : memory_accesses.ranges) {
@@ -0,0 +1,167 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/command_processor.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+
+namespace VideoCore::GPUThread {
+
+/// Maximum number of commands that may be in flight before the CPU thread is throttled
+constexpr u64 MAX_PENDING_COMMANDS = 4096;
+
+MICROPROFILE_DEFINE(GPU_ThreadWait, "GPU", "Wait For GPU Thread", MP_RGB(255, 128, 0));
+
+void SynchState::WaitForSynchronization(u64 fence) {
+    if (signaled_fence.load(std::memory_order_acquire) >= fence) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_ThreadWait);
+    std::unique_lock lock{signal_mutex};
+    signal_cv.wait(lock, [this, fence] {
+        return signaled_fence.load(std::memory_order_acquire) >= fence || !is_running;
+    });
+}
+
+void SynchState::SignalFence(u64 fence) {
+    {
+        std::scoped_lock lock{signal_mutex};
+        signaled_fence.store(fence, std::memory_order_release);
+    }
+    signal_cv.notify_all();
+}
+
+/// Runs the GPU thread
+static void RunThread(RendererBase& renderer, Frontend::EmuWindow& emu_window, SynchState& state) {
+    Common::SetCurrentThreadName("GPU");
+    MicroProfileOnThreadCreate("GPU");
+
+    emu_window.MakeCurrent();
+
+    RasterizerInterface* rasterizer = renderer.Rasterizer();
+    while (state.is_running) {
+        CommandDataContainer next = state.queue.PopWait();
+        if (const auto submit_list = std::get_if<SubmitListCommand>(&next.data)) {
+            Pica::CommandProcessor::ProcessCommandList(submit_list->head, submit_list->size);
+        } else if (const auto fill = std::get_if<MemoryFillCommand>(&next.data)) {
+            GPU::ProcessMemoryFill(fill->config, fill->is_second_filler);
+        } else if (const auto transfer = std::get_if<DisplayTransferCommand>(&next.data)) {
+            GPU::ProcessDisplayTransfer(transfer->config);
+        } else if (const auto swap = std::get_if<SwapBuffersCommand>(&next.data)) {
+            renderer.SwapBuffers(swap->frame);
+        } else if (const auto flush = std::get_if<FlushRegionCommand>(&next.data)) {
+            rasterizer->FlushRegion(flush->addr, flush->size);
+        } else if (const auto invalidate = std::get_if<InvalidateRegionCommand>(&next.data)) {
+            rasterizer->InvalidateRegion(invalidate->addr, invalidate->size);
+        } else if (const auto flush_invalidate =
+                       std::get_if<FlushAndInvalidateRegionCommand>(&next.data)) {
+            rasterizer->FlushAndInvalidateRegion(flush_invalidate->addr, flush_invalidate->size);
+        } else if (const auto clear = std::get_if<ClearAllCommand>(&next.data)) {
+            rasterizer->ClearAll(clear->flush);
+        } else if (std::holds_alternative<EndProcessingCommand>(next.data)) {
+            state.is_running = false;
+        } else if (!std::holds_alternative<NoOpCommand>(next.data)) {
+            UNREACHABLE();
+        }
+
+        state.SignalFence(next.fence);
+    }
+
+    emu_window.DoneCurrent();
+}
+
+ThreadManager::ThreadManager(RendererBase& renderer, Frontend::EmuWindow& emu_window)
+    : renderer{renderer}, emu_window{emu_window} {}
+
+ThreadManager::~ThreadManager() {
+    if (!thread.joinable()) {
+        return;
+    }
+
+    // Notify GPU thread that a shutdown is pending
+    PushCommand(EndProcessingCommand());
+    thread.join();
+
+    // Give the graphics context back to the thread that owned it before the GPU thread started
+    emu_window.MakeCurrent();
+}
+
+void ThreadManager::StartThread() {
+    // The renderer objects were created on the emulation thread context. Release it here so the
+    // GPU thread can take ownership of it for the rest of the session.
+    emu_window.DoneCurrent();
+    thread = std::thread{RunThread, std::ref(renderer), std::ref(emu_window), std::ref(state)};
+    thread_id = thread.get_id();
+}
+
+void ThreadManager::SubmitList(PAddr head, u32 size, bool block) {
+    PushCommand(SubmitListCommand{head, size}, block);
+}
+
+void ThreadManager::MemoryFill(const GPU::Regs::MemoryFillConfig& config, bool is_second_filler,
+                               bool block) {
+    PushCommand(MemoryFillCommand{config, is_second_filler}, block);
+}
+
+void ThreadManager::DisplayTransfer(const GPU::Regs::DisplayTransferConfig& config, bool block) {
+    PushCommand(DisplayTransferCommand{config}, block);
+}
+
+void ThreadManager::SwapBuffers(const FrameInfo& frame) {
+    // Allow the GPU thread to lag behind by at most one frame
+    state.WaitForSynchronization(last_swap_fence);
+    last_swap_fence = PushCommand(SwapBuffersCommand{frame});
+}
+
+void ThreadManager::FlushRegion(PAddr addr, u32 size) {
+    PushCommand(FlushRegionCommand{addr, size}, true);
+}
+
+void ThreadManager::InvalidateRegion(PAddr addr, u32 size) {
+    PushCommand(InvalidateRegionCommand{addr, size});
+}
+
+void ThreadManager::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    PushCommand(FlushAndInvalidateRegionCommand{addr, size}, true);
+}
+
+void ThreadManager::ClearAll(bool flush) {
+    PushCommand(ClearAllCommand{flush}, true);
+}
+
+void ThreadManager::WaitIdle() {
+    if (!thread.joinable()) {
+        return;
+    }
+    state.WaitForSynchronization(state.last_fence);
+}
+
+u64 ThreadManager::PushCommand(CommandData&& command_data, bool block) {
+    // Commands issued by the GPU thread itself (e.g. rasterizer cache page tracking) must run
+    // inline, queueing them would deadlock on the fence.
+    ASSERT_MSG(!IsGPUThread(), "Attempted to queue a GPU command from the GPU thread");
+
+    if (!thread.joinable()) {
+        StartThread();
+    }
+
+    const u64 fence{++state.last_fence};
+    if (fence > MAX_PENDING_COMMANDS) {
+        state.WaitForSynchronization(fence - MAX_PENDING_COMMANDS);
+    }
+
+    state.queue.Push(CommandDataContainer(std::move(command_data), fence));
+    if (block) {
+        state.WaitForSynchronization(fence);
+    }
+    return fence;
+}
+
+} // namespace VideoCore::GPUThread
@@ -0,0 +1,167 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <variant>
+#include "common/common_types.h"
+#include "common/threadsafe_queue.h"
+#include "core/hw/gpu.h"
+#include "video_core/renderer_base.h"
+
+namespace Frontend {
+class EmuWindow;
+}
+
+namespace VideoCore::GPUThread {
+
+/// Command to process a PICA command list
+struct SubmitListCommand final {
+    PAddr head;
+    u32 size;
+};
+
+/// Command to perform a memory fill
+struct MemoryFillCommand final {
+    GPU::Regs::MemoryFillConfig config;
+    bool is_second_filler;
+};
+
+/// Command to perform a display transfer or texture copy
+struct DisplayTransferCommand final {
+    GPU::Regs::DisplayTransferConfig config;
+};
+
+/// Command to finalize the current frame and swap buffers
+struct SwapBuffersCommand final {
+    FrameInfo frame;
+};
+
+/// Command to flush the rasterizer caches of a region back to guest memory
+struct FlushRegionCommand final {
+    PAddr addr;
+    u32 size;
+};
+
+/// Command to invalidate the rasterizer caches of a region
+struct InvalidateRegionCommand final {
+    PAddr addr;
+    u32 size;
+};
+
+/// Command to flush and invalidate the rasterizer caches of a region
+struct FlushAndInvalidateRegionCommand final {
+    PAddr addr;
+    u32 size;
+};
+
+/// Command to remove as much state as possible from the rasterizer
+struct ClearAllCommand final {
+    bool flush;
+};
+
+/// Command that does nothing, used to wait for the queue to drain
+struct NoOpCommand final {};
+
+/// Command to signal to the GPU thread that it should exit
+struct EndProcessingCommand final {};
+
+using CommandData =
+    std::variant<EndProcessingCommand, SubmitListCommand, MemoryFillCommand,
+                 DisplayTransferCommand, SwapBuffersCommand, FlushRegionCommand,
+                 InvalidateRegionCommand, FlushAndInvalidateRegionCommand, ClearAllCommand,
+                 NoOpCommand>;
+
+struct CommandDataContainer {
+    CommandDataContainer() = default;
+
+    CommandDataContainer(CommandData&& data, u64 next_fence)
+        : data{std::move(data)}, fence{next_fence} {}
+
+    CommandData data;
+    u64 fence{};
+};
+
+/// Struct used to synchronize the GPU thread
+struct SynchState final {
+    std::atomic_bool is_running{true};
+
+    Common::SPSCQueue<CommandDataContainer> queue;
+    u64 last_fence{};
+    std::atomic<u64> signaled_fence{};
+
+    std::mutex signal_mutex;
+    std::condition_variable signal_cv;
+
+    /// Blocks until the GPU thread has processed the command with the given fence
+    void WaitForSynchronization(u64 fence);
+
+    /// Marks every command up to and including fence as processed
+    void SignalFence(u64 fence);
+};
+
+/**
+ * Runs PICA command processing, GPU transfers and frame swaps on a dedicated host thread so that
+ * CPU and GPU emulation can overlap. Commands are consumed in submission order. Operations that
+ * make rasterizer state visible to the emulated CPU (region flushes) block the caller until the
+ * GPU thread has caught up, which keeps guest memory coherent.
+ */
+class ThreadManager final {
+public:
+    explicit ThreadManager(RendererBase& renderer, Frontend::EmuWindow& emu_window);
+    ~ThreadManager();
+
+    /// Queues a PICA command list for processing, waiting for it if block is set
+    void SubmitList(PAddr head, u32 size, bool block);
+
+    /// Queues a memory fill, its completion interrupt is signalled once it has been performed
+    void MemoryFill(const GPU::Regs::MemoryFillConfig& config, bool is_second_filler, bool block);
+
+    /// Queues a display transfer or texture copy, its interrupt is signalled once it is performed
+    void DisplayTransfer(const GPU::Regs::DisplayTransferConfig& config, bool block);
+
+    /// Queues a buffer swap, throttling the caller if the GPU thread falls behind by a frame
+    void SwapBuffers(const FrameInfo& frame);
+
+    /// Flushes the region to guest memory and waits for completion
+    void FlushRegion(PAddr addr, u32 size);
+
+    /// Queues an invalidation of the region
+    void InvalidateRegion(PAddr addr, u32 size);
+
+    /// Flushes and invalidates the region and waits for completion
+    void FlushAndInvalidateRegion(PAddr addr, u32 size);
+
+    /// Clears rasterizer state and waits for completion
+    void ClearAll(bool flush);
+
+    /// Blocks until every queued command has been processed
+    void WaitIdle();
+
+    /// Returns true when called from the GPU thread
+    [[nodiscard]] bool IsGPUThread() const {
+        return std::this_thread::get_id() == thread_id;
+    }
+
+private:
+    /// Pushes a command to be executed by the GPU thread, returning its fence
+    u64 PushCommand(CommandData&& command_data, bool block = false);
+
+    /// Launches the GPU thread on first use, handing over the graphics context
+    void StartThread();
+
+private:
+    RendererBase& renderer;
+    Frontend::EmuWindow& emu_window;
+    SynchState state;
+    std::thread thread;
+    std::thread::id thread_id;
+    u64 last_swap_fence{};
+};
+
+} // namespace VideoCore::GPUThread
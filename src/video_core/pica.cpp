@@ -28,6 +28,7 @@ void Init() {
 
 void Shutdown() {
     Shader::Shutdown();
+    g_state.vertex_loader_cache.is_valid = false;
 }
 
 template <typename T>
@@ -67,5 +68,6 @@ void State::Reset() {
     gs_uniform_write_buffer.fill(0);
     default_attr_counter = 0;
     default_attr_write_buffer.fill(0);
+    vertex_loader_cache.is_valid = false;
 }
 } // namespace Pica
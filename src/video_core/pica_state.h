@@ -15,6 +15,7 @@
 #include "video_core/primitive_assembly.h"
 #include "video_core/regs.h"
 #include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
 // Boost::serialization doesn't like union types for some reason,
@@ -206,6 +207,19 @@ struct State {
     int default_attr_counter = 0;
     std::array<u32, 3> default_attr_write_buffer{};
 
+    /// Vertex loader of the last draw, reused as long as the attribute layout doesn't change.
+    /// It is rebuilt from the registers, so it isn't serialized.
+    struct VertexLoaderCache {
+        // The base address is only applied when loading each vertex, skip it in the comparison
+        static constexpr std::size_t LAYOUT_OFFSET = sizeof(u32);
+        static constexpr std::size_t LAYOUT_SIZE =
+            sizeof(PipelineRegs::vertex_attributes) - LAYOUT_OFFSET;
+
+        VertexLoader loader;
+        std::array<u8, LAYOUT_SIZE> layout{};
+        bool is_valid = false;
+    } vertex_loader_cache;
+
 private:
     friend class boost::serialization::access;
     template <class Archive>
@@ -247,6 +261,7 @@ private:
         cmd_list.head_ptr =
             reinterpret_cast<u32*>(VideoCore::g_memory->GetPhysicalPointer(cmd_list.addr));
         cmd_list.current_ptr = cmd_list.head_ptr + offset;
+        vertex_loader_cache.is_valid = false;
     }
 };
 
@@ -129,6 +129,9 @@ RasterizerAccelerated::VertexArrayInfo RasterizerAccelerated::AnalyzeVertexArray
 }
 
 void RasterizerAccelerated::SyncEntireState() {
+    // The registers may have changed without notifications, e.g. after loading a save state
+    shader_dirty = Pica::FSConfigGroup::All;
+
     // Sync renderer-specific fixed-function state
     SyncFixedState();
 
@@ -177,12 +180,13 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
 
     // Depth buffering
     case PICA_REG_INDEX(rasterizer.depthmap_enable):
-        shader_dirty = true;
+        shader_dirty |= Pica::FSConfigGroup::Rasterizer;
         break;
 
     // Shadow texture
     case PICA_REG_INDEX(texturing.shadow):
         SyncShadowTextureBias();
+        shader_dirty |= Pica::FSConfigGroup::Texturing;
         break;
 
     // Fog state
@@ -205,7 +209,7 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(texturing.proctex_lut):
     case PICA_REG_INDEX(texturing.proctex_lut_offset):
         SyncProcTexBias();
-        shader_dirty = true;
+        shader_dirty |= Pica::FSConfigGroup::ProcTex;
         break;
 
     case PICA_REG_INDEX(texturing.proctex_noise_u):
@@ -245,7 +249,7 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
     // Alpha test
     case PICA_REG_INDEX(framebuffer.output_merger.alpha_test):
         SyncAlphaTest();
-        shader_dirty = true;
+        shader_dirty |= Pica::FSConfigGroup::Framebuffer;
         break;
 
     case PICA_REG_INDEX(framebuffer.shadow):
@@ -254,16 +258,16 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
 
     // Scissor test
     case PICA_REG_INDEX(rasterizer.scissor_test.mode):
-        shader_dirty = true;
+        shader_dirty |= Pica::FSConfigGroup::Rasterizer;
         break;
 
     case PICA_REG_INDEX(texturing.main_config):
-        shader_dirty = true;
+        shader_dirty |= Pica::FSConfigGroup::Texturing | Pica::FSConfigGroup::ProcTex;
         break;
 
     // Texture 0 type
     case PICA_REG_INDEX(texturing.texture0.type):
-        shader_dirty = true;
+        shader_dirty |= Pica::FSConfigGroup::Texturing;
         break;
 
     // TEV stages
@@ -293,7 +297,7 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(texturing.tev_stage5.color_op):
     case PICA_REG_INDEX(texturing.tev_stage5.color_scale):
     case PICA_REG_INDEX(texturing.tev_combiner_buffer_input):
-        shader_dirty = true;
+        shader_dirty |= Pica::FSConfigGroup::TevStages;
         break;
     case PICA_REG_INDEX(texturing.tev_stage0.const_r):
         SyncTevConstColor(0, regs.texturing.tev_stage0);
@@ -328,6 +332,7 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(lighting.lut_input):
     case PICA_REG_INDEX(lighting.lut_scale):
     case PICA_REG_INDEX(lighting.light_enable):
+        shader_dirty |= Pica::FSConfigGroup::Lighting;
         break;
 
     // Fragment lighting specular 0 color
@@ -511,7 +516,7 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(lighting.light[5].config):
     case PICA_REG_INDEX(lighting.light[6].config):
     case PICA_REG_INDEX(lighting.light[7].config):
-        shader_dirty = true;
+        shader_dirty |= Pica::FSConfigGroup::Lighting;
         break;
 
     // Fragment lighting distance attenuation bias
@@ -6,7 +6,7 @@
 
 #include "common/vector_math.h"
 #include "video_core/rasterizer_interface.h"
-#include "video_core/regs_texturing.h"
+#include "video_core/regs.h"
 #include "video_core/shader/shader_uniforms.h"
 
 namespace Memory {
@@ -144,7 +144,7 @@ protected:
     Pica::Regs& regs;
 
     std::vector<HardwareVertex> vertex_batch;
-    bool shader_dirty = true;
+    Pica::FSConfigGroup shader_dirty = Pica::FSConfigGroup::All;
 
     UniformBlockData uniform_block_data{};
     std::array<std::array<Common::Vec2f, 256>, Pica::LightingRegs::NumLightingSampler>
@@ -4,7 +4,6 @@
 
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
-#include "common/texture.h"
 #include "core/core.h"
 #include "video_core/rasterizer_cache/cached_surface.h"
 #include "video_core/rasterizer_cache/morton_swizzle.h"
@@ -35,8 +34,8 @@ static Aspect ToAspect(SurfaceType type) {
 
 CachedSurface::~CachedSurface() {
     if (texture.handle) {
-        auto tag = is_custom ? HostTextureTag{GetFormatTuple(PixelFormat::RGBA8),
-                                              custom_tex_info.width, custom_tex_info.height}
+        auto tag = is_custom ? HostTextureTag{GetFormatTuple(PixelFormat::RGBA8), custom_width,
+                                              custom_height}
                              : HostTextureTag{GetFormatTuple(pixel_format), GetScaledWidth(),
                                               GetScaledHeight()};
 
@@ -107,12 +106,30 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
             const auto rect = GetSubRect(FromInterval(load_interval));
             ASSERT(FromInterval(load_interval).GetInterval() == load_interval);
 
-            for (unsigned y = rect.bottom; y < rect.top; ++y) {
-                for (unsigned x = rect.left; x < rect.right; ++x) {
-                    auto vec4 =
-                        Pica::Texture::LookupTexture(texture_src_data, x, height - 1 - y, tex_info);
-                    const std::size_t offset = (x + (width * y)) * 4;
-                    std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
+            const bool tile_aligned = rect.left % 8 == 0 && rect.right % 8 == 0 &&
+                                      rect.bottom % 8 == 0 && rect.top % 8 == 0 &&
+                                      height % 8 == 0;
+            if (tile_aligned) {
+                // Decode whole tiles, flipping them vertically with a negative pitch
+                const std::size_t tile_size = Pica::Texture::CalculateTileSize(tex_info.format);
+                const std::ptrdiff_t gl_pitch = -static_cast<std::ptrdiff_t>(width * 4);
+                for (unsigned ty = height - rect.top; ty < height - rect.bottom; ty += 8) {
+                    for (unsigned tx = rect.left; tx < rect.right; tx += 8) {
+                        const u8* tile =
+                            texture_src_data + (ty / 8) * tex_info.stride + (tx / 8) * tile_size;
+                        const std::size_t offset = (tx + width * (height - 1 - ty)) * 4;
+                        Pica::Texture::DecodeTile(tile, tex_info.format, &gl_buffer[offset],
+                                                  gl_pitch);
+                    }
+                }
+            } else {
+                for (unsigned y = rect.bottom; y < rect.top; ++y) {
+                    for (unsigned x = rect.left; x < rect.right; ++x) {
+                        auto vec4 = Pica::Texture::LookupTexture(texture_src_data, x,
+                                                                 height - 1 - y, tex_info);
+                        const std::size_t offset = (x + (width * y)) * 4;
+                        std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
+                    }
                 }
             }
         } else {
@@ -184,38 +201,19 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
     }
 }
 
-bool CachedSurface::LoadCustomTexture(u64 tex_hash) {
+std::shared_ptr<const Core::CustomTexInfo> CachedSurface::LoadCustomTexture(u64 tex_hash) {
     auto& custom_tex_cache = Core::System::GetInstance().CustomTexCache();
-    const auto& image_interface = Core::System::GetInstance().GetImageInterface();
-
-    if (custom_tex_cache.IsTextureCached(tex_hash)) {
-        custom_tex_info = custom_tex_cache.LookupTexture(tex_hash);
-        return true;
-    }
-
-    if (!custom_tex_cache.CustomTextureExists(tex_hash)) {
-        return false;
-    }
-
-    const auto& path_info = custom_tex_cache.LookupTexturePathInfo(tex_hash);
-    if (!image_interface->DecodePNG(custom_tex_info.tex, custom_tex_info.width,
-                                    custom_tex_info.height, path_info.path)) {
-        LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
-        return false;
-    }
-
-    const std::bitset<32> width_bits(custom_tex_info.width);
-    const std::bitset<32> height_bits(custom_tex_info.height);
-    if (width_bits.count() != 1 || height_bits.count() != 1) {
-        LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
-        return false;
+    auto custom_tex = custom_tex_cache.GetTexture(tex_hash);
+
+    // Upload the original texture meanwhile, the rasterizer cache reloads the surface once the
+    // custom texture is ready
+    custom_tex_hash = tex_hash;
+    is_custom_pending = !custom_tex && custom_tex_cache.IsTextureLoading(tex_hash);
+    if (custom_tex) {
+        custom_width = custom_tex->width;
+        custom_height = custom_tex->height;
     }
-
-    LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-    Common::FlipRGBA8Texture(custom_tex_info.tex, custom_tex_info.width, custom_tex_info.height);
-    custom_tex_cache.CacheTexture(tex_hash, custom_tex_info.tex, custom_tex_info.width,
-                                  custom_tex_info.height);
-    return true;
+    return custom_tex;
 }
 
 void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
@@ -229,47 +227,36 @@ void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
         return;
     }
 
-    // Dump texture to RGBA8 and encode as PNG
-    const auto& image_interface = Core::System::GetInstance().GetImageInterface();
     auto& custom_tex_cache = Core::System::GetInstance().CustomTexCache();
-    std::string dump_path =
-        fmt::format("{}textures/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::DumpDir),
-                    Core::System::GetInstance().Kernel().GetCurrentProcess()->codeset->program_id);
-    if (!FileUtil::CreateFullPath(dump_path)) {
-        LOG_ERROR(Render, "Unable to create {}", dump_path);
+    if (custom_tex_cache.IsTextureDumped(tex_hash)) {
         return;
     }
 
-    dump_path += fmt::format("tex1_{}x{}_{:016X}_{}.png", width, height, tex_hash, pixel_format);
-    if (!custom_tex_cache.IsTextureDumped(tex_hash) && !FileUtil::Exists(dump_path)) {
-        custom_tex_cache.SetTextureDumped(tex_hash);
-
-        LOG_INFO(Render_OpenGL, "Dumping texture to {}", dump_path);
-        std::vector<u8> decoded_texture;
-        decoded_texture.resize(width * height * 4);
-        OpenGLState state = OpenGLState::GetCurState();
-        GLuint old_texture = state.texture_units[0].texture_2d;
-        state.Apply();
-        /*
-           GetTexImageOES is used even if not using OpenGL ES to work around a small issue that
-           happens if using custom textures with texture dumping at the same.
-           Let's say there's 2 textures that are both 32x32 and one of them gets replaced with a
-           higher quality 256x256 texture. If the 256x256 texture is displayed first and the
-           32x32 texture gets uploaded to the same underlying OpenGL texture, the 32x32 texture
-           will appear in the corner of the 256x256 texture. If texture dumping is enabled and
-           the 32x32 is undumped, Citra will attempt to dump it. Since the underlying OpenGL
-           texture is still 256x256, Citra crashes because it thinks the texture is only 32x32.
-           GetTexImageOES conveniently only dumps the specified region, and works on both
-           desktop and ES.
-        */
-        owner.texture_downloader_es->GetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                                                 height, width, &decoded_texture[0]);
-        state.texture_units[0].texture_2d = old_texture;
-        state.Apply();
-        Common::FlipRGBA8Texture(decoded_texture, width, height);
-        if (!image_interface->EncodePNG(dump_path, decoded_texture, width, height))
-            LOG_ERROR(Render_OpenGL, "Failed to save decoded texture");
-    }
+    // Read the texture back as RGBA8, flipping and PNG encoding happen on the dump workers
+    std::vector<u8> decoded_texture(width * height * 4);
+    OpenGLState state = OpenGLState::GetCurState();
+    GLuint old_texture = state.texture_units[0].texture_2d;
+    state.Apply();
+    /*
+       GetTexImageOES is used even if not using OpenGL ES to work around a small issue that
+       happens if using custom textures with texture dumping at the same.
+       Let's say there's 2 textures that are both 32x32 and one of them gets replaced with a
+       higher quality 256x256 texture. If the 256x256 texture is displayed first and the
+       32x32 texture gets uploaded to the same underlying OpenGL texture, the 32x32 texture
+       will appear in the corner of the 256x256 texture. If texture dumping is enabled and
+       the 32x32 is undumped, Citra will attempt to dump it. Since the underlying OpenGL
+       texture is still 256x256, Citra crashes because it thinks the texture is only 32x32.
+       GetTexImageOES conveniently only dumps the specified region, and works on both
+       desktop and ES.
+    */
+    owner.texture_downloader_es->GetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, height,
+                                             width, &decoded_texture[0]);
+    state.texture_units[0].texture_2d = old_texture;
+    state.Apply();
+
+    custom_tex_cache.DumpTexture(
+        tex_hash, fmt::format("tex1_{}x{}_{:016X}_{}.png", width, height, tex_hash, pixel_format),
+        std::move(decoded_texture), width, height);
 }
 
 MICROPROFILE_DEFINE(RasterizerCache_TextureUL, "RasterizerCache", "Texture Upload",
@@ -288,8 +275,10 @@ void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect) {
         tex_hash = Common::ComputeHash64(gl_buffer.data(), gl_buffer.size());
     }
 
+    std::shared_ptr<const Core::CustomTexInfo> custom_tex;
     if (Settings::values.custom_textures) {
-        is_custom = LoadCustomTexture(tex_hash);
+        custom_tex = LoadCustomTexture(tex_hash);
+        is_custom = custom_tex != nullptr;
     }
 
     // Load data from memory to the surface
@@ -309,8 +298,7 @@ void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect) {
 
         if (is_custom) {
             const auto& tuple = GetFormatTuple(PixelFormat::RGBA8);
-            unscaled_tex =
-                owner.AllocateSurfaceTexture(tuple, custom_tex_info.width, custom_tex_info.height);
+            unscaled_tex = owner.AllocateSurfaceTexture(tuple, custom_width, custom_height);
         } else {
             unscaled_tex = owner.AllocateSurfaceTexture(tuple, rect.GetWidth(), rect.GetHeight());
         }
@@ -329,17 +317,17 @@ void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect) {
     if (is_custom) {
         if (res_scale == 1) {
             texture = owner.AllocateSurfaceTexture(GetFormatTuple(PixelFormat::RGBA8),
-                                                   custom_tex_info.width, custom_tex_info.height);
+                                                   custom_width, custom_height);
             cur_state.texture_units[0].texture_2d = texture.handle;
             cur_state.Apply();
         }
 
         // Always going to be using rgba8
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(custom_tex_info.width));
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(custom_width));
 
         glActiveTexture(GL_TEXTURE0);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, custom_tex_info.width, custom_tex_info.height,
-                        GL_RGBA, GL_UNSIGNED_BYTE, custom_tex_info.tex.data());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, custom_width, custom_height, GL_RGBA,
+                        GL_UNSIGNED_BYTE, custom_tex->tex.data());
     } else {
         glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(stride));
 
@@ -350,7 +338,7 @@ void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect) {
     }
 
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    if (Settings::values.dump_textures && !is_custom) {
+    if (Settings::values.dump_textures && !is_custom && !is_custom_pending) {
         DumpTexture(target_tex, tex_hash);
     }
 
@@ -364,8 +352,8 @@ void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect) {
         scaled_rect.right *= res_scale;
         scaled_rect.bottom *= res_scale;
 
-        const u32 width = is_custom ? custom_tex_info.width : rect.GetWidth();
-        const u32 height = is_custom ? custom_tex_info.height : rect.GetHeight();
+        const u32 width = is_custom ? custom_width : rect.GetWidth();
+        const u32 height = is_custom ? custom_height : rect.GetHeight();
         const Common::Rectangle<u32> from_rect{0, height, width, 0};
 
         if (is_custom ||
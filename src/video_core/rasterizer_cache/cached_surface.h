@@ -55,7 +55,7 @@ public:
     void FlushGLBuffer(PAddr flush_start, PAddr flush_end);
 
     /// Custom texture loading and dumping
-    bool LoadCustomTexture(u64 tex_hash);
+    std::shared_ptr<const Core::CustomTexInfo> LoadCustomTexture(u64 tex_hash);
     void DumpTexture(GLuint target_tex, u64 tex_hash);
 
     /// Upload/Download data in gl_buffer in/to this surface's texture
@@ -115,7 +115,10 @@ public:
 
     // Information about custom textures
     bool is_custom = false;
-    Core::CustomTexInfo custom_tex_info;
+    bool is_custom_pending = false; ///< The custom texture is still loading in the background
+    u64 custom_tex_hash = 0;
+    u32 custom_width = 0;
+    u32 custom_height = 0;
 
 private:
     RasterizerCacheOpenGL& owner;
@@ -5,6 +5,7 @@
 #pragma once
 #include "common/alignment.h"
 #include "core/memory.h"
+#include "video_core/rasterizer_cache/morton_swizzle_simd.h"
 #include "video_core/rasterizer_cache/pixel_format.h"
 #include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/utils.h"
@@ -76,6 +77,11 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
 
     ASSERT(!morton_to_gl || (aligned_start == start && aligned_end == end));
 
+    static const MortonTileFunc copy_tile = [] {
+        const MortonTileFunc func = GetMortonTileFunc(format, morton_to_gl, GetHostMortonISA());
+        return func ? func : &MortonCopyTile<morton_to_gl, format>;
+    }();
+
     const u32 begin_pixel_index = (aligned_down_start - base) / bytes_per_pixel;
     u32 x = (begin_pixel_index % (stride * 8)) / 8;
     u32 y = (begin_pixel_index / (stride * 8)) * 8;
@@ -95,7 +101,7 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
 
     if (start < aligned_start && !morton_to_gl) {
         std::array<u8, tile_size> tmp_buf;
-        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
+        copy_tile(stride, &tmp_buf[0], gl_buffer);
         std::memcpy(tile_buffer, &tmp_buf[start - aligned_down_start],
                     std::min(aligned_start, end) - start);
 
@@ -113,7 +119,7 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
             LOG_ERROR(Render_OpenGL, "Out of bound texture");
             break;
         }
-        MortonCopyTile<morton_to_gl, format>(stride, tile_buffer, gl_buffer);
+        copy_tile(stride, tile_buffer, gl_buffer);
         tile_buffer += tile_size;
         current_paddr += tile_size;
         glbuf_next_tile();
@@ -121,7 +127,7 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
 
     if (end > std::max(aligned_start, aligned_end) && !morton_to_gl) {
         std::array<u8, tile_size> tmp_buf;
-        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
+        copy_tile(stride, &tmp_buf[0], gl_buffer);
         std::memcpy(tile_buffer, &tmp_buf[0], end - aligned_end);
     }
 }
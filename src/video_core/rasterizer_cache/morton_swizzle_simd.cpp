@@ -0,0 +1,538 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include "common/arch.h"
+#include "video_core/rasterizer_cache/morton_swizzle_simd.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+#include "video_core/utils.h"
+
+#if CITRA_ARCH(x86_64)
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
+#if CITRA_ARCH(x86_64) && !defined(_MSC_VER)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#endif
+
+namespace OpenGL {
+
+namespace {
+
+/*
+ * A tile is made of 16 blocks of 2x2 pixels stored one after the other, so every block holds two
+ * pixels of two consecutive rows. The kernels load the four blocks of a pair of rows and split
+ * them into the rows with 64-bit (32-bit pixels), 32-bit (16-bit pixels) or byte (24-bit pixels)
+ * interleaves. Byte order conversions are done with byte shuffles.
+ */
+
+/// Morton index of the first pixel of the 2x2 block at the block coordinates of a tile
+constexpr u32 BlockIndex(u32 block_x, u32 block_y) {
+    return VideoCore::MortonInterleave(block_x * 2, block_y * 2);
+}
+
+/// Byte shuffle mask, indices with the top bit set produce zero with both PSHUFB and TBL
+using ByteMask = std::array<u8, 16>;
+constexpr u8 ZERO_BYTE = 0x80;
+
+/// Returns a mask that reorders the bytes of every 32-bit pixel as given by order
+constexpr ByteMask MakePixelShuffle(std::array<u8, 4> order) {
+    ByteMask mask{};
+    for (u32 i = 0; i < mask.size(); i++) {
+        mask[i] = static_cast<u8>((i & ~3U) + order[i & 3]);
+    }
+    return mask;
+}
+
+constexpr ByteMask D24S8_TO_GL = MakePixelShuffle({3, 0, 1, 2});
+constexpr ByteMask D24S8_TO_TILE = MakePixelShuffle({1, 2, 3, 0});
+// GLES has no ABGR format, so RGBA8 is byte swapped
+constexpr ByteMask RGBA8_GLES = MakePixelShuffle({3, 2, 1, 0});
+
+/// Returns the byte shuffle that converts 32-bit pixels of the format, nullptr if there is none
+template <bool morton_to_gl, PixelFormat format>
+const ByteMask* GetPixelShuffle32() {
+    if constexpr (format == PixelFormat::D24S8) {
+        return morton_to_gl ? &D24S8_TO_GL : &D24S8_TO_TILE;
+    } else {
+        return GLES ? &RGBA8_GLES : nullptr;
+    }
+}
+
+/// Masks applied to two vectors whose shuffled bytes are combined into one
+struct MaskPair {
+    ByteMask first;
+    ByteMask second;
+};
+
+/// Shuffles of 24-bit pixels between a pair of blocks and the halves of two rows
+struct Shuffles24 {
+    /// Bytes [0, 16) and [8, 24) of a block pair to the first and second row half
+    std::array<MaskPair, 2> to_gl;
+    /// First and second row half to bytes [0, 16) and [16, 24) of a block pair
+    std::array<MaskPair, 2> to_tile;
+    /// Bytes of the destination rows that are kept
+    ByteMask keep;
+};
+
+/**
+ * Builds the shuffles for 24-bit pixels stored with gl_bpp bytes in the GL buffer. Four byte
+ * pixels keep their low byte, and reverse swaps the components, as RGB8 on GLES needs.
+ */
+constexpr Shuffles24 MakeShuffles24(u32 gl_bpp, bool reverse) {
+    // Pixels of a block pair in the first and second row
+    constexpr std::array<std::array<u32, 4>, 2> row_pixels{{{0, 1, 4, 5}, {2, 3, 6, 7}}};
+    const auto gl_component = [&](u32 component) {
+        return gl_bpp == 4 ? component + 1 : (reverse ? 2 - component : component);
+    };
+
+    Shuffles24 shuffles{};
+    for (u32 row = 0; row < 2; row++) {
+        MaskPair& masks = shuffles.to_gl[row];
+        masks.first.fill(ZERO_BYTE);
+        masks.second.fill(ZERO_BYTE);
+        for (u32 pixel = 0; pixel < 4; pixel++) {
+            for (u32 component = 0; component < 3; component++) {
+                const u32 dst = pixel * gl_bpp + gl_component(component);
+                const u32 src = row_pixels[row][pixel] * 3 + component;
+                if (src < 16) {
+                    masks.first[dst] = static_cast<u8>(src);
+                } else {
+                    masks.second[dst] = static_cast<u8>(src - 8);
+                }
+            }
+        }
+    }
+    for (u32 part = 0; part < 2; part++) {
+        MaskPair& masks = shuffles.to_tile[part];
+        masks.first.fill(ZERO_BYTE);
+        masks.second.fill(ZERO_BYTE);
+        for (u32 dst = 0; dst < 16 && part * 16 + dst < 24; dst++) {
+            const u32 pixel = (part * 16 + dst) / 3;
+            const u32 component = (part * 16 + dst) % 3;
+            const u32 src = ((pixel >> 2) * 2 + (pixel & 1)) * gl_bpp + gl_component(component);
+            if ((pixel >> 1) & 1) {
+                masks.second[dst] = static_cast<u8>(src);
+            } else {
+                masks.first[dst] = static_cast<u8>(src);
+            }
+        }
+    }
+    for (u32 i = 0; i < shuffles.keep.size(); i++) {
+        shuffles.keep[i] = gl_bpp == 4 && i % 4 == 0 ? 0xFF : 0;
+    }
+    return shuffles;
+}
+
+constexpr Shuffles24 RGB8_SHUFFLES = MakeShuffles24(3, false);
+constexpr Shuffles24 RGB8_GLES_SHUFFLES = MakeShuffles24(3, true);
+constexpr Shuffles24 D24_SHUFFLES = MakeShuffles24(4, false);
+
+template <PixelFormat format>
+const Shuffles24& GetShuffles24() {
+    if constexpr (format == PixelFormat::D24) {
+        return D24_SHUFFLES;
+    } else {
+        return GLES ? RGB8_GLES_SHUFFLES : RGB8_SHUFFLES;
+    }
+}
+
+/// Returns the start of the GL pixel, MortonCopy offsets the buffer to the stored bytes of D24
+template <PixelFormat format>
+u8* GLPixelBase(u8* gl_buffer) {
+    return gl_buffer - (GetBytesPerPixel(format) - GetFormatBpp(format) / 8);
+}
+
+#if CITRA_ARCH(x86_64)
+
+TARGET_SSE41 __m128i Load(const u8* src) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+TARGET_SSE41 __m128i LoadPartial(const u8* src, std::size_t size) {
+    __m128i value = _mm_setzero_si128();
+    std::memcpy(&value, src, size);
+    return value;
+}
+
+TARGET_SSE41 void Store(u8* dst, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+}
+
+TARGET_SSE41 void StorePartial(u8* dst, __m128i value, std::size_t size) {
+    std::memcpy(dst, &value, size);
+}
+
+TARGET_SSE41 __m128i Shuffle(__m128i value, const ByteMask& mask) {
+    return _mm_shuffle_epi8(value, Load(mask.data()));
+}
+
+TARGET_SSE41 __m128i Shuffle(__m128i first, __m128i second, const MaskPair& masks) {
+    return _mm_or_si128(Shuffle(first, masks.first), Shuffle(second, masks.second));
+}
+
+TARGET_SSE41 __m128i Convert(__m128i value, const ByteMask* shuffle) {
+    return shuffle ? Shuffle(value, *shuffle) : value;
+}
+
+template <bool morton_to_gl, PixelFormat format>
+TARGET_SSE41 void MortonCopyTile32SSE41(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    const ByteMask* shuffle = GetPixelShuffle32<morton_to_gl, format>();
+    const std::size_t row_size = stride * 4;
+    for (u32 block_y = 0; block_y < 4; block_y++) {
+        u8* const row0 = gl_buffer + (7 - block_y * 2) * row_size;
+        u8* const row1 = row0 - row_size;
+        u8* const block0 = tile_buffer + BlockIndex(0, block_y) * 4;
+        u8* const block2 = tile_buffer + BlockIndex(2, block_y) * 4;
+        if constexpr (morton_to_gl) {
+            const __m128i a = Load(block0);
+            const __m128i b = Load(block0 + 16);
+            const __m128i c = Load(block2);
+            const __m128i d = Load(block2 + 16);
+            Store(row0, Convert(_mm_unpacklo_epi64(a, b), shuffle));
+            Store(row0 + 16, Convert(_mm_unpacklo_epi64(c, d), shuffle));
+            Store(row1, Convert(_mm_unpackhi_epi64(a, b), shuffle));
+            Store(row1 + 16, Convert(_mm_unpackhi_epi64(c, d), shuffle));
+        } else {
+            const __m128i row0_left = Convert(Load(row0), shuffle);
+            const __m128i row0_right = Convert(Load(row0 + 16), shuffle);
+            const __m128i row1_left = Convert(Load(row1), shuffle);
+            const __m128i row1_right = Convert(Load(row1 + 16), shuffle);
+            Store(block0, _mm_unpacklo_epi64(row0_left, row1_left));
+            Store(block0 + 16, _mm_unpackhi_epi64(row0_left, row1_left));
+            Store(block2, _mm_unpacklo_epi64(row0_right, row1_right));
+            Store(block2 + 16, _mm_unpackhi_epi64(row0_right, row1_right));
+        }
+    }
+}
+
+template <bool morton_to_gl>
+TARGET_SSE41 void MortonCopyTile16SSE41(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    // Swaps the middle 32-bit lanes, turning two blocks into two row halves and back
+    constexpr int SWAP_MIDDLE = _MM_SHUFFLE(3, 1, 2, 0);
+    const std::size_t row_size = stride * 2;
+    for (u32 block_y = 0; block_y < 4; block_y++) {
+        u8* const row0 = gl_buffer + (7 - block_y * 2) * row_size;
+        u8* const row1 = row0 - row_size;
+        u8* const block0 = tile_buffer + BlockIndex(0, block_y) * 2;
+        u8* const block2 = tile_buffer + BlockIndex(2, block_y) * 2;
+        if constexpr (morton_to_gl) {
+            const __m128i left = _mm_shuffle_epi32(Load(block0), SWAP_MIDDLE);
+            const __m128i right = _mm_shuffle_epi32(Load(block2), SWAP_MIDDLE);
+            Store(row0, _mm_unpacklo_epi64(left, right));
+            Store(row1, _mm_unpackhi_epi64(left, right));
+        } else {
+            const __m128i row0_pixels = Load(row0);
+            const __m128i row1_pixels = Load(row1);
+            Store(block0,
+                  _mm_shuffle_epi32(_mm_unpacklo_epi64(row0_pixels, row1_pixels), SWAP_MIDDLE));
+            Store(block2,
+                  _mm_shuffle_epi32(_mm_unpackhi_epi64(row0_pixels, row1_pixels), SWAP_MIDDLE));
+        }
+    }
+}
+
+template <bool morton_to_gl, PixelFormat format>
+TARGET_SSE41 void MortonCopyTile24SSE41(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    constexpr u32 gl_bpp = GetBytesPerPixel(format);
+    constexpr u32 half_size = gl_bpp * 4;
+    const Shuffles24& shuffles = GetShuffles24<format>();
+    const std::size_t row_size = stride * gl_bpp;
+    gl_buffer = GLPixelBase<format>(gl_buffer);
+    for (u32 block_y = 0; block_y < 4; block_y++) {
+        u8* const row0 = gl_buffer + (7 - block_y * 2) * row_size;
+        u8* const row1 = row0 - row_size;
+        for (u32 half = 0; half < 2; half++) {
+            u8* const pair = tile_buffer + BlockIndex(half * 2, block_y) * 3;
+            u8* const rows[2] = {row0 + half * half_size, row1 + half * half_size};
+            if constexpr (morton_to_gl) {
+                const __m128i low = Load(pair);
+                const __m128i high = Load(pair + 8);
+                for (u32 row = 0; row < 2; row++) {
+                    const __m128i pixels = Shuffle(low, high, shuffles.to_gl[row]);
+                    if constexpr (gl_bpp == 4) {
+                        const __m128i kept =
+                            _mm_and_si128(Load(rows[row]), Load(shuffles.keep.data()));
+                        Store(rows[row], _mm_or_si128(pixels, kept));
+                    } else {
+                        StorePartial(rows[row], pixels, half_size);
+                    }
+                }
+            } else {
+                const __m128i first = LoadPartial(rows[0], half_size);
+                const __m128i second = LoadPartial(rows[1], half_size);
+                Store(pair, Shuffle(first, second, shuffles.to_tile[0]));
+                StorePartial(pair + 16, Shuffle(first, second, shuffles.to_tile[1]), 8);
+            }
+        }
+    }
+}
+
+TARGET_AVX2 __m256i Load256(const u8* src) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+}
+
+TARGET_AVX2 void Store256(u8* dst, __m256i value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), value);
+}
+
+TARGET_AVX2 __m256i Convert256(__m256i value, const ByteMask* shuffle) {
+    if (!shuffle) {
+        return value;
+    }
+    return _mm256_shuffle_epi8(value, _mm256_broadcastsi128_si256(Load(shuffle->data())));
+}
+
+template <bool morton_to_gl, PixelFormat format>
+TARGET_AVX2 void MortonCopyTile32AVX2(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    // The interleaves work within 128-bit lanes, this puts the 64-bit units back in order
+    constexpr int CROSS_LANES = _MM_SHUFFLE(3, 1, 2, 0);
+    const ByteMask* shuffle = GetPixelShuffle32<morton_to_gl, format>();
+    const std::size_t row_size = stride * 4;
+    for (u32 block_y = 0; block_y < 4; block_y++) {
+        u8* const row0 = gl_buffer + (7 - block_y * 2) * row_size;
+        u8* const row1 = row0 - row_size;
+        u8* const block0 = tile_buffer + BlockIndex(0, block_y) * 4;
+        u8* const block2 = tile_buffer + BlockIndex(2, block_y) * 4;
+        if constexpr (morton_to_gl) {
+            const __m256i left = Load256(block0);
+            const __m256i right = Load256(block2);
+            const __m256i first = _mm256_unpacklo_epi64(left, right);
+            const __m256i second = _mm256_unpackhi_epi64(left, right);
+            Store256(row0, Convert256(_mm256_permute4x64_epi64(first, CROSS_LANES), shuffle));
+            Store256(row1, Convert256(_mm256_permute4x64_epi64(second, CROSS_LANES), shuffle));
+        } else {
+            const __m256i first =
+                _mm256_permute4x64_epi64(Convert256(Load256(row0), shuffle), CROSS_LANES);
+            const __m256i second =
+                _mm256_permute4x64_epi64(Convert256(Load256(row1), shuffle), CROSS_LANES);
+            Store256(block0, _mm256_unpacklo_epi64(first, second));
+            Store256(block2, _mm256_unpackhi_epi64(first, second));
+        }
+    }
+}
+
+template <bool morton_to_gl>
+MortonTileFunc GetTileFuncSSE41(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return MortonCopyTile32SSE41<morton_to_gl, PixelFormat::RGBA8>;
+    case PixelFormat::D24S8:
+        return MortonCopyTile32SSE41<morton_to_gl, PixelFormat::D24S8>;
+    case PixelFormat::RGB8:
+        return MortonCopyTile24SSE41<morton_to_gl, PixelFormat::RGB8>;
+    case PixelFormat::D24:
+        return MortonCopyTile24SSE41<morton_to_gl, PixelFormat::D24>;
+    case PixelFormat::RGB5A1:
+    case PixelFormat::RGB565:
+    case PixelFormat::RGBA4:
+    case PixelFormat::D16:
+        return MortonCopyTile16SSE41<morton_to_gl>;
+    default:
+        return nullptr;
+    }
+}
+
+template <bool morton_to_gl>
+MortonTileFunc GetTileFuncAVX2(PixelFormat format) {
+    // Rows of narrower pixels fill at most half of a 256-bit register
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return MortonCopyTile32AVX2<morton_to_gl, PixelFormat::RGBA8>;
+    case PixelFormat::D24S8:
+        return MortonCopyTile32AVX2<morton_to_gl, PixelFormat::D24S8>;
+    default:
+        return GetTileFuncSSE41<morton_to_gl>(format);
+    }
+}
+
+#elif CITRA_ARCH(arm64)
+
+uint8x16_t LoadPartial(const u8* src, std::size_t size) {
+    std::array<u8, 16> bytes{};
+    std::memcpy(bytes.data(), src, size);
+    return vld1q_u8(bytes.data());
+}
+
+void StorePartial(u8* dst, uint8x16_t value, std::size_t size) {
+    std::array<u8, 16> bytes;
+    vst1q_u8(bytes.data(), value);
+    std::memcpy(dst, bytes.data(), size);
+}
+
+uint8x16_t Shuffle(uint8x16_t first, uint8x16_t second, const MaskPair& masks) {
+    return vorrq_u8(vqtbl1q_u8(first, vld1q_u8(masks.first.data())),
+                    vqtbl1q_u8(second, vld1q_u8(masks.second.data())));
+}
+
+uint8x16_t Convert(uint8x16_t value, const ByteMask* shuffle) {
+    return shuffle ? vqtbl1q_u8(value, vld1q_u8(shuffle->data())) : value;
+}
+
+uint8x16_t ZipLow64(uint8x16_t first, uint8x16_t second) {
+    return vreinterpretq_u8_u64(
+        vzip1q_u64(vreinterpretq_u64_u8(first), vreinterpretq_u64_u8(second)));
+}
+
+uint8x16_t ZipHigh64(uint8x16_t first, uint8x16_t second) {
+    return vreinterpretq_u8_u64(
+        vzip2q_u64(vreinterpretq_u64_u8(first), vreinterpretq_u64_u8(second)));
+}
+
+template <bool morton_to_gl, PixelFormat format>
+void MortonCopyTile32NEON(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    const ByteMask* shuffle = GetPixelShuffle32<morton_to_gl, format>();
+    const std::size_t row_size = stride * 4;
+    for (u32 block_y = 0; block_y < 4; block_y++) {
+        u8* const row0 = gl_buffer + (7 - block_y * 2) * row_size;
+        u8* const row1 = row0 - row_size;
+        u8* const block0 = tile_buffer + BlockIndex(0, block_y) * 4;
+        u8* const block2 = tile_buffer + BlockIndex(2, block_y) * 4;
+        if constexpr (morton_to_gl) {
+            const uint8x16_t a = vld1q_u8(block0);
+            const uint8x16_t b = vld1q_u8(block0 + 16);
+            const uint8x16_t c = vld1q_u8(block2);
+            const uint8x16_t d = vld1q_u8(block2 + 16);
+            vst1q_u8(row0, Convert(ZipLow64(a, b), shuffle));
+            vst1q_u8(row0 + 16, Convert(ZipLow64(c, d), shuffle));
+            vst1q_u8(row1, Convert(ZipHigh64(a, b), shuffle));
+            vst1q_u8(row1 + 16, Convert(ZipHigh64(c, d), shuffle));
+        } else {
+            const uint8x16_t row0_left = Convert(vld1q_u8(row0), shuffle);
+            const uint8x16_t row0_right = Convert(vld1q_u8(row0 + 16), shuffle);
+            const uint8x16_t row1_left = Convert(vld1q_u8(row1), shuffle);
+            const uint8x16_t row1_right = Convert(vld1q_u8(row1 + 16), shuffle);
+            vst1q_u8(block0, ZipLow64(row0_left, row1_left));
+            vst1q_u8(block0 + 16, ZipHigh64(row0_left, row1_left));
+            vst1q_u8(block2, ZipLow64(row0_right, row1_right));
+            vst1q_u8(block2 + 16, ZipHigh64(row0_right, row1_right));
+        }
+    }
+}
+
+template <bool morton_to_gl>
+void MortonCopyTile16NEON(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    const std::size_t row_size = stride * 2;
+    for (u32 block_y = 0; block_y < 4; block_y++) {
+        u8* const row0 = gl_buffer + (7 - block_y * 2) * row_size;
+        u8* const row1 = row0 - row_size;
+        u8* const block0 = tile_buffer + BlockIndex(0, block_y) * 2;
+        u8* const block2 = tile_buffer + BlockIndex(2, block_y) * 2;
+        if constexpr (morton_to_gl) {
+            // Every 32-bit lane holds two pixels, even lanes belong to the first row
+            const uint32x4_t left = vreinterpretq_u32_u8(vld1q_u8(block0));
+            const uint32x4_t right = vreinterpretq_u32_u8(vld1q_u8(block2));
+            vst1q_u8(row0, vreinterpretq_u8_u32(vuzp1q_u32(left, right)));
+            vst1q_u8(row1, vreinterpretq_u8_u32(vuzp2q_u32(left, right)));
+        } else {
+            const uint32x4_t first = vreinterpretq_u32_u8(vld1q_u8(row0));
+            const uint32x4_t second = vreinterpretq_u32_u8(vld1q_u8(row1));
+            vst1q_u8(block0, vreinterpretq_u8_u32(vzip1q_u32(first, second)));
+            vst1q_u8(block2, vreinterpretq_u8_u32(vzip2q_u32(first, second)));
+        }
+    }
+}
+
+template <bool morton_to_gl, PixelFormat format>
+void MortonCopyTile24NEON(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    constexpr u32 gl_bpp = GetBytesPerPixel(format);
+    constexpr u32 half_size = gl_bpp * 4;
+    const Shuffles24& shuffles = GetShuffles24<format>();
+    const std::size_t row_size = stride * gl_bpp;
+    gl_buffer = GLPixelBase<format>(gl_buffer);
+    for (u32 block_y = 0; block_y < 4; block_y++) {
+        u8* const row0 = gl_buffer + (7 - block_y * 2) * row_size;
+        u8* const row1 = row0 - row_size;
+        for (u32 half = 0; half < 2; half++) {
+            u8* const pair = tile_buffer + BlockIndex(half * 2, block_y) * 3;
+            u8* const rows[2] = {row0 + half * half_size, row1 + half * half_size};
+            if constexpr (morton_to_gl) {
+                const uint8x16_t low = vld1q_u8(pair);
+                const uint8x16_t high = vld1q_u8(pair + 8);
+                for (u32 row = 0; row < 2; row++) {
+                    const uint8x16_t pixels = Shuffle(low, high, shuffles.to_gl[row]);
+                    if constexpr (gl_bpp == 4) {
+                        const uint8x16_t keep = vld1q_u8(shuffles.keep.data());
+                        vst1q_u8(rows[row], vbslq_u8(keep, vld1q_u8(rows[row]), pixels));
+                    } else {
+                        StorePartial(rows[row], pixels, half_size);
+                    }
+                }
+            } else {
+                const uint8x16_t first = LoadPartial(rows[0], half_size);
+                const uint8x16_t second = LoadPartial(rows[1], half_size);
+                vst1q_u8(pair, Shuffle(first, second, shuffles.to_tile[0]));
+                StorePartial(pair + 16, Shuffle(first, second, shuffles.to_tile[1]), 8);
+            }
+        }
+    }
+}
+
+template <bool morton_to_gl>
+MortonTileFunc GetTileFuncNEON(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return MortonCopyTile32NEON<morton_to_gl, PixelFormat::RGBA8>;
+    case PixelFormat::D24S8:
+        return MortonCopyTile32NEON<morton_to_gl, PixelFormat::D24S8>;
+    case PixelFormat::RGB8:
+        return MortonCopyTile24NEON<morton_to_gl, PixelFormat::RGB8>;
+    case PixelFormat::D24:
+        return MortonCopyTile24NEON<morton_to_gl, PixelFormat::D24>;
+    case PixelFormat::RGB5A1:
+    case PixelFormat::RGB565:
+    case PixelFormat::RGBA4:
+    case PixelFormat::D16:
+        return MortonCopyTile16NEON<morton_to_gl>;
+    default:
+        return nullptr;
+    }
+}
+
+#endif
+
+} // Anonymous namespace
+
+MortonISA GetHostMortonISA() {
+#if CITRA_ARCH(x86_64)
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.avx2) {
+        return MortonISA::AVX2;
+    }
+    if (caps.sse4_1) {
+        return MortonISA::SSE41;
+    }
+    return MortonISA::Scalar;
+#elif CITRA_ARCH(arm64)
+    return MortonISA::NEON;
+#else
+    return MortonISA::Scalar;
+#endif
+}
+
+MortonTileFunc GetMortonTileFunc(PixelFormat format, bool morton_to_gl, MortonISA isa) {
+    switch (isa) {
+#if CITRA_ARCH(x86_64)
+    case MortonISA::SSE41:
+        return morton_to_gl ? GetTileFuncSSE41<true>(format) : GetTileFuncSSE41<false>(format);
+    case MortonISA::AVX2:
+        return morton_to_gl ? GetTileFuncAVX2<true>(format) : GetTileFuncAVX2<false>(format);
+#elif CITRA_ARCH(arm64)
+    case MortonISA::NEON:
+        return morton_to_gl ? GetTileFuncNEON<true>(format) : GetTileFuncNEON<false>(format);
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+} // namespace OpenGL
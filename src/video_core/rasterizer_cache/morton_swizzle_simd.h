@@ -0,0 +1,32 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "video_core/rasterizer_cache/pixel_format.h"
+
+namespace OpenGL {
+
+/// Converts one 8x8 tile, takes the same arguments as MortonCopyTile
+using MortonTileFunc = void (*)(u32 stride, u8* tile_buffer, u8* gl_buffer);
+
+/// Instruction sets with vectorized tile kernels
+enum class MortonISA {
+    Scalar,
+    SSE41,
+    AVX2,
+    NEON,
+};
+
+/// Returns the widest instruction set with tile kernels that the host supports
+MortonISA GetHostMortonISA();
+
+/**
+ * Returns the vectorized tile kernel of the format for the instruction set, which the host must
+ * support, or nullptr if there is none and MortonCopyTile should be used instead.
+ */
+MortonTileFunc GetMortonTileFunc(PixelFormat format, bool morton_to_gl, MortonISA isa);
+
+} // namespace OpenGL
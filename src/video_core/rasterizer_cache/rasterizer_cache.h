@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include "video_core/rasterizer_cache/cached_surface.h"
 #include "video_core/rasterizer_cache/rasterizer_cache_utils.h"
+#include "video_core/rasterizer_cache/surface_index.h"
 #include "video_core/rasterizer_cache/surface_params.h"
 #include "video_core/texture/texture_decode.h"
 
@@ -78,7 +79,7 @@ public:
 
     // Textures from destroyed surfaces are stored here to be recyled to reduce allocation overhead
     // in the driver
-    // this must be placed above the surface_cache to ensure all cached surfaces are destroyed
+    // this must be placed above the surface_index to ensure all cached surfaces are destroyed
     // before destroying the recycler
     std::unordered_multimap<HostTextureTag, OGLTexture> host_texture_recycler;
 
@@ -109,13 +110,12 @@ private:
     /// Remove surface from the cache
     void UnregisterSurface(const Surface& surface);
 
-    /// Increase/decrease the number of surface in pages touching the specified region
-    void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
+    /// Tells the memory system which pages of the interval hold data not written back yet
+    void UpdateDirtyPages(const SurfaceInterval& interval);
 
     VideoCore::RendererBase& renderer;
     TextureRuntime runtime;
-    SurfaceCache surface_cache;
-    PageMap cached_pages;
+    SurfaceIndex surface_index;
     SurfaceMap dirty_regions;
     SurfaceSet remove_surfaces;
 
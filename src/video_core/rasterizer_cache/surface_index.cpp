@@ -0,0 +1,80 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "video_core/rasterizer_cache/surface_index.h"
+
+namespace OpenGL {
+
+SurfaceIndex::SurfaceIndex() = default;
+
+SurfaceIndex::~SurfaceIndex() = default;
+
+std::vector<Surface> SurfaceIndex::GetAllSurfaces() const {
+    std::vector<Surface> surfaces;
+    surfaces.reserve(slots.size() - free_slots.size());
+    for (const auto& surface : slots) {
+        if (surface) {
+            surfaces.push_back(surface);
+        }
+    }
+    return surfaces;
+}
+
+void SurfaceIndex::Clear() {
+    for (auto& block : blocks) {
+        block.reset();
+    }
+    slots.clear();
+    free_slots.clear();
+    visit_marks.clear();
+    visit_mark = 0;
+}
+
+SurfaceIndex::Bucket& SurfaceIndex::GetBucket(u32 page) {
+    auto& block = blocks[page >> BLOCK_BITS];
+    if (!block) {
+        block = std::make_unique<Block>();
+    }
+    return (*block)[page & BLOCK_PAGE_MASK];
+}
+
+u32 SurfaceIndex::AllocateSlot(const Surface& surface) {
+    if (free_slots.empty()) {
+        slots.push_back(surface);
+        visit_marks.push_back(0);
+        return static_cast<u32>(slots.size() - 1);
+    }
+    const u32 slot = free_slots.back();
+    free_slots.pop_back();
+    slots[slot] = surface;
+    return slot;
+}
+
+u32 SurfaceIndex::FindSlot(const Surface& surface) const {
+    // Every page of a registered surface lists its slot, the first one is as good as any
+    const Block* block = blocks[surface->addr >> (Memory::CITRA_PAGE_BITS + BLOCK_BITS)].get();
+    ASSERT(block);
+    const Bucket& bucket = (*block)[(surface->addr >> Memory::CITRA_PAGE_BITS) & BLOCK_PAGE_MASK];
+    const auto it = std::find_if(bucket.begin(), bucket.end(),
+                                 [&](u32 slot) { return slots[slot] == surface; });
+    ASSERT(it != bucket.end());
+    return *it;
+}
+
+void SurfaceIndex::FreeSlot(u32 slot) {
+    slots[slot].reset();
+    free_slots.push_back(slot);
+}
+
+u32 SurfaceIndex::NextVisitMark() const {
+    if (++visit_mark == 0) {
+        std::fill(visit_marks.begin(), visit_marks.end(), 0);
+        visit_mark = 1;
+    }
+    return visit_mark;
+}
+
+} // namespace OpenGL
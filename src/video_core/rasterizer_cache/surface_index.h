@@ -0,0 +1,188 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+#include "core/memory.h"
+#include "video_core/rasterizer_cache/cached_surface.h"
+
+namespace OpenGL {
+
+/**
+ * Index of the surfaces registered in the rasterizer cache. Surfaces live in a slot map, and
+ * every 4 KiB page of physical memory has a bucket with the slots of the surfaces overlapping
+ * it. Looking up a region only visits the buckets of the pages it spans and does not allocate.
+ */
+class SurfaceIndex {
+public:
+    SurfaceIndex();
+    ~SurfaceIndex();
+
+    /**
+     * Adds a surface to the index
+     * @param on_cached Called with the address and size of every run of pages that did not
+     * overlap any surface before
+     */
+    template <typename Func>
+    void Insert(const Surface& surface, Func&& on_cached) {
+        const u32 slot = AllocateSlot(surface);
+        ForEachPageRun(surface->GetInterval(), on_cached, [this, slot](u32 page) {
+            Bucket& bucket = GetBucket(page);
+            bucket.push_back(slot);
+            return bucket.size() == 1;
+        });
+    }
+
+    /**
+     * Removes a surface from the index
+     * @param on_uncached Called with the address and size of every run of pages that no longer
+     * overlap any surface
+     */
+    template <typename Func>
+    void Remove(const Surface& surface, Func&& on_uncached) {
+        const u32 slot = FindSlot(surface);
+        ForEachPageRun(surface->GetInterval(), on_uncached, [this, slot](u32 page) {
+            Bucket& bucket = GetBucket(page);
+            for (u32& entry : bucket) {
+                if (entry == slot) {
+                    entry = bucket.back();
+                    bucket.pop_back();
+                    break;
+                }
+            }
+            return bucket.empty();
+        });
+        FreeSlot(slot);
+    }
+
+    /**
+     * Calls func once for every surface overlapping the interval. func must not insert or remove
+     * surfaces.
+     */
+    template <typename Func>
+    void ForEachInInterval(SurfaceInterval interval, Func&& func) const {
+        if (boost::icl::is_empty(interval)) {
+            return;
+        }
+        const u32 mark = NextVisitMark();
+        const u32 first_page = interval.lower() >> Memory::CITRA_PAGE_BITS;
+        const u32 last_page = (interval.upper() - 1) >> Memory::CITRA_PAGE_BITS;
+        for (u32 page = first_page; page <= last_page; page++) {
+            const Block* block = blocks[page >> BLOCK_BITS].get();
+            if (!block) {
+                // Skip to the first page of the next block
+                page |= BLOCK_PAGE_MASK;
+                continue;
+            }
+            for (const u32 slot : (*block)[page & BLOCK_PAGE_MASK]) {
+                if (visit_marks[slot] == mark) {
+                    continue;
+                }
+                visit_marks[slot] = mark;
+                const Surface& surface = slots[slot];
+                if (surface->addr < interval.upper() && surface->end > interval.lower()) {
+                    func(surface);
+                }
+            }
+        }
+    }
+
+    /// Calls func with the address and size of every run of pages overlapping any surface
+    template <typename Func>
+    void ForEachCachedRegion(Func&& func) const {
+        PageRun run{func};
+        for (u32 block_index = 0; block_index < NUM_BLOCKS; block_index++) {
+            const Block* block = blocks[block_index].get();
+            if (!block) {
+                run.Add(block_index << BLOCK_BITS, false);
+                continue;
+            }
+            for (u32 i = 0; i < PAGES_PER_BLOCK; i++) {
+                run.Add((block_index << BLOCK_BITS) | i, !(*block)[i].empty());
+            }
+        }
+    }
+
+    /// Returns all registered surfaces
+    std::vector<Surface> GetAllSurfaces() const;
+
+    /// Drops every surface without reporting the pages that become uncached
+    void Clear();
+
+private:
+    using Bucket = std::vector<u32>;
+
+    static constexpr u32 BLOCK_BITS = 12;
+    static constexpr u32 PAGES_PER_BLOCK = 1U << BLOCK_BITS;
+    static constexpr u32 BLOCK_PAGE_MASK = PAGES_PER_BLOCK - 1;
+    static constexpr u32 NUM_BLOCKS = 1U << (32 - Memory::CITRA_PAGE_BITS - BLOCK_BITS);
+
+    /// Buckets of 16 MiB of physical memory, allocated once a surface is placed there
+    using Block = std::array<Bucket, PAGES_PER_BLOCK>;
+
+    /// Merges consecutive pages into runs and reports each run with its address and size
+    template <typename Func>
+    class PageRun {
+    public:
+        explicit PageRun(Func& func) : func{func} {}
+
+        ~PageRun() {
+            Flush();
+        }
+
+        void Add(u32 page, bool in_run) {
+            if (!in_run) {
+                Flush();
+                return;
+            }
+            start = count == 0 ? page : start;
+            count++;
+        }
+
+    private:
+        void Flush() {
+            if (count != 0) {
+                func(start << Memory::CITRA_PAGE_BITS, count << Memory::CITRA_PAGE_BITS);
+                count = 0;
+            }
+        }
+
+        Func& func;
+        u32 start = 0;
+        u32 count = 0;
+    };
+
+    /// Calls update on every page of the interval, pages it returns true for are reported to on_run
+    template <typename Func, typename Update>
+    static void ForEachPageRun(SurfaceInterval interval, Func& on_run, Update&& update) {
+        const u32 first_page = interval.lower() >> Memory::CITRA_PAGE_BITS;
+        const u32 last_page = (interval.upper() - 1) >> Memory::CITRA_PAGE_BITS;
+        PageRun run{on_run};
+        for (u32 page = first_page; page <= last_page; page++) {
+            run.Add(page, update(page));
+        }
+    }
+
+    Bucket& GetBucket(u32 page);
+
+    u32 AllocateSlot(const Surface& surface);
+    u32 FindSlot(const Surface& surface) const;
+    void FreeSlot(u32 slot);
+
+    u32 NextVisitMark() const;
+
+    std::array<std::unique_ptr<Block>, NUM_BLOCKS> blocks;
+    std::vector<Surface> slots;
+    std::vector<u32> free_slots;
+
+    // Deduplicates surfaces spanning several pages during lookups
+    mutable std::vector<u32> visit_marks;
+    mutable u32 visit_mark = 0;
+};
+
+} // namespace OpenGL
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #pragma once
+#include "common/common_funcs.h"
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_lighting.h"
 #include "video_core/regs_pipeline.h"
@@ -40,6 +41,19 @@ struct Regs {
 
 static_assert(sizeof(Regs) == Regs::NUM_REGS * sizeof(u32), "Regs struct has wrong size");
 
+/// Groups of registers that the fragment shader configuration of hardware renderers depends on
+enum class FSConfigGroup : u32 {
+    None = 0,
+    Rasterizer = 1 << 0,  ///< Scissor test and depth mapping
+    Framebuffer = 1 << 1, ///< Alpha test, blending, logic op and fragment operation mode
+    Texturing = 1 << 2,   ///< Texture types, texture coordinates and shadow textures
+    TevStages = 1 << 3,   ///< TEV stage operations, combiner buffer and fog mode
+    Lighting = 1 << 4,
+    ProcTex = 1 << 5,
+    All = (1 << 6) - 1,
+};
+DECLARE_ENUM_FLAG_OPERATORS(FSConfigGroup)
+
 #define ASSERT_REG_POSITION(field_name, position)                                                  \
     static_assert(offsetof(Regs, field_name) == position * 4,                                      \
                   "Field " #field_name " has invalid position")
@@ -4,6 +4,7 @@
 
 #include "core/core.h"
 #include "core/frontend/emu_window.h"
+#include "core/rewind.h"
 #include "core/tracer/recorder.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/renderer_base.h"
@@ -39,14 +40,17 @@ void RendererBase::UpdateCurrentFramebufferLayout(bool is_portrait_mode) {
     }
 }
 
-void RendererBase::EndFrame() {
+void RendererBase::EndFrame(const FrameInfo& frame) {
     current_frame++;
 
     system.perf_stats->EndSystemFrame();
 
     render_window.PollEvents();
 
-    system.frame_limiter.DoFrameLimiting(system.CoreTiming().GetGlobalTimeUs());
+    // Frames replayed after a rewind have already been shown, run through them unthrottled
+    if (!system.RewindBuffer().IsReplaying()) {
+        system.frame_limiter.DoFrameLimiting(frame.system_time);
+    }
     system.perf_stats->BeginSystemFrame();
 
     if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
@@ -4,8 +4,12 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
 #include "common/common_types.h"
 #include "core/frontend/framebuffer_layout.h"
+#include "core/hw/gpu.h"
+#include "core/hw/lcd.h"
 #include "video_core/rasterizer_interface.h"
 
 namespace Frontend {
@@ -31,6 +35,16 @@ struct RendererSettings {
     std::atomic_bool shader_update_requested{false};
 };
 
+/**
+ * The display state a frame is presented with. It is captured on the emulation thread at VBlank,
+ * as the registers may already have changed by the time the GPU thread presents the frame.
+ */
+struct FrameInfo {
+    std::array<GPU::Regs::FramebufferConfig, 2> framebuffer_config;
+    std::array<LCD::Regs::ColorFill, 2> color_fill; ///< Top and bottom screen
+    std::chrono::microseconds system_time;          ///< Emulated time, used for frame limiting
+};
+
 class RendererBase : NonCopyable {
 public:
     explicit RendererBase(Core::System& system, Frontend::EmuWindow& window,
@@ -41,7 +55,7 @@ public:
     virtual VideoCore::RasterizerInterface* Rasterizer() const = 0;
 
     /// Finalize rendering the guest frame and draw into the presentation texture
-    virtual void SwapBuffers() = 0;
+    virtual void SwapBuffers(const FrameInfo& frame) = 0;
 
     /// Draws the latest frame to the window waiting timeout_ms for a frame to arrive (Renderer
     /// specific implementation)
@@ -66,7 +80,7 @@ public:
     void UpdateCurrentFramebufferLayout(bool is_portrait_mode = {});
 
     /// Ends the current frame
-    void EndFrame();
+    void EndFrame(const FrameInfo& frame);
 
     // Getter/setter functions:
     // ------------------------
@@ -631,10 +631,7 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     }
 
     // Sync and bind the shader
-    if (shader_dirty) {
-        SetShader();
-        shader_dirty = false;
-    }
+    SetShader();
 
     // Sync the LUTs within the texture buffer
     SyncAndUploadLUTs();
@@ -740,6 +737,8 @@ void RasterizerOpenGL::NotifyFixedFunctionPicaRegisterChanged(u32 id) {
         // Update since logic op emulation depends on alpha blend enable.
         SyncLogicOp();
         SyncColorWriteMask();
+        // Also holds the fragment operation mode
+        shader_dirty |= Pica::FSConfigGroup::Framebuffer;
         break;
     case PICA_REG_INDEX(framebuffer.output_merger.alpha_blending):
         SyncBlendFuncs();
@@ -785,6 +784,7 @@ void RasterizerOpenGL::NotifyFixedFunctionPicaRegisterChanged(u32 id) {
         SyncLogicOp();
         // Update since color write mask is used to emulate no-op.
         SyncColorWriteMask();
+        shader_dirty |= Pica::FSConfigGroup::Framebuffer;
         break;
     }
 }
@@ -814,6 +814,12 @@ void RasterizerOpenGL::ClearAll(bool flush) {
     res_cache.ClearAll(flush);
 }
 
+u64 RasterizerOpenGL::GetAndResetUploadedBytes() {
+    return vertex_buffer.GetAndResetUploadedBytes() + uniform_buffer.GetAndResetUploadedBytes() +
+           index_buffer.GetAndResetUploadedBytes() + texture_buffer.GetAndResetUploadedBytes() +
+           texture_lf_buffer.GetAndResetUploadedBytes();
+}
+
 bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) {
     MICROPROFILE_SCOPE(OpenGL_Blits);
 
@@ -1073,7 +1079,8 @@ void RasterizerOpenGL::SamplerInfo::SyncWithConfig(
 }
 
 void RasterizerOpenGL::SetShader() {
-    shader_program_manager->UseFragmentShader(Pica::g_state.regs);
+    shader_program_manager->UseFragmentShader(Pica::g_state.regs, shader_dirty);
+    shader_dirty = Pica::FSConfigGroup::None;
 }
 
 void RasterizerOpenGL::SyncClipEnabled() {
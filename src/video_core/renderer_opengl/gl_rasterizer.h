@@ -45,6 +45,9 @@ public:
                            u32 pixel_stride, ScreenInfo& screen_info) override;
     bool AccelerateDrawBatch(bool is_indexed) override;
 
+    /// Returns the number of bytes uploaded through the stream buffers since the last call
+    u64 GetAndResetUploadedBytes();
+
 private:
     void SyncFixedState() override;
     void NotifyFixedFunctionPicaRegisterChanged(u32 id) override;
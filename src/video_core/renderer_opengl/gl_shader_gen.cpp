@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
 #include <string_view>
 #include <fmt/format.h>
 #include "common/bit_set.h"
@@ -61,150 +62,162 @@ out gl_PerVertex {
 
 PicaFSConfig PicaFSConfig::BuildFromRegs(const Pica::Regs& regs) {
     PicaFSConfig res{};
+    res.UpdateFromRegs(regs, Pica::FSConfigGroup::All);
+    return res;
+}
 
-    auto& state = res.state;
+void PicaFSConfig::UpdateFromRegs(const Pica::Regs& regs, Pica::FSConfigGroup groups) {
+    using Pica::FSConfigGroup;
 
-    state.scissor_test_mode = regs.rasterizer.scissor_test.mode;
+    if (True(groups & FSConfigGroup::Rasterizer)) {
+        state.scissor_test_mode = regs.rasterizer.scissor_test.mode;
+        state.depthmap_enable = regs.rasterizer.depthmap_enable;
+    }
 
-    state.depthmap_enable = regs.rasterizer.depthmap_enable;
+    if (True(groups & FSConfigGroup::Framebuffer)) {
+        state.alpha_test_func = regs.framebuffer.output_merger.alpha_test.enable
+                                    ? regs.framebuffer.output_merger.alpha_test.func.Value()
+                                    : FramebufferRegs::CompareFunc::Always;
 
-    state.alpha_test_func = regs.framebuffer.output_merger.alpha_test.enable
-                                ? regs.framebuffer.output_merger.alpha_test.func.Value()
-                                : FramebufferRegs::CompareFunc::Always;
+        if (GLES) {
+            // With GLES, we need this in the fragment shader to emulate logic operations
+            state.alphablend_enable =
+                Pica::g_state.regs.framebuffer.output_merger.alphablend_enable == 1;
+            state.logic_op = regs.framebuffer.output_merger.logic_op;
+        } else {
+            // We don't need these otherwise, reset them to avoid unnecessary shader generation
+            state.alphablend_enable = {};
+            state.logic_op = {};
+        }
 
-    state.texture0_type = regs.texturing.texture0.type;
+        state.shadow_rendering = regs.framebuffer.output_merger.fragment_operation_mode ==
+                                 FramebufferRegs::FragmentOperationMode::Shadow;
+    }
 
-    state.texture2_use_coord1 = regs.texturing.main_config.texture2_use_coord1 != 0;
+    if (True(groups & FSConfigGroup::Texturing)) {
+        state.texture0_type = regs.texturing.texture0.type;
+        state.texture2_use_coord1 = regs.texturing.main_config.texture2_use_coord1 != 0;
+        state.shadow_texture_orthographic = regs.texturing.shadow.orthographic != 0;
+    }
 
-    if (GLES) {
-        // With GLES, we need this in the fragment shader to emulate logic operations
-        state.alphablend_enable =
-            Pica::g_state.regs.framebuffer.output_merger.alphablend_enable == 1;
-        state.logic_op = regs.framebuffer.output_merger.logic_op;
-    } else {
-        // We don't need these otherwise, reset them to avoid unnecessary shader generation
-        state.alphablend_enable = {};
-        state.logic_op = {};
-    }
-
-    // Copy relevant tev stages fields.
-    // We don't sync const_color here because of the high variance, it is a
-    // shader uniform instead.
-    const auto& tev_stages = regs.texturing.GetTevStages();
-    DEBUG_ASSERT(state.tev_stages.size() == tev_stages.size());
-    for (std::size_t i = 0; i < tev_stages.size(); i++) {
-        const auto& tev_stage = tev_stages[i];
-        state.tev_stages[i].sources_raw = tev_stage.sources_raw;
-        state.tev_stages[i].modifiers_raw = tev_stage.modifiers_raw;
-        state.tev_stages[i].ops_raw = tev_stage.ops_raw;
-        state.tev_stages[i].scales_raw = tev_stage.scales_raw;
-    }
-
-    state.fog_mode = regs.texturing.fog_mode;
-    state.fog_flip = regs.texturing.fog_flip != 0;
-
-    state.combiner_buffer_input = regs.texturing.tev_combiner_buffer_input.update_mask_rgb.Value() |
-                                  regs.texturing.tev_combiner_buffer_input.update_mask_a.Value()
-                                      << 4;
-
-    // Fragment lighting
-
-    state.lighting.enable = !regs.lighting.disable;
-    state.lighting.src_num = regs.lighting.max_light_index + 1;
-
-    for (unsigned light_index = 0; light_index < state.lighting.src_num; ++light_index) {
-        unsigned num = regs.lighting.light_enable.GetNum(light_index);
-        const auto& light = regs.lighting.light[num];
-        state.lighting.light[light_index].num = num;
-        state.lighting.light[light_index].directional = light.config.directional != 0;
-        state.lighting.light[light_index].two_sided_diffuse = light.config.two_sided_diffuse != 0;
-        state.lighting.light[light_index].geometric_factor_0 = light.config.geometric_factor_0 != 0;
-        state.lighting.light[light_index].geometric_factor_1 = light.config.geometric_factor_1 != 0;
-        state.lighting.light[light_index].dist_atten_enable =
-            !regs.lighting.IsDistAttenDisabled(num);
-        state.lighting.light[light_index].spot_atten_enable =
-            !regs.lighting.IsSpotAttenDisabled(num);
-        state.lighting.light[light_index].shadow_enable = !regs.lighting.IsShadowDisabled(num);
-    }
-
-    state.lighting.lut_d0.enable = regs.lighting.config1.disable_lut_d0 == 0;
-    state.lighting.lut_d0.abs_input = regs.lighting.abs_lut_input.disable_d0 == 0;
-    state.lighting.lut_d0.type = regs.lighting.lut_input.d0.Value();
-    state.lighting.lut_d0.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.d0);
-
-    state.lighting.lut_d1.enable = regs.lighting.config1.disable_lut_d1 == 0;
-    state.lighting.lut_d1.abs_input = regs.lighting.abs_lut_input.disable_d1 == 0;
-    state.lighting.lut_d1.type = regs.lighting.lut_input.d1.Value();
-    state.lighting.lut_d1.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.d1);
-
-    // this is a dummy field due to lack of the corresponding register
-    state.lighting.lut_sp.enable = true;
-    state.lighting.lut_sp.abs_input = regs.lighting.abs_lut_input.disable_sp == 0;
-    state.lighting.lut_sp.type = regs.lighting.lut_input.sp.Value();
-    state.lighting.lut_sp.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.sp);
-
-    state.lighting.lut_fr.enable = regs.lighting.config1.disable_lut_fr == 0;
-    state.lighting.lut_fr.abs_input = regs.lighting.abs_lut_input.disable_fr == 0;
-    state.lighting.lut_fr.type = regs.lighting.lut_input.fr.Value();
-    state.lighting.lut_fr.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.fr);
-
-    state.lighting.lut_rr.enable = regs.lighting.config1.disable_lut_rr == 0;
-    state.lighting.lut_rr.abs_input = regs.lighting.abs_lut_input.disable_rr == 0;
-    state.lighting.lut_rr.type = regs.lighting.lut_input.rr.Value();
-    state.lighting.lut_rr.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rr);
-
-    state.lighting.lut_rg.enable = regs.lighting.config1.disable_lut_rg == 0;
-    state.lighting.lut_rg.abs_input = regs.lighting.abs_lut_input.disable_rg == 0;
-    state.lighting.lut_rg.type = regs.lighting.lut_input.rg.Value();
-    state.lighting.lut_rg.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rg);
-
-    state.lighting.lut_rb.enable = regs.lighting.config1.disable_lut_rb == 0;
-    state.lighting.lut_rb.abs_input = regs.lighting.abs_lut_input.disable_rb == 0;
-    state.lighting.lut_rb.type = regs.lighting.lut_input.rb.Value();
-    state.lighting.lut_rb.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rb);
-
-    state.lighting.config = regs.lighting.config0.config;
-    state.lighting.enable_primary_alpha = regs.lighting.config0.enable_primary_alpha;
-    state.lighting.enable_secondary_alpha = regs.lighting.config0.enable_secondary_alpha;
-    state.lighting.bump_mode = regs.lighting.config0.bump_mode;
-    state.lighting.bump_selector = regs.lighting.config0.bump_selector;
-    state.lighting.bump_renorm = regs.lighting.config0.disable_bump_renorm == 0;
-    state.lighting.clamp_highlights = regs.lighting.config0.clamp_highlights != 0;
-
-    state.lighting.enable_shadow = regs.lighting.config0.enable_shadow != 0;
-    state.lighting.shadow_primary = regs.lighting.config0.shadow_primary != 0;
-    state.lighting.shadow_secondary = regs.lighting.config0.shadow_secondary != 0;
-    state.lighting.shadow_invert = regs.lighting.config0.shadow_invert != 0;
-    state.lighting.shadow_alpha = regs.lighting.config0.shadow_alpha != 0;
-    state.lighting.shadow_selector = regs.lighting.config0.shadow_selector;
-
-    state.proctex.enable = regs.texturing.main_config.texture3_enable;
-    if (state.proctex.enable) {
-        state.proctex.coord = regs.texturing.main_config.texture3_coordinates;
-        state.proctex.u_clamp = regs.texturing.proctex.u_clamp;
-        state.proctex.v_clamp = regs.texturing.proctex.v_clamp;
-        state.proctex.color_combiner = regs.texturing.proctex.color_combiner;
-        state.proctex.alpha_combiner = regs.texturing.proctex.alpha_combiner;
-        state.proctex.separate_alpha = regs.texturing.proctex.separate_alpha;
-        state.proctex.noise_enable = regs.texturing.proctex.noise_enable;
-        state.proctex.u_shift = regs.texturing.proctex.u_shift;
-        state.proctex.v_shift = regs.texturing.proctex.v_shift;
-        state.proctex.lut_width = regs.texturing.proctex_lut.width;
-        state.proctex.lut_offset0 = regs.texturing.proctex_lut_offset.level0;
-        state.proctex.lut_offset1 = regs.texturing.proctex_lut_offset.level1;
-        state.proctex.lut_offset2 = regs.texturing.proctex_lut_offset.level2;
-        state.proctex.lut_offset3 = regs.texturing.proctex_lut_offset.level3;
-        state.proctex.lod_min = regs.texturing.proctex_lut.lod_min;
-        state.proctex.lod_max = regs.texturing.proctex_lut.lod_max;
-        state.proctex.lut_filter = regs.texturing.proctex_lut.filter;
-    }
-
-    state.shadow_rendering = regs.framebuffer.output_merger.fragment_operation_mode ==
-                             FramebufferRegs::FragmentOperationMode::Shadow;
-
-    state.shadow_texture_orthographic = regs.texturing.shadow.orthographic != 0;
+    if (True(groups & FSConfigGroup::TevStages)) {
+        // Copy relevant tev stages fields.
+        // We don't sync const_color here because of the high variance, it is a
+        // shader uniform instead.
+        const auto& tev_stages = regs.texturing.GetTevStages();
+        DEBUG_ASSERT(state.tev_stages.size() == tev_stages.size());
+        for (std::size_t i = 0; i < tev_stages.size(); i++) {
+            const auto& tev_stage = tev_stages[i];
+            state.tev_stages[i].sources_raw = tev_stage.sources_raw;
+            state.tev_stages[i].modifiers_raw = tev_stage.modifiers_raw;
+            state.tev_stages[i].ops_raw = tev_stage.ops_raw;
+            state.tev_stages[i].scales_raw = tev_stage.scales_raw;
+        }
 
-    return res;
+        state.fog_mode = regs.texturing.fog_mode;
+        state.fog_flip = regs.texturing.fog_flip != 0;
+
+        const auto& combiner_buffer_input = regs.texturing.tev_combiner_buffer_input;
+        state.combiner_buffer_input = combiner_buffer_input.update_mask_rgb.Value() |
+                                      combiner_buffer_input.update_mask_a.Value() << 4;
+    }
+
+    if (True(groups & FSConfigGroup::Lighting)) {
+        // Lights past src_num are left unset, clear them along with the padding
+        std::memset(&state.lighting, 0, sizeof(state.lighting));
+
+        state.lighting.enable = !regs.lighting.disable;
+        state.lighting.src_num = regs.lighting.max_light_index + 1;
+
+        for (unsigned light_index = 0; light_index < state.lighting.src_num; ++light_index) {
+            unsigned num = regs.lighting.light_enable.GetNum(light_index);
+            const auto& light = regs.lighting.light[num];
+            auto& light_config = state.lighting.light[light_index];
+            light_config.num = num;
+            light_config.directional = light.config.directional != 0;
+            light_config.two_sided_diffuse = light.config.two_sided_diffuse != 0;
+            light_config.geometric_factor_0 = light.config.geometric_factor_0 != 0;
+            light_config.geometric_factor_1 = light.config.geometric_factor_1 != 0;
+            light_config.dist_atten_enable = !regs.lighting.IsDistAttenDisabled(num);
+            light_config.spot_atten_enable = !regs.lighting.IsSpotAttenDisabled(num);
+            light_config.shadow_enable = !regs.lighting.IsShadowDisabled(num);
+        }
+
+        state.lighting.lut_d0.enable = regs.lighting.config1.disable_lut_d0 == 0;
+        state.lighting.lut_d0.abs_input = regs.lighting.abs_lut_input.disable_d0 == 0;
+        state.lighting.lut_d0.type = regs.lighting.lut_input.d0.Value();
+        state.lighting.lut_d0.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.d0);
+
+        state.lighting.lut_d1.enable = regs.lighting.config1.disable_lut_d1 == 0;
+        state.lighting.lut_d1.abs_input = regs.lighting.abs_lut_input.disable_d1 == 0;
+        state.lighting.lut_d1.type = regs.lighting.lut_input.d1.Value();
+        state.lighting.lut_d1.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.d1);
+
+        // this is a dummy field due to lack of the corresponding register
+        state.lighting.lut_sp.enable = true;
+        state.lighting.lut_sp.abs_input = regs.lighting.abs_lut_input.disable_sp == 0;
+        state.lighting.lut_sp.type = regs.lighting.lut_input.sp.Value();
+        state.lighting.lut_sp.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.sp);
+
+        state.lighting.lut_fr.enable = regs.lighting.config1.disable_lut_fr == 0;
+        state.lighting.lut_fr.abs_input = regs.lighting.abs_lut_input.disable_fr == 0;
+        state.lighting.lut_fr.type = regs.lighting.lut_input.fr.Value();
+        state.lighting.lut_fr.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.fr);
+
+        state.lighting.lut_rr.enable = regs.lighting.config1.disable_lut_rr == 0;
+        state.lighting.lut_rr.abs_input = regs.lighting.abs_lut_input.disable_rr == 0;
+        state.lighting.lut_rr.type = regs.lighting.lut_input.rr.Value();
+        state.lighting.lut_rr.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rr);
+
+        state.lighting.lut_rg.enable = regs.lighting.config1.disable_lut_rg == 0;
+        state.lighting.lut_rg.abs_input = regs.lighting.abs_lut_input.disable_rg == 0;
+        state.lighting.lut_rg.type = regs.lighting.lut_input.rg.Value();
+        state.lighting.lut_rg.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rg);
+
+        state.lighting.lut_rb.enable = regs.lighting.config1.disable_lut_rb == 0;
+        state.lighting.lut_rb.abs_input = regs.lighting.abs_lut_input.disable_rb == 0;
+        state.lighting.lut_rb.type = regs.lighting.lut_input.rb.Value();
+        state.lighting.lut_rb.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rb);
+
+        state.lighting.config = regs.lighting.config0.config;
+        state.lighting.enable_primary_alpha = regs.lighting.config0.enable_primary_alpha;
+        state.lighting.enable_secondary_alpha = regs.lighting.config0.enable_secondary_alpha;
+        state.lighting.bump_mode = regs.lighting.config0.bump_mode;
+        state.lighting.bump_selector = regs.lighting.config0.bump_selector;
+        state.lighting.bump_renorm = regs.lighting.config0.disable_bump_renorm == 0;
+        state.lighting.clamp_highlights = regs.lighting.config0.clamp_highlights != 0;
+
+        state.lighting.enable_shadow = regs.lighting.config0.enable_shadow != 0;
+        state.lighting.shadow_primary = regs.lighting.config0.shadow_primary != 0;
+        state.lighting.shadow_secondary = regs.lighting.config0.shadow_secondary != 0;
+        state.lighting.shadow_invert = regs.lighting.config0.shadow_invert != 0;
+        state.lighting.shadow_alpha = regs.lighting.config0.shadow_alpha != 0;
+        state.lighting.shadow_selector = regs.lighting.config0.shadow_selector;
+    }
+
+    if (True(groups & FSConfigGroup::ProcTex)) {
+        std::memset(&state.proctex, 0, sizeof(state.proctex));
+        state.proctex.enable = regs.texturing.main_config.texture3_enable;
+        if (state.proctex.enable) {
+            state.proctex.coord = regs.texturing.main_config.texture3_coordinates;
+            state.proctex.u_clamp = regs.texturing.proctex.u_clamp;
+            state.proctex.v_clamp = regs.texturing.proctex.v_clamp;
+            state.proctex.color_combiner = regs.texturing.proctex.color_combiner;
+            state.proctex.alpha_combiner = regs.texturing.proctex.alpha_combiner;
+            state.proctex.separate_alpha = regs.texturing.proctex.separate_alpha;
+            state.proctex.noise_enable = regs.texturing.proctex.noise_enable;
+            state.proctex.u_shift = regs.texturing.proctex.u_shift;
+            state.proctex.v_shift = regs.texturing.proctex.v_shift;
+            state.proctex.lut_width = regs.texturing.proctex_lut.width;
+            state.proctex.lut_offset0 = regs.texturing.proctex_lut_offset.level0;
+            state.proctex.lut_offset1 = regs.texturing.proctex_lut_offset.level1;
+            state.proctex.lut_offset2 = regs.texturing.proctex_lut_offset.level2;
+            state.proctex.lut_offset3 = regs.texturing.proctex_lut_offset.level3;
+            state.proctex.lod_min = regs.texturing.proctex_lut.lod_min;
+            state.proctex.lod_max = regs.texturing.proctex_lut.lod_max;
+            state.proctex.lut_filter = regs.texturing.proctex_lut.filter;
+        }
+    }
 }
 
 void PicaShaderConfigCommon::Init(const Pica::ShaderRegs& regs, Pica::Shader::ShaderSetup& setup) {
@@ -1541,6 +1554,294 @@ do {
     return {std::move(out)};
 }
 
+bool IsFragmentUberShaderCompatible(const PicaFSConfig& config) {
+    const auto& state = config.state;
+    if (state.lighting.enable || state.proctex.enable || state.shadow_rendering) {
+        return false;
+    }
+    if (state.fog_mode == TexturingRegs::FogMode::Gas) {
+        return false;
+    }
+    switch (state.texture0_type) {
+    case TexturingRegs::TextureConfig::Texture2D:
+    case TexturingRegs::TextureConfig::Projection2D:
+    case TexturingRegs::TextureConfig::TextureCube:
+    case TexturingRegs::TextureConfig::Disabled:
+        break;
+    default:
+        return false;
+    }
+    // Logic ops are emulated in the shader on GLES
+    if (GLES && !state.alphablend_enable && state.logic_op != FramebufferRegs::LogicOp::Copy &&
+        state.logic_op != FramebufferRegs::LogicOp::NoOp) {
+        return false;
+    }
+    return true;
+}
+
+ShaderDecompiler::ProgramResult GenerateFragmentUberShader(bool separable_shader) {
+    std::string out;
+
+    if (separable_shader && !GLES) {
+        out += "#extension GL_ARB_separate_shader_objects : enable\n";
+    }
+
+    if (GLES) {
+        out += fragment_shader_precision_OES;
+    }
+
+    out += GetVertexInterfaceDeclaration(false, separable_shader);
+
+    out += R"(
+#ifndef CITRA_GLES
+in vec4 gl_FragCoord;
+#endif // CITRA_GLES
+
+out vec4 color;
+
+uniform sampler2D tex0;
+uniform sampler2D tex1;
+uniform sampler2D tex2;
+uniform samplerCube tex_cube;
+uniform samplerBuffer texture_buffer_lut_lf;
+
+// x: sources, y: modifiers, z: operations, w: scales
+uniform uvec4 uber_tev_stages[6];
+uniform uint uber_combiner_buffer_input;
+uniform int uber_alpha_test_func;
+uniform int uber_scissor_mode;
+uniform int uber_texture0_type;
+uniform bool uber_texture2_use_coord1;
+uniform bool uber_fog_enable;
+uniform bool uber_fog_flip;
+uniform bool uber_w_buffering;
+)";
+
+    out += UniformBlockDef;
+
+    out += R"(
+vec4 rounded_primary_color;
+vec4 tex_color[3];
+vec4 combiner_buffer;
+vec4 last_tex_env_out;
+
+float byteround(float x) {
+    return round(x * 255.0) * (1.0 / 255.0);
+}
+
+vec3 byteround(vec3 x) {
+    return round(x * 255.0) * (1.0 / 255.0);
+}
+
+vec4 byteround(vec4 x) {
+    return round(x * 255.0) * (1.0 / 255.0);
+}
+
+float getLod(vec2 coord) {
+    vec2 d = max(abs(dFdx(coord)), abs(dFdy(coord)));
+    return log2(max(d.x, d.y));
+}
+
+vec4 SampleTexture0() {
+    switch (uber_texture0_type) {
+    case 0:
+        return textureLod(tex0, texcoord0, getLod(texcoord0 * vec2(textureSize(tex0, 0))));
+    case 1:
+        return texture(tex_cube, vec3(texcoord0, texcoord0_w));
+    case 3:
+        return textureProj(tex0, vec3(texcoord0, texcoord0_w));
+    }
+    return vec4(0.0);
+}
+
+vec4 GetSource(uint source, int stage) {
+    switch (source) {
+    case 0u:
+        return rounded_primary_color;
+    case 3u:
+        return tex_color[0];
+    case 4u:
+        return tex_color[1];
+    case 5u:
+        return tex_color[2];
+    case 13u:
+        return combiner_buffer;
+    case 14u:
+        return const_color[stage];
+    case 15u:
+        return last_tex_env_out;
+    }
+    // Fragment lighting and procedural textures are never enabled with this shader
+    return vec4(0.0);
+}
+
+vec3 ColorModifier(uint modifier, vec4 value) {
+    switch (modifier) {
+    case 0u: return value.rgb;
+    case 1u: return vec3(1.0) - value.rgb;
+    case 2u: return value.aaa;
+    case 3u: return vec3(1.0) - value.aaa;
+    case 4u: return value.rrr;
+    case 5u: return vec3(1.0) - value.rrr;
+    case 8u: return value.ggg;
+    case 9u: return vec3(1.0) - value.ggg;
+    case 12u: return value.bbb;
+    case 13u: return vec3(1.0) - value.bbb;
+    }
+    return vec3(0.0);
+}
+
+float AlphaModifier(uint modifier, vec4 value) {
+    switch (modifier) {
+    case 0u: return value.a;
+    case 1u: return 1.0 - value.a;
+    case 2u: return value.r;
+    case 3u: return 1.0 - value.r;
+    case 4u: return value.g;
+    case 5u: return 1.0 - value.g;
+    case 6u: return value.b;
+    case 7u: return 1.0 - value.b;
+    }
+    return 0.0;
+}
+
+vec3 ColorCombine(uint op, vec3 i[3]) {
+    switch (op) {
+    case 0u: return clamp(i[0], vec3(0.0), vec3(1.0));
+    case 1u: return clamp(i[0] * i[1], vec3(0.0), vec3(1.0));
+    case 2u: return clamp(i[0] + i[1], vec3(0.0), vec3(1.0));
+    case 3u: return clamp(i[0] + i[1] - vec3(0.5), vec3(0.0), vec3(1.0));
+    case 4u: return clamp(i[0] * i[2] + i[1] * (vec3(1.0) - i[2]), vec3(0.0), vec3(1.0));
+    case 5u: return clamp(i[0] - i[1], vec3(0.0), vec3(1.0));
+    case 6u:
+    case 7u: return clamp(vec3(dot(i[0] - vec3(0.5), i[1] - vec3(0.5)) * 4.0), vec3(0.0), vec3(1.0));
+    case 8u: return clamp(i[0] * i[1] + i[2], vec3(0.0), vec3(1.0));
+    case 9u: return clamp(min(i[0] + i[1], vec3(1.0)) * i[2], vec3(0.0), vec3(1.0));
+    }
+    return vec3(0.0);
+}
+
+float AlphaCombine(uint op, float i[3]) {
+    switch (op) {
+    case 0u: return clamp(i[0], 0.0, 1.0);
+    case 1u: return clamp(i[0] * i[1], 0.0, 1.0);
+    case 2u: return clamp(i[0] + i[1], 0.0, 1.0);
+    case 3u: return clamp(i[0] + i[1] - 0.5, 0.0, 1.0);
+    case 4u: return clamp(i[0] * i[2] + i[1] * (1.0 - i[2]), 0.0, 1.0);
+    case 5u: return clamp(i[0] - i[1], 0.0, 1.0);
+    case 8u: return clamp(i[0] * i[1] + i[2], 0.0, 1.0);
+    case 9u: return clamp(min(i[0] + i[1], 1.0) * i[2], 0.0, 1.0);
+    }
+    return 0.0;
+}
+
+float TevMultiplier(uint scale) {
+    return scale < 3u ? float(1u << scale) : 1.0;
+}
+
+bool AlphaTestFails(int alpha) {
+    switch (uber_alpha_test_func) {
+    case 0: return true;
+    case 2: return alpha != alphatest_ref;
+    case 3: return alpha == alphatest_ref;
+    case 4: return alpha >= alphatest_ref;
+    case 5: return alpha > alphatest_ref;
+    case 6: return alpha <= alphatest_ref;
+    case 7: return alpha < alphatest_ref;
+    }
+    return false;
+}
+
+void main() {
+rounded_primary_color = byteround(primary_color);
+
+if (uber_alpha_test_func == 0) {
+    discard;
+}
+
+if (uber_scissor_mode != 0) {
+    bool inside = gl_FragCoord.x >= float(scissor_x1) && gl_FragCoord.y >= float(scissor_y1) &&
+                  gl_FragCoord.x < float(scissor_x2) && gl_FragCoord.y < float(scissor_y2);
+    // Mode 3 keeps the pixels inside the scissor box, mode 1 the ones outside
+    if ((uber_scissor_mode == 3) != inside) {
+        discard;
+    }
+}
+
+float z_over_w = 2.0 * gl_FragCoord.z - 1.0;
+float depth = z_over_w * depth_scale + depth_offset;
+if (uber_w_buffering) {
+    depth /= gl_FragCoord.w;
+}
+
+tex_color[0] = SampleTexture0();
+tex_color[1] = textureLod(tex1, texcoord1, getLod(texcoord1 * vec2(textureSize(tex1, 0))));
+vec2 tex2_coord = uber_texture2_use_coord1 ? texcoord1 : texcoord2;
+tex_color[2] = textureLod(tex2, tex2_coord, getLod(tex2_coord * vec2(textureSize(tex2, 0))));
+
+combiner_buffer = vec4(0.0);
+vec4 next_combiner_buffer = tev_combiner_buffer_color;
+last_tex_env_out = vec4(0.0);
+
+for (int i = 0; i < 6; ++i) {
+    uvec4 stage = uber_tev_stages[i];
+    uint color_op = stage.z & 0xFu;
+    uint alpha_op = (stage.z >> 16) & 0xFu;
+
+    vec3 color_results[3] = vec3[3](
+        ColorModifier(stage.y & 0xFu, GetSource(stage.x & 0xFu, i)),
+        ColorModifier((stage.y >> 4) & 0xFu, GetSource((stage.x >> 4) & 0xFu, i)),
+        ColorModifier((stage.y >> 8) & 0xFu, GetSource((stage.x >> 8) & 0xFu, i)));
+    vec3 color_output = byteround(ColorCombine(color_op, color_results));
+
+    float alpha_output;
+    if (color_op == 7u) {
+        // Dot3_RGBA also places the result in the alpha component
+        alpha_output = color_output[0];
+    } else {
+        float alpha_results[3] = float[3](
+            AlphaModifier((stage.y >> 12) & 0x7u, GetSource((stage.x >> 16) & 0xFu, i)),
+            AlphaModifier((stage.y >> 16) & 0x7u, GetSource((stage.x >> 20) & 0xFu, i)),
+            AlphaModifier((stage.y >> 20) & 0x7u, GetSource((stage.x >> 24) & 0xFu, i)));
+        alpha_output = byteround(AlphaCombine(alpha_op, alpha_results));
+    }
+
+    last_tex_env_out = vec4(
+        clamp(color_output * TevMultiplier(stage.w & 3u), vec3(0.0), vec3(1.0)),
+        clamp(alpha_output * TevMultiplier((stage.w >> 16) & 3u), 0.0, 1.0));
+
+    combiner_buffer = next_combiner_buffer;
+    if (i < 4) {
+        if ((uber_combiner_buffer_input & (1u << uint(i))) != 0u) {
+            next_combiner_buffer.rgb = last_tex_env_out.rgb;
+        }
+        if (((uber_combiner_buffer_input >> 4) & (1u << uint(i))) != 0u) {
+            next_combiner_buffer.a = last_tex_env_out.a;
+        }
+    }
+}
+
+if (AlphaTestFails(int(last_tex_env_out.a * 255.0))) {
+    discard;
+}
+
+if (uber_fog_enable) {
+    float fog_index = uber_fog_flip ? (1.0 - depth) * 128.0 : depth * 128.0;
+    float fog_i = clamp(floor(fog_index), 0.0, 127.0);
+    float fog_f = fog_index - fog_i;
+    vec2 fog_lut_entry = texelFetch(texture_buffer_lut_lf, int(fog_i) + fog_lut_offset).rg;
+    float fog_factor = clamp(fog_lut_entry.r + fog_lut_entry.g * fog_f, 0.0, 1.0);
+    last_tex_env_out.rgb = mix(fog_color.rgb, last_tex_env_out.rgb, fog_factor);
+}
+
+gl_FragDepth = depth;
+color = byteround(last_tex_env_out);
+}
+)";
+
+    return {std::move(out)};
+}
+
 ShaderDecompiler::ProgramResult GenerateTrivialVertexShader(bool separable_shader) {
     std::string out;
     if (separable_shader && !GLES) {
@@ -132,6 +132,9 @@ struct PicaFSConfig : Common::HashableStruct<PicaFSConfigState> {
     /// Construct a PicaFSConfig with the given Pica register configuration.
     static PicaFSConfig BuildFromRegs(const Pica::Regs& regs);
 
+    /// Rebuilds the parts of the configuration that depend on the given register groups.
+    void UpdateFromRegs(const Pica::Regs& regs, Pica::FSConfigGroup groups);
+
     bool TevStageUpdatesCombinerBufferColor(unsigned stage_index) const {
         return (stage_index < 4) && (state.combiner_buffer_input & (1 << stage_index));
     }
@@ -229,6 +232,21 @@ ShaderDecompiler::ProgramResult GenerateFixedGeometryShader(const PicaFixedGSCon
 ShaderDecompiler::ProgramResult GenerateFragmentShader(const PicaFSConfig& config,
                                                        bool separable_shader);
 
+/**
+ * Returns true if the generic fragment shader can stand in for the specialized shader of the
+ * given configuration while the latter is being compiled
+ */
+bool IsFragmentUberShaderCompatible(const PicaFSConfig& config);
+
+/**
+ * Generates the GLSL source of a generic fragment shader that reads the TEV configuration from
+ * uniforms instead of baking it into the code. It covers texturing, the TEV combiners, alpha test,
+ * scissor and fog but not fragment lighting, procedural textures or shadows.
+ * @param separable_shader generates shader that can be used for separate shader object
+ * @returns String of the shader source code
+ */
+ShaderDecompiler::ProgramResult GenerateFragmentUberShader(bool separable_shader);
+
 } // namespace OpenGL
 
 namespace std {
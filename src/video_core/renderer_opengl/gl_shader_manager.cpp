@@ -3,10 +3,17 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <set>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
+#include "common/settings.h"
+#include "core/frontend/emu_window.h"
 #include "video_core/renderer_opengl/gl_driver.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
 #include "video_core/renderer_opengl/gl_shader_disk_cache.h"
@@ -107,26 +114,24 @@ static void SetShaderUniformBlockBindings(GLuint shader) {
                                  sizeof(Pica::Shader::VSUniformData));
 }
 
+// The bindings are set with glProgramUniform so that programs can be set up without binding them,
+// which allows doing so from the shader compilation worker threads.
 static void SetShaderSamplerBinding(GLuint shader, const char* name,
                                     TextureUnits::TextureUnit binding) {
     GLint uniform_tex = glGetUniformLocation(shader, name);
     if (uniform_tex != -1) {
-        glUniform1i(uniform_tex, binding.id);
+        glProgramUniform1i(shader, uniform_tex, binding.id);
     }
 }
 
 static void SetShaderImageBinding(GLuint shader, const char* name, GLuint binding) {
     GLint uniform_tex = glGetUniformLocation(shader, name);
     if (uniform_tex != -1) {
-        glUniform1i(uniform_tex, static_cast<GLint>(binding));
+        glProgramUniform1i(shader, uniform_tex, static_cast<GLint>(binding));
     }
 }
 
 static void SetShaderSamplerBindings(GLuint shader) {
-    OpenGLState cur_state = OpenGLState::GetCurState();
-    GLuint old_program = std::exchange(cur_state.draw.shader_program, shader);
-    cur_state.Apply();
-
     // Set the texture samplers to correspond to different texture units
     SetShaderSamplerBinding(shader, "tex0", TextureUnits::PicaTexture(0));
     SetShaderSamplerBinding(shader, "tex1", TextureUnits::PicaTexture(1));
@@ -145,9 +150,6 @@ static void SetShaderSamplerBindings(GLuint shader) {
     SetShaderImageBinding(shader, "shadow_texture_ny", ImageUnits::ShadowTextureNY);
     SetShaderImageBinding(shader, "shadow_texture_pz", ImageUnits::ShadowTexturePZ);
     SetShaderImageBinding(shader, "shadow_texture_nz", ImageUnits::ShadowTextureNZ);
-
-    cur_state.draw.shader_program = old_program;
-    cur_state.Apply();
 }
 
 /**
@@ -229,6 +231,12 @@ public:
         return {cached_shader.GetHandle(), std::move(result)};
     }
 
+    /// Returns the handle of the shader for the config, or 0 if it was not built yet
+    GLuint TryGet(const KeyConfigType& config) const {
+        const auto iter = shaders.find(config);
+        return iter != shaders.end() ? iter->second.GetHandle() : 0;
+    }
+
     void Inject(const KeyConfigType& key, OGLProgram&& program) {
         OGLShaderStage stage{separable};
         stage.Inject(std::move(program));
@@ -314,14 +322,210 @@ using FixedGeometryShaders =
 
 using FragmentShaders = ShaderCache<PicaFSConfig, &GenerateFragmentShader, GL_FRAGMENT_SHADER>;
 
+/**
+ * Compiles fragment shaders on worker threads that own shared graphics contexts, so that draws
+ * using a configuration for the first time do not have to wait for the driver.
+ */
+class AsyncFragmentShaderCompiler {
+public:
+    struct Result {
+        PicaFSConfig config;
+        ShaderDiskCacheRaw raw;
+        ShaderDecompiler::ProgramResult program;
+        OGLShaderStage stage;
+    };
+
+    explicit AsyncFragmentShaderCompiler(Frontend::EmuWindow& emu_window, bool separable)
+        : separable{separable} {
+        const std::size_t num_workers =
+            std::clamp<std::size_t>(std::thread::hardware_concurrency() / 4, 1, 4);
+
+        emu_window.SaveContext();
+        for (std::size_t i = 0; i < num_workers; ++i) {
+            // On some platforms the shared context has to be created from the GUI thread
+            auto& context = contexts.emplace_back(emu_window.CreateSharedContext());
+            // Release the context, so it can be immediately used by the spawned thread
+            context->DoneCurrent();
+            workers.emplace_back(&AsyncFragmentShaderCompiler::WorkerLoop, this, context.get());
+        }
+        emu_window.RestoreContext();
+    }
+
+    ~AsyncFragmentShaderCompiler() {
+        {
+            std::scoped_lock lock{queue_mutex};
+            stop_workers = true;
+        }
+        queue_cv.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    /// Queues the configuration for compilation unless it was already queued
+    void Queue(const PicaFSConfig& config, const Pica::Regs& regs) {
+        {
+            std::scoped_lock lock{queue_mutex};
+            if (!queued.insert(config).second) {
+                return;
+            }
+            const u64 unique_identifier = GetUniqueIdentifier(regs, {});
+            pending.push_back(
+                Job{config, ShaderDiskCacheRaw{unique_identifier, ProgramType::FS, regs, {}}});
+        }
+        queue_cv.notify_one();
+    }
+
+    /// Returns the shaders that finished compiling since the last call
+    std::vector<Result> TakeCompleted() {
+        if (num_completed.load(std::memory_order_acquire) == 0) {
+            return {};
+        }
+        std::scoped_lock lock{completed_mutex};
+        num_completed.store(0, std::memory_order_relaxed);
+        return std::exchange(completed, {});
+    }
+
+private:
+    struct Job {
+        PicaFSConfig config;
+        ShaderDiskCacheRaw raw;
+    };
+
+    void WorkerLoop(Frontend::GraphicsContext* context) {
+        const auto scope = context->Acquire();
+        while (true) {
+            Job job;
+            {
+                std::unique_lock lock{queue_mutex};
+                queue_cv.wait(lock, [this] { return stop_workers || !pending.empty(); });
+                if (stop_workers) {
+                    return;
+                }
+                job = std::move(pending.front());
+                pending.pop_front();
+            }
+
+            auto program = GenerateFragmentShader(job.config, separable);
+            OGLShaderStage stage{separable};
+            stage.Create(program.code.c_str(), GL_FRAGMENT_SHADER);
+
+            // Make sure the driver finished building the shader before it is used from the
+            // rendering context
+            glFinish();
+
+            std::scoped_lock lock{completed_mutex};
+            completed.push_back(Result{job.config, std::move(job.raw), std::move(program),
+                                       std::move(stage)});
+            num_completed.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    bool separable;
+    std::vector<std::unique_ptr<Frontend::GraphicsContext>> contexts;
+    std::vector<std::thread> workers;
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<Job> pending;
+    std::unordered_set<PicaFSConfig> queued;
+    bool stop_workers = false;
+
+    std::mutex completed_mutex;
+    std::vector<Result> completed;
+    std::atomic<std::size_t> num_completed{0};
+};
+
+/// Uniform locations of the fragment ubershader in a program
+struct UberShaderUniforms {
+    explicit UberShaderUniforms(GLuint program)
+        : tev_stages{glGetUniformLocation(program, "uber_tev_stages")},
+          combiner_buffer_input{glGetUniformLocation(program, "uber_combiner_buffer_input")},
+          alpha_test_func{glGetUniformLocation(program, "uber_alpha_test_func")},
+          scissor_mode{glGetUniformLocation(program, "uber_scissor_mode")},
+          texture0_type{glGetUniformLocation(program, "uber_texture0_type")},
+          texture2_use_coord1{glGetUniformLocation(program, "uber_texture2_use_coord1")},
+          fog_enable{glGetUniformLocation(program, "uber_fog_enable")},
+          fog_flip{glGetUniformLocation(program, "uber_fog_flip")},
+          w_buffering{glGetUniformLocation(program, "uber_w_buffering")} {}
+
+    GLint tev_stages;
+    GLint combiner_buffer_input;
+    GLint alpha_test_func;
+    GLint scissor_mode;
+    GLint texture0_type;
+    GLint texture2_use_coord1;
+    GLint fog_enable;
+    GLint fog_flip;
+    GLint w_buffering;
+
+    std::size_t config_hash = 0;
+};
+
+/// Hash used in place of the fragment shader config hash when the ubershader is bound
+constexpr std::size_t UBERSHADER_HASH = ~std::size_t{0};
+
 class ShaderProgramManager::Impl {
 public:
-    explicit Impl(bool separable)
+    explicit Impl(Frontend::EmuWindow& emu_window, bool separable)
         : separable(separable), programmable_vertex_shaders(separable),
           trivial_vertex_shader(separable), fixed_geometry_shaders(separable),
-          fragment_shaders(separable), disk_cache(separable) {
+          fragment_shaders(separable), fragment_ubershader(separable), disk_cache(separable) {
         if (separable)
             pipeline.Create();
+
+        if (Settings::values.async_shader_compilation) {
+            fragment_ubershader.Create(GenerateFragmentUberShader(separable).code.c_str(),
+                                       GL_FRAGMENT_SHADER);
+            async_compiler = std::make_unique<AsyncFragmentShaderCompiler>(emu_window, separable);
+        }
+    }
+
+    /**
+     * Moves the fragment shaders that finished compiling in the background into the cache
+     * @returns true if any shader was added to the cache
+     */
+    bool CollectAsyncShaders() {
+        auto completed = async_compiler->TakeCompleted();
+        for (auto& result : completed) {
+            fragment_shaders.Inject(result.config, std::move(result.stage));
+            disk_cache.SaveRaw(result.raw);
+            disk_cache.SaveDecompiled(result.raw.GetUniqueIdentifier(), result.program, false);
+        }
+        return !completed.empty();
+    }
+
+    /// Uploads the TEV configuration the ubershader stands in for to the given program
+    void SetUberShaderUniforms(GLuint program) {
+        auto [iter, is_new] = ubershader_uniforms.try_emplace(program, program);
+        UberShaderUniforms& uniforms = iter->second;
+        if (!is_new && uniforms.config_hash == fs_config_hash) {
+            return;
+        }
+        uniforms.config_hash = fs_config_hash;
+
+        const auto& state = fs_config.state;
+        std::array<GLuint, 4 * 6> tev_stages;
+        for (std::size_t i = 0; i < state.tev_stages.size(); ++i) {
+            const auto& stage = state.tev_stages[i];
+            tev_stages[i * 4 + 0] = stage.sources_raw;
+            tev_stages[i * 4 + 1] = stage.modifiers_raw;
+            tev_stages[i * 4 + 2] = stage.ops_raw;
+            tev_stages[i * 4 + 3] = stage.scales_raw;
+        }
+        glProgramUniform4uiv(program, uniforms.tev_stages, 6, tev_stages.data());
+        glProgramUniform1ui(program, uniforms.combiner_buffer_input, state.combiner_buffer_input);
+        glProgramUniform1i(program, uniforms.alpha_test_func,
+                           static_cast<GLint>(state.alpha_test_func));
+        glProgramUniform1i(program, uniforms.scissor_mode,
+                           static_cast<GLint>(state.scissor_test_mode));
+        glProgramUniform1i(program, uniforms.texture0_type, static_cast<GLint>(state.texture0_type));
+        glProgramUniform1i(program, uniforms.texture2_use_coord1, state.texture2_use_coord1);
+        glProgramUniform1i(program, uniforms.fog_enable,
+                           state.fog_mode == Pica::TexturingRegs::FogMode::Fog);
+        glProgramUniform1i(program, uniforms.fog_flip, state.fog_flip);
+        glProgramUniform1i(program, uniforms.w_buffering,
+                           state.depthmap_enable == Pica::RasterizerRegs::DepthBuffering::WBuffering);
     }
 
     struct ShaderTuple {
@@ -363,11 +567,21 @@ public:
     std::unordered_map<u64, OGLProgram> program_cache;
     OGLPipeline pipeline;
     ShaderDiskCache disk_cache;
+
+    /// Fragment shader configuration of the last draw, updated from the dirty register groups
+    PicaFSConfig fs_config{};
+    std::size_t fs_config_hash = 0;
+
+    OGLShaderStage fragment_ubershader;
+    bool using_ubershader = false;
+    std::unordered_map<GLuint, UberShaderUniforms> ubershader_uniforms;
+    std::unique_ptr<AsyncFragmentShaderCompiler> async_compiler;
 };
 
 ShaderProgramManager::ShaderProgramManager(Frontend::EmuWindow& emu_window_, const Driver& driver_,
                                            bool separable)
-    : impl(std::make_unique<Impl>(separable)), emu_window{emu_window_}, driver{driver_} {}
+    : impl(std::make_unique<Impl>(emu_window_, separable)), emu_window{emu_window_},
+      driver{driver_} {}
 
 ShaderProgramManager::~ShaderProgramManager() = default;
 
@@ -412,11 +626,40 @@ void ShaderProgramManager::UseTrivialGeometryShader() {
     impl->current.gs_hash = 0;
 }
 
-void ShaderProgramManager::UseFragmentShader(const Pica::Regs& regs) {
-    PicaFSConfig config = PicaFSConfig::BuildFromRegs(regs);
+void ShaderProgramManager::UseFragmentShader(const Pica::Regs& regs, Pica::FSConfigGroup dirty) {
+    PicaFSConfig& config = impl->fs_config;
+    bool changed = impl->current.fs == 0;
+    if (dirty != Pica::FSConfigGroup::None) {
+        const PicaFSConfig previous = config;
+        config.UpdateFromRegs(regs, dirty);
+        changed |= config != previous;
+    }
+
+    // Keep the bound shader unless the configuration changed or the specialized shader that the
+    // ubershader stands in for finished compiling
+    const bool collected = impl->async_compiler && impl->CollectAsyncShaders();
+    if (!changed && !(impl->using_ubershader && collected)) {
+        return;
+    }
+    if (changed) {
+        impl->fs_config_hash = config.Hash();
+    }
+    impl->using_ubershader = false;
+
+    // Draw with the ubershader while the specialized shader is compiled in the background
+    if (impl->async_compiler) {
+        if (impl->fragment_shaders.TryGet(config) == 0 && IsFragmentUberShaderCompatible(config)) {
+            impl->async_compiler->Queue(config, regs);
+            impl->current.fs = impl->fragment_ubershader.GetHandle();
+            impl->current.fs_hash = UBERSHADER_HASH;
+            impl->using_ubershader = true;
+            return;
+        }
+    }
+
     auto [handle, result] = impl->fragment_shaders.Get(config);
     impl->current.fs = handle;
-    impl->current.fs_hash = config.Hash();
+    impl->current.fs_hash = impl->fs_config_hash;
     // Save FS to the disk cache if its a new shader
     if (result) {
         auto& disk_cache = impl->disk_cache;
@@ -440,19 +683,30 @@ void ShaderProgramManager::ApplyTo(OpenGLState& state) {
         glUseProgramStages(impl->pipeline.handle, GL_FRAGMENT_SHADER_BIT, impl->current.fs);
         state.draw.shader_program = 0;
         state.draw.program_pipeline = impl->pipeline.handle;
+
+        if (impl->using_ubershader) {
+            impl->SetUberShaderUniforms(impl->current.fs);
+        }
     } else {
         const u64 unique_identifier = impl->current.GetConfigHash();
         OGLProgram& cached_program = impl->program_cache[unique_identifier];
         if (cached_program.handle == 0) {
             cached_program.Create(false, {impl->current.vs, impl->current.gs, impl->current.fs});
-            auto& disk_cache = impl->disk_cache;
-            disk_cache.SaveDumpToFile(unique_identifier, cached_program.handle,
-                                      VideoCore::g_hw_shader_accurate_mul);
+            // Programs linked against the ubershader are temporary, do not persist them
+            if (!impl->using_ubershader) {
+                auto& disk_cache = impl->disk_cache;
+                disk_cache.SaveDumpToFile(unique_identifier, cached_program.handle,
+                                          VideoCore::g_hw_shader_accurate_mul);
+            }
 
             SetShaderUniformBlockBindings(cached_program.handle);
             SetShaderSamplerBindings(cached_program.handle);
         }
         state.draw.shader_program = cached_program.handle;
+
+        if (impl->using_ubershader) {
+            impl->SetUberShaderUniforms(cached_program.handle);
+        }
     }
 }
 
@@ -13,6 +13,7 @@ class EmuWindow;
 
 namespace Pica {
 struct Regs;
+enum class FSConfigGroup : u32;
 }
 
 namespace Pica::Shader {
@@ -41,7 +42,8 @@ public:
 
     void UseTrivialGeometryShader();
 
-    void UseFragmentShader(const Pica::Regs& config);
+    /// Binds the fragment shader, rebuilding only the parts of its configuration that are dirty
+    void UseFragmentShader(const Pica::Regs& config, Pica::FSConfigGroup dirty);
 
     void ApplyTo(OpenGLState& state);
 
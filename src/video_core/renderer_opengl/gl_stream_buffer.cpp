@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <utility>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/microprofile.h"
@@ -10,6 +11,8 @@
 
 MICROPROFILE_DEFINE(OpenGL_StreamBuffer, "OpenGL", "Stream Buffer Orphaning",
                     MP_RGB(128, 128, 192));
+MICROPROFILE_DEFINE(OpenGL_StreamBufferWait, "OpenGL", "Stream Buffer Fence Wait",
+                    MP_RGB(192, 128, 128));
 
 namespace OpenGL {
 
@@ -24,12 +27,17 @@ OGLStreamBuffer::OGLStreamBuffer(Driver& driver, GLenum target, GLsizeiptr size,
         allocate_size *= 2;
     }
 
-    if (GLAD_GL_ARB_buffer_storage) {
+    // GLES gets persistent buffers from EXT_buffer_storage, which has the same flag values
+    if (driver.HasArbBufferStorage() || driver.HasExtBufferStorage()) {
         persistent = true;
         coherent = prefer_coherent;
         GLbitfield flags =
             GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | (coherent ? GL_MAP_COHERENT_BIT : 0);
-        glBufferStorage(gl_target, allocate_size, nullptr, flags);
+        if (driver.HasArbBufferStorage()) {
+            glBufferStorage(gl_target, allocate_size, nullptr, flags);
+        } else {
+            glBufferStorageEXT(gl_target, allocate_size, nullptr, flags);
+        }
         mapped_ptr = static_cast<u8*>(glMapBufferRange(
             gl_target, 0, buffer_size, flags | (coherent ? 0 : GL_MAP_FLUSH_EXPLICIT_BIT)));
     } else {
@@ -38,6 +46,11 @@ OGLStreamBuffer::OGLStreamBuffer(Driver& driver, GLenum target, GLsizeiptr size,
 }
 
 OGLStreamBuffer::~OGLStreamBuffer() {
+    for (GLsync fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
     if (persistent) {
         glBindBuffer(gl_target, gl_buffer.handle);
         glUnmapBuffer(gl_target);
@@ -64,18 +77,25 @@ std::tuple<u8*, GLintptr, bool> OGLStreamBuffer::Map(GLsizeiptr size, GLintptr a
 
     bool invalidate = false;
     if (buffer_pos + size > buffer_size) {
-        buffer_pos = 0;
-        invalidate = true;
-
         if (persistent) {
-            glUnmapBuffer(gl_target);
+            FenceRegions(fenced_regions, NUM_SYNCS);
+            fenced_regions = 0;
         }
+        buffer_pos = 0;
+        invalidate = true;
     }
 
-    if (invalidate || !persistent) {
+    if (persistent) {
+        // The chunks before the new one were used by commands that were already issued, so
+        // fence them. The new chunk has to wait for the commands of the previous lap instead
+        const std::size_t begin_region = GetRegion(buffer_pos);
+        FenceRegions(fenced_regions, begin_region);
+        fenced_regions = begin_region;
+        WaitRegions(begin_region, GetRegion(buffer_pos + size - 1));
+        mapped_offset = 0;
+    } else {
         MICROPROFILE_SCOPE(OpenGL_StreamBuffer);
-        GLbitfield flags = GL_MAP_WRITE_BIT | (persistent ? GL_MAP_PERSISTENT_BIT : 0) |
-                           (coherent ? GL_MAP_COHERENT_BIT : GL_MAP_FLUSH_EXPLICIT_BIT) |
+        GLbitfield flags = GL_MAP_WRITE_BIT | (coherent ? 0 : GL_MAP_FLUSH_EXPLICIT_BIT) |
                            (invalidate ? GL_MAP_INVALIDATE_BUFFER_BIT : GL_MAP_UNSYNCHRONIZED_BIT);
         mapped_ptr = static_cast<u8*>(
             glMapBufferRange(gl_target, buffer_pos, buffer_size - buffer_pos, flags));
@@ -97,6 +117,38 @@ void OGLStreamBuffer::Unmap(GLsizeiptr size) {
     }
 
     buffer_pos += size;
+    uploaded_bytes += size;
+}
+
+u64 OGLStreamBuffer::GetAndResetUploadedBytes() {
+    return std::exchange(uploaded_bytes, 0);
+}
+
+std::size_t OGLStreamBuffer::GetRegion(GLintptr offset) const {
+    return std::min<std::size_t>(offset * NUM_SYNCS / buffer_size, NUM_SYNCS - 1);
+}
+
+void OGLStreamBuffer::FenceRegions(std::size_t begin, std::size_t end) {
+    for (std::size_t region = begin; region < end; ++region) {
+        // Regions that were skipped in this lap may still have the fence of the previous one
+        if (fences[region]) {
+            glDeleteSync(fences[region]);
+        }
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void OGLStreamBuffer::WaitRegions(std::size_t begin, std::size_t end) {
+    for (std::size_t region = begin; region <= end; ++region) {
+        GLsync& fence = fences[region];
+        if (!fence) {
+            continue;
+        }
+        MICROPROFILE_SCOPE(OpenGL_StreamBufferWait);
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
 }
 
 } // namespace OpenGL
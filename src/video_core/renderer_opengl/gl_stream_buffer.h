@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <tuple>
 #include "video_core/renderer_opengl/gl_resource_manager.h"
 
@@ -23,7 +24,7 @@ public:
     /*
      * Allocates a linear chunk of memory in the GPU buffer with at least "size" bytes
      * and the optional alignment requirement.
-     * If the buffer is full, the whole buffer is reallocated which invalidates old chunks.
+     * If the buffer is full, allocation starts over at its beginning which invalidates old chunks.
      * The return values are the pointer to the new chunk, the offset within the buffer,
      * and the invalidation flag for previous chunks.
      * The actual used size must be specified on unmapping the chunk.
@@ -32,18 +33,38 @@ public:
 
     void Unmap(GLsizeiptr size);
 
+    /// Returns the number of bytes written since the last call
+    u64 GetAndResetUploadedBytes();
+
 private:
+    /// Number of regions of a persistent buffer that are guarded by their own fence
+    static constexpr std::size_t NUM_SYNCS = 16;
+
+    /// Returns the region of a persistent buffer that the offset belongs to
+    std::size_t GetRegion(GLintptr offset) const;
+
+    /// Fences the regions in [begin, end) after the commands that read them
+    void FenceRegions(std::size_t begin, std::size_t end);
+
+    /// Waits until the GPU is done reading the regions in [begin, end]
+    void WaitRegions(std::size_t begin, std::size_t end);
+
     OGLBuffer gl_buffer;
     GLenum gl_target;
 
     bool coherent = false;
     bool persistent = false;
 
+    /// Once written, persistent chunks are reused only after the GPU signals their region fence
+    std::array<GLsync, NUM_SYNCS> fences{};
+    std::size_t fenced_regions = 0; ///< Regions before this one were fenced in the current lap
+
     GLintptr buffer_pos = 0;
     GLsizeiptr buffer_size = 0;
     GLintptr mapped_offset = 0;
     GLsizeiptr mapped_size = 0;
     u8* mapped_ptr = nullptr;
+    u64 uploaded_bytes = 0;
 };
 
 } // namespace OpenGL
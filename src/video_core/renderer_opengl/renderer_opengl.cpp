@@ -369,12 +369,12 @@ MICROPROFILE_DEFINE(OpenGL_RenderFrame, "OpenGL", "Render Frame", MP_RGB(128, 12
 MICROPROFILE_DEFINE(OpenGL_WaitPresent, "OpenGL", "Wait For Present", MP_RGB(128, 128, 128));
 
 /// Swap buffers (render frame)
-void RendererOpenGL::SwapBuffers() {
+void RendererOpenGL::SwapBuffers(const VideoCore::FrameInfo& frame) {
     // Maintain the rasterizer's state as a priority
     OpenGLState prev_state = OpenGLState::GetCurState();
     state.Apply();
 
-    PrepareRendertarget();
+    PrepareRendertarget(frame);
     RenderScreenshot();
 
     const auto& main_layout = render_window.GetFramebufferLayout();
@@ -396,7 +396,8 @@ void RendererOpenGL::SwapBuffers() {
         }
     }
 
-    EndFrame();
+    system.perf_stats->AddUploadedBytes(rasterizer->GetAndResetUploadedBytes());
+    EndFrame(frame);
     prev_state.Apply();
 }
 
@@ -433,17 +434,11 @@ void RendererOpenGL::RenderScreenshot() {
     }
 }
 
-void RendererOpenGL::PrepareRendertarget() {
+void RendererOpenGL::PrepareRendertarget(const VideoCore::FrameInfo& frame) {
     for (int i : {0, 1, 2}) {
         int fb_id = i == 2 ? 1 : 0;
-        const auto& framebuffer = GPU::g_regs.framebuffer_config[fb_id];
-
-        // Main LCD (0): 0x1ED02204, Sub LCD (1): 0x1ED02A04
-        u32 lcd_color_addr =
-            (fb_id == 0) ? LCD_REG_INDEX(color_fill_top) : LCD_REG_INDEX(color_fill_bottom);
-        lcd_color_addr = HW::VADDR_LCD + 4 * lcd_color_addr;
-        LCD::Regs::ColorFill color_fill = {0};
-        LCD::Read(color_fill.raw, lcd_color_addr);
+        const auto& framebuffer = frame.framebuffer_config[fb_id];
+        const LCD::Regs::ColorFill color_fill = frame.color_fill[fb_id];
 
         if (color_fill.is_enabled) {
             LoadColorToActiveGLTexture(color_fill.color_r, color_fill.color_g, color_fill.color_b,
@@ -64,7 +64,7 @@ public:
         return rasterizer.get();
     }
 
-    void SwapBuffers() override;
+    void SwapBuffers(const VideoCore::FrameInfo& frame) override;
     void TryPresent(int timeout_ms, bool is_secondary) override;
     void PrepareVideoDumping() override;
     void CleanupVideoDumping() override;
@@ -74,7 +74,7 @@ private:
     void InitOpenGLObjects();
     void ReloadSampler();
     void ReloadShader();
-    void PrepareRendertarget();
+    void PrepareRendertarget(const VideoCore::FrameInfo& frame);
     void RenderScreenshot();
     void RenderToMailbox(const Layout::FramebufferLayout& layout,
                          std::unique_ptr<Frontend::TextureMailbox>& mailbox, bool flipped);
@@ -11,6 +11,7 @@
 #include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/math_util.h"
 #include "common/microprofile.h"
 #include "common/quaternion.h"
 #include "common/vector_math.h"
@@ -23,6 +24,7 @@
 #include "video_core/regs_rasterizer.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/renderer_software/rasterizer.h"
+#include "video_core/renderer_software/sw_coverage.h"
 #include "video_core/renderer_software/sw_framebuffer.h"
 #include "video_core/renderer_software/sw_lighting.h"
 #include "video_core/renderer_software/sw_proctex.h"
@@ -119,25 +121,62 @@ static std::tuple<float24, float24, float24, PAddr> ConvertCubeCoord(float24 u,
 
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+static Fix12P4 FloatToFix(float24 flt) {
+    // TODO: Rounding here is necessary to prevent garbage pixels at
+    //       triangle borders. Is it that the correct solution, though?
+    return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
+}
+
+static Common::Vec3<Fix12P4> ScreenToRasterizerCoordinates(const Common::Vec3<float24>& vec) {
+    return Common::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
+}
+
+/**
+ * Calculates the bounding box of the triangle in rasterizer coordinates, clipped to the scissor
+ * box when the scissor test is in Include mode. The minimum is rounded down and the maximum is
+ * rounded up to whole pixels.
+ */
+static Common::Rectangle<u16> GetBoundingBox(const Common::Vec3<Fix12P4> (&vtxpos)[3]) {
+    const auto& regs = g_state.regs;
+
+    u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
+    u16 min_y = std::min({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+    u16 max_x = std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
+    u16 max_y = std::max({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+
+    if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Include) {
+        // Convert the scissor box coordinates to 12.4 fixed point
+        u16 scissor_x1 = (u16)(regs.rasterizer.scissor_test.x1 << 4);
+        u16 scissor_y1 = (u16)(regs.rasterizer.scissor_test.y1 << 4);
+        // x2,y2 have +1 added to cover the entire sub-pixel area
+        u16 scissor_x2 = (u16)((regs.rasterizer.scissor_test.x2 + 1) << 4);
+        u16 scissor_y2 = (u16)((regs.rasterizer.scissor_test.y2 + 1) << 4);
+
+        // Calculate the new bounds
+        min_x = std::max(min_x, scissor_x1);
+        min_y = std::max(min_y, scissor_y1);
+        max_x = std::min(max_x, scissor_x2);
+        max_y = std::min(max_y, scissor_y2);
+    }
+
+    min_x &= Fix12P4::IntMask();
+    min_y &= Fix12P4::IntMask();
+    max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
+    max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
+
+    return {min_x, min_y, max_x, max_y};
+}
+
 /**
  * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
  * culling via recursion.
  */
 static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Vertex& v2,
-                                    bool reversed = false) {
+                                    const Common::Rectangle<u32>& region, bool reversed = false) {
     const auto& regs = g_state.regs;
     MICROPROFILE_SCOPE(GPU_Rasterization);
 
     // vertex positions in rasterizer coordinates
-    static auto FloatToFix = [](float24 flt) {
-        // TODO: Rounding here is necessary to prevent garbage pixels at
-        //       triangle borders. Is it that the correct solution, though?
-        return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
-    };
-    static auto ScreenToRasterizerCoordinates = [](const Common::Vec3<float24>& vec) {
-        return Common::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
-    };
-
     Common::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(v0.screenpos),
                                     ScreenToRasterizerCoordinates(v1.screenpos),
                                     ScreenToRasterizerCoordinates(v2.screenpos)};
@@ -145,13 +184,13 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     if (regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepAll) {
         // Make sure we always end up with a triangle wound counter-clockwise
         if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, region, true);
             return;
         }
     } else {
         if (!reversed && regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepClockWise) {
             // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, region, true);
             return;
         }
 
@@ -160,10 +199,13 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             return;
     }
 
-    u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
-    u16 min_y = std::min({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
-    u16 max_x = std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
-    u16 max_y = std::max({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+    // Restrict the bounding box to the region being rasterized. The region is aligned to whole
+    // pixels, so this only drops the pixels outside of it.
+    const auto bounds = GetBoundingBox(vtxpos);
+    const u16 min_x = static_cast<u16>(std::max<u32>(bounds.left, region.left << 4));
+    const u16 min_y = static_cast<u16>(std::max<u32>(bounds.top, region.top << 4));
+    const u16 max_x = static_cast<u16>(std::min<u32>(bounds.right, region.right << 4));
+    const u16 max_y = static_cast<u16>(std::min<u32>(bounds.bottom, region.bottom << 4));
 
     // Convert the scissor box coordinates to 12.4 fixed point
     u16 scissor_x1 = (u16)(regs.rasterizer.scissor_test.x1 << 4);
@@ -172,19 +214,6 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     u16 scissor_x2 = (u16)((regs.rasterizer.scissor_test.x2 + 1) << 4);
     u16 scissor_y2 = (u16)((regs.rasterizer.scissor_test.y2 + 1) << 4);
 
-    if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Include) {
-        // Calculate the new bounds
-        min_x = std::max(min_x, scissor_x1);
-        min_y = std::max(min_y, scissor_y1);
-        max_x = std::min(max_x, scissor_x2);
-        max_y = std::min(max_y, scissor_y2);
-    }
-
-    min_x &= Fix12P4::IntMask();
-    min_y &= Fix12P4::IntMask();
-    max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
-    max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
-
     // Triangle filling rules: Pixels on the right-sided edge or on flat bottom edges are not
     // drawn. Pixels on any other triangle border are drawn. This is implemented with three bias
     // values which are added to the barycentric coordinates w0, w1 and w2, respectively.
@@ -220,10 +249,44 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
         g_state.regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
     const auto stencil_test = g_state.regs.framebuffer.output_merger.stencil_test;
 
+    // These do not depend on the pixel, so look them up once per triangle
+    const float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
+    const float depth_offset =
+        float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
+    std::array<Texture::TextureInfo, 3> texture_infos{};
+    for (std::size_t i = 0; i < texture_infos.size(); ++i) {
+        if (textures[i].enabled && textures[i].config.address != 0) {
+            texture_infos[i] =
+                Texture::TextureInfo::FromPicaRegister(textures[i].config, textures[i].format);
+        }
+    }
+
+    // The edge functions are linear in the pixel position, so moving one pixel to the right
+    // changes each of them by a constant amount
+    const std::array<int, 3> edge_step{
+        -16 * (static_cast<int>(vtxpos[2].y) - static_cast<int>(vtxpos[1].y)),
+        -16 * (static_cast<int>(vtxpos[0].y) - static_cast<int>(vtxpos[2].y)),
+        -16 * (static_cast<int>(vtxpos[1].y) - static_cast<int>(vtxpos[0].y)),
+    };
+    const u16 start_x = min_x + 8;
+    const std::size_t row_pixels = max_x > min_x ? (max_x - min_x) >> 4 : 0;
+
     // Enter rasterization loop, starting at the center of the topleft bounding box corner.
-    // TODO: Not sure if looping through x first might be faster
     for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
+        // Calculate the barycentric coordinates w0, w1 and w2 at the start of the row and find
+        // the pixels covered by the current primitive
+        const EdgeSpan edges{
+            {
+                bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {start_x, y}),
+                bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {start_x, y}),
+                bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {start_x, y}),
+            },
+            edge_step,
+        };
+        const auto [span_begin, span_end] = FindCoveredSpan(edges, row_pixels);
+
+        for (std::size_t i = span_begin; i < span_end; ++i) {
+            const u16 x = static_cast<u16>(start_x + (i << 4));
 
             // Do not process the pixel if it's inside the scissor box and the scissor mode is set
             // to Exclude
@@ -232,16 +295,12 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     continue;
             }
 
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
+            const int pixel_index = static_cast<int>(i);
+            int w0 = edges.start[0] + pixel_index * edges.step[0];
+            int w1 = edges.start[1] + pixel_index * edges.step[1];
+            int w2 = edges.start[2] + pixel_index * edges.step[2];
             int wsum = w0 + w1 + w2;
 
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
-                continue;
-
             auto baricentric_coordinates =
                 Common::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
                                 float24::FromFloat32(static_cast<float>(w1)),
@@ -257,9 +316,6 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
 
             // Not fully accurate. About 3 bits in precision are missing.
             // Z-Buffer (z / w * scale + offset)
-            float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
-            float depth_offset =
-                float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
             float depth = interpolated_z_over_w * depth_scale + depth_offset;
 
             // Potentially switch to W-Buffer
@@ -409,11 +465,9 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
 
                     const u8* texture_data =
                         VideoCore::g_memory->GetPhysicalPointer(texture_address);
-                    auto info =
-                        Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
 
                     // TODO: Apply the min and mag filters to the texture
-                    texture_color[i] = Texture::LookupTexture(texture_data, s, t, info);
+                    texture_color[i] = Texture::LookupTexture(texture_data, s, t, texture_infos[i]);
                 }
 
                 if (i == 0 && (texture.config.type == TexturingRegs::TextureConfig::Shadow2D ||
@@ -894,8 +948,17 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     }
 }
 
-void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
-    ProcessTriangleInternal(v0, v1, v2);
+Common::Rectangle<u32> GetTriangleBounds(const Triangle& triangle) {
+    const Common::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(triangle.v0.screenpos),
+                                          ScreenToRasterizerCoordinates(triangle.v1.screenpos),
+                                          ScreenToRasterizerCoordinates(triangle.v2.screenpos)};
+    const auto bounds = GetBoundingBox(vtxpos);
+    return Common::Rectangle<u32>(bounds.left >> 4, bounds.top >> 4, bounds.right >> 4,
+                                  bounds.bottom >> 4);
+}
+
+void ProcessTriangle(const Triangle& triangle, const Common::Rectangle<u32>& region) {
+    ProcessTriangleInternal(triangle.v0, triangle.v1, triangle.v2, region);
 }
 
 } // namespace Pica::Rasterizer
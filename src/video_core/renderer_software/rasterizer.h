@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "common/math_util.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica::Rasterizer {
@@ -39,6 +40,23 @@ struct Vertex : Shader::OutputVertex {
     }
 };
 
-void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+/// A clipped triangle with its screen coordinates computed, ready to be rasterized
+struct Triangle {
+    Vertex v0;
+    Vertex v1;
+    Vertex v2;
+};
+
+/**
+ * Returns the region of the screen, in pixels, that the triangle may cover with the current
+ * rasterizer state. The right and bottom edges are exclusive.
+ */
+Common::Rectangle<u32> GetTriangleBounds(const Triangle& triangle);
+
+/**
+ * Rasterizes the part of the triangle that lies inside the region, in pixels. Pixels outside of
+ * the region are left untouched, which allows splitting the screen among several threads.
+ */
+void ProcessTriangle(const Triangle& triangle, const Common::Rectangle<u32>& region);
 
 } // namespace Pica::Rasterizer
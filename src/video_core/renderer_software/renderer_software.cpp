@@ -12,8 +12,8 @@ RendererSoftware::RendererSoftware(Core::System& system, Frontend::EmuWindow& wi
 
 RendererSoftware::~RendererSoftware() = default;
 
-void RendererSoftware::SwapBuffers() {
-    EndFrame();
+void RendererSoftware::SwapBuffers(const FrameInfo& frame) {
+    EndFrame(frame);
 }
 
 } // namespace VideoCore
@@ -22,7 +22,7 @@ public:
         return rasterizer.get();
     }
 
-    void SwapBuffers() override;
+    void SwapBuffers(const FrameInfo& frame) override;
     void TryPresent(int timeout_ms, bool is_secondary) override {}
     void Sync() override {}
 
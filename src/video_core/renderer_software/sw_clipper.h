@@ -4,16 +4,24 @@
 
 #pragma once
 
+#include <vector>
+
 namespace Pica {
 namespace Shader {
 struct OutputVertex;
 }
 
+namespace Rasterizer {
+struct Triangle;
+}
+
 namespace Clipper {
 
 using Shader::OutputVertex;
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
+/// Clips the triangle against the view volume and appends the resulting triangles to the list
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     std::vector<Rasterizer::Triangle>& triangles);
 
 } // namespace Clipper
 } // namespace Pica
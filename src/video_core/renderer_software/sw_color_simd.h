@@ -0,0 +1,73 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include "common/arch.h"
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+#if CITRA_ARCH(x86_64)
+#include <emmintrin.h>
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
+namespace Pica::Rasterizer {
+
+/**
+ * Computes clamp((a * b + c * d) / 255, 0, 255), or clamp((a * b - c * d) / 255, 0, 255) when
+ * Subtract is set, for the four channels of a color at once. The division truncates like the
+ * integer division of the reference code. SSE2 and NEON are part of the baseline of their
+ * architectures, so no runtime dispatch is needed.
+ */
+template <bool Subtract = false>
+inline Common::Vec4<u8> MultiplyAddDiv255(const Common::Vec4<u8>& a, const Common::Vec4<u8>& b,
+                                          const Common::Vec4<u8>& c, const Common::Vec4<u8>& d) {
+    Common::Vec4<u8> result;
+#if CITRA_ARCH(x86_64)
+    const auto load = [](const Common::Vec4<u8>& v) {
+        u32 raw;
+        std::memcpy(&raw, v.AsArray(), sizeof(raw));
+        return _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(raw)), _mm_setzero_si128());
+    };
+    // The products fit in 16 bits unsigned, so the low half of the signed multiply is exact
+    const __m128i ab = _mm_unpacklo_epi16(_mm_mullo_epi16(load(a), load(b)), _mm_setzero_si128());
+    const __m128i cd = _mm_unpacklo_epi16(_mm_mullo_epi16(load(c), load(d)), _mm_setzero_si128());
+    const __m128i sum = Subtract ? _mm_sub_epi32(ab, cd) : _mm_add_epi32(ab, cd);
+    // x / 255 == (x + 1 + (x >> 8)) >> 8 for the range of sum, once clamped to [0, 255]
+    const __m128i quotient = _mm_srai_epi32(
+        _mm_add_epi32(_mm_add_epi32(sum, _mm_set1_epi32(1)), _mm_srai_epi32(sum, 8)), 8);
+    const __m128i words = _mm_packs_epi32(quotient, quotient);
+    const u32 raw = static_cast<u32>(_mm_cvtsi128_si32(_mm_packus_epi16(words, words)));
+    std::memcpy(result.AsArray(), &raw, sizeof(raw));
+#elif CITRA_ARCH(arm64)
+    const auto load = [](const Common::Vec4<u8>& v) {
+        u32 raw;
+        std::memcpy(&raw, v.AsArray(), sizeof(raw));
+        return vreinterpret_u8_u32(vdup_n_u32(raw));
+    };
+    const uint16x4_t ab = vget_low_u16(vmull_u8(load(a), load(b)));
+    const uint16x4_t cd = vget_low_u16(vmull_u8(load(c), load(d)));
+    const int32x4_t sum = Subtract ? vreinterpretq_s32_u32(vsubl_u16(ab, cd))
+                                   : vreinterpretq_s32_u32(vaddl_u16(ab, cd));
+    // x / 255 == (x + 1 + (x >> 8)) >> 8 for the range of sum, once clamped to [0, 255]
+    const int32x4_t quotient =
+        vshrq_n_s32(vaddq_s32(vaddq_s32(sum, vdupq_n_s32(1)), vshrq_n_s32(sum, 8)), 8);
+    const uint16x4_t words = vqmovun_s32(quotient);
+    const u32 raw = vget_lane_u32(vreinterpret_u32_u8(vqmovn_u16(vcombine_u16(words, words))), 0);
+    std::memcpy(result.AsArray(), &raw, sizeof(raw));
+#else
+    for (std::size_t i = 0; i < 4; ++i) {
+        const int ab = a[i] * b[i];
+        const int cd = c[i] * d[i];
+        result[i] = static_cast<u8>(std::clamp((Subtract ? ab - cd : ab + cd) / 255, 0, 255));
+    }
+#endif
+    return result;
+}
+
+} // namespace Pica::Rasterizer
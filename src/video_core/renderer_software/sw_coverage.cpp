@@ -0,0 +1,235 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <bit>
+#include "common/arch.h"
+#include "common/common_types.h"
+#include "video_core/renderer_software/sw_coverage.h"
+
+#if CITRA_ARCH(x86_64)
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
+// The ISA specific scanners are flattened so that the generic scan loop is inlined into them and
+// compiled for the wider instruction set as well
+#if CITRA_ARCH(x86_64) && !defined(_MSC_VER)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define FLATTEN __attribute__((flatten))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#define FLATTEN
+#endif
+
+namespace Pica::Rasterizer {
+
+namespace {
+
+using SpanFinder = std::pair<std::size_t, std::size_t> (*)(const EdgeSpan&, std::size_t);
+
+/**
+ * Scans the row in groups of pixels. Group::Load returns the edge function values of the first
+ * group, Group::Advance moves them to the next one and Group::UncoveredMask returns a bit for
+ * every pixel of the group where one of the edge functions is negative.
+ */
+template <typename Group>
+std::pair<std::size_t, std::size_t> ScanGroups(const EdgeSpan& edges, std::size_t count) {
+    constexpr std::size_t Lanes = Group::LANES;
+    constexpr u32 ALL_LANES = (1u << Lanes) - 1;
+
+    Group group{edges};
+    std::size_t base = 0;
+    std::size_t begin = count;
+
+    // Skip the uncovered pixels on the left
+    for (; base < count; base += Lanes, group.Advance()) {
+        const u32 covered = ~group.UncoveredMask() & ALL_LANES;
+        if (covered != 0) {
+            begin = base + std::countr_zero(covered);
+            break;
+        }
+    }
+    if (begin >= count) {
+        return {0, 0};
+    }
+
+    // Find the first uncovered pixel on the right, starting from the group that contains begin
+    const u32 first_lane = static_cast<u32>(begin - base);
+    u32 uncovered = group.UncoveredMask() & (ALL_LANES << first_lane) & ALL_LANES;
+    while (uncovered == 0) {
+        base += Lanes;
+        if (base >= count) {
+            return {begin, count};
+        }
+        group.Advance();
+        uncovered = group.UncoveredMask();
+    }
+    return {begin, std::min(base + std::countr_zero(uncovered), count)};
+}
+
+struct ScalarGroup {
+    static constexpr std::size_t LANES = 1;
+
+    explicit ScalarGroup(const EdgeSpan& edges) : w{edges.start}, step{edges.step} {}
+
+    void Advance() {
+        for (std::size_t i = 0; i < w.size(); ++i) {
+            w[i] += step[i];
+        }
+    }
+
+    u32 UncoveredMask() const {
+        return (w[0] | w[1] | w[2]) < 0 ? 1 : 0;
+    }
+
+    std::array<int, 3> w;
+    std::array<int, 3> step;
+};
+
+std::pair<std::size_t, std::size_t> FindCoveredSpanScalar(const EdgeSpan& edges,
+                                                          std::size_t count) {
+    return ScanGroups<ScalarGroup>(edges, count);
+}
+
+#if CITRA_ARCH(x86_64)
+
+struct SSE41Group {
+    static constexpr std::size_t LANES = 4;
+
+    TARGET_SSE41 explicit SSE41Group(const EdgeSpan& edges) {
+        const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+        for (std::size_t i = 0; i < 3; ++i) {
+            const __m128i step = _mm_set1_epi32(edges.step[i]);
+            w[i] = _mm_add_epi32(_mm_set1_epi32(edges.start[i]), _mm_mullo_epi32(lane, step));
+            group_step[i] = _mm_slli_epi32(step, 2);
+        }
+    }
+
+    TARGET_SSE41 void Advance() {
+        for (std::size_t i = 0; i < 3; ++i) {
+            w[i] = _mm_add_epi32(w[i], group_step[i]);
+        }
+    }
+
+    TARGET_SSE41 u32 UncoveredMask() const {
+        // A pixel is uncovered when the sign bit of any edge function is set
+        const __m128i any_negative = _mm_or_si128(_mm_or_si128(w[0], w[1]), w[2]);
+        return static_cast<u32>(_mm_movemask_ps(_mm_castsi128_ps(any_negative)));
+    }
+
+    __m128i w[3];
+    __m128i group_step[3];
+};
+
+FLATTEN TARGET_SSE41 std::pair<std::size_t, std::size_t> FindCoveredSpanSSE41(const EdgeSpan& edges,
+                                                                      std::size_t count) {
+    return ScanGroups<SSE41Group>(edges, count);
+}
+
+struct AVX2Group {
+    static constexpr std::size_t LANES = 8;
+
+    TARGET_AVX2 explicit AVX2Group(const EdgeSpan& edges) {
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        for (std::size_t i = 0; i < 3; ++i) {
+            const __m256i step = _mm256_set1_epi32(edges.step[i]);
+            w[i] = _mm256_add_epi32(_mm256_set1_epi32(edges.start[i]),
+                                    _mm256_mullo_epi32(lane, step));
+            group_step[i] = _mm256_slli_epi32(step, 3);
+        }
+    }
+
+    TARGET_AVX2 void Advance() {
+        for (std::size_t i = 0; i < 3; ++i) {
+            w[i] = _mm256_add_epi32(w[i], group_step[i]);
+        }
+    }
+
+    TARGET_AVX2 u32 UncoveredMask() const {
+        const __m256i any_negative = _mm256_or_si256(_mm256_or_si256(w[0], w[1]), w[2]);
+        return static_cast<u32>(_mm256_movemask_ps(_mm256_castsi256_ps(any_negative)));
+    }
+
+    __m256i w[3];
+    __m256i group_step[3];
+};
+
+FLATTEN TARGET_AVX2 std::pair<std::size_t, std::size_t> FindCoveredSpanAVX2(const EdgeSpan& edges,
+                                                                    std::size_t count) {
+    return ScanGroups<AVX2Group>(edges, count);
+}
+
+SpanFinder SelectSpanFinder() {
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.avx2) {
+        return FindCoveredSpanAVX2;
+    }
+    if (caps.sse4_1) {
+        return FindCoveredSpanSSE41;
+    }
+    return FindCoveredSpanScalar;
+}
+
+#elif CITRA_ARCH(arm64)
+
+struct NEONGroup {
+    static constexpr std::size_t LANES = 4;
+
+    explicit NEONGroup(const EdgeSpan& edges) {
+        static constexpr std::array<s32, 4> lanes{0, 1, 2, 3};
+        const int32x4_t lane = vld1q_s32(lanes.data());
+        for (std::size_t i = 0; i < 3; ++i) {
+            const int32x4_t step = vdupq_n_s32(edges.step[i]);
+            w[i] = vmlaq_s32(vdupq_n_s32(edges.start[i]), lane, step);
+            group_step[i] = vshlq_n_s32(step, 2);
+        }
+    }
+
+    void Advance() {
+        for (std::size_t i = 0; i < 3; ++i) {
+            w[i] = vaddq_s32(w[i], group_step[i]);
+        }
+    }
+
+    u32 UncoveredMask() const {
+        // Move the sign bit of every lane into its own bit of the mask
+        static constexpr std::array<s32, 4> shifts{0, 1, 2, 3};
+        const int32x4_t any_negative = vorrq_s32(vorrq_s32(w[0], w[1]), w[2]);
+        const uint32x4_t sign = vshrq_n_u32(vreinterpretq_u32_s32(any_negative), 31);
+        return vaddvq_u32(vshlq_u32(sign, vld1q_s32(shifts.data())));
+    }
+
+    int32x4_t w[3];
+    int32x4_t group_step[3];
+};
+
+std::pair<std::size_t, std::size_t> FindCoveredSpanNEON(const EdgeSpan& edges, std::size_t count) {
+    return ScanGroups<NEONGroup>(edges, count);
+}
+
+SpanFinder SelectSpanFinder() {
+    return FindCoveredSpanNEON;
+}
+
+#else
+
+SpanFinder SelectSpanFinder() {
+    return FindCoveredSpanScalar;
+}
+
+#endif
+
+} // Anonymous namespace
+
+std::pair<std::size_t, std::size_t> FindCoveredSpan(const EdgeSpan& edges, std::size_t count) {
+    static const SpanFinder find_span = SelectSpanFinder();
+    return find_span(edges, count);
+}
+
+} // namespace Pica::Rasterizer
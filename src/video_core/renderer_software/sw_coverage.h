@@ -0,0 +1,29 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace Pica::Rasterizer {
+
+/// Values of the three triangle edge functions at the first pixel of a row and their increment
+/// from one pixel to the next
+struct EdgeSpan {
+    std::array<int, 3> start;
+    std::array<int, 3> step;
+};
+
+/**
+ * Finds the pixels of a row that are covered by a triangle, i.e. where none of the edge functions
+ * is negative. The edge functions are linear, so the covered pixels are always contiguous.
+ * @param edges Edge function values for the row
+ * @param count Number of pixels in the row
+ * @return Range [begin, end) of covered pixel indices, empty if no pixel is covered
+ */
+std::pair<std::size_t, std::size_t> FindCoveredSpan(const EdgeSpan& edges, std::size_t count);
+
+} // namespace Pica::Rasterizer
@@ -12,6 +12,7 @@
 #include "core/memory.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs_framebuffer.h"
+#include "video_core/renderer_software/sw_color_simd.h"
 #include "video_core/renderer_software/sw_framebuffer.h"
 #include "video_core/utils.h"
 #include "video_core/video_core.h"
@@ -264,21 +265,15 @@ Common::Vec4<u8> EvaluateBlendEquation(const Common::Vec4<u8>& src,
                                        FramebufferRegs::BlendEquation equation) {
     Common::Vec4<int> result;
 
-    auto src_result = (src * srcfactor).Cast<int>();
-    auto dst_result = (dest * destfactor).Cast<int>();
-
     switch (equation) {
     case FramebufferRegs::BlendEquation::Add:
-        result = (src_result + dst_result) / 255;
-        break;
+        return MultiplyAddDiv255(src, srcfactor, dest, destfactor);
 
     case FramebufferRegs::BlendEquation::Subtract:
-        result = (src_result - dst_result) / 255;
-        break;
+        return MultiplyAddDiv255<true>(src, srcfactor, dest, destfactor);
 
     case FramebufferRegs::BlendEquation::ReverseSubtract:
-        result = (dst_result - src_result) / 255;
-        break;
+        return MultiplyAddDiv255<true>(dest, destfactor, src, srcfactor);
 
     // TODO: How do these two actually work?  OpenGL doesn't include the blend factors in the
     //       min/max computations, but is this what the 3DS actually does?
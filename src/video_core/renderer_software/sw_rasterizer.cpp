@@ -2,15 +2,116 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "common/microprofile.h"
+#include "common/thread_worker.h"
 #include "video_core/renderer_software/sw_clipper.h"
 #include "video_core/renderer_software/sw_rasterizer.h"
 
 namespace VideoCore {
 
+/// Width and height, in pixels, of the screen tiles that are shaded in parallel
+constexpr u32 TILE_SIZE = 32;
+
+/// Region covering every pixel addressable by the 12.4 fixed point rasterizer coordinates
+constexpr Common::Rectangle<u32> FULL_REGION{0, 0, 4096, 4096};
+
+MICROPROFILE_DEFINE(GPU_TileBinning, "GPU", "Tile Binning", MP_RGB(50, 50, 180));
+
+RasterizerSoftware::RasterizerSoftware() {
+    const u32 num_threads = std::thread::hardware_concurrency();
+    if (num_threads > 1) {
+        workers = std::make_unique<Common::ThreadWorker>(num_threads, "SoftwareRasterizer");
+    }
+}
+
+RasterizerSoftware::~RasterizerSoftware() = default;
+
 void RasterizerSoftware::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                      const Pica::Shader::OutputVertex& v1,
                                      const Pica::Shader::OutputVertex& v2) {
-    Pica::Clipper::ProcessTriangle(v0, v1, v2);
+    Pica::Clipper::ProcessTriangle(v0, v1, v2, triangles);
+}
+
+void RasterizerSoftware::DrawTriangles() {
+    if (triangles.empty()) {
+        return;
+    }
+
+    if (!workers) {
+        for (const auto& triangle : triangles) {
+            Pica::Rasterizer::ProcessTriangle(triangle, FULL_REGION);
+        }
+        triangles.clear();
+        return;
+    }
+
+    BinTriangles();
+
+    // Every tile rasterizes its triangles in submission order and tiles never share pixels, so
+    // the result is identical to rasterizing the whole batch on a single thread. The PICA state
+    // does not change until the batch is done, as the command processor is blocked here.
+    const u32 num_tiles = tiles_x * tiles_y;
+    std::atomic<u32> next_tile{0};
+    const auto shade_tiles = [&] {
+        for (u32 tile = next_tile++; tile < num_tiles; tile = next_tile++) {
+            const u32 x = (tile % tiles_x) * TILE_SIZE;
+            const u32 y = (tile / tiles_x) * TILE_SIZE;
+            const Common::Rectangle<u32> region{x, y, x + TILE_SIZE, y + TILE_SIZE};
+            for (const u32 index : tile_bins[tile]) {
+                Pica::Rasterizer::ProcessTriangle(triangles[index], region);
+            }
+        }
+    };
+
+    const std::size_t num_jobs = std::min<std::size_t>(workers->NumWorkers(), num_tiles);
+    for (std::size_t i = 0; i < num_jobs; ++i) {
+        workers->QueueWork(shade_tiles);
+    }
+    workers->WaitForRequests();
+
+    triangles.clear();
+}
+
+void RasterizerSoftware::BinTriangles() {
+    MICROPROFILE_SCOPE(GPU_TileBinning);
+
+    u32 max_x = 0;
+    u32 max_y = 0;
+    triangle_bounds.clear();
+    for (const auto& triangle : triangles) {
+        const auto& bounds =
+            triangle_bounds.emplace_back(Pica::Rasterizer::GetTriangleBounds(triangle));
+        max_x = std::max(max_x, bounds.right);
+        max_y = std::max(max_y, bounds.bottom);
+    }
+
+    tiles_x = (max_x + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_y = (max_y + TILE_SIZE - 1) / TILE_SIZE;
+    if (tile_bins.size() < tiles_x * tiles_y) {
+        tile_bins.resize(tiles_x * tiles_y);
+    }
+    for (auto& bin : tile_bins) {
+        bin.clear();
+    }
+
+    for (u32 index = 0; index < triangles.size(); ++index) {
+        const auto& bounds = triangle_bounds[index];
+        if (bounds.left >= bounds.right || bounds.top >= bounds.bottom) {
+            continue;
+        }
+        const u32 tile_x0 = bounds.left / TILE_SIZE;
+        const u32 tile_y0 = bounds.top / TILE_SIZE;
+        const u32 tile_x1 = (bounds.right - 1) / TILE_SIZE;
+        const u32 tile_y1 = (bounds.bottom - 1) / TILE_SIZE;
+        for (u32 tile_y = tile_y0; tile_y <= tile_y1; ++tile_y) {
+            for (u32 tile_x = tile_x0; tile_x <= tile_x1; ++tile_x) {
+                tile_bins[tile_y * tiles_x + tile_x].push_back(index);
+            }
+        }
+    }
 }
 
 } // namespace VideoCore
@@ -4,8 +4,15 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
 #include "common/common_types.h"
 #include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_software/rasterizer.h"
+
+namespace Common {
+class ThreadWorker;
+}
 
 namespace Pica::Shader {
 struct OutputVertex;
@@ -14,15 +21,31 @@ struct OutputVertex;
 namespace VideoCore {
 
 class RasterizerSoftware : public RasterizerInterface {
+public:
+    RasterizerSoftware();
+    ~RasterizerSoftware() override;
+
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
+    void DrawTriangles() override;
     void NotifyPicaRegisterChanged(u32 id) override {}
     void FlushAll() override {}
     void FlushRegion(PAddr addr, u32 size) override {}
     void InvalidateRegion(PAddr addr, u32 size) override {}
     void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
     void ClearAll(bool flush) override {}
+
+private:
+    /// Sorts the pending triangles into the screen tiles they overlap
+    void BinTriangles();
+
+private:
+    std::vector<Pica::Rasterizer::Triangle> triangles;
+    std::vector<Common::Rectangle<u32>> triangle_bounds;
+    std::vector<std::vector<u32>> tile_bins;
+    u32 tiles_x = 0;
+    u32 tiles_y = 0;
+    std::unique_ptr<Common::ThreadWorker> workers;
 };
 
 } // namespace VideoCore
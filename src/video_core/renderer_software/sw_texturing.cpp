@@ -7,6 +7,7 @@
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
+#include "video_core/renderer_software/sw_color_simd.h"
 #include "video_core/renderer_software/sw_texturing.h"
 
 namespace Pica::Rasterizer {
@@ -125,12 +126,17 @@ u8 GetAlphaModifier(TevStageConfig::AlphaModifier factor, const Common::Vec4<u8>
 Common::Vec3<u8> ColorCombine(TevStageConfig::Operation op, const Common::Vec3<u8> input[3]) {
     using Operation = TevStageConfig::Operation;
 
+    // The multiplying operations go through MultiplyAddDiv255, with the fourth lane unused
+    const auto widen = [](const Common::Vec3<u8>& v) { return Common::MakeVec(v, u8{0}); };
+    const Common::Vec4<u8> zero{};
+    const Common::Vec4<u8> full{255, 255, 255, 255};
+
     switch (op) {
     case Operation::Replace:
         return input[0];
 
     case Operation::Modulate:
-        return ((input[0] * input[1]) / 255).Cast<u8>();
+        return MultiplyAddDiv255(widen(input[0]), widen(input[1]), zero, zero).rgb();
 
     case Operation::Add: {
         auto result = input[0] + input[1];
@@ -152,10 +158,9 @@ Common::Vec3<u8> ColorCombine(TevStageConfig::Operation op, const Common::Vec3<u
     }
 
     case Operation::Lerp:
-        return ((input[0] * input[2] +
-                 input[1] * (Common::MakeVec<u8>(255, 255, 255) - input[2]).Cast<u8>()) /
-                255)
-            .Cast<u8>();
+        return MultiplyAddDiv255(widen(input[0]), widen(input[2]), widen(input[1]),
+                                 (full - widen(input[2])).Cast<u8>())
+            .rgb();
 
     case Operation::Subtract: {
         auto result = input[0].Cast<int>() - input[1].Cast<int>();
@@ -165,21 +170,15 @@ Common::Vec3<u8> ColorCombine(TevStageConfig::Operation op, const Common::Vec3<u
         return result.Cast<u8>();
     }
 
-    case Operation::MultiplyThenAdd: {
-        auto result = (input[0] * input[1] + 255 * input[2].Cast<int>()) / 255;
-        result.r() = std::min(255, result.r());
-        result.g() = std::min(255, result.g());
-        result.b() = std::min(255, result.b());
-        return result.Cast<u8>();
-    }
+    case Operation::MultiplyThenAdd:
+        return MultiplyAddDiv255(widen(input[0]), widen(input[1]), widen(input[2]), full).rgb();
 
     case Operation::AddThenMultiply: {
         auto result = input[0] + input[1];
         result.r() = std::min(255, result.r());
         result.g() = std::min(255, result.g());
         result.b() = std::min(255, result.b());
-        result = (result * input[2].Cast<int>()) / 255;
-        return result.Cast<u8>();
+        return MultiplyAddDiv255(widen(result.Cast<u8>()), widen(input[2]), zero, zero).rgb();
     }
     case Operation::Dot3_RGB:
     case Operation::Dot3_RGBA: {
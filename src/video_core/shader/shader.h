@@ -341,6 +341,15 @@ public:
      * @param state Shader unit state, must be setup with input data before each shader invocation.
      */
     virtual void Run(const ShaderSetup& setup, UnitState& state) const = 0;
+
+    /**
+     * Runs the currently setup shader on several independent vertices. Engines that are able to
+     * process multiple vertices at once override this, by default each vertex is run on its own.
+     *
+     * @param setup Shader engine state, must be setup with SetupBatch on each shader change.
+     * @param states Shader unit states, each must be setup with input data before the invocation.
+     */
+    virtual void RunBatch(const ShaderSetup& setup, std::span<UnitState> states) const;
 };
 
 // TODO(yuriks): Remove and make it non-global state somewhere
@@ -6,8 +6,10 @@
 #include <array>
 #include <cmath>
 #include <numeric>
+#include <span>
 #include <boost/container/static_vector.hpp>
 #include <nihstro/shader_bytecode.h>
+#include "common/arch.h"
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
@@ -18,6 +20,26 @@
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_interpreter.h"
 
+#if CITRA_ARCH(x86_64)
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
+// The ISA specific batch interpreters are flattened so that the generic interpreter loop is
+// inlined into them and compiled for the wider instruction set as well
+#if CITRA_ARCH(x86_64) && !defined(_MSC_VER)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define FLATTEN __attribute__((flatten))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#define FLATTEN
+#endif
+
+using nihstro::DestRegister;
 using nihstro::Instruction;
 using nihstro::OpCode;
 using nihstro::RegisterType;
@@ -665,11 +687,888 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     }
 }
 
+/// Number of vertices processed side by side by the batched interpreter
+constexpr std::size_t BATCH_LANES = 8;
+
+/// Bit mask with one bit for each lane of a batch
+using LaneMask = u32;
+
+/// One register component for every lane of a batch
+using LaneFloats = std::array<float, BATCH_LANES>;
+
+/// One register for every lane of a batch, stored as [component][lane]
+using LaneVec4 = std::array<LaneFloats, 4>;
+
+/// Shader unit state of a batch of vertices in structure-of-arrays layout
+struct BatchUnitState {
+    std::array<LaneVec4, 16> input;
+    std::array<LaneVec4, 16> temporary;
+    std::array<LaneVec4, 16> output;
+    std::array<std::array<bool, BATCH_LANES>, 2> conditional_code;
+    std::array<std::array<s32, BATCH_LANES>, 3> address_registers;
+};
+
+struct BatchCallStackElement : CallStackElement {
+    LaneMask restore_mask; // Lanes to reenable when leaving scope
+    bool divergent;        // Whether the scope was entered by only some of the lanes
+};
+
+/// Multiplies two components the way float24::operator* does
+static float MulLane(float a, float b) {
+    const float result = a * b;
+    // PICA gives 0 instead of NaN when multiplying by inf
+    if (std::isnan(result) && !std::isnan(a) && !std::isnan(b)) {
+        return 0.f;
+    }
+    return result;
+}
+
+/**
+ * Operations on groups of WIDTH lanes held in a host register, one implementation per instruction
+ * set. They match the results of the float24 operators and of the scalar interpreter bit for bit.
+ */
+struct ScalarLanes {
+    using Reg = float;
+    static constexpr std::size_t WIDTH = 1;
+
+    static Reg Load(const float* lanes) {
+        return *lanes;
+    }
+    static void Store(float* lanes, Reg value) {
+        *lanes = value;
+    }
+    static Reg Negate(Reg a) {
+        return -a;
+    }
+    static Reg Add(Reg a, Reg b) {
+        return a + b;
+    }
+    static Reg Mul(Reg a, Reg b) {
+        return MulLane(a, b);
+    }
+    static Reg Max(Reg a, Reg b) {
+        return (a > b) ? a : b;
+    }
+    static Reg Min(Reg a, Reg b) {
+        return (a < b) ? a : b;
+    }
+    static Reg Floor(Reg a) {
+        return std::floor(a);
+    }
+    static Reg Rcp(Reg a) {
+        return 1.0f / a;
+    }
+    static Reg Rsq(Reg a) {
+        return 1.0f / std::sqrt(a);
+    }
+    static Reg GreaterEqual(Reg a, Reg b) {
+        return (a >= b) ? 1.0f : 0.0f;
+    }
+    static Reg LessThan(Reg a, Reg b) {
+        return (a < b) ? 1.0f : 0.0f;
+    }
+};
+
+#if CITRA_ARCH(x86_64)
+
+struct SSE41Lanes {
+    using Reg = __m128;
+    static constexpr std::size_t WIDTH = 4;
+
+    TARGET_SSE41 static Reg Load(const float* lanes) {
+        return _mm_loadu_ps(lanes);
+    }
+    TARGET_SSE41 static void Store(float* lanes, Reg value) {
+        _mm_storeu_ps(lanes, value);
+    }
+    TARGET_SSE41 static Reg Negate(Reg a) {
+        return _mm_xor_ps(a, _mm_set1_ps(-0.0f));
+    }
+    TARGET_SSE41 static Reg Add(Reg a, Reg b) {
+        return _mm_add_ps(a, b);
+    }
+    TARGET_SSE41 static Reg Mul(Reg a, Reg b) {
+        const __m128 result = _mm_mul_ps(a, b);
+        // PICA gives 0 instead of NaN when multiplying by inf
+        const __m128 inf_by_zero = _mm_and_ps(_mm_cmpunord_ps(result, result), _mm_cmpord_ps(a, b));
+        return _mm_andnot_ps(inf_by_zero, result);
+    }
+    // MAXPS and MINPS return the second operand when the comparison fails, NaNs included
+    TARGET_SSE41 static Reg Max(Reg a, Reg b) {
+        return _mm_max_ps(a, b);
+    }
+    TARGET_SSE41 static Reg Min(Reg a, Reg b) {
+        return _mm_min_ps(a, b);
+    }
+    TARGET_SSE41 static Reg Floor(Reg a) {
+        return _mm_floor_ps(a);
+    }
+    TARGET_SSE41 static Reg Rcp(Reg a) {
+        return _mm_div_ps(_mm_set1_ps(1.0f), a);
+    }
+    TARGET_SSE41 static Reg Rsq(Reg a) {
+        return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a));
+    }
+    TARGET_SSE41 static Reg GreaterEqual(Reg a, Reg b) {
+        return _mm_and_ps(_mm_cmpge_ps(a, b), _mm_set1_ps(1.0f));
+    }
+    TARGET_SSE41 static Reg LessThan(Reg a, Reg b) {
+        return _mm_and_ps(_mm_cmplt_ps(a, b), _mm_set1_ps(1.0f));
+    }
+};
+
+struct AVX2Lanes {
+    using Reg = __m256;
+    static constexpr std::size_t WIDTH = 8;
+
+    TARGET_AVX2 static Reg Load(const float* lanes) {
+        return _mm256_loadu_ps(lanes);
+    }
+    TARGET_AVX2 static void Store(float* lanes, Reg value) {
+        _mm256_storeu_ps(lanes, value);
+    }
+    TARGET_AVX2 static Reg Negate(Reg a) {
+        return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f));
+    }
+    TARGET_AVX2 static Reg Add(Reg a, Reg b) {
+        return _mm256_add_ps(a, b);
+    }
+    TARGET_AVX2 static Reg Mul(Reg a, Reg b) {
+        const __m256 result = _mm256_mul_ps(a, b);
+        // PICA gives 0 instead of NaN when multiplying by inf
+        const __m256 inf_by_zero = _mm256_and_ps(_mm256_cmp_ps(result, result, _CMP_UNORD_Q),
+                                                 _mm256_cmp_ps(a, b, _CMP_ORD_Q));
+        return _mm256_andnot_ps(inf_by_zero, result);
+    }
+    // VMAXPS and VMINPS return the second operand when the comparison fails, NaNs included
+    TARGET_AVX2 static Reg Max(Reg a, Reg b) {
+        return _mm256_max_ps(a, b);
+    }
+    TARGET_AVX2 static Reg Min(Reg a, Reg b) {
+        return _mm256_min_ps(a, b);
+    }
+    TARGET_AVX2 static Reg Floor(Reg a) {
+        return _mm256_floor_ps(a);
+    }
+    TARGET_AVX2 static Reg Rcp(Reg a) {
+        return _mm256_div_ps(_mm256_set1_ps(1.0f), a);
+    }
+    TARGET_AVX2 static Reg Rsq(Reg a) {
+        return _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(a));
+    }
+    TARGET_AVX2 static Reg GreaterEqual(Reg a, Reg b) {
+        return _mm256_and_ps(_mm256_cmp_ps(a, b, _CMP_GE_OQ), _mm256_set1_ps(1.0f));
+    }
+    TARGET_AVX2 static Reg LessThan(Reg a, Reg b) {
+        return _mm256_and_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ), _mm256_set1_ps(1.0f));
+    }
+};
+
+#elif CITRA_ARCH(arm64)
+
+struct NEONLanes {
+    using Reg = float32x4_t;
+    static constexpr std::size_t WIDTH = 4;
+
+    static Reg Load(const float* lanes) {
+        return vld1q_f32(lanes);
+    }
+    static void Store(float* lanes, Reg value) {
+        vst1q_f32(lanes, value);
+    }
+    static Reg Negate(Reg a) {
+        return vnegq_f32(a);
+    }
+    static Reg Add(Reg a, Reg b) {
+        return vaddq_f32(a, b);
+    }
+    static Reg Mul(Reg a, Reg b) {
+        const float32x4_t result = vmulq_f32(a, b);
+        // PICA gives 0 instead of NaN when multiplying by inf
+        const uint32x4_t ordered = vandq_u32(vceqq_f32(a, a), vceqq_f32(b, b));
+        const uint32x4_t inf_by_zero = vbicq_u32(ordered, vceqq_f32(result, result));
+        return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(result), inf_by_zero));
+    }
+    // FMAX and FMIN propagate NaNs, so select like the scalar comparison does
+    static Reg Max(Reg a, Reg b) {
+        return vbslq_f32(vcgtq_f32(a, b), a, b);
+    }
+    static Reg Min(Reg a, Reg b) {
+        return vbslq_f32(vcltq_f32(a, b), a, b);
+    }
+    static Reg Floor(Reg a) {
+        return vrndmq_f32(a);
+    }
+    static Reg Rcp(Reg a) {
+        return vdivq_f32(vdupq_n_f32(1.0f), a);
+    }
+    static Reg Rsq(Reg a) {
+        return vdivq_f32(vdupq_n_f32(1.0f), vsqrtq_f32(a));
+    }
+    static Reg GreaterEqual(Reg a, Reg b) {
+        return vreinterpretq_f32_u32(
+            vandq_u32(vcgeq_f32(a, b), vreinterpretq_u32_f32(vdupq_n_f32(1.0f))));
+    }
+    static Reg LessThan(Reg a, Reg b) {
+        return vreinterpretq_f32_u32(
+            vandq_u32(vcltq_f32(a, b), vreinterpretq_u32_f32(vdupq_n_f32(1.0f))));
+    }
+};
+
+#endif
+
+/// Applies op to every group of Lanes::WIDTH lanes of the arguments
+template <typename Lanes, typename Op, typename... Args>
+static LaneFloats MapLanes(Op op, const Args&... args) {
+    LaneFloats result;
+    for (std::size_t lane = 0; lane < BATCH_LANES; lane += Lanes::WIDTH) {
+        Lanes::Store(&result[lane], op(Lanes::Load(&args[lane])...));
+    }
+    return result;
+}
+
+static void LoadBatch(BatchUnitState& batch, std::span<const UnitState> states) {
+    for (std::size_t lane = 0; lane < states.size(); ++lane) {
+        const UnitState& state = states[lane];
+        for (std::size_t reg = 0; reg < 16; ++reg) {
+            for (std::size_t comp = 0; comp < 4; ++comp) {
+                batch.input[reg][comp][lane] = state.registers.input[reg][comp].ToFloat32();
+                batch.temporary[reg][comp][lane] = state.registers.temporary[reg][comp].ToFloat32();
+                batch.output[reg][comp][lane] = state.registers.output[reg][comp].ToFloat32();
+            }
+        }
+        for (std::size_t i = 0; i < 3; ++i) {
+            batch.address_registers[i][lane] = state.address_registers[i];
+        }
+        batch.conditional_code[0][lane] = false;
+        batch.conditional_code[1][lane] = false;
+    }
+}
+
+static void StoreBatch(const BatchUnitState& batch, std::span<UnitState> states) {
+    for (std::size_t lane = 0; lane < states.size(); ++lane) {
+        UnitState& state = states[lane];
+        for (std::size_t reg = 0; reg < 16; ++reg) {
+            for (std::size_t comp = 0; comp < 4; ++comp) {
+                state.registers.temporary[reg][comp] =
+                    float24::FromFloat32(batch.temporary[reg][comp][lane]);
+                state.registers.output[reg][comp] =
+                    float24::FromFloat32(batch.output[reg][comp][lane]);
+            }
+        }
+        for (std::size_t i = 0; i < 3; ++i) {
+            state.address_registers[i] = batch.address_registers[i][lane];
+        }
+        state.conditional_code[0] = batch.conditional_code[0][lane];
+        state.conditional_code[1] = batch.conditional_code[1][lane];
+    }
+}
+
+/**
+ * Runs the shader on a batch of vertices at once. Every instruction is decoded once and then
+ * applied to all lanes with the vector operations of Lanes. Lanes diverging on conditional IF and
+ * CALL blocks are handled by masking writes of inactive lanes.
+ * @return false if the shader used a feature that can't be executed in lockstep (jumps taken by
+ *         only some lanes or while lanes are diverged, or geometry emission), in which case the
+ *         batch has to be run one vertex at a time instead. The contents of the batch state are
+ *         undefined in that case.
+ */
+template <typename Lanes>
+static bool RunBatchInterpreter(const ShaderSetup& setup, BatchUnitState& state,
+                                std::size_t num_lanes, unsigned offset) {
+    using Reg = typename Lanes::Reg;
+
+    boost::container::static_vector<BatchCallStackElement, 16> call_stack;
+    u32 program_counter = offset;
+
+    const LaneMask batch_mask = (1u << num_lanes) - 1;
+    LaneMask alive_mask = batch_mask; // Lanes which haven't reached END yet
+    LaneMask exec_mask = batch_mask;  // Lanes executing the current instruction
+
+    auto call = [&program_counter, &call_stack](u32 offset, u32 num_instructions, u32 return_offset,
+                                                u8 repeat_count, u8 loop_increment,
+                                                LaneMask restore_mask) {
+        // -1 to make sure when incrementing the PC we end up at the correct offset
+        program_counter = offset - 1;
+        ASSERT(call_stack.size() < call_stack.capacity());
+        call_stack.push_back({{offset + num_instructions, return_offset, repeat_count,
+                               loop_increment, offset},
+                              restore_mask,
+                              false});
+    };
+
+    /// Jumps move all executing lanes, so they are only possible while no lane waits for the
+    /// others to leave a divergent scope
+    auto lanes_in_lockstep = [&exec_mask, &alive_mask, &call_stack] {
+        return exec_mask == alive_mask &&
+               std::none_of(call_stack.begin(), call_stack.end(),
+                            [](const BatchCallStackElement& frame) { return frame.divergent; });
+    };
+
+    auto evaluate_condition = [&state, &exec_mask](Instruction::FlowControlType flow_control) {
+        using Op = Instruction::FlowControlType::Op;
+
+        LaneMask result = 0;
+        for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+            const bool result_x = flow_control.refx.Value() == state.conditional_code[0][lane];
+            const bool result_y = flow_control.refy.Value() == state.conditional_code[1][lane];
+
+            bool passed;
+            switch (flow_control.op) {
+            case Op::Or:
+                passed = result_x || result_y;
+                break;
+            case Op::And:
+                passed = result_x && result_y;
+                break;
+            case Op::JustX:
+                passed = result_x;
+                break;
+            case Op::JustY:
+                passed = result_y;
+                break;
+            default:
+                UNREACHABLE();
+                passed = false;
+                break;
+            }
+            result |= static_cast<LaneMask>(passed) << lane;
+        }
+        return result & exec_mask;
+    };
+
+    const auto& uniforms = setup.uniforms;
+    const auto& swizzle_data = setup.swizzle_data;
+    const auto& program_code = setup.program_code;
+
+    // Placeholder for invalid inputs and outputs
+    LaneVec4 dummy_vec4{};
+
+    auto lookup_component = [&](const SourceRegister& source_reg, std::size_t lane,
+                                int component) -> float {
+        switch (source_reg.GetRegisterType()) {
+        case RegisterType::Input:
+            return state.input[source_reg.GetIndex()][component][lane];
+
+        case RegisterType::Temporary:
+            return state.temporary[source_reg.GetIndex()][component][lane];
+
+        case RegisterType::FloatUniform:
+            return uniforms.f[source_reg.GetIndex()][component].ToFloat32();
+
+        default:
+            return dummy_vec4[component][lane];
+        }
+    };
+
+    /// Fetches the swizzled source register of every lane. `offsets` is null unless the source
+    /// is addressed relative to an address register.
+    auto fetch_source = [&](const SourceRegister& source_reg,
+                            const std::array<s32, BATCH_LANES>* offsets,
+                            const std::array<int, 4>& selectors, bool negate) {
+        LaneVec4 result;
+        if (offsets == nullptr) {
+            switch (source_reg.GetRegisterType()) {
+            case RegisterType::Input:
+            case RegisterType::Temporary: {
+                const LaneVec4& src = source_reg.GetRegisterType() == RegisterType::Input
+                                          ? state.input[source_reg.GetIndex()]
+                                          : state.temporary[source_reg.GetIndex()];
+                for (std::size_t i = 0; i < 4; ++i) {
+                    result[i] = src[selectors[i]];
+                }
+                break;
+            }
+
+            case RegisterType::FloatUniform:
+                for (std::size_t i = 0; i < 4; ++i) {
+                    result[i].fill(uniforms.f[source_reg.GetIndex()][selectors[i]].ToFloat32());
+                }
+                break;
+
+            default:
+                for (std::size_t i = 0; i < 4; ++i) {
+                    result[i] = dummy_vec4[selectors[i]];
+                }
+                break;
+            }
+        } else {
+            for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                const SourceRegister lane_reg = source_reg + (*offsets)[lane];
+                for (std::size_t i = 0; i < 4; ++i) {
+                    result[i][lane] = lookup_component(lane_reg, lane, selectors[i]);
+                }
+            }
+        }
+
+        if (negate) {
+            for (auto& component : result) {
+                component = MapLanes<Lanes>([](Reg a) { return Lanes::Negate(a); }, component);
+            }
+        }
+        return result;
+    };
+
+    auto lookup_dest = [&](const DestRegister& dest) -> LaneVec4& {
+        return (dest < 0x10)   ? state.output[dest.GetIndex()]
+               : (dest < 0x20) ? state.temporary[dest.GetIndex()]
+                               : dummy_vec4;
+    };
+
+    /// Writes compute(component) to each enabled component of dest, for active lanes only
+    auto write_dest = [&exec_mask, batch_mask](LaneVec4& dest, const SwizzlePattern& swizzle,
+                                               auto&& compute) {
+        for (int i = 0; i < 4; ++i) {
+            if (!swizzle.DestComponentEnabled(i))
+                continue;
+
+            const LaneFloats result = compute(i);
+
+            if (exec_mask == batch_mask) {
+                dest[i] = result;
+                continue;
+            }
+            for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                dest[i][lane] = ((exec_mask >> lane) & 1) ? result[lane] : dest[i][lane];
+            }
+        }
+    };
+
+    while (true) {
+        if (!call_stack.empty()) {
+            auto& top = call_stack.back();
+            if (program_counter == top.final_address) {
+                for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                    if ((exec_mask >> lane) & 1) {
+                        state.address_registers[2][lane] += top.loop_increment;
+                    }
+                }
+
+                if (top.repeat_counter-- == 0) {
+                    program_counter = top.return_address;
+                    exec_mask = top.restore_mask & alive_mask;
+                    call_stack.pop_back();
+                } else {
+                    program_counter = top.loop_address;
+                }
+
+                continue;
+            }
+        } else if (exec_mask == 0) {
+            return true;
+        }
+
+        const Instruction instr = {program_code[program_counter]};
+        const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+
+        switch (instr.opcode.Value().GetInfo().type) {
+        case OpCode::Type::Arithmetic: {
+            const bool is_inverted =
+                (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+            const std::array<s32, BATCH_LANES>* address_offset =
+                (instr.common.address_register_index == 0)
+                    ? nullptr
+                    : &state.address_registers[instr.common.address_register_index - 1];
+
+            LaneVec4 src1 = fetch_source(instr.common.GetSrc1(is_inverted),
+                                         is_inverted ? nullptr : address_offset,
+                                         {(int)swizzle.src1_selector_0.Value(),
+                                          (int)swizzle.src1_selector_1.Value(),
+                                          (int)swizzle.src1_selector_2.Value(),
+                                          (int)swizzle.src1_selector_3.Value()},
+                                         swizzle.negate_src1 != 0);
+            const LaneVec4 src2 = fetch_source(instr.common.GetSrc2(is_inverted),
+                                               is_inverted ? address_offset : nullptr,
+                                               {(int)swizzle.src2_selector_0.Value(),
+                                                (int)swizzle.src2_selector_1.Value(),
+                                                (int)swizzle.src2_selector_2.Value(),
+                                                (int)swizzle.src2_selector_3.Value()},
+                                               swizzle.negate_src2 != 0);
+
+            LaneVec4& dest = lookup_dest(instr.common.dest.Value());
+
+            switch (instr.opcode.Value().EffectiveOpCode()) {
+            case OpCode::Id::ADD:
+                write_dest(dest, swizzle, [&](int i) {
+                    return MapLanes<Lanes>([](Reg a, Reg b) { return Lanes::Add(a, b); }, src1[i],
+                                           src2[i]);
+                });
+                break;
+
+            case OpCode::Id::MUL:
+                write_dest(dest, swizzle, [&](int i) {
+                    return MapLanes<Lanes>([](Reg a, Reg b) { return Lanes::Mul(a, b); }, src1[i],
+                                           src2[i]);
+                });
+                break;
+
+            case OpCode::Id::FLR:
+                write_dest(dest, swizzle, [&](int i) {
+                    return MapLanes<Lanes>([](Reg a) { return Lanes::Floor(a); }, src1[i]);
+                });
+                break;
+
+            case OpCode::Id::MAX:
+                // NOTE: Same NaN semantics as the scalar interpreter, see Lanes::Max
+                write_dest(dest, swizzle, [&](int i) {
+                    return MapLanes<Lanes>([](Reg a, Reg b) { return Lanes::Max(a, b); }, src1[i],
+                                           src2[i]);
+                });
+                break;
+
+            case OpCode::Id::MIN:
+                write_dest(dest, swizzle, [&](int i) {
+                    return MapLanes<Lanes>([](Reg a, Reg b) { return Lanes::Min(a, b); }, src1[i],
+                                           src2[i]);
+                });
+                break;
+
+            case OpCode::Id::DP3:
+            case OpCode::Id::DP4:
+            case OpCode::Id::DPH:
+            case OpCode::Id::DPHI: {
+                OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+                if (opcode == OpCode::Id::DPH || opcode == OpCode::Id::DPHI)
+                    src1[3].fill(1.0f);
+
+                const std::size_t num_components = (opcode == OpCode::Id::DP3) ? 3 : 4;
+                // Accumulated in the same order as float24 to get the same rounding
+                LaneFloats dot{};
+                for (std::size_t i = 0; i < num_components; ++i) {
+                    dot = MapLanes<Lanes>(
+                        [](Reg sum, Reg a, Reg b) { return Lanes::Add(sum, Lanes::Mul(a, b)); },
+                        dot, src1[i], src2[i]);
+                }
+                write_dest(dest, swizzle, [&](int) { return dot; });
+                break;
+            }
+
+            // Reciprocal
+            case OpCode::Id::RCP:
+                write_dest(dest, swizzle, [&](int) {
+                    return MapLanes<Lanes>([](Reg a) { return Lanes::Rcp(a); }, src1[0]);
+                });
+                break;
+
+            // Reciprocal Square Root
+            case OpCode::Id::RSQ:
+                write_dest(dest, swizzle, [&](int) {
+                    return MapLanes<Lanes>([](Reg a) { return Lanes::Rsq(a); }, src1[0]);
+                });
+                break;
+
+            case OpCode::Id::MOVA:
+                for (int i = 0; i < 2; ++i) {
+                    if (!swizzle.DestComponentEnabled(i))
+                        continue;
+
+                    for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                        if ((exec_mask >> lane) & 1) {
+                            state.address_registers[i][lane] = static_cast<s32>(src1[i][lane]);
+                        }
+                    }
+                }
+                break;
+
+            case OpCode::Id::MOV:
+                write_dest(dest, swizzle, [&](int i) { return src1[i]; });
+                break;
+
+            case OpCode::Id::SGE:
+            case OpCode::Id::SGEI:
+                write_dest(dest, swizzle, [&](int i) {
+                    return MapLanes<Lanes>([](Reg a, Reg b) { return Lanes::GreaterEqual(a, b); },
+                                           src1[i], src2[i]);
+                });
+                break;
+
+            case OpCode::Id::SLT:
+            case OpCode::Id::SLTI:
+                write_dest(dest, swizzle, [&](int i) {
+                    return MapLanes<Lanes>([](Reg a, Reg b) { return Lanes::LessThan(a, b); },
+                                           src1[i], src2[i]);
+                });
+                break;
+
+            case OpCode::Id::CMP:
+                for (int i = 0; i < 2; ++i) {
+                    auto compare_op = instr.common.compare_op;
+                    auto op = (i == 0) ? compare_op.x.Value() : compare_op.y.Value();
+
+                    for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                        if (!((exec_mask >> lane) & 1))
+                            continue;
+
+                        const float a = src1[i][lane];
+                        const float b = src2[i][lane];
+                        bool& result = state.conditional_code[i][lane];
+                        switch (op) {
+                        case Instruction::Common::CompareOpType::Equal:
+                            result = (a == b);
+                            break;
+                        case Instruction::Common::CompareOpType::NotEqual:
+                            result = (a != b);
+                            break;
+                        case Instruction::Common::CompareOpType::LessThan:
+                            result = (a < b);
+                            break;
+                        case Instruction::Common::CompareOpType::LessEqual:
+                            result = (a <= b);
+                            break;
+                        case Instruction::Common::CompareOpType::GreaterThan:
+                            result = (a > b);
+                            break;
+                        case Instruction::Common::CompareOpType::GreaterEqual:
+                            result = (a >= b);
+                            break;
+                        default:
+                            break;
+                        }
+                    }
+                }
+                break;
+
+            case OpCode::Id::EX2:
+                // No vector exp2 and log2 to match the scalar results with
+                write_dest(dest, swizzle, [&](int) {
+                    LaneFloats result;
+                    for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                        result[lane] = std::exp2(src1[0][lane]);
+                    }
+                    return result;
+                });
+                break;
+
+            case OpCode::Id::LG2:
+                write_dest(dest, swizzle, [&](int) {
+                    LaneFloats result;
+                    for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                        result[lane] = std::log2(src1[0][lane]);
+                    }
+                    return result;
+                });
+                break;
+
+            default:
+                // Let the scalar interpreter report the instruction
+                return false;
+            }
+
+            break;
+        }
+
+        case OpCode::Type::MultiplyAdd: {
+            if ((instr.opcode.Value().EffectiveOpCode() != OpCode::Id::MAD) &&
+                (instr.opcode.Value().EffectiveOpCode() != OpCode::Id::MADI)) {
+                return false;
+            }
+
+            const SwizzlePattern& swizzle = *reinterpret_cast<const SwizzlePattern*>(
+                &swizzle_data[instr.mad.operand_desc_id]);
+
+            const bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
+
+            const std::array<s32, BATCH_LANES>* address_offset =
+                (instr.mad.address_register_index == 0)
+                    ? nullptr
+                    : &state.address_registers[instr.mad.address_register_index - 1];
+
+            const LaneVec4 src1 = fetch_source(instr.mad.GetSrc1(is_inverted), nullptr,
+                                               {(int)swizzle.src1_selector_0.Value(),
+                                                (int)swizzle.src1_selector_1.Value(),
+                                                (int)swizzle.src1_selector_2.Value(),
+                                                (int)swizzle.src1_selector_3.Value()},
+                                               swizzle.negate_src1 != 0);
+            const LaneVec4 src2 = fetch_source(instr.mad.GetSrc2(is_inverted),
+                                               is_inverted ? nullptr : address_offset,
+                                               {(int)swizzle.src2_selector_0.Value(),
+                                                (int)swizzle.src2_selector_1.Value(),
+                                                (int)swizzle.src2_selector_2.Value(),
+                                                (int)swizzle.src2_selector_3.Value()},
+                                               swizzle.negate_src2 != 0);
+            const LaneVec4 src3 = fetch_source(instr.mad.GetSrc3(is_inverted),
+                                               is_inverted ? address_offset : nullptr,
+                                               {(int)swizzle.src3_selector_0.Value(),
+                                                (int)swizzle.src3_selector_1.Value(),
+                                                (int)swizzle.src3_selector_2.Value(),
+                                                (int)swizzle.src3_selector_3.Value()},
+                                               swizzle.negate_src3 != 0);
+
+            LaneVec4& dest = lookup_dest(instr.mad.dest.Value());
+            write_dest(dest, swizzle, [&](int i) {
+                return MapLanes<Lanes>(
+                    [](Reg a, Reg b, Reg c) { return Lanes::Add(Lanes::Mul(a, b), c); }, src1[i],
+                    src2[i], src3[i]);
+            });
+            break;
+        }
+
+        default: {
+            // Handle each instruction on its own
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::END:
+                alive_mask &= ~exec_mask;
+                if (alive_mask == 0) {
+                    return true;
+                }
+                // Other lanes still have to finish their enclosing blocks
+                exec_mask = 0;
+                break;
+
+            case OpCode::Id::JMPC: {
+                const LaneMask taken = evaluate_condition(instr.flow_control);
+                if (taken == 0) {
+                    break;
+                }
+                if (taken != exec_mask || !lanes_in_lockstep()) {
+                    // Lanes jumping to different locations can't be kept in lockstep
+                    return false;
+                }
+                program_counter = instr.flow_control.dest_offset - 1;
+                break;
+            }
+
+            case OpCode::Id::JMPU:
+                if (uniforms.b[instr.flow_control.bool_uniform_id] ==
+                    !(instr.flow_control.num_instructions & 1)) {
+                    if (!lanes_in_lockstep()) {
+                        return false;
+                    }
+                    program_counter = instr.flow_control.dest_offset - 1;
+                }
+                break;
+
+            case OpCode::Id::CALL:
+                call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                     program_counter + 1, 0, 0, exec_mask);
+                break;
+
+            case OpCode::Id::CALLU:
+                if (uniforms.b[instr.flow_control.bool_uniform_id]) {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         program_counter + 1, 0, 0, exec_mask);
+                }
+                break;
+
+            case OpCode::Id::CALLC: {
+                const LaneMask taken = evaluate_condition(instr.flow_control);
+                if (taken != 0) {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         program_counter + 1, 0, 0, exec_mask);
+                    call_stack.back().divergent = taken != exec_mask;
+                    exec_mask = taken;
+                }
+                break;
+            }
+
+            case OpCode::Id::NOP:
+                break;
+
+            case OpCode::Id::IFU:
+                if (uniforms.b[instr.flow_control.bool_uniform_id]) {
+                    call(program_counter + 1, instr.flow_control.dest_offset - program_counter - 1,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
+                         0, exec_mask);
+                } else {
+                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
+                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
+                         0, exec_mask);
+                }
+                break;
+
+            case OpCode::Id::IFC: {
+                const LaneMask taken = evaluate_condition(instr.flow_control);
+                const u32 else_offset = instr.flow_control.dest_offset;
+                const u32 end_offset = else_offset + instr.flow_control.num_instructions;
+                if (taken == exec_mask) {
+                    call(program_counter + 1, else_offset - program_counter - 1, end_offset, 0, 0,
+                         exec_mask);
+                } else if (taken == 0) {
+                    call(else_offset, instr.flow_control.num_instructions, end_offset, 0, 0,
+                         exec_mask);
+                } else {
+                    // Lanes diverge: run the else block for the remaining lanes once the
+                    // lanes which passed the condition are done with the if block.
+                    ASSERT(call_stack.size() < call_stack.capacity());
+                    call_stack.push_back(
+                        {{end_offset, end_offset, 0, 0, else_offset}, exec_mask, true});
+                    call(program_counter + 1, else_offset - program_counter - 1, else_offset, 0,
+                         0, exec_mask & ~taken);
+                    call_stack.back().divergent = true;
+                    exec_mask = taken;
+                }
+                break;
+            }
+
+            case OpCode::Id::LOOP: {
+                Common::Vec4<u8> loop_param(uniforms.i[instr.flow_control.int_uniform_id].x,
+                                            uniforms.i[instr.flow_control.int_uniform_id].y,
+                                            uniforms.i[instr.flow_control.int_uniform_id].z,
+                                            uniforms.i[instr.flow_control.int_uniform_id].w);
+                for (std::size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                    if ((exec_mask >> lane) & 1) {
+                        state.address_registers[2][lane] = loop_param.y;
+                    }
+                }
+
+                call(program_counter + 1, instr.flow_control.dest_offset - program_counter,
+                     instr.flow_control.dest_offset + 1, loop_param.x, loop_param.z, exec_mask);
+                break;
+            }
+
+            default:
+                // Geometry emission and unknown instructions are left to the scalar interpreter
+                return false;
+            }
+
+            break;
+        }
+        }
+
+        ++program_counter;
+    }
+}
+
 void InterpreterEngine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
 }
 
+using BatchRunner = bool (*)(const ShaderSetup&, BatchUnitState&, std::size_t, unsigned);
+
+#if CITRA_ARCH(x86_64)
+
+FLATTEN TARGET_AVX2 static bool RunBatchAVX2(const ShaderSetup& setup, BatchUnitState& state,
+                                             std::size_t num_lanes, unsigned offset) {
+    return RunBatchInterpreter<AVX2Lanes>(setup, state, num_lanes, offset);
+}
+
+FLATTEN TARGET_SSE41 static bool RunBatchSSE41(const ShaderSetup& setup, BatchUnitState& state,
+                                               std::size_t num_lanes, unsigned offset) {
+    return RunBatchInterpreter<SSE41Lanes>(setup, state, num_lanes, offset);
+}
+
+#endif
+
+/// Picks the widest batch interpreter the host supports
+static BatchRunner SelectBatchRunner() {
+#if CITRA_ARCH(x86_64)
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.avx2) {
+        return RunBatchAVX2;
+    }
+    if (caps.sse4_1) {
+        return RunBatchSSE41;
+    }
+    return RunBatchInterpreter<ScalarLanes>;
+#elif CITRA_ARCH(arm64)
+    return RunBatchInterpreter<NEONLanes>;
+#else
+    return RunBatchInterpreter<ScalarLanes>;
+#endif
+}
+
 MICROPROFILE_DECLARE(GPU_Shader);
 
 void InterpreterEngine::Run(const ShaderSetup& setup, UnitState& state) const {
@@ -680,6 +1579,30 @@ void InterpreterEngine::Run(const ShaderSetup& setup, UnitState& state) const {
     RunInterpreter(setup, state, dummy_debug_data, setup.engine_data.entry_point);
 }
 
+void InterpreterEngine::RunBatch(const ShaderSetup& setup, std::span<UnitState> states) const {
+    MICROPROFILE_SCOPE(GPU_Shader);
+
+    static const BatchRunner run_batch = SelectBatchRunner();
+
+    DebugData<false> dummy_debug_data;
+    BatchUnitState batch{};
+    for (std::size_t first = 0; first < states.size(); first += BATCH_LANES) {
+        const auto lanes = states.subspan(first, std::min(BATCH_LANES, states.size() - first));
+        if (lanes.size() > 1) {
+            LoadBatch(batch, lanes);
+            if (run_batch(setup, batch, lanes.size(), setup.engine_data.entry_point)) {
+                StoreBatch(batch, lanes);
+                continue;
+            }
+        }
+
+        // Single vertices and batches that can't run in lockstep go through the scalar path
+        for (UnitState& state : lanes) {
+            RunInterpreter(setup, state, dummy_debug_data, setup.engine_data.entry_point);
+        }
+    }
+}
+
 DebugData<true> InterpreterEngine::ProduceDebugInfo(const ShaderSetup& setup,
                                                     const AttributeBuffer& input,
                                                     const ShaderRegs& config) const {
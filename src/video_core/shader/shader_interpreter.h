@@ -14,6 +14,12 @@ public:
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
 
+    /**
+     * Runs the shader on groups of vertices in lockstep, using a structure-of-arrays register
+     * layout so each instruction is decoded once for the whole group.
+     */
+    void RunBatch(const ShaderSetup& setup, std::span<UnitState> states) const override;
+
     /**
      * Produce debug information based on the given shader and input vertex
      * @param setup  Shader engine state
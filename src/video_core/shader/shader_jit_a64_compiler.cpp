@@ -0,0 +1,1130 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/arch.h"
+#if CITRA_ARCH(arm64)
+
+#include <algorithm>
+#include <cstdint>
+#include <nihstro/shader_bytecode.h>
+#include "common/aarch64/oaknut_abi.h"
+#include "common/aarch64/oaknut_util.h"
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/vector_math.h"
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_jit_a64_compiler.h"
+
+using namespace Common::A64;
+using namespace oaknut;
+using namespace oaknut::util;
+
+namespace Pica::Shader {
+
+typedef void (JitShader::*JitFunction)(Instruction instr);
+
+const JitFunction instr_table[64] = {
+    &JitShader::Compile_ADD,    // add
+    &JitShader::Compile_DP3,    // dp3
+    &JitShader::Compile_DP4,    // dp4
+    &JitShader::Compile_DPH,    // dph
+    nullptr,                    // unknown
+    &JitShader::Compile_EX2,    // ex2
+    &JitShader::Compile_LG2,    // lg2
+    nullptr,                    // unknown
+    &JitShader::Compile_MUL,    // mul
+    &JitShader::Compile_SGE,    // sge
+    &JitShader::Compile_SLT,    // slt
+    &JitShader::Compile_FLR,    // flr
+    &JitShader::Compile_MAX,    // max
+    &JitShader::Compile_MIN,    // min
+    &JitShader::Compile_RCP,    // rcp
+    &JitShader::Compile_RSQ,    // rsq
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    &JitShader::Compile_MOVA,   // mova
+    &JitShader::Compile_MOV,    // mov
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    &JitShader::Compile_DPH,    // dphi
+    nullptr,                    // unknown
+    &JitShader::Compile_SGE,    // sgei
+    &JitShader::Compile_SLT,    // slti
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    &JitShader::Compile_NOP,    // nop
+    &JitShader::Compile_END,    // end
+    &JitShader::Compile_BREAKC, // breakc
+    &JitShader::Compile_CALL,   // call
+    &JitShader::Compile_CALLC,  // callc
+    &JitShader::Compile_CALLU,  // callu
+    &JitShader::Compile_IF,     // ifu
+    &JitShader::Compile_IF,     // ifc
+    &JitShader::Compile_LOOP,   // loop
+    &JitShader::Compile_EMIT,   // emit
+    &JitShader::Compile_SETE,   // sete
+    &JitShader::Compile_JMP,    // jmpc
+    &JitShader::Compile_JMP,    // jmpu
+    &JitShader::Compile_CMP,    // cmp
+    &JitShader::Compile_CMP,    // cmp
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+};
+
+// The following is used to alias some commonly used registers. Generally, X4-X5 and Q0-Q5 can be
+// used as scratch registers within a compiler function. The other registers have designated
+// purposes, as documented below:
+
+/// Pointer to the uniform memory
+constexpr XReg UNIFORMS = X9;
+/// The two 32-bit VS address offset registers set by the MOVA instruction
+constexpr XReg ADDROFFS_REG_0 = X10;
+constexpr XReg ADDROFFS_REG_1 = X11;
+/// VS loop count register (Multiplied by 16)
+constexpr WReg LOOPCOUNT_REG = W12;
+/// Current VS loop iteration number (we could probably use LOOPCOUNT_REG, but this quicker)
+constexpr WReg LOOPCOUNT = W6;
+/// Number to increment LOOPCOUNT_REG by on each loop iteration (Multiplied by 16)
+constexpr WReg LOOPINC = W7;
+/// Result of the previous CMP instruction for the X-component comparison
+constexpr XReg COND0 = X13;
+/// Result of the previous CMP instruction for the Y-component comparison
+constexpr XReg COND1 = X14;
+/// Pointer to the UnitState instance for the current VS unit
+constexpr XReg STATE = X15;
+/// General purpose scratch registers
+constexpr XReg XSCRATCH0 = X4;
+constexpr XReg XSCRATCH1 = X5;
+/// SIMD scratch register
+constexpr QReg VSCRATCH0 = Q0;
+/// Loaded with the first swizzled source register, otherwise can be used as a scratch register
+constexpr QReg SRC1 = Q1;
+/// Loaded with the second swizzled source register, otherwise can be used as a scratch register
+constexpr QReg SRC2 = Q2;
+/// Loaded with the third swizzled source register, otherwise can be used as a scratch register
+constexpr QReg SRC3 = Q3;
+/// Additional scratch registers
+constexpr QReg VSCRATCH1 = Q4;
+constexpr QReg VSCRATCH2 = Q5;
+/// Constant vector of [1.0f, 1.0f, 1.0f, 1.0f], used to efficiently set a vector to one
+constexpr QReg ONE = Q14;
+
+// State registers that must not be modified by external functions calls
+// Scratch registers, e.g., SRC1 and VSCRATCH0, have to be saved on the side if needed
+static const std::bitset<64> persistent_regs = BuildRegSet({
+    // Pointers to register blocks
+    UNIFORMS,
+    STATE,
+    // Cached registers
+    ADDROFFS_REG_0,
+    ADDROFFS_REG_1,
+    LOOPCOUNT_REG,
+    COND0,
+    COND1,
+    // Constants
+    ONE,
+    // Loop variables
+    LOOPCOUNT,
+    LOOPINC,
+    // Link register, holds the return address of the current subroutine
+    X30,
+});
+
+/// Raw constant for the source register selector that indicates no swizzling is performed
+static const u8 NO_SRC_REG_SWIZZLE = 0x1b;
+/// Raw constant for the destination register enable mask that indicates all components are enabled
+static const u8 NO_DEST_REG_MASK = 0xf;
+
+/// Returns the lowest 32-bit lane of a vector register as a scalar register
+static constexpr SReg ToS(QReg reg) {
+    return SReg(reg.index());
+}
+
+static void LogCritical(const char* msg) {
+    LOG_CRITICAL(HW_GPU, "{}", msg);
+}
+
+void JitShader::Compile_Assert(bool condition, const char* msg) {
+    if (!condition) {
+        ABI_PushRegisters(*this, PersistentCallerSavedRegs());
+        MOVP2R(ABI_PARAM1, msg);
+        CallFarFunction(*this, LogCritical);
+        ABI_PopRegisters(*this, PersistentCallerSavedRegs());
+    }
+}
+
+/**
+ * Loads and swizzles a source register into the specified vector register.
+ * @param instr VS instruction, used for determining how to load the source register
+ * @param src_num Number indicating which source register to load (1 = src1, 2 = src2, 3 = src3)
+ * @param src_reg SourceRegister object corresponding to the source register to load
+ * @param dest Destination vector register to store the loaded, swizzled source register
+ */
+void JitShader::Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRegister src_reg,
+                                   QReg dest) {
+    const bool is_uniform = src_reg.GetRegisterType() == RegisterType::FloatUniform;
+    const XReg src_ptr = is_uniform ? UNIFORMS : STATE;
+    const std::size_t src_offset = is_uniform ? Uniforms::GetFloatUniformOffset(src_reg.GetIndex())
+                                              : UnitState::InputOffset(src_reg);
+
+    unsigned operand_desc_id;
+
+    const bool is_inverted =
+        (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+    unsigned address_register_index;
+    unsigned offset_src;
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        operand_desc_id = instr.mad.operand_desc_id;
+        offset_src = is_inverted ? 3 : 2;
+        address_register_index = instr.mad.address_register_index;
+    } else {
+        operand_desc_id = instr.common.operand_desc_id;
+        offset_src = is_inverted ? 2 : 1;
+        address_register_index = instr.common.address_register_index;
+    }
+
+    if (src_num == offset_src && address_register_index != 0) {
+        switch (address_register_index) {
+        case 1: // address offset 1
+            ADD(XSCRATCH1, src_ptr, ADDROFFS_REG_0);
+            break;
+        case 2: // address offset 2
+            ADD(XSCRATCH1, src_ptr, ADDROFFS_REG_1);
+            break;
+        case 3: // address offset 3
+            ADD(XSCRATCH1, src_ptr, LOOPCOUNT_REG.toX());
+            break;
+        default:
+            UNREACHABLE();
+            break;
+        }
+        LDR(dest, XSCRATCH1, src_offset);
+    } else {
+        // Load the source
+        LDR(dest, src_ptr, src_offset);
+    }
+
+    SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
+
+    // Generate instructions for source register swizzling as needed
+    const u8 sel = swiz.GetRawSelector(src_num);
+    if (sel != NO_SRC_REG_SWIZZLE) {
+        const unsigned x = (sel >> 6) & 3;
+        if (sel == x * 0x55) {
+            // Broadcast of a single component
+            DUP(dest.S4(), dest.Selem()[x]);
+        } else {
+            // Shuffle inputs for swizzle using the precomputed byte indices of the selector
+            ADR(XSCRATCH0, swizzle_table);
+            LDR(VSCRATCH2, XSCRATCH0, sel * 16);
+            TBL(dest.B16(), List{dest.B16()}, VSCRATCH2.B16());
+        }
+    }
+
+    // If the source register should be negated, flip the sign bit
+    const bool negate[] = {swiz.negate_src1, swiz.negate_src2, swiz.negate_src3};
+    if (negate[src_num - 1]) {
+        FNEG(dest.S4(), dest.S4());
+    }
+}
+
+void JitShader::Compile_DestEnable(Instruction instr, QReg src) {
+    DestRegister dest;
+    unsigned operand_desc_id;
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        operand_desc_id = instr.mad.operand_desc_id;
+        dest = instr.mad.dest.Value();
+    } else {
+        operand_desc_id = instr.common.operand_desc_id;
+        dest = instr.common.dest.Value();
+    }
+
+    SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
+
+    std::size_t dest_offset_disp = UnitState::OutputOffset(dest);
+
+    // If all components are enabled, write the result to the destination register
+    if (swiz.dest_mask == NO_DEST_REG_MASK) {
+        // Store dest back to memory
+        STR(src, STATE, dest_offset_disp);
+
+    } else {
+        // Not all components are enabled, so mask the result when storing to the destination
+        // register...
+        LDR(VSCRATCH0, STATE, dest_offset_disp);
+
+        for (unsigned i = 0; i < 4; ++i) {
+            if (swiz.DestComponentEnabled(i)) {
+                MOV(VSCRATCH0.Selem()[i], src.Selem()[i]);
+            }
+        }
+
+        // Store dest back to memory
+        STR(VSCRATCH0, STATE, dest_offset_disp);
+    }
+}
+
+void JitShader::Compile_SanitizedMul(QReg src1, QReg src2, QReg scratch) {
+    // 0 * inf and inf * 0 in the PICA should return 0 instead of NaN. FMULX behaves exactly like
+    // FMUL except that it returns 2.0 for these cases, so the results of both only differ where
+    // FMUL generated a NaN from a 0 * inf multiplication. Clear those components to 0 to match
+    // PICA fp rules.
+    FMULX(scratch.S4(), src1.S4(), src2.S4());
+    FMUL(src1.S4(), src1.S4(), src2.S4());
+    CMEQ(scratch.S4(), scratch.S4(), src1.S4());
+    AND(src1.B16(), src1.B16(), scratch.B16());
+}
+
+void JitShader::Compile_EvaluateCondition(Instruction instr) {
+    // Note: NXOR is used below to check for equality
+    const auto nxor = [this](WReg dest, XReg cond, u32 ref) {
+        if (ref) {
+            MOV(dest, cond.toW());
+        } else {
+            EOR(dest, cond.toW(), 1);
+        }
+    };
+
+    const WReg result = XSCRATCH0.toW();
+    const WReg scratch = XSCRATCH1.toW();
+    switch (instr.flow_control.op) {
+    case Instruction::FlowControlType::Or:
+        nxor(result, COND0, instr.flow_control.refx.Value());
+        nxor(scratch, COND1, instr.flow_control.refy.Value());
+        ORR(result, result, scratch);
+        break;
+
+    case Instruction::FlowControlType::And:
+        nxor(result, COND0, instr.flow_control.refx.Value());
+        nxor(scratch, COND1, instr.flow_control.refy.Value());
+        AND(result, result, scratch);
+        break;
+
+    case Instruction::FlowControlType::JustX:
+        nxor(result, COND0, instr.flow_control.refx.Value());
+        break;
+
+    case Instruction::FlowControlType::JustY:
+        nxor(result, COND1, instr.flow_control.refy.Value());
+        break;
+    }
+}
+
+void JitShader::Compile_UniformCondition(Instruction instr) {
+    std::size_t offset = Uniforms::GetBoolUniformOffset(instr.flow_control.bool_uniform_id);
+    LDRB(XSCRATCH0.toW(), UNIFORMS, offset);
+}
+
+std::bitset<64> JitShader::PersistentCallerSavedRegs() {
+    return persistent_regs & ABI_ALL_CALLER_SAVED;
+}
+
+void JitShader::Compile_ADD(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    FADD(SRC1.S4(), SRC1.S4(), SRC2.S4());
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_DP3(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    Compile_SanitizedMul(SRC1, SRC2, VSCRATCH0);
+
+    DUP(SRC2.S4(), SRC1.Selem()[1]);
+    DUP(SRC3.S4(), SRC1.Selem()[2]);
+    DUP(SRC1.S4(), SRC1.Selem()[0]);
+    FADD(SRC1.S4(), SRC1.S4(), SRC2.S4());
+    FADD(SRC1.S4(), SRC1.S4(), SRC3.S4());
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_DP4(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    Compile_SanitizedMul(SRC1, SRC2, VSCRATCH0);
+
+    FADDP(SRC1.S4(), SRC1.S4(), SRC1.S4());
+    FADDP(SRC1.S4(), SRC1.S4(), SRC1.S4());
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_DPH(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::DPHI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    // Set 4th component to 1.0
+    MOV(SRC1.Selem()[3], ONE.Selem()[0]);
+
+    Compile_SanitizedMul(SRC1, SRC2, VSCRATCH0);
+
+    FADDP(SRC1.S4(), SRC1.S4(), SRC1.S4());
+    FADDP(SRC1.S4(), SRC1.S4(), SRC1.S4());
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_EX2(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    // The link register holds the return address when inside a CALL, preserve it
+    STR(X30, SP, PRE_INDEXED, -16);
+    BL(exp2_subroutine);
+    LDR(X30, SP, POST_INDEXED, 16);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_LG2(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    // The link register holds the return address when inside a CALL, preserve it
+    STR(X30, SP, PRE_INDEXED, -16);
+    BL(log2_subroutine);
+    LDR(X30, SP, POST_INDEXED, 16);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_MUL(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    Compile_SanitizedMul(SRC1, SRC2, VSCRATCH0);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_SGE(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SGEI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    FCMGE(SRC2.S4(), SRC1.S4(), SRC2.S4());
+    AND(SRC2.B16(), SRC2.B16(), ONE.B16());
+
+    Compile_DestEnable(instr, SRC2);
+}
+
+void JitShader::Compile_SLT(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SLTI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    FCMGT(SRC1.S4(), SRC2.S4(), SRC1.S4());
+    AND(SRC1.B16(), SRC1.B16(), ONE.B16());
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_FLR(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    FRINTM(SRC1.S4(), SRC1.S4());
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_MAX(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    // FMAX propagates NaNs, but in case of NaN the PICA returns SRC2. Select SRC1 only where it is
+    // greater, the comparison is false for NaNs.
+    FCMGT(VSCRATCH0.S4(), SRC1.S4(), SRC2.S4());
+    BIF(SRC1.B16(), SRC2.B16(), VSCRATCH0.B16());
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_MIN(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    // FMIN propagates NaNs, but in case of NaN the PICA returns SRC2. Select SRC1 only where it is
+    // less, the comparison is false for NaNs.
+    FCMGT(VSCRATCH0.S4(), SRC2.S4(), SRC1.S4());
+    BIF(SRC1.B16(), SRC2.B16(), VSCRATCH0.B16());
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_MOVA(Instruction instr) {
+    SwizzlePattern swiz = {(*swizzle_data)[instr.common.operand_desc_id]};
+
+    if (!swiz.DestComponentEnabled(0) && !swiz.DestComponentEnabled(1)) {
+        return; // NoOp
+    }
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // Convert floats to integers using truncation (only care about X and Y components)
+    FCVTZS(SRC1.S4(), SRC1.S4());
+
+    // Handle destination enable
+    if (swiz.DestComponentEnabled(0)) {
+        // Move and sign-extend the X component
+        SMOV(ADDROFFS_REG_0, SRC1.Selem()[0]);
+
+        // Multiply by 16 to be used as an offset later
+        LSL(ADDROFFS_REG_0, ADDROFFS_REG_0, 4);
+    }
+    if (swiz.DestComponentEnabled(1)) {
+        // Move and sign-extend the Y component
+        SMOV(ADDROFFS_REG_1, SRC1.Selem()[1]);
+
+        // Multiply by 16 to be used as an offset later
+        LSL(ADDROFFS_REG_1, ADDROFFS_REG_1, 4);
+    }
+}
+
+void JitShader::Compile_MOV(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_RCP(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // FRECPE only provides an 8-bit estimate, a full precision division matches the interpreter.
+    FDIV(ToS(SRC1), ToS(ONE), ToS(SRC1));
+    DUP(SRC1.S4(), SRC1.Selem()[0]); // XYWZ -> XXXX
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_RSQ(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // FRSQRTE only provides an 8-bit estimate, a full precision division matches the interpreter.
+    FSQRT(ToS(SRC1), ToS(SRC1));
+    FDIV(ToS(SRC1), ToS(ONE), ToS(SRC1));
+    DUP(SRC1.S4(), SRC1.Selem()[0]); // XYWZ -> XXXX
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_NOP(Instruction instr) {}
+
+void JitShader::Compile_END(Instruction instr) {
+    // Save conditional code
+    STRB(COND0.toW(), STATE, offsetof(UnitState, conditional_code[0]));
+    STRB(COND1.toW(), STATE, offsetof(UnitState, conditional_code[1]));
+
+    // Save address/loop registers
+    ASR(ADDROFFS_REG_0, ADDROFFS_REG_0, 4);
+    ASR(ADDROFFS_REG_1, ADDROFFS_REG_1, 4);
+    ASR(LOOPCOUNT_REG, LOOPCOUNT_REG, 4);
+    STR(ADDROFFS_REG_0.toW(), STATE, offsetof(UnitState, address_registers[0]));
+    STR(ADDROFFS_REG_1.toW(), STATE, offsetof(UnitState, address_registers[1]));
+    STR(LOOPCOUNT_REG, STATE, offsetof(UnitState, address_registers[2]));
+
+    // Drop the dummy return offset and restore the caller's registers
+    ADD(SP, SP, 16);
+    ABI_PopRegisters(*this, ABI_ALL_CALLEE_SAVED);
+    RET();
+}
+
+void JitShader::Compile_BREAKC(Instruction instr) {
+    Compile_Assert(loop_depth, "BREAKC must be inside a LOOP");
+    if (loop_depth) {
+        Compile_EvaluateCondition(instr);
+        ASSERT(!loop_break_labels.empty());
+        Label b;
+        CBZ(XSCRATCH0.toW(), b);
+        B(loop_break_labels.back());
+        l(b);
+    }
+}
+
+void JitShader::Compile_CALL(Instruction instr) {
+    // Push offset of the return and the link register, keeping the stack 16-byte aligned
+    MOV(XSCRATCH0,
+        static_cast<u64>(instr.flow_control.dest_offset + instr.flow_control.num_instructions));
+    STP(XSCRATCH0, X30, SP, PRE_INDEXED, -16);
+
+    // Call the subroutine
+    BL(instruction_labels[instr.flow_control.dest_offset]);
+
+    // Skip over the return offset that's on the stack
+    LDP(XSCRATCH0, X30, SP, POST_INDEXED, 16);
+}
+
+void JitShader::Compile_CALLC(Instruction instr) {
+    Compile_EvaluateCondition(instr);
+    Label b;
+    CBZ(XSCRATCH0.toW(), b);
+    Compile_CALL(instr);
+    l(b);
+}
+
+void JitShader::Compile_CALLU(Instruction instr) {
+    Compile_UniformCondition(instr);
+    Label b;
+    CBZ(XSCRATCH0.toW(), b);
+    Compile_CALL(instr);
+    l(b);
+}
+
+void JitShader::Compile_CMP(Instruction instr) {
+    using Op = Instruction::Common::CompareOpType::Op;
+    Op op_x = instr.common.compare_op.x;
+    Op op_y = instr.common.compare_op.y;
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    // Comparisons with NaN operands are false, except for NotEqual which is the inverse of
+    // Equal and thus true.
+    const auto compare = [this](QReg dest, Op op) {
+        switch (op) {
+        case Op::Equal:
+            FCMEQ(dest.S4(), SRC1.S4(), SRC2.S4());
+            break;
+        case Op::NotEqual:
+            FCMEQ(dest.S4(), SRC1.S4(), SRC2.S4());
+            MVN(dest.B16(), dest.B16());
+            break;
+        case Op::LessThan:
+            FCMGT(dest.S4(), SRC2.S4(), SRC1.S4());
+            break;
+        case Op::LessEqual:
+            FCMGE(dest.S4(), SRC2.S4(), SRC1.S4());
+            break;
+        case Op::GreaterThan:
+            FCMGT(dest.S4(), SRC1.S4(), SRC2.S4());
+            break;
+        case Op::GreaterEqual:
+            FCMGE(dest.S4(), SRC1.S4(), SRC2.S4());
+            break;
+        default:
+            LOG_ERROR(HW_GPU, "Unknown compare mode {:x}", static_cast<int>(op));
+            break;
+        }
+    };
+
+    if (op_x == op_y) {
+        // Compare X-component and Y-component together
+        compare(VSCRATCH0, op_x);
+        UMOV(COND0.toW(), VSCRATCH0.Selem()[0]);
+        UMOV(COND1.toW(), VSCRATCH0.Selem()[1]);
+    } else {
+        compare(VSCRATCH0, op_x);
+        compare(VSCRATCH1, op_y);
+        UMOV(COND0.toW(), VSCRATCH0.Selem()[0]);
+        UMOV(COND1.toW(), VSCRATCH1.Selem()[1]);
+    }
+
+    LSR(COND0.toW(), COND0.toW(), 31);
+    LSR(COND1.toW(), COND1.toW(), 31);
+}
+
+void JitShader::Compile_MAD(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.mad.src1, SRC1);
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        Compile_SwizzleSrc(instr, 2, instr.mad.src2i, SRC2);
+        Compile_SwizzleSrc(instr, 3, instr.mad.src3i, SRC3);
+    } else {
+        Compile_SwizzleSrc(instr, 2, instr.mad.src2, SRC2);
+        Compile_SwizzleSrc(instr, 3, instr.mad.src3, SRC3);
+    }
+
+    Compile_SanitizedMul(SRC1, SRC2, VSCRATCH0);
+    FADD(SRC1.S4(), SRC1.S4(), SRC3.S4());
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_IF(Instruction instr) {
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter,
+                   "Backwards if-statements not supported");
+    Label l_if, l_else, l_endif;
+
+    // Evaluate the "IF" condition
+    if (instr.opcode.Value() == OpCode::Id::IFU) {
+        Compile_UniformCondition(instr);
+    } else if (instr.opcode.Value() == OpCode::Id::IFC) {
+        Compile_EvaluateCondition(instr);
+    }
+    // Branch over an unconditional jump, CBZ has a limited range
+    CBNZ(XSCRATCH0.toW(), l_if);
+    B(l_else);
+    l(l_if);
+
+    // Compile the code that corresponds to the condition evaluating as true
+    Compile_Block(instr.flow_control.dest_offset);
+
+    // If there isn't an "ELSE" condition, we are done here
+    if (instr.flow_control.num_instructions == 0) {
+        l(l_else);
+        return;
+    }
+
+    B(l_endif);
+
+    l(l_else);
+    // This code corresponds to the "ELSE" condition
+    // Comple the code that corresponds to the condition evaluating as false
+    Compile_Block(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+
+    l(l_endif);
+}
+
+void JitShader::Compile_LOOP(Instruction instr) {
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter,
+                   "Backwards loops not supported");
+    Compile_Assert(loop_depth < 1, "Nested loops may not be supported");
+    if (loop_depth++) {
+        const auto loop_save_regs = BuildRegSet({LOOPCOUNT_REG, LOOPINC, LOOPCOUNT});
+        ABI_PushRegisters(*this, loop_save_regs);
+    }
+
+    // This decodes the fields from the integer uniform at index instr.flow_control.int_uniform_id.
+    // The Y (LOOPCOUNT_REG) and Z (LOOPINC) component are kept multiplied by 16 (Left shifted by
+    // 4 bits) to be used as an offset into the 16-byte vector registers later
+    std::size_t offset = Uniforms::GetIntUniformOffset(instr.flow_control.int_uniform_id);
+    LDR(LOOPCOUNT, UNIFORMS, offset);
+    UBFX(LOOPCOUNT_REG, LOOPCOUNT, 8, 8);
+    LSL(LOOPCOUNT_REG, LOOPCOUNT_REG, 4); // Y-component is the start
+    UBFX(LOOPINC, LOOPCOUNT, 16, 8);
+    LSL(LOOPINC, LOOPINC, 4);         // Z-component is the incrementer
+    UXTB(LOOPCOUNT, LOOPCOUNT);       // X-component is iteration count
+    ADD(LOOPCOUNT, LOOPCOUNT, 1);     // Iteration count is X-component + 1
+
+    Label l_loop_start;
+    l(l_loop_start);
+
+    loop_break_labels.emplace_back(Label());
+    Compile_Block(instr.flow_control.dest_offset + 1);
+
+    ADD(LOOPCOUNT_REG, LOOPCOUNT_REG, LOOPINC); // Increment LOOPCOUNT_REG by Z-component
+    SUBS(LOOPCOUNT, LOOPCOUNT, 1);              // Increment loop count by 1
+    B(Cond::NE, l_loop_start);                  // Loop if not equal
+
+    l(loop_break_labels.back());
+    loop_break_labels.pop_back();
+
+    if (--loop_depth) {
+        const auto loop_save_regs = BuildRegSet({LOOPCOUNT_REG, LOOPINC, LOOPCOUNT});
+        ABI_PopRegisters(*this, loop_save_regs);
+    }
+}
+
+void JitShader::Compile_JMP(Instruction instr) {
+    if (instr.opcode.Value() == OpCode::Id::JMPC)
+        Compile_EvaluateCondition(instr);
+    else if (instr.opcode.Value() == OpCode::Id::JMPU)
+        Compile_UniformCondition(instr);
+    else
+        UNREACHABLE();
+
+    bool inverted_condition =
+        (instr.opcode.Value() == OpCode::Id::JMPU) && (instr.flow_control.num_instructions & 1);
+
+    // Branch over an unconditional jump, CBZ/CBNZ have a limited range
+    Label& b = instruction_labels[instr.flow_control.dest_offset];
+    Label skip;
+    if (inverted_condition) {
+        CBNZ(XSCRATCH0.toW(), skip);
+    } else {
+        CBZ(XSCRATCH0.toW(), skip);
+    }
+    B(b);
+    l(skip);
+}
+
+static void Emit(GSEmitter* emitter, Common::Vec4<float24> (*output)[16]) {
+    emitter->Emit(*output);
+}
+
+void JitShader::Compile_EMIT(Instruction instr) {
+    Label have_emitter, end;
+    LDR(XSCRATCH0, STATE, offsetof(UnitState, emitter_ptr));
+    CBNZ(XSCRATCH0, have_emitter);
+
+    ABI_PushRegisters(*this, PersistentCallerSavedRegs());
+    MOVP2R(ABI_PARAM1, "Execute EMIT on VS");
+    CallFarFunction(*this, LogCritical);
+    ABI_PopRegisters(*this, PersistentCallerSavedRegs());
+    B(end);
+
+    l(have_emitter);
+    ABI_PushRegisters(*this, PersistentCallerSavedRegs());
+    MOV(ABI_PARAM1, XSCRATCH0);
+    ADD(ABI_PARAM2, STATE, offsetof(UnitState, registers.output));
+    CallFarFunction(*this, Emit);
+    ABI_PopRegisters(*this, PersistentCallerSavedRegs());
+    l(end);
+}
+
+void JitShader::Compile_SETE(Instruction instr) {
+    Label have_emitter, end;
+    LDR(XSCRATCH0, STATE, offsetof(UnitState, emitter_ptr));
+    CBNZ(XSCRATCH0, have_emitter);
+
+    ABI_PushRegisters(*this, PersistentCallerSavedRegs());
+    MOVP2R(ABI_PARAM1, "Execute SETEMIT on VS");
+    CallFarFunction(*this, LogCritical);
+    ABI_PopRegisters(*this, PersistentCallerSavedRegs());
+    B(end);
+
+    l(have_emitter);
+    MOV(XSCRATCH1.toW(), static_cast<u32>(instr.setemit.vertex_id.Value()));
+    STRB(XSCRATCH1.toW(), XSCRATCH0, offsetof(GSEmitter, vertex_id));
+    MOV(XSCRATCH1.toW(), static_cast<u32>(instr.setemit.prim_emit.Value()));
+    STRB(XSCRATCH1.toW(), XSCRATCH0, offsetof(GSEmitter, prim_emit));
+    MOV(XSCRATCH1.toW(), static_cast<u32>(instr.setemit.winding.Value()));
+    STRB(XSCRATCH1.toW(), XSCRATCH0, offsetof(GSEmitter, winding));
+    l(end);
+}
+
+void JitShader::Compile_Block(unsigned end) {
+    while (program_counter < end) {
+        Compile_NextInstr();
+    }
+}
+
+void JitShader::Compile_Return() {
+    // Peek return offset on the stack and check if we're at that offset
+    LDR(XSCRATCH0, SP, 0);
+    CMP(XSCRATCH0, program_counter);
+
+    // If so, jump back to before CALL
+    Label b;
+    B(Cond::NE, b);
+    RET();
+    l(b);
+}
+
+void JitShader::Compile_NextInstr() {
+    if (std::binary_search(return_offsets.begin(), return_offsets.end(), program_counter)) {
+        Compile_Return();
+    }
+
+    l(instruction_labels[program_counter]);
+    instruction_addresses[program_counter] = oaknut::CodeGenerator::ptr<const std::byte*>();
+
+    Instruction instr = {(*program_code)[program_counter++]};
+
+    OpCode::Id opcode = instr.opcode.Value();
+    auto instr_func = instr_table[static_cast<unsigned>(opcode)];
+
+    if (instr_func) {
+        // JIT the instruction!
+        ((*this).*instr_func)(instr);
+    } else {
+        // Unhandled instruction
+        LOG_CRITICAL(HW_GPU, "Unhandled instruction: 0x{:02x} (0x{:08x})",
+                     static_cast<u32>(instr.opcode.Value().EffectiveOpCode()), instr.hex);
+    }
+}
+
+void JitShader::FindReturnOffsets() {
+    return_offsets.clear();
+
+    for (std::size_t offset = 0; offset < program_code->size(); ++offset) {
+        Instruction instr = {(*program_code)[offset]};
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::CALL:
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU:
+            return_offsets.push_back(instr.flow_control.dest_offset +
+                                     instr.flow_control.num_instructions);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Sort for efficient binary search later
+    std::sort(return_offsets.begin(), return_offsets.end());
+}
+
+void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
+                        const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_) {
+    program_code = program_code_;
+    swizzle_data = swizzle_data_;
+
+    unprotect();
+
+    // Reset flow control state
+    program = oaknut::CodeGenerator::ptr<CompiledShader*>();
+    program_counter = 0;
+    loop_depth = 0;
+    instruction_labels.fill(Label());
+    instruction_addresses.fill(nullptr);
+
+    // Find all `CALL` instructions and identify return locations
+    FindReturnOffsets();
+
+    // We reserve 16 bytes and assign a dummy value to the first 8 bytes, to catch any potential
+    // return checks (see Compile_Return) that happen in shader main routine.
+    ABI_PushRegisters(*this, ABI_ALL_CALLEE_SAVED);
+    MOV(XSCRATCH0, 0xFFFFFFFFFFFFFFFFULL);
+    STP(XSCRATCH0, XZR, SP, PRE_INDEXED, -16);
+
+    MOV(UNIFORMS, ABI_PARAM1);
+    MOV(STATE, ABI_PARAM2);
+
+    // Load address/loop registers
+    LDRSW(ADDROFFS_REG_0, STATE, offsetof(UnitState, address_registers[0]));
+    LDRSW(ADDROFFS_REG_1, STATE, offsetof(UnitState, address_registers[1]));
+    LDR(LOOPCOUNT_REG, STATE, offsetof(UnitState, address_registers[2]));
+    LSL(ADDROFFS_REG_0, ADDROFFS_REG_0, 4);
+    LSL(ADDROFFS_REG_1, ADDROFFS_REG_1, 4);
+    LSL(LOOPCOUNT_REG, LOOPCOUNT_REG, 4);
+
+    // Load conditional code
+    LDRB(COND0.toW(), STATE, offsetof(UnitState, conditional_code[0]));
+    LDRB(COND1.toW(), STATE, offsetof(UnitState, conditional_code[1]));
+
+    // Used to set a register to one
+    MOV(XSCRATCH0.toW(), 0x3f800000);
+    DUP(ONE.S4(), XSCRATCH0.toW());
+
+    // Jump to start of the shader program
+    BR(ABI_PARAM3);
+
+    // Compile entire program
+    Compile_Block(static_cast<unsigned>(program_code->size()));
+
+    // Free memory that's no longer needed
+    program_code = nullptr;
+    swizzle_data = nullptr;
+    return_offsets.clear();
+    return_offsets.shrink_to_fit();
+
+    protect();
+    invalidate_all();
+
+    const std::size_t code_size = oaknut::CodeGenerator::ptr<const std::byte*>() -
+                                  reinterpret_cast<const std::byte*>(oaknut::CodeBlock::ptr());
+    ASSERT_MSG(code_size <= MAX_SHADER_SIZE, "Compiled a shader that exceeds the allocated size!");
+    LOG_DEBUG(HW_GPU, "Compiled shader size={}", code_size);
+}
+
+JitShader::JitShader()
+    : oaknut::CodeBlock(MAX_SHADER_SIZE), oaknut::CodeGenerator(oaknut::CodeBlock::ptr()) {
+    unprotect();
+    CompilePrelude();
+}
+
+void JitShader::CompilePrelude() {
+    swizzle_table = CompilePrelude_SwizzleTable();
+    log2_subroutine = CompilePrelude_Log2();
+    exp2_subroutine = CompilePrelude_Exp2();
+}
+
+Label JitShader::CompilePrelude_SwizzleTable() {
+    Label table;
+
+    // NEON has no immediate shuffle like SHUFPS, so swizzles are performed with TBL. Emit the
+    // byte indices for every possible selector, entry `sel` is found at `table + sel * 16`.
+    l(table);
+    for (u32 sel = 0; sel < 256; ++sel) {
+        for (u32 component = 0; component < 4; ++component) {
+            const u32 src = ((sel >> (6 - 2 * component)) & 3) * 4;
+            dw(src | ((src + 1) << 8) | ((src + 2) << 16) | ((src + 3) << 24));
+        }
+    }
+
+    return table;
+}
+
+Label JitShader::CompilePrelude_Log2() {
+    Label subroutine;
+
+    // NEON does not have a log instruction, thus we must approximate.
+    // We perform this approximation first performaing a range reduction into the range [1.0, 2.0).
+    // A minimax polynomial which was fit for the function log2(x) / (x - 1) is then evaluated.
+    // We multiply the result by (x - 1) then restore the result into the appropriate range.
+    // The same polynomial as the x86_64 backend is used, so both JITs produce identical results.
+
+    // Coefficients for the minimax polynomial.
+    // f(x) computes approximately log2(x) / (x - 1).
+    // f(x) = c4 + x * (c3 + x * (c2 + x * (c1 + x * c0)).
+    constexpr u32 c0 = 0x3d74552f;
+    constexpr u32 c1 = 0xbeee7397;
+    constexpr u32 c2 = 0x3fbd96dd;
+    constexpr u32 c3 = 0xc02153f6;
+    constexpr u32 c4 = 0x4038d96c;
+
+    constexpr u32 negative_infinity = 0xff800000;
+    constexpr u32 default_qnan = 0x7fc00000;
+
+    // Loads a float constant into SRC2, which is free to use as a scratch register here
+    const auto load_constant = [this](u32 value) {
+        MOV(XSCRATCH1.toW(), value);
+        FMOV(ToS(SRC2), XSCRATCH1.toW());
+    };
+
+    Label input_is_nan, input_is_zero, input_out_of_range;
+
+    l(input_out_of_range);
+    B(Cond::EQ, input_is_zero);
+    MOV(XSCRATCH0.toW(), default_qnan);
+    DUP(SRC1.S4(), XSCRATCH0.toW());
+    RET();
+    l(input_is_zero);
+    MOV(XSCRATCH0.toW(), negative_infinity);
+    DUP(SRC1.S4(), XSCRATCH0.toW());
+    RET();
+
+    l(subroutine);
+
+    // Here we handle edge cases: input in {NaN, 0, -Inf, Negative}.
+    EOR(VSCRATCH0.B16(), VSCRATCH0.B16(), VSCRATCH0.B16());
+    FCMP(ToS(SRC1), ToS(VSCRATCH0));
+    B(Cond::VS, input_is_nan);
+    B(Cond::LS, input_out_of_range);
+
+    // Split input
+    FMOV(XSCRATCH0.toW(), ToS(SRC1));
+    AND(XSCRATCH1.toW(), XSCRATCH0.toW(), 0x007fffff);
+    ORR(XSCRATCH1.toW(), XSCRATCH1.toW(), 0x3f800000);
+    FMOV(ToS(SRC1), XSCRATCH1.toW());
+    // SRC1 now contains the mantissa of the input.
+    UBFX(XSCRATCH0.toW(), XSCRATCH0.toW(), 23, 8);
+    SUB(XSCRATCH0.toW(), XSCRATCH0.toW(), 0x7f);
+    SCVTF(ToS(VSCRATCH1), XSCRATCH0.toW());
+    // VSCRATCH1 now contains the exponent of the input.
+
+    // Complete computation of polynomial
+    load_constant(c0);
+    FMUL(ToS(VSCRATCH0), ToS(SRC2), ToS(SRC1));
+    load_constant(c1);
+    FADD(ToS(VSCRATCH0), ToS(VSCRATCH0), ToS(SRC2));
+    FMUL(ToS(VSCRATCH0), ToS(VSCRATCH0), ToS(SRC1));
+    load_constant(c2);
+    FADD(ToS(VSCRATCH0), ToS(VSCRATCH0), ToS(SRC2));
+    FMUL(ToS(VSCRATCH0), ToS(VSCRATCH0), ToS(SRC1));
+    load_constant(c3);
+    FADD(ToS(VSCRATCH0), ToS(VSCRATCH0), ToS(SRC2));
+    FMUL(ToS(VSCRATCH0), ToS(VSCRATCH0), ToS(SRC1));
+    FSUB(ToS(SRC1), ToS(SRC1), ToS(ONE));
+    load_constant(c4);
+    FADD(ToS(VSCRATCH0), ToS(VSCRATCH0), ToS(SRC2));
+    FMUL(ToS(VSCRATCH0), ToS(VSCRATCH0), ToS(SRC1));
+    FADD(ToS(VSCRATCH1), ToS(VSCRATCH1), ToS(VSCRATCH0));
+
+    // Duplicate result across vector
+    DUP(SRC1.S4(), VSCRATCH1.Selem()[0]);
+    RET();
+
+    l(input_is_nan);
+    DUP(SRC1.S4(), SRC1.Selem()[0]);
+    RET();
+
+    return subroutine;
+}
+
+Label JitShader::CompilePrelude_Exp2() {
+    Label subroutine;
+
+    // NEON does not have a exp instruction, thus we must approximate.
+    // We perform this approximation first performaing a range reduction into the range [-0.5, 0.5).
+    // A minimax polynomial which was fit for the function exp2(x) is then evaluated.
+    // We then restore the result into the appropriate range.
+
+    constexpr u32 input_max = 0x43010000;
+    constexpr u32 input_min = 0xc2fdffff;
+    constexpr u32 c0 = 0x3c5dbe69;
+    constexpr u32 half = 0x3f000000;
+    constexpr u32 c1 = 0x3d5509f9;
+    constexpr u32 c2 = 0x3e773cc5;
+    constexpr u32 c3 = 0x3f3168b3;
+    constexpr u32 c4 = 0x3f800016;
+
+    // Loads a float constant into SRC2, which is free to use as a scratch register here
+    const auto load_constant = [this](u32 value) {
+        MOV(XSCRATCH1.toW(), value);
+        FMOV(ToS(SRC2), XSCRATCH1.toW());
+    };
+
+    Label ret_label;
+
+    l(subroutine);
+
+    // Handle edge cases
+    FCMP(ToS(SRC1), ToS(SRC1));
+    B(Cond::VS, ret_label);
+    // Clamp to maximum range since we shift the value directly into the exponent.
+    load_constant(input_max);
+    FMIN(ToS(SRC1), ToS(SRC1), ToS(SRC2));
+    load_constant(input_min);
+    FMAX(ToS(SRC1), ToS(SRC1), ToS(SRC2));
+
+    // Decompose input
+    load_constant(half);
+    FSUB(ToS(VSCRATCH0), ToS(SRC1), ToS(SRC2));
+    FCVTNS(XSCRATCH0.toW(), ToS(VSCRATCH0));
+    SCVTF(ToS(VSCRATCH0), XSCRATCH0.toW());
+    // VSCRATCH0 now contains input rounded to the nearest integer.
+    ADD(XSCRATCH0.toW(), XSCRATCH0.toW(), 0x7f);
+    FSUB(ToS(SRC1), ToS(SRC1), ToS(VSCRATCH0));
+    // SRC1 contains input - round(input), which is in [-0.5, 0.5).
+    load_constant(c0);
+    FMUL(ToS(VSCRATCH1), ToS(SRC2), ToS(SRC1));
+    LSL(XSCRATCH0.toW(), XSCRATCH0.toW(), 23);
+    FMOV(ToS(VSCRATCH0), XSCRATCH0.toW());
+    // VSCRATCH0 contains 2^(round(input)).
+
+    // Complete computation of polynomial.
+    load_constant(c1);
+    FADD(ToS(VSCRATCH1), ToS(VSCRATCH1), ToS(SRC2));
+    FMUL(ToS(VSCRATCH1), ToS(VSCRATCH1), ToS(SRC1));
+    load_constant(c2);
+    FADD(ToS(VSCRATCH1), ToS(VSCRATCH1), ToS(SRC2));
+    FMUL(ToS(VSCRATCH1), ToS(VSCRATCH1), ToS(SRC1));
+    load_constant(c3);
+    FADD(ToS(VSCRATCH1), ToS(VSCRATCH1), ToS(SRC2));
+    FMUL(ToS(SRC1), ToS(SRC1), ToS(VSCRATCH1));
+    load_constant(c4);
+    FADD(ToS(SRC1), ToS(SRC1), ToS(SRC2));
+    FMUL(ToS(SRC1), ToS(SRC1), ToS(VSCRATCH0));
+
+    // Duplicate result across vector
+    l(ret_label);
+    DUP(SRC1.S4(), SRC1.Selem()[0]);
+
+    RET();
+
+    return subroutine;
+}
+
+} // namespace Pica::Shader
+
+#endif // CITRA_ARCH(arm64)
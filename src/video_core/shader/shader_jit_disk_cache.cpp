@@ -0,0 +1,180 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/settings.h"
+#include "core/core.h"
+#include "core/loader/loader.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_jit_disk_cache.h"
+
+namespace Pica::Shader {
+
+constexpr u32 NativeVersion = 1;
+
+constexpr std::size_t REVISION_LENGTH = 64;
+using BuildRevision = std::array<char, REVISION_LENGTH>;
+
+static BuildRevision GetBuildRevision() {
+    BuildRevision revision{};
+    const std::size_t length = std::min(std::strlen(Common::g_scm_rev), revision.size());
+    std::memcpy(revision.data(), Common::g_scm_rev, length);
+    return revision;
+}
+
+/// Returns the data without its trailing zero words, which make up most of the arrays
+template <std::size_t N>
+static std::size_t GetUsedLength(const std::array<u32, N>& data) {
+    const auto last = std::find_if(data.rbegin(), data.rend(), [](u32 word) { return word != 0; });
+    return static_cast<std::size_t>(data.rend() - last);
+}
+
+/// Returns the program id of the running title, or 0 if the disk cache shouldn't be used
+static u64 GetCurrentProgramId() {
+    if (!Settings::values.use_disk_shader_cache) {
+        return 0;
+    }
+    u64 program_id{};
+    if (Core::System::GetInstance().GetAppLoader().ReadProgramId(program_id) !=
+        Loader::ResultStatus::Success) {
+        return 0;
+    }
+    return program_id;
+}
+
+JitDiskCache::JitDiskCache() : JitDiskCache(GetCurrentProgramId()) {}
+
+JitDiskCache::JitDiskCache(u64 program_id_) : program_id{program_id_} {
+    if (program_id == 0) {
+        return;
+    }
+    file = OpenFile();
+}
+
+JitDiskCache::~JitDiskCache() = default;
+
+bool JitDiskCache::IsUsable() const {
+    return program_id != 0 && file.IsOpen();
+}
+
+std::vector<JitDiskCacheEntry> JitDiskCache::Load() {
+    if (!IsUsable()) {
+        return {};
+    }
+
+    file.Seek(0, SEEK_SET);
+    u32 version{};
+    BuildRevision revision{};
+    if (file.ReadBytes(&version, sizeof(version)) != sizeof(version) ||
+        file.ReadArray(revision.data(), revision.size()) != revision.size()) {
+        LOG_ERROR(HW_GPU, "Failed to read shader JIT cache header - removing");
+        Invalidate();
+        return {};
+    }
+    if (version != NativeVersion || revision != GetBuildRevision()) {
+        LOG_INFO(HW_GPU, "Shader JIT cache was created by a different build - removing");
+        Invalidate();
+        return {};
+    }
+
+    std::vector<JitDiskCacheEntry> entries;
+    while (file.Tell() < file.GetSize()) {
+        JitDiskCacheEntry entry{};
+        u64 code_length{};
+        u64 swizzle_length{};
+        if (file.ReadBytes(&entry.cache_key, sizeof(u64)) != sizeof(u64) ||
+            file.ReadBytes(&code_length, sizeof(u64)) != sizeof(u64) ||
+            code_length > MAX_PROGRAM_CODE_LENGTH) {
+            LOG_ERROR(HW_GPU, "Failed to read shader JIT cache entry - removing");
+            Invalidate();
+            return {};
+        }
+        entry.program_code.resize(code_length);
+        if (file.ReadArray(entry.program_code.data(), code_length) != code_length ||
+            file.ReadBytes(&swizzle_length, sizeof(u64)) != sizeof(u64) ||
+            swizzle_length > MAX_SWIZZLE_DATA_LENGTH) {
+            LOG_ERROR(HW_GPU, "Failed to read shader JIT cache entry - removing");
+            Invalidate();
+            return {};
+        }
+        entry.swizzle_data.resize(swizzle_length);
+        if (file.ReadArray(entry.swizzle_data.data(), swizzle_length) != swizzle_length) {
+            LOG_ERROR(HW_GPU, "Failed to read shader JIT cache entry - removing");
+            Invalidate();
+            return {};
+        }
+
+        stored_keys.insert(entry.cache_key);
+        entries.push_back(std::move(entry));
+    }
+
+    LOG_INFO(HW_GPU, "Found a shader JIT cache with {} entries for title id={:016X}",
+             entries.size(), program_id);
+    return entries;
+}
+
+void JitDiskCache::Save(u64 cache_key, const ShaderSetup& setup) {
+    if (!IsUsable() || !stored_keys.insert(cache_key).second) {
+        return;
+    }
+
+    const u64 code_length = GetUsedLength(setup.program_code);
+    const u64 swizzle_length = GetUsedLength(setup.swizzle_data);
+    if (file.WriteObject(cache_key) != 1 || file.WriteObject(code_length) != 1 ||
+        file.WriteArray(setup.program_code.data(), code_length) != code_length ||
+        file.WriteObject(swizzle_length) != 1 ||
+        file.WriteArray(setup.swizzle_data.data(), swizzle_length) != swizzle_length) {
+        LOG_ERROR(HW_GPU, "Failed to write shader JIT cache entry - removing");
+        Invalidate();
+        return;
+    }
+    file.Flush();
+}
+
+FileUtil::IOFile JitDiskCache::OpenFile() {
+    const std::string shader_dir = FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir);
+    const std::string jit_dir = shader_dir + DIR_SEP "jit";
+    if (!FileUtil::CreateDir(shader_dir) || !FileUtil::CreateDir(jit_dir)) {
+        LOG_ERROR(HW_GPU, "Failed to create directory={}", jit_dir);
+        return {};
+    }
+
+    const std::string path = GetFilePath();
+    FileUtil::IOFile new_file(path, "ab+");
+    if (!new_file.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Failed to open shader JIT cache in path={}", path);
+        return {};
+    }
+    if (new_file.GetSize() == 0) {
+        const BuildRevision revision = GetBuildRevision();
+        if (new_file.WriteObject(NativeVersion) != 1 ||
+            new_file.WriteArray(revision.data(), revision.size()) != revision.size()) {
+            LOG_ERROR(HW_GPU, "Failed to write shader JIT cache header in path={}", path);
+            return {};
+        }
+    }
+    return new_file;
+}
+
+void JitDiskCache::Invalidate() {
+    file.Close();
+    if (!FileUtil::Delete(GetFilePath())) {
+        LOG_ERROR(HW_GPU, "Failed to invalidate shader JIT cache file={}", GetFilePath());
+    }
+    stored_keys.clear();
+    file = OpenFile();
+}
+
+std::string JitDiskCache::GetFilePath() const {
+    return FileUtil::SanitizePath(FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir) +
+                                  DIR_SEP "jit" DIR_SEP + fmt::format("{:016X}.bin", program_id));
+}
+
+} // namespace Pica::Shader
@@ -0,0 +1,158 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/thread_worker.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica::Shader {
+
+/// Program code and swizzle data of a shader recorded in the JIT disk cache
+struct JitDiskCacheEntry {
+    u64 cache_key;
+    std::vector<u32> program_code;
+    std::vector<u32> swizzle_data;
+};
+
+/**
+ * Records the PICA shader programs used by a title, so the shader JIT is able to compile them
+ * ahead of time on the next boot. Only the guest programs are stored, the host code is
+ * regenerated on load. The file is discarded whenever the build revision changes.
+ */
+class JitDiskCache {
+public:
+    /// Opens the cache of the running title, if the disk shader cache is enabled
+    JitDiskCache();
+    /// Opens the cache of the given title, a program id of 0 leaves the cache unusable
+    explicit JitDiskCache(u64 program_id);
+    ~JitDiskCache();
+
+    /// Returns true if the cache is enabled and a title with a valid title id is running
+    bool IsUsable() const;
+
+    /// Loads the programs recorded for the current title. Invalidates the file on failure.
+    std::vector<JitDiskCacheEntry> Load();
+
+    /// Appends a program to the cache file unless it was recorded before
+    void Save(u64 cache_key, const ShaderSetup& setup);
+
+private:
+    /// Opens the cache file for appending, writing the header if the file is new
+    FileUtil::IOFile OpenFile();
+
+    /// Removes the cache file and starts over with an empty one
+    void Invalidate();
+
+    std::string GetFilePath() const;
+
+    FileUtil::IOFile file;
+    std::unordered_set<u64> stored_keys;
+    u64 program_id{};
+};
+
+/**
+ * Host programs compiled by a shader JIT backend, keyed by the guest program. The programs
+ * recorded in the disk cache are compiled on a background thread when the first program is
+ * requested, and new programs are recorded as they are compiled.
+ * @tparam Program Compiled shader of the backend, providing Compile(program_code, swizzle_data)
+ */
+template <typename Program>
+class JitProgramCache {
+public:
+    /// Returns the compiled program for the code and swizzle data of the setup
+    const Program* Get(ShaderSetup& setup) {
+        if (!disk_cache_loaded) {
+            disk_cache_loaded = true;
+            LoadDiskCache();
+        }
+
+        const u64 cache_key = setup.GetProgramCodeHash() ^ setup.GetSwizzleDataHash();
+        std::unique_lock lock{cache_mutex};
+        auto iter = cache.find(cache_key);
+        if (iter != cache.end()) {
+            return iter->second.get();
+        }
+
+        // Don't stall the background compilations while compiling this program
+        lock.unlock();
+        auto program = std::make_unique<Program>();
+        program->Compile(&setup.program_code, &setup.swizzle_data);
+        lock.lock();
+
+        // The program might have been precompiled in the meantime, in which case that one is used
+        iter = cache.try_emplace(cache_key, std::move(program)).first;
+        const Program* result = iter->second.get();
+        lock.unlock();
+
+        if (disk_cache) {
+            disk_cache->Save(cache_key, setup);
+        }
+        return result;
+    }
+
+private:
+    /// Queues the programs recorded in the disk cache for compilation on a background thread
+    void LoadDiskCache() {
+        disk_cache = std::make_unique<JitDiskCache>();
+        if (!disk_cache->IsUsable()) {
+            disk_cache.reset();
+            return;
+        }
+
+        std::vector<JitDiskCacheEntry> entries = disk_cache->Load();
+        if (entries.empty()) {
+            return;
+        }
+
+        precompile_worker = std::make_unique<Common::ThreadWorker>(1, "ShaderJitPrecompile");
+        for (JitDiskCacheEntry& entry : entries) {
+            precompile_worker->QueueWork([this, entry = std::move(entry)] {
+                {
+                    std::scoped_lock lock{cache_mutex};
+                    if (cache.contains(entry.cache_key)) {
+                        return;
+                    }
+                }
+
+                auto program_code = std::make_unique<ProgramCode>();
+                auto swizzle_data = std::make_unique<SwizzleData>();
+                program_code->fill(0);
+                swizzle_data->fill(0);
+                std::copy(entry.program_code.begin(), entry.program_code.end(),
+                          program_code->begin());
+                std::copy(entry.swizzle_data.begin(), entry.swizzle_data.end(),
+                          swizzle_data->begin());
+
+                auto program = std::make_unique<Program>();
+                program->Compile(program_code.get(), swizzle_data.get());
+
+                std::scoped_lock lock{cache_mutex};
+                cache.try_emplace(entry.cache_key, std::move(program));
+            });
+        }
+        LOG_INFO(HW_GPU, "Precompiling {} shader programs in the background", entries.size());
+    }
+
+    std::mutex cache_mutex;
+    std::unordered_map<u64, std::unique_ptr<Program>> cache;
+
+    std::unique_ptr<JitDiskCache> disk_cache;
+    bool disk_cache_loaded = false;
+
+    /// Declared last so pending compilations are stopped before the caches are destroyed
+    std::unique_ptr<Common::ThreadWorker> precompile_worker;
+};
+
+} // namespace Pica::Shader
@@ -7,10 +7,9 @@
 #include "common/arch.h"
 #if CITRA_ARCH(x86_64)
 
-#include <memory>
-#include <unordered_map>
 #include "common/common_types.h"
 #include "video_core/shader/shader.h"
+#include "video_core/shader/shader_jit_disk_cache.h"
 
 namespace Pica::Shader {
 
@@ -25,7 +24,7 @@ public:
     void Run(const ShaderSetup& setup, UnitState& state) const override;
 
 private:
-    std::unordered_map<u64, std::unique_ptr<JitShader>> cache;
+    JitProgramCache<JitShader> program_cache;
 };
 
 } // namespace Pica::Shader
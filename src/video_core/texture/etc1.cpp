@@ -4,12 +4,28 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
+#include "common/arch.h"
 #include "common/bit_field.h"
 #include "common/color.h"
 #include "common/common_types.h"
+#include "common/swap.h"
 #include "common/vector_math.h"
 #include "video_core/texture/etc1.h"
 
+#if CITRA_ARCH(x86_64)
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
+#if CITRA_ARCH(x86_64) && !defined(_MSC_VER)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#else
+#define TARGET_SSE41
+#endif
+
 namespace Pica::Texture {
 
 namespace {
@@ -69,19 +85,14 @@ union ETC1Tile {
         BitField<60, 4, u64> r1;
     } separate;
 
-    const Common::Vec3<u8> GetRGB(unsigned int x, unsigned int y) const {
-        int texel = 4 * x + y;
-
-        if (flip)
-            std::swap(x, y);
-
-        // Lookup base value
+    /// Returns the base color of the left or top half, or of the right or bottom one if flipped
+    Common::Vec3<int> GetBaseColor(bool second_half) const {
         Common::Vec3<int> ret;
         if (differential_mode) {
             ret.r() = static_cast<int>(differential.r);
             ret.g() = static_cast<int>(differential.g);
             ret.b() = static_cast<int>(differential.b);
-            if (x >= 2) {
+            if (second_half) {
                 ret.r() += static_cast<int>(differential.dr);
                 ret.g() += static_cast<int>(differential.dg);
                 ret.b() += static_cast<int>(differential.db);
@@ -90,7 +101,7 @@ union ETC1Tile {
             ret.g() = Common::Color::Convert5To8(ret.g());
             ret.b() = Common::Color::Convert5To8(ret.b());
         } else {
-            if (x < 2) {
+            if (!second_half) {
                 ret.r() = Common::Color::Convert4To8(static_cast<u8>(separate.r1));
                 ret.g() = Common::Color::Convert4To8(static_cast<u8>(separate.g1));
                 ret.b() = Common::Color::Convert4To8(static_cast<u8>(separate.b1));
@@ -100,10 +111,24 @@ union ETC1Tile {
                 ret.b() = Common::Color::Convert4To8(static_cast<u8>(separate.b2));
             }
         }
+        return ret;
+    }
+
+    unsigned GetTableIndex(bool second_half) const {
+        return static_cast<unsigned>(second_half ? table_index_2.Value() : table_index_1.Value());
+    }
+
+    const Common::Vec3<u8> GetRGB(unsigned int x, unsigned int y) const {
+        int texel = 4 * x + y;
+
+        if (flip)
+            std::swap(x, y);
+
+        // Lookup base value
+        Common::Vec3<int> ret = GetBaseColor(x >= 2);
 
         // Add modifier
-        unsigned table_index =
-            static_cast<int>((x < 2) ? table_index_1.Value() : table_index_2.Value());
+        unsigned table_index = GetTableIndex(x >= 2);
 
         int modifier = etc1_modifier_table[table_index][GetTableSubIndex(texel)];
         if (GetNegationFlag(texel))
@@ -117,6 +142,236 @@ union ETC1Tile {
     }
 };
 
+/// Decoded header of a 4x4 subtile, shared by all of its texels
+struct SubtileHeader {
+    /// Base colors of both halves as RGBA8 texels with zero alpha
+    std::array<u32, 2> base;
+    std::array<unsigned, 2> table_index;
+    bool flip;
+};
+
+SubtileHeader DecodeSubtileHeader(const ETC1Tile& tile) {
+    SubtileHeader header{};
+    for (u32 half = 0; half < 2; half++) {
+        const auto color = tile.GetBaseColor(half != 0).Cast<u8>();
+        header.base[half] = color.r() | (color.g() << 8) | (color.b() << 16);
+        header.table_index[half] = tile.GetTableIndex(half != 0);
+    }
+    header.flip = tile.flip != 0;
+    return header;
+}
+
+/// Writes the texels of a subtile, alpha holds 16 4-bit values and is ignored without has_alpha
+using SubtileDecoder = void (*)(u64 value, u64 alpha, bool has_alpha, u8* dst,
+                                std::ptrdiff_t dst_pitch);
+
+void DecodeSubtileScalar(u64 value, u64 alpha, bool has_alpha, u8* dst, std::ptrdiff_t dst_pitch) {
+    const ETC1Tile tile{value};
+    const SubtileHeader header = DecodeSubtileHeader(tile);
+    for (u32 y = 0; y < 4; y++) {
+        std::array<u32, 4> row;
+        for (u32 x = 0; x < 4; x++) {
+            const u32 texel = 4 * x + y;
+            const u32 half = (header.flip ? y : x) >= 2 ? 1 : 0;
+            const auto& modifiers = etc1_modifier_table[header.table_index[half]];
+            int modifier = modifiers[tile.GetTableSubIndex(texel)];
+            if (tile.GetNegationFlag(texel)) {
+                modifier = -modifier;
+            }
+            u32 result = 0;
+            for (u32 channel = 0; channel < 3; channel++) {
+                const int base = (header.base[half] >> (channel * 8)) & 0xFF;
+                result |= static_cast<u32>(std::clamp(base + modifier, 0, 255)) << (channel * 8);
+            }
+            const u8 texel_alpha =
+                has_alpha ? Common::Color::Convert4To8((alpha >> (4 * texel)) & 0xF) : 255;
+            row[x] = result | (texel_alpha << 24);
+        }
+        std::memcpy(dst + y * dst_pitch, row.data(), sizeof(row));
+    }
+}
+
+/*
+ * The vectorized decoders work on the 16 texels of a subtile at once, with texel 4 * x + y in
+ * byte lane 4 * x + y, as the bits of the subtile are ordered. The modifier table fits in one
+ * vector and is indexed with a byte shuffle, and as the base colors are within [0, 255] adding the
+ * modifiers with unsigned saturation clamps them like the scalar decoder does. Every row is then
+ * gathered from the lanes with another shuffle.
+ */
+
+/// Modifier table with entry [i][j] in byte 2 * i + j
+constexpr std::array<u8, 16> MODIFIER_BYTES = [] {
+    std::array<u8, 16> bytes{};
+    for (u32 i = 0; i < bytes.size(); i++) {
+        bytes[i] = etc1_modifier_table[i / 2][i % 2];
+    }
+    return bytes;
+}();
+
+/// Lanes of the texels in the second half of a subtile, unflipped and flipped
+constexpr std::array<u8, 16> SECOND_HALF = {0, 0, 0, 0, 0, 0, 0, 0,
+                                            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+constexpr std::array<u8, 16> SECOND_HALF_FLIPPED = {0, 0, 0xFF, 0xFF, 0, 0, 0xFF, 0xFF,
+                                                    0, 0, 0xFF, 0xFF, 0, 0, 0xFF, 0xFF};
+
+/// Bit of every lane in the byte that holds it
+constexpr std::array<u8, 16> LANE_BITS = {1, 2, 4, 8, 16, 32, 64, 128,
+                                          1, 2, 4, 8, 16, 32, 64, 128};
+
+/// Shuffles gathering the color channels and the alpha of each row from the texel lanes
+struct RowShuffles {
+    std::array<std::array<u8, 16>, 4> color;
+    std::array<std::array<u8, 16>, 4> alpha;
+};
+
+constexpr RowShuffles ROW_SHUFFLES = [] {
+    RowShuffles shuffles{};
+    for (u32 y = 0; y < 4; y++) {
+        for (u32 x = 0; x < 4; x++) {
+            const u8 lane = static_cast<u8>(4 * x + y);
+            for (u32 channel = 0; channel < 4; channel++) {
+                shuffles.color[y][x * 4 + channel] = channel < 3 ? lane : 0x80;
+                shuffles.alpha[y][x * 4 + channel] = channel == 3 ? lane : 0x80;
+            }
+        }
+    }
+    return shuffles;
+}();
+
+#if CITRA_ARCH(x86_64)
+
+TARGET_SSE41 __m128i LoadBytes(const std::array<u8, 16>& bytes) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes.data()));
+}
+
+/// Returns 0xFF in the lanes whose bit is set in the 16-bit mask
+TARGET_SSE41 __m128i ExpandBits(u32 bits) {
+    const __m128i bytes = _mm_setr_epi8(static_cast<char>(bits), static_cast<char>(bits),
+                                        static_cast<char>(bits), static_cast<char>(bits),
+                                        static_cast<char>(bits), static_cast<char>(bits),
+                                        static_cast<char>(bits), static_cast<char>(bits),
+                                        static_cast<char>(bits >> 8), static_cast<char>(bits >> 8),
+                                        static_cast<char>(bits >> 8), static_cast<char>(bits >> 8),
+                                        static_cast<char>(bits >> 8), static_cast<char>(bits >> 8),
+                                        static_cast<char>(bits >> 8), static_cast<char>(bits >> 8));
+    const __m128i lane_bits = LoadBytes(LANE_BITS);
+    return _mm_cmpeq_epi8(_mm_and_si128(bytes, lane_bits), lane_bits);
+}
+
+TARGET_SSE41 void DecodeSubtileSSE41(u64 value, u64 alpha, bool has_alpha, u8* dst,
+                                     std::ptrdiff_t dst_pitch) {
+    const ETC1Tile tile{value};
+    const SubtileHeader header = DecodeSubtileHeader(tile);
+
+    const __m128i second_half = LoadBytes(header.flip ? SECOND_HALF_FLIPPED : SECOND_HALF);
+    const __m128i sub_index = _mm_and_si128(ExpandBits(tile.table_subindexes), _mm_set1_epi8(1));
+    const __m128i negate = ExpandBits(tile.negation_flags);
+    const __m128i table_index =
+        _mm_blendv_epi8(_mm_set1_epi8(static_cast<char>(header.table_index[0] * 2)),
+                        _mm_set1_epi8(static_cast<char>(header.table_index[1] * 2)), second_half);
+    const __m128i modifier =
+        _mm_shuffle_epi8(LoadBytes(MODIFIER_BYTES), _mm_or_si128(table_index, sub_index));
+    const __m128i add = _mm_andnot_si128(negate, modifier);
+    const __m128i subtract = _mm_and_si128(negate, modifier);
+
+    __m128i alpha_lanes = _mm_set1_epi8(static_cast<char>(0xFF));
+    if (has_alpha) {
+        const __m128i packed = _mm_cvtsi64_si128(static_cast<s64>(alpha));
+        const __m128i low = _mm_and_si128(packed, _mm_set1_epi8(0xF));
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(packed, 4), _mm_set1_epi8(0xF));
+        const __m128i nibbles = _mm_unpacklo_epi8(low, high);
+        alpha_lanes = _mm_or_si128(_mm_slli_epi16(nibbles, 4), nibbles);
+    }
+
+    const __m128i first_base = _mm_set1_epi32(static_cast<int>(header.base[0]));
+    const __m128i second_base = _mm_set1_epi32(static_cast<int>(header.base[1]));
+    for (u32 y = 0; y < 4; y++) {
+        __m128i base;
+        if (header.flip) {
+            base = y < 2 ? first_base : second_base;
+        } else {
+            base = _mm_unpacklo_epi64(first_base, second_base);
+        }
+        const __m128i color_shuffle = LoadBytes(ROW_SHUFFLES.color[y]);
+        const __m128i color =
+            _mm_subs_epu8(_mm_adds_epu8(base, _mm_shuffle_epi8(add, color_shuffle)),
+                          _mm_shuffle_epi8(subtract, color_shuffle));
+        const __m128i row =
+            _mm_or_si128(color, _mm_shuffle_epi8(alpha_lanes, LoadBytes(ROW_SHUFFLES.alpha[y])));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + y * dst_pitch), row);
+    }
+}
+
+SubtileDecoder SelectSubtileDecoder() {
+    if (Common::GetCPUCaps().sse4_1) {
+        return DecodeSubtileSSE41;
+    }
+    return DecodeSubtileScalar;
+}
+
+#elif CITRA_ARCH(arm64)
+
+uint8x16_t ExpandBits(u32 bits) {
+    const uint8x16_t bytes = vcombine_u8(vdup_n_u8(static_cast<u8>(bits)),
+                                         vdup_n_u8(static_cast<u8>(bits >> 8)));
+    return vtstq_u8(bytes, vld1q_u8(LANE_BITS.data()));
+}
+
+void DecodeSubtileNEON(u64 value, u64 alpha, bool has_alpha, u8* dst, std::ptrdiff_t dst_pitch) {
+    const ETC1Tile tile{value};
+    const SubtileHeader header = DecodeSubtileHeader(tile);
+
+    const uint8x16_t second_half =
+        vld1q_u8(header.flip ? SECOND_HALF_FLIPPED.data() : SECOND_HALF.data());
+    const uint8x16_t sub_index = vandq_u8(ExpandBits(tile.table_subindexes), vdupq_n_u8(1));
+    const uint8x16_t negate = ExpandBits(tile.negation_flags);
+    const uint8x16_t table_index =
+        vbslq_u8(second_half, vdupq_n_u8(static_cast<u8>(header.table_index[1] * 2)),
+                 vdupq_n_u8(static_cast<u8>(header.table_index[0] * 2)));
+    const uint8x16_t modifier =
+        vqtbl1q_u8(vld1q_u8(MODIFIER_BYTES.data()), vorrq_u8(table_index, sub_index));
+    const uint8x16_t add = vbicq_u8(modifier, negate);
+    const uint8x16_t subtract = vandq_u8(modifier, negate);
+
+    uint8x16_t alpha_lanes = vdupq_n_u8(0xFF);
+    if (has_alpha) {
+        const uint8x8_t packed = vcreate_u8(alpha);
+        const uint8x8x2_t nibbles = vzip_u8(vand_u8(packed, vdup_n_u8(0xF)), vshr_n_u8(packed, 4));
+        const uint8x16_t values = vcombine_u8(nibbles.val[0], nibbles.val[1]);
+        alpha_lanes = vorrq_u8(vshlq_n_u8(values, 4), values);
+    }
+
+    const uint32x4_t first_base = vdupq_n_u32(header.base[0]);
+    const uint32x4_t second_base = vdupq_n_u32(header.base[1]);
+    for (u32 y = 0; y < 4; y++) {
+        uint32x4_t base;
+        if (header.flip) {
+            base = y < 2 ? first_base : second_base;
+        } else {
+            base = vcombine_u32(vget_low_u32(first_base), vget_low_u32(second_base));
+        }
+        const uint8x16_t color_shuffle = vld1q_u8(ROW_SHUFFLES.color[y].data());
+        const uint8x16_t color = vqsubq_u8(
+            vqaddq_u8(vreinterpretq_u8_u32(base), vqtbl1q_u8(add, color_shuffle)),
+            vqtbl1q_u8(subtract, color_shuffle));
+        const uint8x16_t row =
+            vorrq_u8(color, vqtbl1q_u8(alpha_lanes, vld1q_u8(ROW_SHUFFLES.alpha[y].data())));
+        vst1q_u8(dst + y * dst_pitch, row);
+    }
+}
+
+SubtileDecoder SelectSubtileDecoder() {
+    return DecodeSubtileNEON;
+}
+
+#else
+
+SubtileDecoder SelectSubtileDecoder() {
+    return DecodeSubtileScalar;
+}
+
+#endif
+
 } // anonymous namespace
 
 Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y) {
@@ -124,4 +379,22 @@ Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y) {
     return tile.GetRGB(x, y);
 }
 
+void DecodeETC1Tile(const u8* source, bool has_alpha, u8* dst, std::ptrdiff_t dst_pitch) {
+    static const SubtileDecoder decode_subtile = SelectSubtileDecoder();
+    for (u32 subtile = 0; subtile < 4; subtile++) {
+        u64_le alpha = 0;
+        if (has_alpha) {
+            std::memcpy(&alpha, source, sizeof(u64));
+            source += sizeof(u64);
+        }
+        u64_le value;
+        std::memcpy(&value, source, sizeof(u64));
+        source += sizeof(u64);
+
+        // Subtiles are stored left to right, then top to bottom
+        u8* const subtile_dst = dst + (subtile / 2) * 4 * dst_pitch + (subtile % 2) * 4 * 4;
+        decode_subtile(value, alpha, has_alpha, subtile_dst, dst_pitch);
+    }
+}
+
 } // namespace Pica::Texture
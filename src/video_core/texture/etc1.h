@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 
@@ -11,4 +12,13 @@ namespace Pica::Texture {
 
 Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y);
 
+/**
+ * Decodes a whole 8x8 ETC1 or ETC1A4 tile to RGBA8.
+ * @param source Pointer to the beginning of the tile
+ * @param has_alpha True for ETC1A4 tiles
+ * @param dst Destination of texel (0, 0), texel (x, y) is written to dst + y * dst_pitch + x * 4
+ * @param dst_pitch Distance between destination rows in bytes
+ */
+void DecodeETC1Tile(const u8* source, bool has_alpha, u8* dst, std::ptrdiff_t dst_pitch);
+
 } // namespace Pica::Texture
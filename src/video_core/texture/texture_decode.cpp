@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <cstring>
+#include "common/arch.h"
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/logging/log.h"
@@ -13,6 +16,12 @@
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
 
+#if CITRA_ARCH(x86_64)
+#include <emmintrin.h>
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
 using TextureFormat = Pica::TexturingRegs::TextureFormat;
 
 namespace Pica::Texture {
@@ -212,6 +221,373 @@ Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned in
     }
 }
 
+namespace {
+
+/// Morton offsets of the texels of a tile in row-major order
+constexpr std::array<u8, TILE_SIZE> MORTON_OFFSETS = [] {
+    std::array<u8, TILE_SIZE> offsets{};
+    for (u32 y = 0; y < 8; y++) {
+        for (u32 x = 0; x < 8; x++) {
+            offsets[y * 8 + x] = static_cast<u8>(VideoCore::MortonInterleave(x, y));
+        }
+    }
+    return offsets;
+}();
+
+/**
+ * Decodes the texels of a tile one row at a time, converting each texel separately. Used for the
+ * 24 and 32-bit formats, whose conversion only reorders bytes.
+ */
+template <typename Converter>
+void DecodeTexels(const u8* source, u8* dst, std::ptrdiff_t dst_pitch, Converter&& convert) {
+    for (u32 y = 0; y < 8; y++) {
+        std::array<u8, 8 * 4> row;
+        for (u32 x = 0; x < 8; x++) {
+            const Common::Vec4<u8> texel = convert(source, MORTON_OFFSETS[y * 8 + x]);
+            row[x * 4 + 0] = texel.r();
+            row[x * 4 + 1] = texel.g();
+            row[x * 4 + 2] = texel.b();
+            row[x * 4 + 3] = texel.a();
+        }
+        std::memcpy(dst + y * dst_pitch, row.data(), row.size());
+    }
+}
+
+/// Returns the 4-bit value at the morton offset of a tile with two values per byte
+u8 GetNibble(const u8* source, u32 morton_offset) {
+    const u8 value = source[morton_offset / 2];
+    return (morton_offset % 2) ? (value >> 4) : (value & 0xF);
+}
+
+/**
+ * The texels of a tile row, widened to 16 bits. The formats of up to 16 bits per texel are
+ * expanded to RGBA8 with the operations below only, so the same expressions are compiled to
+ * SSE2 or NEON, which are part of the baseline of their architectures, and to plain loops
+ * elsewhere.
+ */
+struct Row16 {
+#if CITRA_ARCH(x86_64)
+    __m128i value;
+#elif CITRA_ARCH(arm64)
+    uint16x8_t value;
+#else
+    std::array<u16, 8> value;
+#endif
+};
+
+#if CITRA_ARCH(x86_64)
+
+Row16 LoadRow(const std::array<u16, 8>& texels) {
+    return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels.data()))};
+}
+
+Row16 Splat(u16 value) {
+    return {_mm_set1_epi16(static_cast<s16>(value))};
+}
+
+Row16 operator|(Row16 a, Row16 b) {
+    return {_mm_or_si128(a.value, b.value)};
+}
+
+Row16 operator&(Row16 a, u16 mask) {
+    return {_mm_and_si128(a.value, _mm_set1_epi16(static_cast<s16>(mask)))};
+}
+
+Row16 operator-(Row16 a, Row16 b) {
+    return {_mm_sub_epi16(a.value, b.value)};
+}
+
+template <int N>
+Row16 ShiftLeft(Row16 a) {
+    return {_mm_slli_epi16(a.value, N)};
+}
+
+template <int N>
+Row16 ShiftRight(Row16 a) {
+    return {_mm_srli_epi16(a.value, N)};
+}
+
+/// Stores eight RGBA8 texels made of the red/green and blue/alpha halves
+void StoreTexels(Row16 rg, Row16 ba, u8* dst) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi16(rg.value, ba.value));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_unpackhi_epi16(rg.value, ba.value));
+}
+
+#elif CITRA_ARCH(arm64)
+
+Row16 LoadRow(const std::array<u16, 8>& texels) {
+    return {vld1q_u16(texels.data())};
+}
+
+Row16 Splat(u16 value) {
+    return {vdupq_n_u16(value)};
+}
+
+Row16 operator|(Row16 a, Row16 b) {
+    return {vorrq_u16(a.value, b.value)};
+}
+
+Row16 operator&(Row16 a, u16 mask) {
+    return {vandq_u16(a.value, vdupq_n_u16(mask))};
+}
+
+Row16 operator-(Row16 a, Row16 b) {
+    return {vsubq_u16(a.value, b.value)};
+}
+
+template <int N>
+Row16 ShiftLeft(Row16 a) {
+    return {vshlq_n_u16(a.value, N)};
+}
+
+template <int N>
+Row16 ShiftRight(Row16 a) {
+    return {vshrq_n_u16(a.value, N)};
+}
+
+/// Stores eight RGBA8 texels made of the red/green and blue/alpha halves
+void StoreTexels(Row16 rg, Row16 ba, u8* dst) {
+    vst2q_u16(reinterpret_cast<u16*>(dst), uint16x8x2_t{{rg.value, ba.value}});
+}
+
+#else
+
+template <typename Op>
+Row16 Apply(Row16 a, Op&& op) {
+    for (auto& value : a.value) {
+        value = static_cast<u16>(op(value));
+    }
+    return a;
+}
+
+Row16 LoadRow(const std::array<u16, 8>& texels) {
+    return {texels};
+}
+
+Row16 Splat(u16 value) {
+    Row16 row;
+    row.value.fill(value);
+    return row;
+}
+
+Row16 operator|(Row16 a, Row16 b) {
+    for (std::size_t i = 0; i < a.value.size(); i++) {
+        a.value[i] |= b.value[i];
+    }
+    return a;
+}
+
+Row16 operator&(Row16 a, u16 mask) {
+    return Apply(a, [mask](u16 value) { return value & mask; });
+}
+
+Row16 operator-(Row16 a, Row16 b) {
+    for (std::size_t i = 0; i < a.value.size(); i++) {
+        a.value[i] -= b.value[i];
+    }
+    return a;
+}
+
+template <int N>
+Row16 ShiftLeft(Row16 a) {
+    return Apply(a, [](u16 value) { return value << N; });
+}
+
+template <int N>
+Row16 ShiftRight(Row16 a) {
+    return Apply(a, [](u16 value) { return value >> N; });
+}
+
+/// Stores eight RGBA8 texels made of the red/green and blue/alpha halves
+void StoreTexels(Row16 rg, Row16 ba, u8* dst) {
+    for (std::size_t i = 0; i < rg.value.size(); i++) {
+        dst[i * 4 + 0] = static_cast<u8>(rg.value[i]);
+        dst[i * 4 + 1] = static_cast<u8>(rg.value[i] >> 8);
+        dst[i * 4 + 2] = static_cast<u8>(ba.value[i]);
+        dst[i * 4 + 3] = static_cast<u8>(ba.value[i] >> 8);
+    }
+}
+
+#endif
+
+struct ExpandedRow {
+    Row16 rg; ///< Red in the low byte, green in the high byte
+    Row16 ba; ///< Blue in the low byte, alpha in the high byte
+};
+
+/**
+ * Decodes a tile one row at a time. `fetch` reads the value of the texel at a morton offset and
+ * `expand` converts a row of values to RGBA8.
+ */
+template <typename Fetch, typename Expand>
+void DecodeExpandedTexels(const u8* source, u8* dst, std::ptrdiff_t dst_pitch, Fetch&& fetch,
+                          Expand&& expand) {
+    for (u32 y = 0; y < 8; y++) {
+        std::array<u16, 8> texels;
+        for (u32 x = 0; x < 8; x++) {
+            texels[x] = fetch(source, MORTON_OFFSETS[y * 8 + x]);
+        }
+        const ExpandedRow row = expand(LoadRow(texels));
+        StoreTexels(row.rg, row.ba, dst + y * dst_pitch);
+    }
+}
+
+u16 Fetch16(const u8* tile, u32 offset) {
+    u16_le value;
+    std::memcpy(&value, tile + offset * 2, sizeof(value));
+    return value;
+}
+
+u16 Fetch8(const u8* tile, u32 offset) {
+    return tile[offset];
+}
+
+u16 Fetch4(const u8* tile, u32 offset) {
+    return GetNibble(tile, offset);
+}
+
+// Expansions of the formats. The bit replication of Convert4To8, Convert5To8 and Convert6To8 is
+// done with shifts and masks which place the result directly in its byte.
+
+ExpandedRow ExpandRGBA4(Row16 p) {
+    return {
+        ShiftRight<12>(p) | (ShiftRight<8>(p) & 0xF0) | (p & 0x0F00) | (ShiftLeft<4>(p) & 0xF000),
+        (ShiftRight<4>(p) & 0x0F) | (p & 0xF0) | (ShiftLeft<8>(p) & 0x0F00) | ShiftLeft<12>(p),
+    };
+}
+
+Row16 Expand5To8Red(Row16 p) {
+    return (ShiftRight<8>(p) & 0xF8) | ShiftRight<13>(p);
+}
+
+ExpandedRow ExpandRGB5A1(Row16 p) {
+    const Row16 green = (ShiftLeft<5>(p) & 0xF800) | (p & 0x0700);
+    const Row16 blue = (ShiftLeft<2>(p) & 0xF8) | (ShiftRight<3>(p) & 0x07);
+    const Row16 alpha = (Splat(0) - (p & 0x1)) & 0xFF00;
+    return {Expand5To8Red(p) | green, blue | alpha};
+}
+
+ExpandedRow ExpandRGB565(Row16 p) {
+    const Row16 green = (ShiftLeft<5>(p) & 0xFC00) | (ShiftRight<1>(p) & 0x0300);
+    const Row16 blue = (ShiftLeft<3>(p) & 0xF8) | (ShiftRight<2>(p) & 0x07);
+    return {Expand5To8Red(p) | green, blue | Splat(0xFF00)};
+}
+
+ExpandedRow ExpandIA8(Row16 p) {
+    return {ShiftRight<8>(p) | (p & 0xFF00), ShiftRight<8>(p) | ShiftLeft<8>(p)};
+}
+
+ExpandedRow ExpandRG8(Row16 p) {
+    return {ShiftRight<8>(p) | ShiftLeft<8>(p), Splat(0xFF00)};
+}
+
+ExpandedRow ExpandI8(Row16 i) {
+    return {i | ShiftLeft<8>(i), i | Splat(0xFF00)};
+}
+
+ExpandedRow ExpandA8(Row16 a) {
+    return {Splat(0), ShiftLeft<8>(a)};
+}
+
+ExpandedRow ExpandIA4(Row16 p) {
+    const Row16 i = ShiftRight<4>(p) | (p & 0xF0);
+    const Row16 a = (p & 0x0F) | (ShiftLeft<4>(p) & 0xF0);
+    return {i | ShiftLeft<8>(i), i | ShiftLeft<8>(a)};
+}
+
+ExpandedRow ExpandI4(Row16 value) {
+    const Row16 i = value | ShiftLeft<4>(value);
+    return {i | ShiftLeft<8>(i), i | Splat(0xFF00)};
+}
+
+ExpandedRow ExpandA4(Row16 value) {
+    return {Splat(0), ShiftLeft<8>(value) | ShiftLeft<12>(value)};
+}
+
+} // Anonymous namespace
+
+void DecodeTile(const u8* source, TextureFormat format, u8* dst, std::ptrdiff_t dst_pitch) {
+    using namespace Common::Color;
+
+    switch (format) {
+    case TextureFormat::RGBA8:
+        DecodeTexels(source, dst, dst_pitch, [](const u8* tile, u32 offset) {
+            return DecodeRGBA8(tile + offset * 4);
+        });
+        break;
+
+    case TextureFormat::RGB8:
+        DecodeTexels(source, dst, dst_pitch, [](const u8* tile, u32 offset) {
+            return DecodeRGB8(tile + offset * 3);
+        });
+        break;
+
+    case TextureFormat::RGB5A1:
+        DecodeExpandedTexels(source, dst, dst_pitch, Fetch16, ExpandRGB5A1);
+        break;
+
+    case TextureFormat::RGB565:
+        DecodeExpandedTexels(source, dst, dst_pitch, Fetch16, ExpandRGB565);
+        break;
+
+    case TextureFormat::RGBA4:
+        DecodeExpandedTexels(source, dst, dst_pitch, Fetch16, ExpandRGBA4);
+        break;
+
+    case TextureFormat::IA8:
+        DecodeExpandedTexels(source, dst, dst_pitch, Fetch16, ExpandIA8);
+        break;
+
+    case TextureFormat::RG8:
+        DecodeExpandedTexels(source, dst, dst_pitch, Fetch16, ExpandRG8);
+        break;
+
+    case TextureFormat::I8:
+        DecodeExpandedTexels(source, dst, dst_pitch, Fetch8, ExpandI8);
+        break;
+
+    case TextureFormat::A8:
+        DecodeExpandedTexels(source, dst, dst_pitch, Fetch8, ExpandA8);
+        break;
+
+    case TextureFormat::IA4:
+        DecodeExpandedTexels(source, dst, dst_pitch, Fetch8, ExpandIA4);
+        break;
+
+    case TextureFormat::I4:
+        DecodeExpandedTexels(source, dst, dst_pitch, Fetch4, ExpandI4);
+        break;
+
+    case TextureFormat::A4:
+        DecodeExpandedTexels(source, dst, dst_pitch, Fetch4, ExpandA4);
+        break;
+
+    case TextureFormat::ETC1:
+    case TextureFormat::ETC1A4:
+        DecodeETC1Tile(source, format == TextureFormat::ETC1A4, dst, dst_pitch);
+        break;
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown texture format: {:x}", (u32)format);
+        DEBUG_ASSERT(false);
+        break;
+    }
+}
+
+void DecodeTexture(const u8* source, const TextureInfo& info, u8* dst) {
+    ASSERT(info.width % 8 == 0 && info.height % 8 == 0);
+
+    const std::size_t tile_size = CalculateTileSize(info.format);
+    const std::ptrdiff_t dst_pitch = info.width * 4;
+    for (u32 y = 0; y < info.height; y += 8) {
+        const u8* tile = source + (y / 8) * info.stride;
+        for (u32 x = 0; x < info.width; x += 8) {
+            DecodeTile(tile, info.format, dst + y * dst_pitch + x * 4, dst_pitch);
+            tile += tile_size;
+        }
+    }
+}
+
 TextureInfo TextureInfo::FromPicaRegister(const TexturingRegs::TextureConfig& config,
                                           const TexturingRegs::TextureFormat& format) {
     TextureInfo info;
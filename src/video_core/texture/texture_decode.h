@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
@@ -55,4 +56,21 @@ Common::Vec4<u8> LookupTexture(const u8* source, unsigned int x, unsigned int y,
 Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int y,
                                    const TextureInfo& info, bool disable_alpha);
 
+/**
+ * Decodes a whole 8x8 texture tile to RGBA8, producing the same texels as LookupTexelInTile.
+ *
+ * @param source Pointer to the beginning of the tile.
+ * @param format Format of the tile.
+ * @param dst Destination of texel (0, 0), texel (x, y) is written to dst + y * dst_pitch + x * 4.
+ * @param dst_pitch Distance between destination rows in bytes, may be negative.
+ */
+void DecodeTile(const u8* source, TexturingRegs::TextureFormat format, u8* dst,
+                std::ptrdiff_t dst_pitch);
+
+/**
+ * Decodes a whole texture to RGBA8, with texel (x, y) of LookupTexture written to
+ * dst + (y * info.width + x) * 4. The dimensions of the texture must be multiples of 8.
+ */
+void DecodeTexture(const u8* source, const TextureInfo& info, u8* dst);
+
 } // namespace Pica::Texture
@@ -7,6 +7,7 @@
 #include "common/logging/log.h"
 #include "common/settings.h"
 #include "core/core.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_base.h"
@@ -21,6 +22,7 @@
 namespace VideoCore {
 
 std::unique_ptr<RendererBase> g_renderer{}; ///< Renderer plugin
+std::unique_ptr<GPUThread::ThreadManager> g_gpu_thread{};
 
 std::atomic<bool> g_shader_jit_enabled;
 std::atomic<bool> g_hw_shader_enabled;
@@ -49,10 +51,16 @@ void Init(Frontend::EmuWindow& emu_window, Frontend::EmuWindow* secondary_window
         LOG_CRITICAL(Render, "Unknown graphics API {}, using OpenGL", graphics_api);
         g_renderer = std::make_unique<OpenGL::RendererOpenGL>(system, emu_window, secondary_window);
     }
+
+    if (Settings::values.use_gpu_thread) {
+        LOG_INFO(Render, "Processing GPU commands on a dedicated thread");
+        g_gpu_thread = std::make_unique<GPUThread::ThreadManager>(*g_renderer, emu_window);
+    }
 }
 
 /// Shutdown the video core
 void Shutdown() {
+    g_gpu_thread.reset();
     Pica::Shutdown();
     g_renderer.reset();
 
@@ -61,6 +69,9 @@ void Shutdown() {
 
 template <class Archive>
 void serialize(Archive& ar, const unsigned int) {
+    if (g_gpu_thread) {
+        g_gpu_thread->WaitIdle();
+    }
     ar& Pica::g_state;
 }
 
@@ -29,8 +29,15 @@ namespace VideoCore {
 
 class RendererBase;
 
+namespace GPUThread {
+class ThreadManager;
+}
+
 extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 
+/// GPU thread, only present when GPU commands are processed asynchronously
+extern std::unique_ptr<GPUThread::ThreadManager> g_gpu_thread;
+
 // TODO: Wrap these in a user settings struct along with any other graphics settings (often set from
 // qt ui)
 extern std::atomic<bool> g_shader_jit_enabled;